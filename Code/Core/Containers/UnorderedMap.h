@@ -60,6 +60,9 @@ public:
     // Add items to the map
     KeyValue &                  Insert( const KEY & key, const VALUE & value );
 
+    // Remove items from the map (returns false if not found)
+    bool                        Erase( const KEY & key );
+
 protected:
     enum : uint32_t { kTableSizePower = 16 };
     enum : uint32_t { kTableSize = ( 1 << kTableSizePower ) };
@@ -179,4 +182,40 @@ typename UnorderedMap< KEY, VALUE >::KeyValue & UnorderedMap< KEY, VALUE >::Inse
     return *newKeyValue;
 }
 
+// Erase
+//------------------------------------------------------------------------------
+template< class KEY, class VALUE >
+bool UnorderedMap< KEY, VALUE >::Erase( const KEY & key )
+{
+    // Handle empty
+    if ( m_Buckets == nullptr )
+    {
+        return false;
+    }
+
+    // Hash the key
+    const uint32_t hash = UnorderedMapKeyHashingFunctions::Hash( key );
+
+    // Find the bucket
+    const uint32_t bucketId = ( hash & kTableSizeMask );
+
+    // Unlink matching entry from the bucket
+    KeyValue ** link = &m_Buckets[ bucketId ];
+    while ( *link )
+    {
+        KeyValue * keyValue = *link;
+        if ( keyValue->m_Key == key )
+        {
+            *link = keyValue->m_Next;
+            FDELETE keyValue;
+            m_Count--;
+            return true;
+        }
+        link = &keyValue->m_Next;
+    }
+
+    // Not found
+    return false;
+}
+
 //------------------------------------------------------------------------------
@@ -16,6 +16,7 @@ int main( int, char *[] )
     REGISTER_TESTGROUP( TestEnv )
     REGISTER_TESTGROUP( TestFileIO )
     REGISTER_TESTGROUP( TestFileStream )
+    REGISTER_TESTGROUP( TestFileWatcher )
     REGISTER_TESTGROUP( TestHash )
     REGISTER_TESTGROUP( TestLevenshteinDistance )
     REGISTER_TESTGROUP( TestMemInfo )
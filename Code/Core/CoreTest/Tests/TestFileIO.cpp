@@ -23,6 +23,9 @@
 #if defined( __LINUX__ )
     #include <unistd.h>
 #endif
+#if defined( __APPLE__ ) || defined( __LINUX__ )
+    #include <sys/stat.h>
+#endif
 
 // TestFileIO
 //------------------------------------------------------------------------------
@@ -44,6 +47,7 @@ private:
     #endif
     void CreateOrOpenReadWrite() const;
     void CreateOrOpenReadWritePerf() const;
+    void OwnerOnly() const;
 
     // Helpers
     mutable Random m_Random;
@@ -66,6 +70,7 @@ REGISTER_TESTS_BEGIN( TestFileIO )
     #endif
     REGISTER_TEST( CreateOrOpenReadWrite )
     REGISTER_TEST( CreateOrOpenReadWritePerf )
+    REGISTER_TEST( OwnerOnly )
 REGISTER_TESTS_END
 
 // FileExists
@@ -669,4 +674,41 @@ void TestFileIO::CreateOrOpenReadWritePerf() const
     OUTPUT(" Truncate on Close: %2.5f s\n", static_cast<double>( t2 ) );
 }
 
+// OwnerOnly
+//------------------------------------------------------------------------------
+void TestFileIO::OwnerOnly() const
+{
+    // generate a process unique file path
+    AStackString<> path;
+    GenerateTempFileName( path );
+
+    // Create file accessible only by the current user
+    {
+        FileStream f;
+        TEST_ASSERT( f.Open( path.Get(), FileStream::WRITE_ONLY | FileStream::OWNER_ONLY ) );
+        TEST_ASSERT( f.Write( path ) );
+    }
+    #if defined( __APPLE__ ) || defined( __LINUX__ )
+        struct stat s;
+        TEST_ASSERT( stat( path.Get(), &s ) == 0 );
+        TEST_ASSERT( ( s.st_mode & ( S_IRWXG | S_IRWXO ) ) == 0 );
+
+        // An existing file is restricted when opened
+        TEST_ASSERT( chmod( path.Get(), S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH ) == 0 );
+        {
+            FileStream f;
+            TEST_ASSERT( f.Open( path.Get(), FileStream::WRITE_ONLY | FileStream::OWNER_ONLY ) );
+        }
+        TEST_ASSERT( stat( path.Get(), &s ) == 0 );
+        TEST_ASSERT( ( s.st_mode & ( S_IRWXG | S_IRWXO ) ) == 0 );
+    #endif
+
+    // File is still accessible to the owner
+    {
+        FileStream f;
+        TEST_ASSERT( f.Open( path.Get(), FileStream::READ_ONLY ) );
+    }
+    TEST_ASSERT( FileIO::FileDelete( path.Get() ) );
+}
+
 //------------------------------------------------------------------------------
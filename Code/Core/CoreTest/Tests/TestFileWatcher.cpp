@@ -0,0 +1,171 @@
+// TestFileWatcher.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "TestFramework/TestGroup.h"
+
+// Core
+#include "Core/FileIO/FileIO.h"
+#include "Core/FileIO/FileStream.h"
+#include "Core/FileIO/FileWatcher.h"
+#include "Core/FileIO/PathUtils.h"
+#include "Core/Process/Process.h"
+#include "Core/Strings/AStackString.h"
+
+// TestFileWatcher
+//------------------------------------------------------------------------------
+class TestFileWatcher : public TestGroup
+{
+private:
+    DECLARE_TESTS
+
+    void Unsupported() const;
+    void DetectChanges() const;
+    void DirectoryRemoved() const;
+
+    // Helpers
+    void CreateTempDir( const char * name, AString & outPath ) const;
+    static bool Contains( const Array< AString > & files, const AString & file );
+};
+
+// Register Tests
+//------------------------------------------------------------------------------
+REGISTER_TESTS_BEGIN( TestFileWatcher )
+    #if defined( __LINUX__ )
+        REGISTER_TEST( DetectChanges )
+        REGISTER_TEST( DirectoryRemoved )
+    #else
+        REGISTER_TEST( Unsupported )
+    #endif
+REGISTER_TESTS_END
+
+// Unsupported
+//------------------------------------------------------------------------------
+void TestFileWatcher::Unsupported() const
+{
+    // Without platform support, nothing is watched so callers fall back to
+    // checking files themselves
+    AStackString<> dir;
+    CreateTempDir( "Unsupported", dir );
+
+    FileWatcher watcher;
+    TEST_ASSERT( watcher.WatchDirectory( dir ) == false );
+    TEST_ASSERT( watcher.IsWatched( dir ) == false );
+
+    Array< AString > changes;
+    TEST_ASSERT( watcher.GetChanges( changes ) );
+    TEST_ASSERT( changes.IsEmpty() );
+
+    TEST_ASSERT( FileIO::DirectoryDelete( dir ) );
+}
+
+// DetectChanges
+//------------------------------------------------------------------------------
+void TestFileWatcher::DetectChanges() const
+{
+    AStackString<> dir;
+    CreateTempDir( "DetectChanges", dir );
+
+    AStackString<> fileA( dir );
+    fileA += NATIVE_SLASH;
+    fileA += "a.txt";
+    AStackString<> fileB( dir );
+    fileB += NATIVE_SLASH;
+    fileB += "b.txt";
+
+    FileWatcher watcher;
+    TEST_ASSERT( watcher.WatchDirectory( dir ) );
+    TEST_ASSERT( watcher.IsWatched( dir ) );
+    TEST_ASSERT( watcher.WatchDirectory( dir ) ); // Watching again is harmless
+
+    // Missing directories can't be watched
+    AStackString<> missingDir( dir );
+    missingDir += NATIVE_SLASH;
+    missingDir += "Missing";
+    TEST_ASSERT( watcher.WatchDirectory( missingDir ) == false );
+
+    // No changes yet
+    Array< AString > changes;
+    TEST_ASSERT( watcher.GetChanges( changes ) );
+    TEST_ASSERT( changes.IsEmpty() );
+
+    // Create a file
+    {
+        FileStream f;
+        TEST_ASSERT( f.Open( fileA.Get(), FileStream::WRITE_ONLY ) );
+        TEST_ASSERT( f.WriteBuffer( "a", 1 ) == 1 );
+    }
+    TEST_ASSERT( watcher.GetChanges( changes ) );
+    TEST_ASSERT( Contains( changes, fileA ) );
+    TEST_ASSERT( Contains( changes, fileB ) == false );
+
+    // Changes are only reported once
+    changes.Clear();
+    TEST_ASSERT( watcher.GetChanges( changes ) );
+    TEST_ASSERT( changes.IsEmpty() );
+
+    // Timestamp change
+    TEST_ASSERT( FileIO::SetFileLastWriteTimeToNow( fileA ) );
+    TEST_ASSERT( watcher.GetChanges( changes ) );
+    TEST_ASSERT( Contains( changes, fileA ) );
+
+    // Rename reports both files
+    changes.Clear();
+    TEST_ASSERT( FileIO::FileMove( fileA, fileB ) );
+    TEST_ASSERT( watcher.GetChanges( changes ) );
+    TEST_ASSERT( Contains( changes, fileA ) );
+    TEST_ASSERT( Contains( changes, fileB ) );
+
+    // Deletion
+    changes.Clear();
+    TEST_ASSERT( FileIO::FileDelete( fileB.Get() ) );
+    TEST_ASSERT( watcher.GetChanges( changes ) );
+    TEST_ASSERT( Contains( changes, fileB ) );
+
+    TEST_ASSERT( FileIO::DirectoryDelete( dir ) );
+}
+
+// DirectoryRemoved
+//------------------------------------------------------------------------------
+void TestFileWatcher::DirectoryRemoved() const
+{
+    AStackString<> dir;
+    CreateTempDir( "DirectoryRemoved", dir );
+
+    FileWatcher watcher;
+    TEST_ASSERT( watcher.WatchDirectory( dir ) );
+
+    // Removing a watched directory means changes could be missed
+    TEST_ASSERT( FileIO::DirectoryDelete( dir ) );
+    Array< AString > changes;
+    TEST_ASSERT( watcher.GetChanges( changes ) == false );
+
+    // All watches are discarded, but watching can resume
+    TEST_ASSERT( watcher.IsWatched( dir ) == false );
+    CreateTempDir( "DirectoryRemoved", dir );
+    TEST_ASSERT( watcher.WatchDirectory( dir ) );
+    TEST_ASSERT( watcher.GetChanges( changes ) );
+
+    TEST_ASSERT( FileIO::DirectoryDelete( dir ) );
+}
+
+// CreateTempDir
+//------------------------------------------------------------------------------
+void TestFileWatcher::CreateTempDir( const char * name, AString & outPath ) const
+{
+    VERIFY( FileIO::GetTempDir( outPath ) );
+    AStackString<> buffer;
+    buffer.Format( "TestFileWatcher.%s.%u", name, Process::GetCurrentId() );
+    outPath += buffer;
+    TEST_ASSERT( FileIO::EnsurePathExists( outPath ) );
+}
+
+// Contains
+//------------------------------------------------------------------------------
+/*static*/ bool TestFileWatcher::Contains( const Array< AString > & files, const AString & file )
+{
+    return ( files.Find( file ) != nullptr );
+}
+
+//------------------------------------------------------------------------------
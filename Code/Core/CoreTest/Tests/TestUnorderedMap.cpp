@@ -19,6 +19,7 @@ private:
     void Destruct() const;
     void Insert() const;
     void Find() const;
+    void Erase() const;
 };
 
 // Register Tests
@@ -27,6 +28,7 @@ REGISTER_TESTS_BEGIN( TestUnorderedMap )
     REGISTER_TEST( ConstructEmpty )
     REGISTER_TEST( Insert )
     REGISTER_TEST( Find )
+    REGISTER_TEST( Erase )
     REGISTER_TEST( Destruct )
 REGISTER_TESTS_END
 
@@ -83,6 +85,38 @@ void TestUnorderedMap::Find() const
     }
 }
 
+// Erase
+//------------------------------------------------------------------------------
+void TestUnorderedMap::Erase() const
+{
+    // empty
+    {
+        UnorderedMap<AString, AString> map;
+        TEST_ASSERT( map.Erase( AString( "thing" ) ) == false );
+    }
+
+    // not empty
+    {
+        UnorderedMap<AString, AString> map;
+        map.Insert( AString( "Hello" ), AString( "there" ) );
+        map.Insert( AString( "Key" ), AString( "Value" ) );
+
+        // not found
+        TEST_ASSERT( map.Erase( AString( "Thing" ) ) == false );
+        TEST_ASSERT( map.GetSize() == 2 );
+
+        // found
+        TEST_ASSERT( map.Erase( AString( "Hello" ) ) );
+        TEST_ASSERT( map.GetSize() == 1 );
+        TEST_ASSERT( map.Find( AString( "Hello" ) ) == nullptr );
+        TEST_ASSERT( map.Find( AString( "Key" ) ) );
+
+        // can be inserted again
+        map.Insert( AString( "Hello" ), AString( "again" ) );
+        TEST_ASSERT( map.Find( AString( "Hello" ) )->m_Value == "again" );
+    }
+}
+
 // Destruct
 //------------------------------------------------------------------------------
 void TestUnorderedMap::Destruct() const
@@ -30,6 +30,7 @@
     {
         char* getenv(const char * name);
         int32_t setenv(const char * name, const char * value, int32_t overwrite);
+        extern char ** environ;
     }
 #endif
 
@@ -39,6 +40,7 @@
     {
         int * _NSGetArgc( void );
         char *** _NSGetArgv( void );
+        char *** _NSGetEnviron( void );
     };
 #endif
 
@@ -236,6 +238,40 @@ Env::ProcessorInfo::ProcessorInfo()
     #endif
 }
 
+// GetEnvironment
+//------------------------------------------------------------------------------
+/*static*/ void Env::GetEnvironment( Array< AString > & outEnvironment )
+{
+    #if defined( __WINDOWS__ )
+        char * envBlock = ::GetEnvironmentStringsA();
+        if ( envBlock == nullptr )
+        {
+            return;
+        }
+        for ( const char * pos = envBlock; *pos; pos += ( AString::StrLen( pos ) + 1 ) )
+        {
+            // Skip per-drive working dirs (=C:=C:\...)
+            if ( *pos != '=' )
+            {
+                outEnvironment.EmplaceBack( pos );
+            }
+        }
+        ::FreeEnvironmentStringsA( envBlock );
+    #elif defined( __LINUX__ ) || defined( __APPLE__ )
+        #if defined( __APPLE__ )
+            const char * const * envVars = *_NSGetEnviron();
+        #else
+            const char * const * envVars = environ;
+        #endif
+        for ( ; envVars && *envVars; ++envVars )
+        {
+            outEnvironment.EmplaceBack( *envVars );
+        }
+    #else
+        #error Unknown platform
+    #endif
+}
+
 // SetEnvVariable
 //------------------------------------------------------------------------------
 /*static*/ bool Env::SetEnvVariable( const char * envVarName, const AString & envVarValue )
@@ -36,6 +36,7 @@
 #if defined( __LINUX__ )
     #include <fcntl.h>
     #include <sys/sendfile.h>
+    #include <sys/syscall.h>
 #endif
 #if defined( __APPLE__ )
     #include <copyfile.h>
@@ -425,6 +426,225 @@
     return false;
 }
 
+// GetDirectoryContents
+//------------------------------------------------------------------------------
+/*static*/ bool FileIO::GetDirectoryContents( const AString & path,
+                                              const Array< AString > * patterns,
+                                              bool followSymlink,
+                                              uint64_t & outLastWriteTime,
+                                              Array< FileInfo > & outFiles,
+                                              Array< AString > & outDirectories )
+{
+    AStackString<> pathCopy( path );
+    PathUtils::EnsureTrailingSlash( pathCopy );
+    const uint32_t baseLength = pathCopy.GetLength();
+
+    // Path without trailing slash (so symlinks are only followed if requested)
+    const AStackString<> dirPath( pathCopy.Get(), pathCopy.GetEnd() - ( ( baseLength > 1 ) ? 1 : 0 ) );
+
+    #if defined( __WINDOWS__ )
+        // Get time of dir itself
+        WIN32_FILE_ATTRIBUTE_DATA dirAttribs;
+        if ( ( GetFileAttributesEx( dirPath.Get(), GetFileExInfoStandard, &dirAttribs ) == FALSE ) ||
+             ( ( dirAttribs.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ) == 0 ) )
+        {
+            return false;
+        }
+        outLastWriteTime = (uint64_t)dirAttribs.ftLastWriteTime.dwLowDateTime | ( (uint64_t)dirAttribs.ftLastWriteTime.dwHighDateTime << 32 );
+
+        // Start dir list operation
+        pathCopy += '*'; // retrieve all files/folders
+        WIN32_FIND_DATA findData;
+        HANDLE hFind = FindFirstFileEx( pathCopy.Get(), FindExInfoBasic, &findData, FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH );
+        if ( hFind == INVALID_HANDLE_VALUE )
+        {
+            return false;
+        }
+        do
+        {
+            const char * const entryName = findData.cFileName;
+            pathCopy.SetLength( baseLength );
+            if ( ( findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ) == FILE_ATTRIBUTE_DIRECTORY )
+            {
+                // ignore magic '.' and '..' folders
+                if ( ( entryName[ 0 ] == '.' ) &&
+                     ( ( entryName[ 1 ] == '.' ) || ( entryName[ 1 ] == 0 ) ) )
+                {
+                    continue;
+                }
+                pathCopy += entryName;
+                pathCopy += NATIVE_SLASH;
+                outDirectories.EmplaceBack( pathCopy );
+                continue;
+            }
+            if ( IsMatch( patterns, entryName ) == false )
+            {
+                continue;
+            }
+            FileInfo & fileInfo = outFiles.EmplaceBack();
+            fileInfo.m_Name = pathCopy;
+            fileInfo.m_Name += entryName;
+            fileInfo.m_Attributes = findData.dwFileAttributes;
+            fileInfo.m_LastWriteTime = (uint64_t)findData.ftLastWriteTime.dwLowDateTime | ( (uint64_t)findData.ftLastWriteTime.dwHighDateTime << 32 );
+            fileInfo.m_Size = (uint64_t)findData.nFileSizeLow | ( (uint64_t)findData.nFileSizeHigh << 32 );
+        }
+        while ( FindNextFile( hFind, &findData ) != 0 );
+        FindClose( hFind );
+        return true;
+    #elif defined( __LINUX__ )
+        // Open dir, failing for symlinks unless they should be followed
+        const int dirFd = open( dirPath.Get(), O_RDONLY | O_DIRECTORY | O_CLOEXEC | ( followSymlink ? 0 : O_NOFOLLOW ) );
+        if ( dirFd == -1 )
+        {
+            return false;
+        }
+
+        // Get time of dir itself
+        struct stat info;
+        if ( fstat( dirFd, &info ) != 0 )
+        {
+            close( dirFd );
+            return false;
+        }
+        outLastWriteTime = ( ( (uint64_t)info.st_mtim.tv_sec * 1000000000ULL ) + (uint64_t)info.st_mtim.tv_nsec );
+
+        // Retrieve entries in large batches directly from the kernel, and stat
+        // files relative to the open dir to avoid repeated path resolution
+        struct LinuxDirEnt64
+        {
+            uint64_t        d_ino;
+            int64_t         d_off;
+            unsigned short  d_reclen;
+            unsigned char   d_type;
+            char            d_name[ 1 ]; // Variable length
+        };
+        const size_t kBufferSize = ( 64 * 1024 );
+        UniquePtr< char, FreeDeletor > buffer( static_cast< char * >( ALLOC( kBufferSize ) ) );
+        for ( ;; )
+        {
+            const long numBytes = syscall( SYS_getdents64, dirFd, buffer.Get(), kBufferSize );
+            if ( numBytes <= 0 )
+            {
+                break; // no more entries (or error)
+            }
+            for ( long offset = 0; offset < numBytes; )
+            {
+                const LinuxDirEnt64 * entry = reinterpret_cast< const LinuxDirEnt64 * >( buffer.Get() + offset );
+                offset += entry->d_reclen;
+                const char * const entryName = entry->d_name;
+
+                // Not all filesystems have support for returning the file type in
+                // d_type and applications must properly handle a return of DT_UNKNOWN.
+                bool haveInfo = false;
+                bool isDir = ( entry->d_type == DT_DIR );
+                if ( entry->d_type == DT_UNKNOWN )
+                {
+                    if ( fstatat( dirFd, entryName, &info, AT_SYMLINK_NOFOLLOW ) != 0 )
+                    {
+                        continue; // deleted since being listed
+                    }
+                    haveInfo = true;
+                    isDir = S_ISDIR( info.st_mode );
+                }
+
+                pathCopy.SetLength( baseLength );
+                if ( isDir )
+                {
+                    // ignore magic '.' and '..' folders
+                    if ( ( entryName[ 0 ] == '.' ) &&
+                         ( ( entryName[ 1 ] == '.' ) || ( entryName[ 1 ] == 0 ) ) )
+                    {
+                        continue;
+                    }
+                    pathCopy += entryName;
+                    pathCopy += NATIVE_SLASH;
+                    outDirectories.EmplaceBack( pathCopy );
+                    continue;
+                }
+                if ( IsMatch( patterns, entryName ) == false )
+                {
+                    continue;
+                }
+                if ( ( haveInfo == false ) && ( fstatat( dirFd, entryName, &info, AT_SYMLINK_NOFOLLOW ) != 0 ) )
+                {
+                    continue; // deleted since being listed
+                }
+                FileInfo & fileInfo = outFiles.EmplaceBack();
+                fileInfo.m_Name = pathCopy;
+                fileInfo.m_Name += entryName;
+                fileInfo.m_Attributes = info.st_mode;
+                fileInfo.m_LastWriteTime = ( ( (uint64_t)info.st_mtim.tv_sec * 1000000000ULL ) + (uint64_t)info.st_mtim.tv_nsec );
+                fileInfo.m_Size = static_cast<uint64_t>( info.st_size );
+            }
+        }
+        close( dirFd );
+        return true;
+    #elif defined( __APPLE__ )
+        // Get time of dir itself, failing for symlinks unless they should be followed
+        struct stat info;
+        const int statResult = followSymlink ? stat( dirPath.Get(), &info ) : lstat( dirPath.Get(), &info );
+        if ( ( statResult != 0 ) || ( S_ISDIR( info.st_mode ) == false ) )
+        {
+            return false;
+        }
+        outLastWriteTime = ( ( (uint64_t)info.st_mtimespec.tv_sec * 1000000000ULL ) + (uint64_t)info.st_mtimespec.tv_nsec );
+
+        DIR * dir = opendir( pathCopy.Get() );
+        if ( dir == nullptr )
+        {
+            return false;
+        }
+        for ( ;; )
+        {
+            const dirent * entry = readdir( dir );
+            if ( entry == nullptr )
+            {
+                break; // no more entries
+            }
+            const char * const entryName = entry->d_name;
+            pathCopy.SetLength( baseLength );
+            pathCopy += entryName;
+
+            bool isDir = ( entry->d_type == DT_DIR );
+            if ( entry->d_type == DT_UNKNOWN )
+            {
+                if ( lstat( pathCopy.Get(), &info ) != 0 )
+                {
+                    continue; // deleted since being listed
+                }
+                isDir = S_ISDIR( info.st_mode );
+            }
+
+            if ( isDir )
+            {
+                // ignore magic '.' and '..' folders
+                if ( ( entryName[ 0 ] == '.' ) &&
+                     ( ( entryName[ 1 ] == '.' ) || ( entryName[ 1 ] == 0 ) ) )
+                {
+                    continue;
+                }
+                pathCopy += NATIVE_SLASH;
+                outDirectories.EmplaceBack( pathCopy );
+                continue;
+            }
+            if ( ( IsMatch( patterns, entryName ) == false ) ||
+                 ( lstat( pathCopy.Get(), &info ) != 0 ) )
+            {
+                continue;
+            }
+            FileInfo & fileInfo = outFiles.EmplaceBack();
+            fileInfo.m_Name = pathCopy;
+            fileInfo.m_Attributes = info.st_mode;
+            fileInfo.m_LastWriteTime = ( ( (uint64_t)info.st_mtimespec.tv_sec * 1000000000ULL ) + (uint64_t)info.st_mtimespec.tv_nsec );
+            fileInfo.m_Size = static_cast<uint64_t>( info.st_size );
+        }
+        closedir( dir );
+        return true;
+    #else
+        #error Unknown platform
+    #endif
+}
+
 // GetCurrentDir
 //------------------------------------------------------------------------------
 /*static*/ bool FileIO::GetCurrentDir( AString & output )
@@ -822,13 +1042,13 @@
 /*static*/ bool FileIO::SetFileLastWriteTime( const AString & fileName, uint64_t fileTime )
 {
     #if defined( __WINDOWS__ )
-        // open the file
+        // open the file (or directory)
         HANDLE hFile = CreateFile( fileName.Get(),
                                    FILE_WRITE_ATTRIBUTES,
                                    FILE_SHARE_READ | FILE_SHARE_WRITE,
                                    nullptr,
                                    OPEN_EXISTING,
-                                   0,
+                                   FILE_FLAG_BACKUP_SEMANTICS,
                                    nullptr);
         if ( hFile == INVALID_HANDLE_VALUE )
         {
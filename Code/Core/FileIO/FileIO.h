@@ -49,6 +49,20 @@ public:
                             Array< FileInfo > * results );
     static bool GetFileInfo( const AString & fileName, FileInfo & info );
 
+    // Read the immediate contents of a single directory
+    //  - files matching the patterns are returned (full path) with their info
+    //  - all sub-directories are returned (full path, with trailing slash)
+    //  - the last write time of the directory itself changes when entries are
+    //    added, removed or renamed (but not when the contents of files change)
+    //  - returns false if the directory can't be read, or is a symlink (unless
+    //    followSymlink is set, as for the root of a recursive listing)
+    static bool GetDirectoryContents( const AString & path,
+                                      const Array< AString > * patterns,
+                                      bool followSymlink,
+                                      uint64_t & outLastWriteTime,
+                                      Array< FileInfo > & outFiles,
+                                      Array< AString > & outDirectories );
+
     static bool GetCurrentDir( AString & output );
     static bool SetCurrentDir( const AString & dir );
     static bool GetTempDir( AString & output );
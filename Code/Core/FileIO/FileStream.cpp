@@ -14,6 +14,7 @@
 #include <stdio.h>
 #if defined( __WINDOWS__ )
     #include "Core/Env/WindowsHeader.h"
+    #include <sddl.h> // for ConvertStringSecurityDescriptorToSecurityDescriptorA
 #else
     #include <fcntl.h>
     #include <sys/stat.h>
@@ -93,6 +94,17 @@ bool FileStream::Open( const char * fileName, uint32_t fileMode )
             flags |= FILE_ATTRIBUTE_TEMPORARY; // don't flush to disk if possible
         }
 
+        // restrict access to the owner (ignored if the file already exists)
+        SECURITY_ATTRIBUTES securityAttributes = { sizeof( SECURITY_ATTRIBUTES ), nullptr, FALSE };
+        if ( ( fileMode & OWNER_ONLY ) != 0 )
+        {
+            // Protected DACL with full access for the owner only
+            if ( !ConvertStringSecurityDescriptorToSecurityDescriptorA( "D:P(A;;FA;;;OW)", SDDL_REVISION_1, &securityAttributes.lpSecurityDescriptor, nullptr ) )
+            {
+                return false;
+            }
+        }
+
         // for sharing violations, we'll retry a few times as per http://support.microsoft.com/kb/316609
         size_t retryCount = 0;
         while ( retryCount < 5 )
@@ -100,16 +112,15 @@ bool FileStream::Open( const char * fileName, uint32_t fileMode )
             HANDLE h = CreateFile( fileName,            // _In_     LPCTSTR lpFileName,
                                    desiredAccess,       // _In_     DWORD dwDesiredAccess,
                                    shareMode,           // _In_     DWORD dwShareMode,
-                                   nullptr,             // _In_opt_ LPSECURITY_ATTRIBUTES lpSecurityAttributes,
+                                   securityAttributes.lpSecurityDescriptor ? &securityAttributes : nullptr, // _In_opt_ LPSECURITY_ATTRIBUTES lpSecurityAttributes,
                                    creationDisposition, // _In_     DWORD dwCreationDisposition,
                                    flags,               // _In_     DWORD dwFlagsAndAttributes,
                                    nullptr );           // _In_opt_ HANDLE hTemplateFile
 
             if ( h != INVALID_HANDLE_VALUE )
             {
-                // file opened ok
                 m_Handle = (void *)h;
-                return true;
+                break;
             }
 
             // problem opening file...
@@ -130,6 +141,15 @@ bool FileStream::Open( const char * fileName, uint32_t fileMode )
             // some other kind of error...
             break;
         }
+        if ( securityAttributes.lpSecurityDescriptor )
+        {
+            LocalFree( securityAttributes.lpSecurityDescriptor );
+        }
+        if ( m_Handle != (void *)INVALID_HANDLE_VALUE )
+        {
+            // file opened ok
+            return true;
+        }
     #elif defined( __APPLE__ ) || defined( __LINUX__ )
         // Flags
         int32_t flags = O_CLOEXEC; // Ensure handles are not inherited by child processes
@@ -156,6 +176,10 @@ bool FileStream::Open( const char * fileName, uint32_t fileMode )
         {
             // hint flag - unsupported (we don't want the behaviour of O_TMPFILE)
         }
+        if ( ( fileMode & OWNER_ONLY ) != 0 )
+        {
+            mode = ( S_IRUSR | S_IWUSR );
+        }
 
         m_Handle = open( fileName, flags, mode );
         if ( m_Handle != INVALID_HANDLE_VALUE )
@@ -169,6 +193,14 @@ bool FileStream::Open( const char * fileName, uint32_t fileMode )
 
                 // fall through to setting INVALID_HANDLE_VALUE
             }
+            else if ( ( ( fileMode & OWNER_ONLY ) != 0 ) &&
+                      ( fchmod( m_Handle, S_IRUSR | S_IWUSR ) != 0 ) )
+            {
+                // file already existed and can't be restricted to the owner
+                close( m_Handle );
+
+                // fall through to setting INVALID_HANDLE_VALUE
+            }
             else
             {
                 // file opened ok
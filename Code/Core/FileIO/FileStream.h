@@ -19,6 +19,7 @@ public:
         WRITE_ONLY                    = 0x2,
         OPEN_OR_CREATE_READ_WRITE     = 0x4,
         TEMP                          = 0x8,
+        OWNER_ONLY                    = 0x10, // Created file is only accessible by the current user
         NO_RETRY_ON_SHARING_VIOLATION = 0x80,
     };
 
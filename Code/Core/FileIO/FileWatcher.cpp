@@ -0,0 +1,197 @@
+// FileWatcher.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "FileWatcher.h"
+
+// Core
+#include "Core/Env/Assert.h"
+#include "Core/FileIO/PathUtils.h"
+#include "Core/Profile/Profile.h"
+#include "Core/Strings/AStackString.h"
+
+// system
+#if defined( __LINUX__ )
+    #include <errno.h>
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
+
+// Defines
+//------------------------------------------------------------------------------
+#if defined( __LINUX__ )
+    #define FILE_WATCHER_EVENTS ( IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | \
+                                  IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | \
+                                  IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR )
+#endif
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+FileWatcher::FileWatcher()
+{
+    #if defined( __LINUX__ )
+        m_Handle = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+    #endif
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+FileWatcher::~FileWatcher()
+{
+    #if defined( __LINUX__ )
+        if ( m_Handle >= 0 )
+        {
+            VERIFY( close( m_Handle ) == 0 );
+        }
+    #endif
+}
+
+// WatchDirectory
+//------------------------------------------------------------------------------
+bool FileWatcher::WatchDirectory( const AString & path )
+{
+    #if defined( __LINUX__ )
+        if ( m_Handle < 0 )
+        {
+            return false;
+        }
+
+        // Paths are stored without a trailing slash
+        AStackString<> dir( path );
+        if ( dir.EndsWith( NATIVE_SLASH ) && ( dir.GetLength() > 1 ) )
+        {
+            dir.SetLength( dir.GetLength() - 1 );
+        }
+
+        if ( m_WatchedDirs.Find( dir ) )
+        {
+            return true; // Already watched
+        }
+
+        const int wd = inotify_add_watch( m_Handle, dir.Get(), FILE_WATCHER_EVENTS );
+        if ( wd < 0 )
+        {
+            return false; // Directory doesn't exist, or watch limit reached
+        }
+
+        // The same directory reached via a different path (i.e. a symlink)
+        // would report events using the original path only
+        if ( ( (size_t)wd < m_WatchDescriptorPaths.GetSize() ) &&
+             ( m_WatchDescriptorPaths[ (size_t)wd ].IsEmpty() == false ) )
+        {
+            return false;
+        }
+
+        while ( m_WatchDescriptorPaths.GetSize() <= (size_t)wd )
+        {
+            m_WatchDescriptorPaths.EmplaceBack();
+        }
+        m_WatchDescriptorPaths[ (size_t)wd ] = dir;
+        m_WatchedDirs.Insert( dir, wd );
+        return true;
+    #else
+        (void)path;
+        return false;
+    #endif
+}
+
+// IsWatched
+//------------------------------------------------------------------------------
+bool FileWatcher::IsWatched( const AString & path )
+{
+    #if defined( __LINUX__ )
+        AStackString<> dir( path );
+        if ( dir.EndsWith( NATIVE_SLASH ) && ( dir.GetLength() > 1 ) )
+        {
+            dir.SetLength( dir.GetLength() - 1 );
+        }
+        return ( m_WatchedDirs.Find( dir ) != nullptr );
+    #else
+        (void)path;
+        return false;
+    #endif
+}
+
+// GetChanges
+//------------------------------------------------------------------------------
+bool FileWatcher::GetChanges( Array< AString > & outChangedFiles )
+{
+    PROFILE_FUNCTION;
+
+    #if defined( __LINUX__ )
+        if ( m_Handle < 0 )
+        {
+            return true; // Nothing can be watched, so nothing can be missed
+        }
+
+        bool complete = true;
+        alignas( struct inotify_event ) char buffer[ 64 * 1024 ];
+        for ( ;; )
+        {
+            const ssize_t bytesRead = read( m_Handle, buffer, sizeof( buffer ) );
+            if ( bytesRead <= 0 )
+            {
+                // EAGAIN indicates all pending events have been consumed
+                if ( ( bytesRead < 0 ) && ( errno != EAGAIN ) && ( errno != EINTR ) )
+                {
+                    complete = false;
+                }
+                break;
+            }
+
+            const char * pos = buffer;
+            const char * const end = ( buffer + bytesRead );
+            while ( pos < end )
+            {
+                const struct inotify_event * event = reinterpret_cast< const struct inotify_event * >( pos );
+                pos += sizeof( struct inotify_event ) + event->len;
+
+                // Events which invalidate our knowledge of entire directories
+                if ( event->mask & ( IN_Q_OVERFLOW | IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF ) )
+                {
+                    complete = false;
+                    continue;
+                }
+
+                if ( ( event->len == 0 ) ||
+                     ( event->wd < 0 ) ||
+                     ( (size_t)event->wd >= m_WatchDescriptorPaths.GetSize() ) )
+                {
+                    continue;
+                }
+
+                AString & changedFile = outChangedFiles.EmplaceBack( m_WatchDescriptorPaths[ (size_t)event->wd ] );
+                changedFile += NATIVE_SLASH;
+                changedFile += event->name;
+            }
+        }
+
+        if ( complete == false )
+        {
+            Reset();
+        }
+        return complete;
+    #else
+        (void)outChangedFiles;
+        return true;
+    #endif
+}
+
+// Reset
+//------------------------------------------------------------------------------
+void FileWatcher::Reset()
+{
+    #if defined( __LINUX__ )
+        // Discard all watches (and any pending events) by starting again
+        if ( m_Handle >= 0 )
+        {
+            VERIFY( close( m_Handle ) == 0 );
+        }
+        m_Handle = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+        m_WatchedDirs.Destruct();
+        m_WatchDescriptorPaths.Clear();
+    #endif
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,43 @@
+// FileWatcher.h
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Core/Containers/Array.h"
+#include "Core/Containers/UnorderedMap.h"
+#include "Core/Strings/AString.h"
+
+// FileWatcher
+//  - Reports changes to files within a set of watched directories
+//  - Directories are watched non-recursively
+//  - Only supported on Linux (inotify). On other platforms no directories can
+//    be watched and callers must fall back to checking files directly.
+//------------------------------------------------------------------------------
+class FileWatcher
+{
+public:
+    FileWatcher();
+    ~FileWatcher();
+
+    // Start watching a directory. Returns true if the directory is (now) watched
+    bool WatchDirectory( const AString & path );
+    bool IsWatched( const AString & path );
+
+    // Retrieve the files which have changed since the previous call.
+    // Returns false if changes may have been missed (event queue overflow or
+    // removal of a watched directory), in which case the caller must assume
+    // any file may have changed. All watches are discarded in that case.
+    bool GetChanges( Array< AString > & outChangedFiles );
+
+private:
+    void Reset();
+
+    #if defined( __LINUX__ )
+        int                             m_Handle = -1;
+        UnorderedMap< AString, int >    m_WatchedDirs;          // Path -> watch descriptor
+        Array< AString >                m_WatchDescriptorPaths; // Watch descriptor -> path
+    #endif
+};
+
+//------------------------------------------------------------------------------
@@ -3,9 +3,20 @@
 
 // Includes
 //------------------------------------------------------------------------------
+#if defined( __WINDOWS__ )
+    #define _CRT_RAND_S // for rand_s (must precede all includes of stdlib.h)
+#endif
 #include "Random.h"
 
+// system
 #include <time.h>
+#if defined( __WINDOWS__ )
+    #include <stdlib.h>
+    #include <string.h> // for memcpy
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
 
 // CONSTRUCTOR
 //------------------------------------------------------------------------------
@@ -24,4 +35,48 @@ uint32_t Random::GetRand()
     return( (uint32_t)( m_Seed / ( ( CORE_RAND_MAX + 1 ) * 2 ) ) % ( CORE_RAND_MAX + 1 ) );
 }
 
+// GetSecureRandomBytes
+//------------------------------------------------------------------------------
+/*static*/ bool Random::GetSecureRandomBytes( void * buffer, size_t size )
+{
+    #if defined( __WINDOWS__ )
+        char * pos = static_cast< char * >( buffer );
+        while ( size > 0 )
+        {
+            unsigned int value;
+            if ( rand_s( &value ) != 0 )
+            {
+                return false;
+            }
+            const size_t bytes = ( size < sizeof( value ) ) ? size : sizeof( value );
+            memcpy( pos, &value, bytes );
+            pos += bytes;
+            size -= bytes;
+        }
+        return true;
+    #elif defined( __APPLE__ ) || defined( __LINUX__ )
+        const int handle = open( "/dev/urandom", O_RDONLY | O_CLOEXEC );
+        if ( handle < 0 )
+        {
+            return false;
+        }
+        char * pos = static_cast< char * >( buffer );
+        while ( size > 0 )
+        {
+            const ssize_t bytes = read( handle, pos, size );
+            if ( bytes <= 0 )
+            {
+                close( handle );
+                return false;
+            }
+            pos += bytes;
+            size -= static_cast< size_t >( bytes );
+        }
+        close( handle );
+        return true;
+    #else
+        #error Unknown platform
+    #endif
+}
+
 //------------------------------------------------------------------------------
@@ -34,6 +34,10 @@ public:
         return ( (uint32_t)( (float)size * ( (float)GetRand() / (float)( CORE_RAND_MAX + 1 ) ) ) );
     }
 
+    // fill a buffer from the OS's cryptographically secure random source
+    // (for secrets, unlike the values above)
+    static bool GetSecureRandomBytes( void * buffer, size_t size );
+
     // access the seed value
     inline void     SetSeed( uint32_t seed ) { m_Seed = seed; }
     inline uint32_t GetSeed() const { return m_Seed; }
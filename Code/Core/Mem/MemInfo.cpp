@@ -6,6 +6,10 @@
 
 // Core
 #include "Core/Env/Assert.h"
+#if defined( __LINUX__ )
+    #include "Core/FileIO/FileStream.h"
+    #include "Core/Strings/AStackString.h"
+#endif
 #if defined( __WINDOWS__ )
     #include "Core/Env/WindowsHeader.h" // Must be before Psapi.h
 #endif
@@ -61,8 +65,45 @@
 
     // Physical free memory
     outInfo.mAvailPhysMiB = ConvertBytesToMiB( physAvailPages * pageSize );
+
+    #if defined( __LINUX__ )
+        // _SC_AVPHYS_PAGES excludes reclaimable memory (i.e. the page cache)
+        // and so greatly underestimates what is available after doing some
+        // file IO. Use the kernel's estimate where supported (3.14+)
+        uint32_t availKiB;
+        if ( GetLinuxMemAvailableKiB( availKiB ) )
+        {
+            outInfo.mAvailPhysMiB = ( availKiB / 1024 );
+        }
+    #endif
 }
 
+// GetLinuxMemAvailableKiB
+//------------------------------------------------------------------------------
+#if defined( __LINUX__ )
+    /*static*/ bool MemInfo::GetLinuxMemAvailableKiB( uint32_t & outAvailKiB )
+    {
+        FileStream f;
+        if ( f.Open( "/proc/meminfo", FileStream::READ_ONLY ) == false )
+        {
+            return false;
+        }
+
+        // MemAvailable is near the start of the file
+        AStackString< 1024 > buffer;
+        buffer.SetLength( 1023 );
+        const uint32_t len = static_cast<uint32_t>( f.ReadBuffer( buffer.Get(), buffer.GetLength() ) );
+        buffer.SetLength( len );
+
+        const char * memAvailable = buffer.Find( "MemAvailable:" );
+        if ( memAvailable == nullptr )
+        {
+            return false; // Older kernel
+        }
+        return ( AString::ScanS( memAvailable, "MemAvailable: %u kB", &outAvailKiB ) == 1 );
+    }
+#endif
+
 //------------------------------------------------------------------------------
 /*static*/ uint32_t MemInfo::ConvertBytesToMiB( uint64_t bytes )
 {
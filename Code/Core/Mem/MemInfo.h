@@ -27,6 +27,9 @@ public:
 protected:
     // Internal helpers
     static uint32_t    ConvertBytesToMiB( uint64_t bytes );
+    #if defined( __LINUX__ )
+        static bool    GetLinuxMemAvailableKiB( uint32_t & outAvailKiB );
+    #endif
 };
 
 //------------------------------------------------------------------------------
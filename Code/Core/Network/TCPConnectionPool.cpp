@@ -149,6 +149,7 @@ TCPConnectionPool::TCPConnectionPool()
     : m_ListenConnection( nullptr )
     , m_Connections( 8 )
     , m_ShuttingDown( false )
+    , m_RawMode( false )
 {
 }
 
@@ -211,7 +212,7 @@ void TCPConnectionPool::ShutdownAllConnections()
 
 // Listen
 //------------------------------------------------------------------------------
-bool TCPConnectionPool::Listen( uint16_t port )
+bool TCPConnectionPool::Listen( uint16_t port, bool loopbackOnly )
 {
     // must not be listening already
     ASSERT( m_ListenConnection == nullptr );
@@ -233,7 +234,7 @@ bool TCPConnectionPool::Listen( uint16_t port )
     memset( &addrInfo, 0, sizeof( addrInfo ) );
     addrInfo.sin_family = AF_INET;
     addrInfo.sin_port = htons( port );
-    addrInfo.sin_addr.s_addr = INADDR_ANY;
+    addrInfo.sin_addr.s_addr = loopbackOnly ? htonl( INADDR_LOOPBACK ) : INADDR_ANY; // Loopback: Accept local connections only
 
     // bind
     if ( bind( sockfd, (struct sockaddr *)&addrInfo, sizeof( addrInfo ) ) != 0 )
@@ -645,6 +646,19 @@ bool TCPConnectionPool::SendInternal( const ConnectionInfo * connection, const T
     return sendOK;
 }
 
+// SendRaw
+//------------------------------------------------------------------------------
+bool TCPConnectionPool::SendRaw( const ConnectionInfo * connection, const void * data, size_t size, uint32_t timeoutMS )
+{
+    ASSERT( m_RawMode );
+
+    SendBuffer buffer; // data only
+    buffer.size = (uint32_t)size;
+    buffer.data = data;
+
+    return SendInternal( connection, &buffer, 1, timeoutMS );
+}
+
 // Broadcast
 //------------------------------------------------------------------------------
 bool TCPConnectionPool::Broadcast( const void * data, size_t size )
@@ -680,6 +694,11 @@ bool TCPConnectionPool::HandleRead( ConnectionInfo * ci )
 {
     PROFILE_FUNCTION;
 
+    if ( m_RawMode )
+    {
+        return HandleReadRaw( ci );
+    }
+
     // work out how many bytes there are
     uint32_t size( 0 );
     uint32_t bytesToRead = 4;
@@ -756,6 +775,57 @@ bool TCPConnectionPool::HandleRead( ConnectionInfo * ci )
     return true;
 }
 
+// HandleReadRaw
+//------------------------------------------------------------------------------
+bool TCPConnectionPool::HandleReadRaw( ConnectionInfo * ci )
+{
+    // read whatever is available, without any framing
+    const uint32_t bufferSize = 4096;
+    void * buffer = AllocBuffer( bufferSize );
+    ASSERT( buffer );
+
+    int numBytes;
+    for ( ;; )
+    {
+        #if defined( __WINDOWS__ )
+            numBytes = (int)recv( ci->m_Socket, (char *)buffer, (int32_t)bufferSize, 0 );
+        #else
+            numBytes = (int)recv( ci->m_Socket, buffer, static_cast<size_t>( bufferSize ), 0 );
+        #endif
+        if ( numBytes > 0 )
+        {
+            break;
+        }
+        if ( ( numBytes < 0 ) && WouldBlock() )
+        {
+            if ( ci->m_ThreadQuitNotification.Load() || AtomicLoadRelaxed( &m_ShuttingDown ) )
+            {
+                FreeBuffer( buffer );
+                return false;
+            }
+
+            Thread::Sleep( 1 );
+            continue;
+        }
+        // error or graceful close by remote end
+        TCPDEBUG( "recv() failed (C). Error: %s (Read: %i, Socket: %x)\n", LAST_NETWORK_ERROR_STR, numBytes, (uint32_t)( ci->m_Socket ) );
+        FreeBuffer( buffer );
+        return false;
+    }
+
+    TCPDEBUG( "Handle read raw: %i (%x)\n", numBytes, (uint32_t)( ci->m_Socket ) );
+
+    // tell user the data is in their buffer
+    bool keepMemory = false;
+    OnReceive( ci, buffer, (uint32_t)numBytes, keepMemory );
+    if ( !keepMemory )
+    {
+        FreeBuffer( buffer );
+    }
+
+    return true;
+}
+
 // GetLastNetworkError
 //------------------------------------------------------------------------------
 int TCPConnectionPool::GetLastNetworkError() const
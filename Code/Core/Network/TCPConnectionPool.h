@@ -74,7 +74,7 @@ public:
     void ShutdownAllConnections();
 
     // manage connections
-    bool Listen( uint16_t port );
+    bool Listen( uint16_t port, bool loopbackOnly = false );
     void StopListening();
     const ConnectionInfo * Connect( const AString & host,
                                     uint16_t port,
@@ -87,6 +87,11 @@ public:
     void Disconnect( const ConnectionInfo * ci );
     void SetShuttingDown();
 
+    // Raw mode exchanges unframed data, for interoperability with other
+    // protocols (such as HTTP). OnReceive is called with data as it arrives.
+    // Must be set before listening or connecting.
+    void SetRawMode( bool rawMode ) { m_RawMode = rawMode; }
+
     // query connection state
     size_t GetNumConnections() const;
 
@@ -102,6 +107,10 @@ public:
                size_t payloadSize,
                uint32_t timeoutMS = kDefaultSendTimeoutMS );
     bool Broadcast( const void * data, size_t size );
+    bool SendRaw( const ConnectionInfo * connection,
+                  const void * data,
+                  size_t size,
+                  uint32_t timeoutMS = kDefaultSendTimeoutMS );
 
     static void GetAddressAsString( uint32_t addr, AString & address );
 
@@ -118,6 +127,7 @@ protected:
 private:
     // helper functions
     bool        HandleRead( ConnectionInfo * ci );
+    bool        HandleReadRaw( ConnectionInfo * ci );
 
     // platform specific abstraction
     int         GetLastNetworkError() const;
@@ -164,6 +174,7 @@ private:
     Array< ConnectionInfo * >   m_Connections;
 
     bool                        m_ShuttingDown;
+    bool                        m_RawMode;
     Semaphore                   m_ShutdownSemaphore;
 
     // object to manage network subsystem lifetime
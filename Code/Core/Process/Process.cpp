@@ -7,7 +7,9 @@
 
 #if !defined( __APPLE__ ) || !defined( APPLE_PROCESS_USE_NSTASK )
 
+#include "Core/Containers/Array.h"
 #include "Core/Env/Assert.h"
+#include "Core/Env/Env.h"
 #include "Core/FileIO/FileIO.h"
 #include "Core/Math/Conversions.h"
 #include "Core/Process/Atomic.h"
@@ -21,15 +23,18 @@
 #if defined( __WINDOWS__ )
     #include "Core/Env/WindowsHeader.h"
     #include <TlHelp32.h>
+    #include <Psapi.h>
 #endif
 
 #if defined( __LINUX__ ) || defined( __APPLE__ )
     #include <errno.h>
     #include <fcntl.h>
+    #include <limits.h>
     #include <signal.h>
     #include <stdio.h>
     #include <stdlib.h>
     #include <string.h>
+    #include <sys/resource.h>
     #include <sys/wait.h>
     #include <unistd.h>
     #include <wordexp.h>
@@ -339,6 +344,14 @@ bool Process::Spawn( const char * executable,
         }
         envVector.Append( nullptr ); // env must be terminated with a nullptr
 
+        #if defined( __LINUX__ )
+            // Note our memory use, which the child inherits until it calls exec
+            // (see RecordResourceUsage)
+            m_SpawnMemoryKiB = ReadMemoryStatusKiB( "/proc/self/status", "VmRSS:" );
+            m_SampledPeakMemoryKiB = 0;
+            m_ChildHasExeced = false;
+        #endif
+
         // fork the process
         const pid_t childProcessPid = fork();
         if ( childProcessPid == -1 )
@@ -429,9 +442,21 @@ bool Process::IsRunning() const
             return false;
         }
 
+        #if defined( __LINUX__ )
+            // Check for exit without reaping the process, so its I/O can be read
+            siginfo_t info;
+            info.si_pid = 0;
+            if ( ( waitid( P_PID, (id_t)m_ChildPID, &info, WEXITED | WNOHANG | WNOWAIT ) == 0 ) && ( info.si_pid == 0 ) )
+            {
+                return true; // Still running
+            }
+            ReadIOCounters();
+        #endif
+
         // non-blocking "wait"
         int status( -1 );
-        pid_t result = waitpid( m_ChildPID, &status, WNOHANG );
+        struct rusage usage;
+        pid_t result = wait4( m_ChildPID, &status, WNOHANG, &usage );
         ASSERT ( result != -1 ); // usage error
         if ( result == 0 )
         {
@@ -457,6 +482,7 @@ bool Process::IsRunning() const
             m_ReturnStatus = status; // some other unexpected state change, treat it as a failure
         }
         m_HasAlreadyWaitTerminated = true;
+        RecordResourceUsage( usage );
         return false; // no longer running
     #else
         #error Unknown platform
@@ -486,6 +512,29 @@ int32_t Process::WaitForExit()
 
             // get the result code
             VERIFY( GetExitCodeProcess( GetProcessInfo().hProcess, (LPDWORD)&exitCode ) );
+
+            // get the resource usage
+            m_ResourceUsage.m_NumProcesses = 1;
+            PROCESS_MEMORY_COUNTERS counters;
+            if ( GetProcessMemoryInfo( GetProcessInfo().hProcess, &counters, sizeof( counters ) ) )
+            {
+                m_ResourceUsage.m_PeakMemoryMiB = static_cast<uint32_t>( counters.PeakWorkingSetSize / ( 1024 * 1024 ) );
+            }
+            FILETIME creationTime, exitTime, kernelTime, userTime;
+            if ( GetProcessTimes( GetProcessInfo().hProcess, &creationTime, &exitTime, &kernelTime, &userTime ) )
+            {
+                // FILETIME is in 100ns units
+                const uint64_t kernel100ns = ( ( (uint64_t)kernelTime.dwHighDateTime << 32 ) | kernelTime.dwLowDateTime );
+                const uint64_t user100ns = ( ( (uint64_t)userTime.dwHighDateTime << 32 ) | userTime.dwLowDateTime );
+                m_ResourceUsage.m_SystemTimeMS = static_cast<uint32_t>( kernel100ns / 10000 );
+                m_ResourceUsage.m_UserTimeMS = static_cast<uint32_t>( user100ns / 10000 );
+            }
+            IO_COUNTERS ioCounters;
+            if ( GetProcessIoCounters( GetProcessInfo().hProcess, &ioCounters ) )
+            {
+                m_ResourceUsage.m_ReadBytes = ioCounters.ReadTransferCount;
+                m_ResourceUsage.m_WriteBytes = ioCounters.WriteTransferCount;
+            }
         }
 
         // cleanup
@@ -501,10 +550,20 @@ int32_t Process::WaitForExit()
         VERIFY( close( m_StdErrRead ) == 0 );
         if ( m_HasAlreadyWaitTerminated == false )
         {
+            #if defined( __LINUX__ )
+                // Wait for exit without reaping the process, so its I/O can be read
+                siginfo_t info;
+                while ( ( waitid( P_PID, (id_t)m_ChildPID, &info, WEXITED | WNOWAIT ) == -1 ) && ( errno == EINTR ) )
+                {
+                }
+                ReadIOCounters();
+            #endif
+
             int status;
+            struct rusage usage;
             for( ;; )
             {
-                pid_t ret = waitpid( m_ChildPID, &status, 0 );
+                pid_t ret = wait4( m_ChildPID, &status, 0, &usage );
                 if ( ret == -1 )
                 {
                     if ( errno == EINTR )
@@ -532,6 +591,7 @@ int32_t Process::WaitForExit()
                 }
                 break;
             }
+            RecordResourceUsage( usage );
         }
 
         return m_ReturnStatus;
@@ -540,6 +600,190 @@ int32_t Process::WaitForExit()
     #endif
 }
 
+// RecordResourceUsage
+//------------------------------------------------------------------------------
+#if defined( __LINUX__ ) || defined( __APPLE__ )
+    void Process::RecordResourceUsage( const struct rusage & usage ) const
+    {
+        // The usage includes any descendants of the process that have been
+        // waited on (i.e. the compiler proper when invoked via a driver)
+        #if defined( __APPLE__ )
+            const uint64_t peakBytes = static_cast<uint64_t>( usage.ru_maxrss ); // bytes
+        #else
+            // The peak also includes the memory inherited from this process
+            // before the child called exec, so is only reliable if larger.
+            // The peak of the process tree observed while the child was
+            // running is used as well, which is unknown (0) if the child
+            // exited before it could be sampled.
+            uint64_t peakKiB = m_SampledPeakMemoryKiB;
+            const uint64_t maxRSSKiB = static_cast<uint64_t>( usage.ru_maxrss ); // KiB
+            if ( maxRSSKiB > m_SpawnMemoryKiB )
+            {
+                peakKiB = Math::Max( peakKiB, maxRSSKiB );
+            }
+            const uint64_t peakBytes = ( peakKiB * 1024 );
+        #endif
+        m_ResourceUsage.m_NumProcesses = 1;
+        m_ResourceUsage.m_PeakMemoryMiB = static_cast<uint32_t>( ( peakBytes + ( 1024 * 1024 ) - 1 ) / ( 1024 * 1024 ) ); // Round up so small processes are non-zero
+        m_ResourceUsage.m_UserTimeMS = static_cast<uint32_t>( ( static_cast<uint64_t>( usage.ru_utime.tv_sec ) * 1000 ) + ( static_cast<uint64_t>( usage.ru_utime.tv_usec ) / 1000 ) );
+        m_ResourceUsage.m_SystemTimeMS = static_cast<uint32_t>( ( static_cast<uint64_t>( usage.ru_stime.tv_sec ) * 1000 ) + ( static_cast<uint64_t>( usage.ru_stime.tv_usec ) / 1000 ) );
+
+        // On Linux, I/O is recorded before the process is reaped (see ReadIOCounters)
+    }
+#endif
+
+// SamplePeakMemory
+//------------------------------------------------------------------------------
+#if defined( __LINUX__ )
+    void Process::SamplePeakMemory() const
+    {
+        // Until the child calls exec, its memory is inherited from this process
+        if ( m_ChildHasExeced == false )
+        {
+            AStackString<> childExe;
+            AStackString<> exeLink;
+            exeLink.Format( "/proc/%i/exe", m_ChildPID );
+            char path[ PATH_MAX ];
+            const ssize_t length = readlink( exeLink.Get(), path, PATH_MAX );
+            if ( length <= 0 )
+            {
+                return; // Process may have exited
+            }
+            childExe.Assign( path, path + length );
+            AStackString<> ourExe;
+            Env::GetExePath( ourExe );
+            if ( childExe == ourExe )
+            {
+                return;
+            }
+            m_ChildHasExeced = true;
+        }
+
+        // Sum the peaks of the child and its descendants, since the work is
+        // often done by a grandchild (i.e. the compiler proper, run by a driver)
+        // Processes started directly by a thread other than the main one are
+        // not found
+        StackArray< int, 32 > pids;
+        pids.Append( m_ChildPID );
+        uint64_t treePeakKiB = 0;
+        AStackString<> fileName;
+        for ( size_t i = 0; i < pids.GetSize(); ++i )
+        {
+            const int pid = pids[ i ];
+            fileName.Format( "/proc/%i/status", pid );
+            treePeakKiB += ReadMemoryStatusKiB( fileName.Get(), "VmHWM:" );
+
+            // Limit the cost of pathological process trees
+            if ( pids.GetSize() < 256 )
+            {
+                fileName.Format( "/proc/%i/task/%i/children", pid, pid );
+                ReadChildPIDs( fileName.Get(), pids );
+            }
+        }
+        m_SampledPeakMemoryKiB = Math::Max( m_SampledPeakMemoryKiB, treePeakKiB );
+    }
+#endif
+
+// ReadChildPIDs
+//------------------------------------------------------------------------------
+#if defined( __LINUX__ )
+    /*static*/ void Process::ReadChildPIDs( const char * childrenFileName, Array< int > & outPIDs )
+    {
+        const int fd = open( childrenFileName, O_RDONLY | O_CLOEXEC );
+        if ( fd == -1 )
+        {
+            return; // Process may have exited
+        }
+        char buffer[ 4096 ];
+        const ssize_t len = read( fd, buffer, sizeof( buffer ) - 1 );
+        VERIFY( close( fd ) == 0 );
+        if ( len <= 0 )
+        {
+            return;
+        }
+        buffer[ len ] = 0;
+
+        // Space separated list of pids
+        const char * pos = buffer;
+        for ( ;; )
+        {
+            char * end = nullptr;
+            const long pid = strtol( pos, &end, 10 );
+            if ( end == pos )
+            {
+                break;
+            }
+            outPIDs.Append( static_cast<int>( pid ) );
+            pos = end;
+        }
+    }
+#endif
+
+// ReadIOCounters
+//------------------------------------------------------------------------------
+#if defined( __LINUX__ )
+    void Process::ReadIOCounters() const
+    {
+        // The exited (but not yet reaped) process includes the I/O of any
+        // descendants it waited on. All reads and writes are counted,
+        // including those satisfied by the page cache and pipes
+        AStackString<> fileName;
+        fileName.Format( "/proc/%i/io", m_ChildPID );
+        m_ResourceUsage.m_ReadBytes = ReadProcFileValue( fileName.Get(), "rchar:" );
+        m_ResourceUsage.m_WriteBytes = ReadProcFileValue( fileName.Get(), "wchar:" );
+    }
+#endif
+
+// ReadMemoryStatusKiB
+//------------------------------------------------------------------------------
+#if defined( __LINUX__ )
+    /*static*/ uint64_t Process::ReadMemoryStatusKiB( const char * statusFileName, const char * field )
+    {
+        return ReadProcFileValue( statusFileName, field );
+    }
+#endif
+
+// ReadProcFileValue
+//------------------------------------------------------------------------------
+#if defined( __LINUX__ )
+    /*static*/ uint64_t Process::ReadProcFileValue( const char * fileName, const char * field )
+    {
+        const int fd = open( fileName, O_RDONLY | O_CLOEXEC );
+        if ( fd == -1 )
+        {
+            return 0; // Process may have exited
+        }
+        char buffer[ 4096 ];
+        const ssize_t len = read( fd, buffer, sizeof( buffer ) - 1 );
+        VERIFY( close( fd ) == 0 );
+        if ( len <= 0 )
+        {
+            return 0;
+        }
+        buffer[ len ] = 0;
+
+        // Find "<field>   <value>"
+        const char * pos = strstr( buffer, field );
+        if ( pos == nullptr )
+        {
+            return 0; // Not available (i.e. memory fields of a zombie)
+        }
+        return strtoull( pos + strlen( field ), nullptr, 10 );
+    }
+#endif
+
+// ResourceUsage::Accumulate
+//------------------------------------------------------------------------------
+void Process::ResourceUsage::Accumulate( const ResourceUsage & other )
+{
+    m_NumProcesses += other.m_NumProcesses;
+    m_PeakMemoryMiB = Math::Max( m_PeakMemoryMiB, other.m_PeakMemoryMiB );
+    m_UserTimeMS += other.m_UserTimeMS;
+    m_SystemTimeMS += other.m_SystemTimeMS;
+    m_ReadBytes += other.m_ReadBytes;
+    m_WriteBytes += other.m_WriteBytes;
+}
+
 // Detach
 //------------------------------------------------------------------------------
 void Process::Detach()
@@ -636,6 +880,11 @@ bool Process::ReadAllData( AString & outMem,
                     return false; // Timed out
                 }
 
+                #if defined( __LINUX__ )
+                    // Track peak memory while running (see RecordResourceUsage)
+                    SamplePeakMemory();
+                #endif
+
                 // no data available, but process is still going, so wait
                 // TODO:C Investigate waiting on an event when process terminates
                 // to reduce overall process spawn time
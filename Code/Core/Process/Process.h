@@ -9,6 +9,10 @@
 // Forward Declarations
 //------------------------------------------------------------------------------
 class AString;
+template< class T > class Array;
+#if defined( __LINUX__ ) || defined( __APPLE__ )
+    struct rusage;
+#endif
 
 #if defined( __APPLE__ )
     #if defined( __OBJC__ )
@@ -54,6 +58,30 @@ public:
     [[nodiscard]] bool          HasAborted() const;
     [[nodiscard]] static uint32_t   GetCurrentId();
 
+    // Resources used by the process and any descendants it waited on
+    class ResourceUsage
+    {
+    public:
+        // Combine usage of multiple processes (largest peak memory, total of others)
+        void Accumulate( const ResourceUsage & other );
+
+        uint32_t    m_NumProcesses = 0;
+        uint32_t    m_PeakMemoryMiB = 0;    // Peak physical memory
+        uint32_t    m_UserTimeMS = 0;       // CPU time in user mode
+        uint32_t    m_SystemTimeMS = 0;     // CPU time in kernel mode
+        uint64_t    m_ReadBytes = 0;        // Bytes read, including from caches and pipes (not on OSX)
+        uint64_t    m_WriteBytes = 0;       // Bytes written, including to pipes (not on OSX)
+    };
+
+    // Available once the process has exited
+    [[nodiscard]] const ResourceUsage & GetResourceUsage() const { return m_ResourceUsage; }
+    [[nodiscard]] uint32_t      GetPeakMemoryMiB() const { return m_ResourceUsage.m_PeakMemoryMiB; }
+
+    #if defined( __LINUX__ )
+        // Read a memory field (e.g. "VmRSS:") from a /proc/<pid>/status file
+        [[nodiscard]] static uint64_t ReadMemoryStatusKiB( const char * statusFileName, const char * field );
+    #endif
+
 private:
     #if defined( __WINDOWS__ )
         void KillProcessTreeInternal( const void * hProc, // HANDLE
@@ -68,6 +96,15 @@ private:
     #endif
 
     void Terminate();
+    #if defined( __LINUX__ ) || defined( __APPLE__ )
+        void RecordResourceUsage( const struct rusage & usage ) const;
+    #endif
+    #if defined( __LINUX__ )
+        void SamplePeakMemory() const;
+        void ReadIOCounters() const;
+        static void ReadChildPIDs( const char * childrenFileName, Array< int > & outPIDs );
+        [[nodiscard]] static uint64_t ReadProcFileValue( const char * fileName, const char * field );
+    #endif
 
     #if defined( __WINDOWS__ )
         // This messiness is to avoid including windows.h in this file
@@ -108,6 +145,12 @@ private:
     #endif
 
     bool m_HasAborted = false;
+    mutable ResourceUsage m_ResourceUsage;
+    #if defined( __LINUX__ )
+        uint64_t m_SpawnMemoryKiB = 0;                  // Our memory use when spawning
+        mutable uint64_t m_SampledPeakMemoryKiB = 0;    // Peak memory of the child and its descendants observed while running
+        mutable bool m_ChildHasExeced = false;          // Sampling is only valid once the child no longer shares our memory
+    #endif
     const volatile bool * m_MainAbortFlag; // This member is set when we must cancel processes asap when the main process dies.
     const volatile bool * m_AbortFlag;
 };
@@ -186,7 +186,7 @@ Tracing::Callbacks::Callbacks()
     : m_CallbacksMutex()
     , m_InCallbackDispatch( false )
     , m_CallbacksDebugSpam( 2 )
-    , m_CallbacksOutput( 2 )
+    , m_CallbacksOutput( 4 )
 {
     // Callbacks can now be modified or dispatched
     s_Valid = true;
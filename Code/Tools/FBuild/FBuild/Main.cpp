@@ -5,7 +5,9 @@
 //------------------------------------------------------------------------------
 #include "Tools/FBuild/FBuildCore/FBuild.h"
 #include "Tools/FBuild/FBuildCore/FLog.h"
+#include "Tools/FBuild/FBuildCore/Helpers/BuildDaemon.h"
 #include "Tools/FBuild/FBuildCore/Helpers/BuildProfiler.h"
+#include "Tools/FBuild/FBuildCore/Helpers/BuildTrace.h"
 #include "Tools/FBuild/FBuildCore/Helpers/CtrlCHandler.h"
 
 #include "Core/Process/Process.h"
@@ -36,6 +38,9 @@ enum ReturnCodes
     FBUILD_WRAPPER_CRASHED                  = -7,
     FBUILD_FAILED_TO_WSL_WRAPPER            = -8,
     FBUILD_FAILED_TO_WRITE_PROFILE_JSON     = -9,
+    FBUILD_FAILED_TO_START_DAEMON           = -10,
+    FBUILD_FAILED_TO_WRITE_TRACE            = -11,
+    FBUILD_FAILED_TO_CONVERT_TRACE          = -12,
 };
 
 // Headers
@@ -43,6 +48,8 @@ enum ReturnCodes
 int WrapperMainProcess( const AString & args, const FBuildOptions & options, SystemMutex & finalProcess );
 int WrapperIntermediateProcess( const FBuildOptions & options );
 int32_t WrapperModeForWSL( const FBuildOptions & options );
+bool BuildUsingDaemon( const FBuildOptions & options, int argc, char * argv[], int & outResult );
+void DisplayTotalTime( const Timer & t );
 int Main( int argc, char * argv[] );
 
 // Misc
@@ -110,6 +117,30 @@ int Main( int argc, char * argv[] )
     VERIFY( setvbuf( stdout, nullptr, _IONBF, 0 ) == 0 );
     VERIFY( setvbuf( stderr, nullptr, _IONBF, 0 ) == 0 );
 
+    // convert a previously recorded trace instead of building
+    if ( options.m_TraceConvertFile.IsEmpty() == false )
+    {
+        AStackString<> jsonFile( options.m_TraceConvertFile );
+        jsonFile += ".json";
+        return BuildTrace::ConvertToJSON( options.m_TraceConvertFile.Get(), jsonFile.Get() ) ? FBUILD_OK : FBUILD_FAILED_TO_CONVERT_TRACE;
+    }
+
+    // forward to a resident daemon if there is one
+    if ( options.m_UseDaemon && ( options.m_DaemonMode == false ) )
+    {
+        int result;
+        if ( BuildUsingDaemon( options, argc, argv, result ) )
+        {
+            if ( options.m_ShowTotalTimeTaken )
+            {
+                DisplayTotalTime( t );
+            }
+            ctrlCHandler.DeregisterHandler();
+            return result;
+        }
+        OUTPUT( "FBuild: No daemon running in '%s' - building directly.\n", options.GetWorkingDir().Get() );
+    }
+
     // ensure only one FASTBuild instance is running at a time
     SystemMutex mainProcess( options.GetMainProcessMutexName().Get() );
 
@@ -141,6 +172,15 @@ int Main( int argc, char * argv[] )
         }
     }
 
+    // stay resident, servicing builds for clients
+    if ( options.m_DaemonMode )
+    {
+        BuildDaemon daemon( options );
+        const bool result = daemon.Run();
+        ctrlCHandler.DeregisterHandler(); // Ensure this happens before FBuild is destroyed
+        return result ? FBUILD_OK : FBUILD_FAILED_TO_START_DAEMON;
+    }
+
     if ( wrapperMode == FBuildOptions::WRAPPER_MODE_MAIN_PROCESS )
     {
         return WrapperMainProcess( options.m_Args, options, finalProcess );
@@ -206,6 +246,10 @@ int Main( int argc, char * argv[] )
     {
         result = fBuild.GenerateCompilationDatabase( options.m_Targets );
     }
+    else if ( options.m_HeaderImpactReportType.IsEmpty() == false )
+    {
+        result = fBuild.GenerateHeaderImpactReport( options.m_HeaderImpactReportType );
+    }
     else if ( options.m_CacheInfo )
     {
         result = fBuild.CacheOutputInfo();
@@ -230,6 +274,16 @@ int Main( int argc, char * argv[] )
         }
     }
 
+    // Build Tracing enabled?
+    bool problemSavingBuildTrace = false;
+    if ( options.m_Trace )
+    {
+        if ( BuildTrace::Get().Save( options, "fbuild.trace" ) == false )
+        {
+            problemSavingBuildTrace = true;
+        }
+    }
+
     if ( sharedData )
     {
         sharedData->ReturnCode = ( result == true ) ? FBUILD_OK : FBUILD_BUILD_FAILED;
@@ -238,17 +292,7 @@ int Main( int argc, char * argv[] )
     // final line of output - status of build
     if ( options.m_ShowTotalTimeTaken )
     {
-        const float totalBuildTime = t.GetElapsed();
-        const uint32_t minutes = uint32_t( totalBuildTime / 60.0f );
-        const float seconds = ( totalBuildTime - (float)( minutes * 60 ) );
-        if ( minutes > 0 )
-        {
-            FLOG_OUTPUT( "Time: %um %05.3fs\n", minutes, (double)seconds );
-        }
-        else
-        {
-            FLOG_OUTPUT( "Time: %05.3fs\n", (double)seconds );
-        }
+        DisplayTotalTime( t );
     }
 
     ctrlCHandler.DeregisterHandler(); // Ensure this happens before FBuild is destroyed
@@ -257,6 +301,10 @@ int Main( int argc, char * argv[] )
     {
         return FBUILD_FAILED_TO_WRITE_PROFILE_JSON;
     }
+    if ( problemSavingBuildTrace )
+    {
+        return FBUILD_FAILED_TO_WRITE_TRACE;
+    }
     return ( result == true ) ? FBUILD_OK : FBUILD_BUILD_FAILED;
 }
 
@@ -349,4 +397,48 @@ int32_t WrapperModeForWSL( const FBuildOptions & options )
     return p.WaitForExit();
 }
 
+// BuildUsingDaemon
+//------------------------------------------------------------------------------
+bool BuildUsingDaemon( const FBuildOptions & options, int argc, char * argv[], int & outResult )
+{
+    Array< AString > args( (size_t)argc );
+    for ( int i = 0; i < argc; ++i )
+    {
+        args.EmplaceBack( argv[ i ] );
+    }
+
+    BuildDaemonClient client;
+    BuildDaemon::Result daemonResult;
+    if ( client.Build( options, args, daemonResult ) == false )
+    {
+        return false; // No daemon available
+    }
+
+    switch ( daemonResult )
+    {
+        case BuildDaemon::RESULT_OK:                outResult = FBUILD_OK;                  break;
+        case BuildDaemon::RESULT_BAD_ARGS:          outResult = FBUILD_BAD_ARGS;            break;
+        case BuildDaemon::RESULT_ERROR_LOADING_BFF: outResult = FBUILD_ERROR_LOADING_BFF;   break;
+        default:                                    outResult = FBUILD_BUILD_FAILED;        break;
+    }
+    return true;
+}
+
+// DisplayTotalTime
+//------------------------------------------------------------------------------
+void DisplayTotalTime( const Timer & t )
+{
+    const float totalBuildTime = t.GetElapsed();
+    const uint32_t minutes = uint32_t( totalBuildTime / 60.0f );
+    const float seconds = ( totalBuildTime - (float)( minutes * 60 ) );
+    if ( minutes > 0 )
+    {
+        FLOG_OUTPUT( "Time: %um %05.3fs\n", minutes, (double)seconds );
+    }
+    else
+    {
+        FLOG_OUTPUT( "Time: %05.3fs\n", (double)seconds );
+    }
+}
+
 //------------------------------------------------------------------------------
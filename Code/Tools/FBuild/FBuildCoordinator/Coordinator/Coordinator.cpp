@@ -8,6 +8,7 @@
 // FBuild
 #include "Tools/FBuild/FBuildCore/FBuild.h"
 #include "Tools/FBuild/FBuildCore/FBuildVersion.h"
+#include "Tools/FBuild/FBuildCore/Helpers/MetricsServer.h"
 #include "Tools/FBuild/FBuildCore/WorkerPool/WorkerConnectionPool.h"
 
 // Core
@@ -19,6 +20,7 @@
 Coordinator::Coordinator( const AString & args )
     : m_BaseArgs( args )
     , m_ConnectionPool( nullptr )
+    , m_MetricsServer( nullptr )
 {
     m_ConnectionPool = FNEW( WorkerConnectionPool );
 }
@@ -27,6 +29,7 @@ Coordinator::Coordinator( const AString & args )
 //------------------------------------------------------------------------------
 Coordinator::~Coordinator()
 {
+    FDELETE m_MetricsServer;
     FDELETE m_ConnectionPool;
 }
 
@@ -45,6 +48,15 @@ int32_t Coordinator::Start()
     return static_cast<int32_t>(m_WorkThread.Join());
 }
 
+// StartMetricsServer
+//------------------------------------------------------------------------------
+void Coordinator::StartMetricsServer( uint16_t port )
+{
+    ASSERT( m_MetricsServer == nullptr );
+    m_MetricsServer = FNEW( MetricsServer );
+    m_MetricsServer->Start( port );
+}
+
 // WorkThreadWrapper
 //------------------------------------------------------------------------------
 /*static*/ uint32_t Coordinator::WorkThreadWrapper( void * userData )
@@ -11,6 +11,7 @@
 
 // Forward Declarations
 //------------------------------------------------------------------------------
+class MetricsServer;
 class WorkerConnectionPool;
 
 // Coordinator
@@ -24,12 +25,15 @@ public:
 
     int32_t Start();
 
+    void StartMetricsServer( uint16_t port );
+
 private:
     static uint32_t WorkThreadWrapper( void * userData );
     uint32_t WorkThread();
 
     AString                 m_BaseArgs;
     WorkerConnectionPool    * m_ConnectionPool;
+    MetricsServer           * m_MetricsServer;
     Thread                  m_WorkThread;
 };
 
@@ -14,6 +14,7 @@
 // FBuildCoordinatorOptions (CONSTRUCTOR)
 //------------------------------------------------------------------------------
 FBuildCoordinatorOptions::FBuildCoordinatorOptions()
+    : m_MetricsPort( 0 )
 {
 }
 
@@ -25,6 +26,23 @@ bool FBuildCoordinatorOptions::ProcessCommandLine( const AString & commandLine )
     Array< AString > tokens;
     commandLine.Tokenize( tokens );
 
+    // Check each token
+    for ( const AString & token : tokens )
+    {
+        if ( token.BeginsWith( "-metricsport=" ) )
+        {
+            uint32_t num( 0 );
+            if ( ( AString::ScanS( token.Get() + 13, "%u", &num ) == 1 ) &&
+                 ( num > 0 ) && ( num <= 65535 ) )
+            {
+                m_MetricsPort = (uint16_t)num;
+                continue;
+            }
+            ShowUsageError();
+            return false;
+        }
+    }
+
     return true;
 }
 
@@ -33,7 +51,10 @@ bool FBuildCoordinatorOptions::ProcessCommandLine( const AString & commandLine )
 void FBuildCoordinatorOptions::ShowUsageError()
 {
     OUTPUT( "FBuildCoordinator - " FBUILD_VERSION_STRING " - "
-            "Copyright 2012-2019 Franta Fulin - http://www.fastbuild.org\n" );
+            "Copyright 2012-2019 Franta Fulin - http://www.fastbuild.org\n"
+            "Command Line Options:\n"
+            " -metricsport=<port>\n"
+            "        Serve live metrics on http://127.0.0.1:<port>/metrics\n" );
 }
 
 //------------------------------------------------------------------------------
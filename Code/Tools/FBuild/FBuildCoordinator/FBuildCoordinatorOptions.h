@@ -4,6 +4,7 @@
 
 // Includes
 //------------------------------------------------------------------------------
+#include "Core/Env/Types.h"
 
 // Forward Declaration
 //------------------------------------------------------------------------------
@@ -18,6 +19,9 @@ public:
 
     bool ProcessCommandLine( const AString & commandLine );
 
+    // Other
+    uint16_t m_MetricsPort; // Serve live metrics on this port (0 = disabled)
+
 private:
     void ShowUsageError();
 };
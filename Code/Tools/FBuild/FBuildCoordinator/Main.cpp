@@ -75,6 +75,10 @@ int Main( const AString & args )
     }
 
     Coordinator coordinator( args );
+    if ( options.m_MetricsPort )
+    {
+        coordinator.StartMetricsServer( options.m_MetricsPort );
+    }
 
     return coordinator.Start();
 }
@@ -7,6 +7,7 @@
 
 // FBuild
 #include "Tools/FBuild/FBuildCore/FLog.h"
+#include "Tools/FBuild/FBuildCore/Helpers/Metrics.h"
 
 // Core
 #include "Core/Containers/UniquePtr.h"
@@ -42,7 +43,10 @@ public:
 
 // CONSTRUCTOR
 //------------------------------------------------------------------------------
-/*explicit*/ Cache::Cache() = default;
+/*explicit*/ Cache::Cache( bool isLocalTier )
+    : m_IsLocalTier( isLocalTier )
+{
+}
 
 // DESTRUCTOR
 //------------------------------------------------------------------------------
@@ -140,6 +144,11 @@ public:
         }
     }
 
+    if ( m_IsLocalTier == false )
+    {
+        Metrics::s_CacheStores.Add();
+        Metrics::s_CacheBytesWritten.Add( dataSize );
+    }
     return true;
 }
 
@@ -162,10 +171,22 @@ public:
         {
             dataSize = cacheFileSize;
             data = mem.ReleaseOwnership();
+            if ( m_IsLocalTier )
+            {
+                cacheFile.Close();
+                FileIO::SetFileLastWriteTimeToNow( fullPath ); // Used entries are trimmed last
+                return true;
+            }
+            Metrics::s_CacheHits.Add();
+            Metrics::s_CacheBytesRead.Add( dataSize );
             return true;
         }
     }
 
+    if ( m_IsLocalTier == false )
+    {
+        Metrics::s_CacheMisses.Add();
+    }
     return false;
 }
 
@@ -176,6 +197,25 @@ public:
     FREE( data );
 }
 
+// Quarantine
+//------------------------------------------------------------------------------
+/*virtual*/ bool Cache::Quarantine( const AString & cacheId )
+{
+    // Entry is renamed rather than deleted so it can be inspected. Quarantined
+    // entries keep their original age, so are removed early by -cachetrim
+    AStackString<> fullPath;
+    GetFullPathForCacheEntry( cacheId, fullPath );
+    AStackString<> fullPathQuarantined( fullPath );
+    fullPathQuarantined += ".corrupt";
+
+    FileIO::FileDelete( fullPathQuarantined.Get() ); // Replace any previously quarantined entry
+    if ( FileIO::FileMove( fullPath, fullPathQuarantined ) )
+    {
+        return true;
+    }
+    return FileIO::FileDelete( fullPath.Get() ); // try to at least remove the corrupt entry
+}
+
 // OutputInfo
 //------------------------------------------------------------------------------
 /*virtual*/ bool Cache::OutputInfo( bool showProgress )
@@ -256,59 +296,24 @@ public:
 
     // Do we need to delete anything?
     OUTPUT( "Trimming to %u MiB:\n", sizeMiB );
-    const uint64_t limit = ( (uint64_t)sizeMiB * MEGABYTE );
-    uint32_t numDeleted = 0;
-    if ( limit < totalSize )
-    {
-        const Timer timer;
-        float lastProgressTime = 0.0f;
-        if ( showProgress )
-        {
-            FLog::OutputProgress( 0.0f, 0.0f, 0, 0, 0, 0 );
-        }
-        const uint64_t originalTotalSize = totalSize;
-
-        // Iterate over files, deleting oldest first
-        for ( const FileIO::FileInfo & info : allFiles )
-        {
-            // Try to delete (ok to fail if file is in use)
-            if ( FileIO::FileDelete( info.m_Name.Get() ) )
-            {
-                totalSize -= info.m_Size;
-                ++numDeleted;
-
-                // Are we under the limit now?
-                if ( totalSize <= limit )
-                {
-                    break;
-                }
-
-                // Progress
-                if ( showProgress )
-                {
-                    // Throttled to avoid perf impact
-                    if ( ( timer.GetElapsed() - lastProgressTime ) > 0.5f )
-                    {
-                        const uint64_t toDeleteBytes = originalTotalSize - limit;
-                        const uint64_t deletedBytes = originalTotalSize - totalSize;
-                        const float perc = ( (float)deletedBytes / (float)toDeleteBytes ) * 100.0f;
-                        FLog::OutputProgress( timer.GetElapsed(), perc, 0, 0, 0, 0 );
-                        lastProgressTime = timer.GetElapsed();
-                    }
-                }
-            }
-        }
-
-        if ( showProgress )
-        {
-            FLog::ClearProgress();
-        }
-    }
+    const uint32_t numDeleted = DeleteOldestFiles( showProgress, allFiles, totalSize, ( (uint64_t)sizeMiB * MEGABYTE ) );
 
     OUTPUT( " - After: %u Files @ %u MiB\n", (uint32_t)allFiles.GetSize() - numDeleted, (uint32_t)( totalSize / MEGABYTE ) );
     return true;
 }
 
+// EnforceSizeLimit
+//------------------------------------------------------------------------------
+void Cache::EnforceSizeLimit( uint32_t sizeMiB )
+{
+    Array< FileIO::FileInfo > allFiles( 1000000 );
+    uint64_t totalSize = 0;
+    GetCacheFiles( false, allFiles, totalSize );
+    OldestFileTimeSorter sorter;
+    allFiles.Sort( sorter );
+    DeleteOldestFiles( false, allFiles, totalSize, ( (uint64_t)sizeMiB * MEGABYTE ) );
+}
+
 // GetCacheFiles
 //------------------------------------------------------------------------------
 void Cache::GetCacheFiles( bool showProgress,
@@ -365,6 +370,65 @@ void Cache::GetCacheFiles( bool showProgress,
     }
 }
 
+// DeleteOldestFiles
+//------------------------------------------------------------------------------
+uint32_t Cache::DeleteOldestFiles( bool showProgress,
+                                   const Array< FileIO::FileInfo > & files,
+                                   uint64_t & inOutTotalSize,
+                                   uint64_t limit ) const
+{
+    // Files must be sorted oldest first
+    uint32_t numDeleted = 0;
+    if ( limit < inOutTotalSize )
+    {
+        const Timer timer;
+        float lastProgressTime = 0.0f;
+        if ( showProgress )
+        {
+            FLog::OutputProgress( 0.0f, 0.0f, 0, 0, 0, 0 );
+        }
+        const uint64_t originalTotalSize = inOutTotalSize;
+
+        // Iterate over files, deleting oldest first
+        for ( const FileIO::FileInfo & info : files )
+        {
+            // Try to delete (ok to fail if file is in use)
+            if ( FileIO::FileDelete( info.m_Name.Get() ) )
+            {
+                inOutTotalSize -= info.m_Size;
+                ++numDeleted;
+
+                // Are we under the limit now?
+                if ( inOutTotalSize <= limit )
+                {
+                    break;
+                }
+
+                // Progress
+                if ( showProgress )
+                {
+                    // Throttled to avoid perf impact
+                    if ( ( timer.GetElapsed() - lastProgressTime ) > 0.5f )
+                    {
+                        const uint64_t toDeleteBytes = originalTotalSize - limit;
+                        const uint64_t deletedBytes = originalTotalSize - inOutTotalSize;
+                        const float perc = ( (float)deletedBytes / (float)toDeleteBytes ) * 100.0f;
+                        FLog::OutputProgress( timer.GetElapsed(), perc, 0, 0, 0, 0 );
+                        lastProgressTime = timer.GetElapsed();
+                    }
+                }
+            }
+        }
+
+        if ( showProgress )
+        {
+            FLog::ClearProgress();
+        }
+    }
+
+    return numDeleted;
+}
+
 // GetFullPathForCacheEntry
 //------------------------------------------------------------------------------
 void Cache::GetFullPathForCacheEntry( const AString & cacheId,
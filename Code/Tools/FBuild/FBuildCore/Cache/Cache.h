@@ -13,7 +13,9 @@
 class Cache : public ICache
 {
 public:
-    explicit Cache();
+    // A local tier (see TieredCache) refreshes the age of retrieved entries so
+    // trimming removes the least recently used, and leaves metrics to its owner
+    explicit Cache( bool isLocalTier = false );
     virtual ~Cache() override;
 
     virtual bool Init( const AString & cachePath,
@@ -28,11 +30,17 @@ public:
     virtual void FreeMemory( void * data, size_t dataSize ) override;
     virtual bool OutputInfo( bool showProgress ) override;
     virtual bool Trim( bool showProgress, uint32_t sizeMiB ) override;
+    virtual bool Quarantine( const AString & cacheId ) override;
+
+    // Trim without output
+    void EnforceSizeLimit( uint32_t sizeMiB );
 private:
     void GetCacheFiles( bool showProgress, Array< FileIO::FileInfo > & outInfo, uint64_t & outTotalSize ) const;
+    uint32_t DeleteOldestFiles( bool showProgress, const Array< FileIO::FileInfo > & files, uint64_t & inOutTotalSize, uint64_t limit ) const;
     void GetFullPathForCacheEntry( const AString & cacheId, AString & outFullPath ) const;
 
     AString m_CachePath;
+    bool    m_IsLocalTier;
 };
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,129 @@
+// CacheEntry - Integrity checked cache entries
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "CacheEntry.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/Helpers/Compressor.h"
+
+// Core
+#include "Core/Env/Assert.h"
+#include "Core/Math/xxHash.h"
+#include "Core/Mem/Mem.h"
+#include "Core/Profile/Profile.h"
+#include "Core/Strings/AString.h"
+
+#include <memory.h>
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+CacheEntry::CacheEntry()
+    : m_Data( nullptr )
+    , m_DataSize( 0 )
+{
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+CacheEntry::~CacheEntry()
+{
+    FREE( m_Data );
+}
+
+// Create
+//------------------------------------------------------------------------------
+void CacheEntry::Create( const void * compressedData, size_t compressedDataSize )
+{
+    PROFILE_FUNCTION;
+
+    ASSERT( m_Data == nullptr );
+    ASSERT( Compressor::IsValidData( compressedData, compressedDataSize ) );
+
+    m_DataSize = ( sizeof( Header ) + compressedDataSize );
+    m_Data = ALLOC( m_DataSize );
+    memcpy( (char *)m_Data + sizeof( Header ), compressedData, compressedDataSize );
+
+    // fill out header
+    Header * header = (Header *)m_Data;
+    header->m_Magic = MAGIC;
+    header->m_Version = VERSION;
+    header->m_UncompressedSize = Compressor::GetUncompressedSize( compressedData, compressedDataSize );
+    header->m_PayloadSize = compressedDataSize;
+    header->m_PayloadHash = xxHash3::Calc64( compressedData, compressedDataSize );
+}
+
+// Verify
+//------------------------------------------------------------------------------
+/*static*/ bool CacheEntry::Verify( const void * data, size_t dataSize, AString & outProblem )
+{
+    PROFILE_FUNCTION;
+
+    ASSERT( data );
+
+    if ( dataSize < sizeof( Header ) )
+    {
+        outProblem.Format( "Truncated header (%zu bytes)", dataSize );
+        return false;
+    }
+
+    const Header * header = (const Header *)data;
+    if ( header->m_Magic != MAGIC )
+    {
+        outProblem = "Missing header";
+        return false;
+    }
+    if ( header->m_Version != VERSION )
+    {
+        outProblem.Format( "Unsupported version %u", header->m_Version );
+        return false;
+    }
+
+    const size_t payloadSize = ( dataSize - sizeof( Header ) );
+    if ( header->m_PayloadSize != payloadSize )
+    {
+        outProblem.Format( "Truncated data (%zu of %" PRIu64 " bytes)", payloadSize, header->m_PayloadSize );
+        return false;
+    }
+
+    // Checking the hash first ensures the Compressor header can be safely inspected
+    const void * payload = GetPayload( data );
+    if ( xxHash3::Calc64( payload, payloadSize ) != header->m_PayloadHash )
+    {
+        outProblem = "Hash mismatch";
+        return false;
+    }
+
+    if ( ( Compressor::IsValidData( payload, payloadSize ) == false ) ||
+         ( Compressor::GetUncompressedSize( payload, payloadSize ) != header->m_UncompressedSize ) )
+    {
+        outProblem = "Invalid compressed data";
+        return false;
+    }
+
+    return true;
+}
+
+// GetPayload
+//------------------------------------------------------------------------------
+/*static*/ const void * CacheEntry::GetPayload( const void * data )
+{
+    return ( (const char *)data + sizeof( Header ) );
+}
+
+// GetPayloadSize
+//------------------------------------------------------------------------------
+/*static*/ size_t CacheEntry::GetPayloadSize( const void * data )
+{
+    return (size_t)( (const Header *)data )->m_PayloadSize;
+}
+
+// GetPayloadHash
+//------------------------------------------------------------------------------
+/*static*/ uint64_t CacheEntry::GetPayloadHash( const void * data )
+{
+    return ( (const Header *)data )->m_PayloadHash;
+}
+
+//------------------------------------------------------------------------------
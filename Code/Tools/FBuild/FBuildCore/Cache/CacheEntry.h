@@ -0,0 +1,58 @@
+// CacheEntry - Integrity checked cache entries
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+// Core
+#include "Core/Env/Types.h"
+
+// Forward Declarations
+//------------------------------------------------------------------------------
+class AString;
+
+// CacheEntry
+//  - Compressed data (as produced by the Compressor) is prefixed with a header
+//    recording its size and hash, so truncated or otherwise corrupt entries
+//    are detected before being decompressed and extracted
+//------------------------------------------------------------------------------
+class CacheEntry
+{
+public:
+    explicit CacheEntry();
+    ~CacheEntry();
+
+    // Create an entry from compressed data
+    void Create( const void * compressedData, size_t compressedDataSize );
+
+    const void *    GetData() const         { return m_Data; }
+    size_t          GetDataSize() const     { return m_DataSize; }
+
+    // Check an entry retrieved from the cache, describing the problem if invalid
+    static bool     Verify( const void * data, size_t dataSize, AString & outProblem );
+
+    // Access the compressed data in a valid entry
+    static const void * GetPayload( const void * data );
+    static size_t       GetPayloadSize( const void * data );
+    static uint64_t     GetPayloadHash( const void * data );
+
+private:
+    enum : uint32_t
+    {
+        MAGIC   = 'F' | ( 'B' << 8 ) | ( 'C' << 16 ) | ( 'E' << 24 ),
+        VERSION = 1,            // Bump if header format is changed
+    };
+    struct Header
+    {
+        uint32_t m_Magic;
+        uint32_t m_Version;
+        uint64_t m_UncompressedSize;
+        uint64_t m_PayloadSize;
+        uint64_t m_PayloadHash;  // xxHash3 of compressed data
+    };
+
+    void *  m_Data;
+    size_t  m_DataSize;
+};
+
+//------------------------------------------------------------------------------
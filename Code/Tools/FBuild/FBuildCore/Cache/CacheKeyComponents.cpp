@@ -0,0 +1,402 @@
+// CacheKeyComponents - The inputs which make up the cache key of an object
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "CacheKeyComponents.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/Cache/ICache.h"
+#include "Tools/FBuild/FBuildCore/Helpers/Compressor.h"
+
+// Core
+#include "Core/Math/xxHash.h"
+#include "Core/Profile/Profile.h"
+#include "Core/Strings/AStackString.h"
+
+// system
+#include <stdlib.h> // for strtoull
+#include <string.h> // for memchr
+
+// Defines
+//------------------------------------------------------------------------------
+#define CACHE_KEYS_HEADER "FBuildCacheKeys 1" // Bump if the format is changed
+
+// Constants
+//------------------------------------------------------------------------------
+namespace
+{
+    const size_t kMaxListedDifferences = 10; // Per component
+
+    // Sort and remove duplicates
+    void SortUnique( Array< AString > & items )
+    {
+        items.Sort();
+        size_t numUnique = 0;
+        for ( size_t i = 0; i < items.GetSize(); ++i )
+        {
+            if ( ( numUnique > 0 ) && ( items[ i ] == items[ numUnique - 1 ] ) )
+            {
+                continue;
+            }
+            if ( i != numUnique )
+            {
+                items[ numUnique ] = items[ i ];
+            }
+            ++numUnique;
+        }
+        while ( items.GetSize() > numUnique )
+        {
+            items.Pop();
+        }
+    }
+
+    bool ContainsWorkingDir( const AString & item, const AString & workingDir )
+    {
+        return ( workingDir.IsEmpty() == false ) && ( item.Find( workingDir ) != nullptr );
+    }
+}
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+CacheKeyComponents::CacheKeyComponents() = default;
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+CacheKeyComponents::~CacheKeyComponents() = default;
+
+// SetSourceFromPreprocessedOutput
+//------------------------------------------------------------------------------
+void CacheKeyComponents::SetSourceFromPreprocessedOutput( uint64_t sourceKey, const void * data, size_t dataSize )
+{
+    PROFILE_FUNCTION;
+
+    m_SourceKey = sourceKey;
+    m_SourceSize = dataSize;
+    m_SourceFiles.Clear();
+
+    // Files are named by line markers, which take the form:
+    //   # <line> "<file>" ...      (GCC/Clang)
+    //   #line <line> "<file>"      (MSVC)
+    const char * pos = static_cast< const char * >( data );
+    const char * const end = ( pos + dataSize );
+    while ( pos < end )
+    {
+        const char * lineEnd = static_cast< const char * >( memchr( pos, '\n', (size_t)( end - pos ) ) );
+        if ( lineEnd == nullptr )
+        {
+            lineEnd = end;
+        }
+        if ( *pos == '#' )
+        {
+            const char * token = ( pos + 1 );
+            if ( ( ( lineEnd - token ) > 4 ) && ( strncmp( token, "line", 4 ) == 0 ) )
+            {
+                token += 4;
+            }
+            while ( ( token < lineEnd ) && ( ( *token == ' ' ) || ( *token == '\t' ) ) )
+            {
+                ++token;
+            }
+            const char * const lineNumber = token;
+            while ( ( token < lineEnd ) && ( *token >= '0' ) && ( *token <= '9' ) )
+            {
+                ++token;
+            }
+            while ( ( token < lineEnd ) && ( *token == ' ' ) )
+            {
+                ++token;
+            }
+            if ( ( token > lineNumber ) && ( token < lineEnd ) && ( *token == '"' ) )
+            {
+                const char * const fileStart = ( token + 1 );
+                const char * const fileEnd = static_cast< const char * >( memchr( fileStart, '"', (size_t)( lineEnd - fileStart ) ) );
+                if ( fileEnd )
+                {
+                    // Consecutive markers for the same file are common, so
+                    // avoid growing the list for those
+                    const AStackString<> file( fileStart, fileEnd );
+                    if ( m_SourceFiles.IsEmpty() || ( m_SourceFiles.Top() != file ) )
+                    {
+                        m_SourceFiles.Append( file );
+                    }
+                }
+            }
+        }
+        pos = ( lineEnd + 1 );
+    }
+    SortUnique( m_SourceFiles );
+}
+
+// SetSourceFromLightCache
+//------------------------------------------------------------------------------
+void CacheKeyComponents::SetSourceFromLightCache( uint64_t lightCacheKey, const Array< AString > & includes )
+{
+    m_SourceKey = lightCacheKey;
+    m_SourceSize = 0;
+    m_SourceFiles = includes;
+    SortUnique( m_SourceFiles );
+}
+
+// Publish
+//------------------------------------------------------------------------------
+bool CacheKeyComponents::Publish( ICache & cache ) const
+{
+    PROFILE_FUNCTION;
+
+    AString text( 4096 );
+    Serialize( text );
+
+    Compressor c;
+    c.Compress( text.Get(), text.GetLength() );
+
+    AStackString<> sidecarId;
+    GetSidecarId( m_Object, sidecarId );
+    return cache.Publish( sidecarId, c.GetResult(), c.GetResultSize() );
+}
+
+// Retrieve
+//------------------------------------------------------------------------------
+bool CacheKeyComponents::Retrieve( ICache & cache, const AString & object )
+{
+    PROFILE_FUNCTION;
+
+    AStackString<> sidecarId;
+    GetSidecarId( object, sidecarId );
+
+    void * data = nullptr;
+    size_t dataSize = 0;
+    if ( cache.Retrieve( sidecarId, data, dataSize ) == false )
+    {
+        return false;
+    }
+
+    bool ok = false;
+    if ( Compressor::IsValidData( data, dataSize ) )
+    {
+        Compressor d;
+        if ( d.Decompress( data ) )
+        {
+            const char * const text = static_cast< const char * >( d.GetResult() );
+            ok = Deserialize( AString( text, text + d.GetResultSize() ) );
+        }
+    }
+    cache.FreeMemory( data, dataSize );
+
+    // Ids are a hash of the object name, so ensure this is the right object
+    return ok && ( m_Object == object );
+}
+
+// Explain
+//------------------------------------------------------------------------------
+void CacheKeyComponents::Explain( const CacheKeyComponents & previous, AString & outExplanation ) const
+{
+    outExplanation.AppendFormat( "   Nearest entry: '%s'\n", previous.m_CacheId.Get() );
+
+    // Absolute paths are the usual cause of keys differing between machines,
+    // so differences containing either working dir are highlighted
+    bool differs = false;
+    if ( m_WorkingDir != previous.m_WorkingDir )
+    {
+        outExplanation.AppendFormat( "   - Working dir differs: '%s' vs '%s'\n", m_WorkingDir.Get(), previous.m_WorkingDir.Get() );
+    }
+
+    // Pre-processed source
+    if ( m_SourceKey != previous.m_SourceKey )
+    {
+        differs = true;
+        outExplanation.AppendFormat( "   - Source differs: %016" PRIX64 " (%" PRIu64 " bytes) vs %016" PRIX64 " (%" PRIu64 " bytes)\n",
+                                     m_SourceKey, m_SourceSize, previous.m_SourceKey, previous.m_SourceSize );
+        if ( DiffLists( m_SourceFiles, previous.m_SourceFiles, m_WorkingDir, previous.m_WorkingDir, outExplanation ) == false )
+        {
+            outExplanation += "     Same files were used, so their contents differ\n";
+        }
+        if ( m_WorkingDir != previous.m_WorkingDir )
+        {
+            uint32_t numAbsolute = 0;
+            for ( const AString & file : m_SourceFiles )
+            {
+                numAbsolute += ContainsWorkingDir( file, m_WorkingDir ) ? 1u : 0u;
+            }
+            if ( numAbsolute > 0 )
+            {
+                outExplanation.AppendFormat( "     %u file(s) are named by absolute path, so are embedded in the source\n", numAbsolute );
+            }
+        }
+    }
+
+    // Args
+    if ( m_Args != previous.m_Args )
+    {
+        differs = true;
+        outExplanation += "   - Args differ\n";
+        Array< AString > args;
+        Array< AString > previousArgs;
+        m_Args.Tokenize( args );
+        previous.m_Args.Tokenize( previousArgs );
+        args.Sort();
+        previousArgs.Sort();
+        if ( DiffLists( args, previousArgs, m_WorkingDir, previous.m_WorkingDir, outExplanation ) == false )
+        {
+            outExplanation += "     Same args were used, in a different order\n";
+        }
+    }
+
+    // Toolchain
+    if ( m_ToolChainKey != previous.m_ToolChainKey )
+    {
+        differs = true;
+        outExplanation.AppendFormat( "   - Toolchain differs: %016" PRIX64 " vs %016" PRIX64 "\n", m_ToolChainKey, previous.m_ToolChainKey );
+        DiffLists( m_ToolFiles, previous.m_ToolFiles, m_WorkingDir, previous.m_WorkingDir, outExplanation );
+    }
+
+    // PCH
+    if ( m_PCHKey != previous.m_PCHKey )
+    {
+        differs = true;
+        outExplanation.AppendFormat( "   - PCH differs: %016" PRIX64 " vs %016" PRIX64 "\n", m_PCHKey, previous.m_PCHKey );
+    }
+
+    if ( differs == false )
+    {
+        outExplanation += "   - All components match, so the entry was not stored or has been removed\n";
+    }
+}
+
+// Serialize
+//------------------------------------------------------------------------------
+void CacheKeyComponents::Serialize( AString & outText ) const
+{
+    outText = CACHE_KEYS_HEADER "\n";
+    outText.AppendFormat( "Object %s\n", m_Object.Get() );
+    outText.AppendFormat( "CacheId %s\n", m_CacheId.Get() );
+    outText.AppendFormat( "WorkingDir %s\n", m_WorkingDir.Get() );
+    outText.AppendFormat( "SourceKey %016" PRIX64 "\n", m_SourceKey );
+    outText.AppendFormat( "SourceSize %" PRIu64 "\n", m_SourceSize );
+    for ( const AString & file : m_SourceFiles )
+    {
+        outText.AppendFormat( "SourceFile %s\n", file.Get() );
+    }
+    outText.AppendFormat( "Args %s\n", m_Args.Get() );
+    outText.AppendFormat( "ToolChainKey %016" PRIX64 "\n", m_ToolChainKey );
+    for ( const AString & file : m_ToolFiles )
+    {
+        outText.AppendFormat( "ToolFile %s\n", file.Get() );
+    }
+    outText.AppendFormat( "PCHKey %016" PRIX64 "\n", m_PCHKey );
+}
+
+// Deserialize
+//------------------------------------------------------------------------------
+bool CacheKeyComponents::Deserialize( const AString & text )
+{
+    m_SourceFiles.Clear();
+    m_ToolFiles.Clear();
+
+    if ( text.BeginsWith( CACHE_KEYS_HEADER "\n" ) == false )
+    {
+        return false;
+    }
+
+    // Each line is a key and value, separated by the first space
+    const char * pos = ( text.Get() + strlen( CACHE_KEYS_HEADER "\n" ) );
+    const char * const end = text.GetEnd();
+    while ( pos < end )
+    {
+        const char * lineEnd = text.Find( '\n', pos );
+        if ( lineEnd == nullptr )
+        {
+            lineEnd = end;
+        }
+        const char * const space = text.Find( ' ', pos, lineEnd );
+        if ( space == nullptr )
+        {
+            return false;
+        }
+        const AStackString<> key( pos, space );
+        const AStackString<> value( space + 1, lineEnd );
+        pos = ( lineEnd + 1 );
+
+        if ( key == "Object" )          { m_Object = value; }
+        else if ( key == "CacheId" )    { m_CacheId = value; }
+        else if ( key == "WorkingDir" ) { m_WorkingDir = value; }
+        else if ( key == "SourceKey" )  { m_SourceKey = strtoull( value.Get(), nullptr, 16 ); }
+        else if ( key == "SourceSize" ) { m_SourceSize = strtoull( value.Get(), nullptr, 10 ); }
+        else if ( key == "SourceFile" ) { m_SourceFiles.Append( value ); }
+        else if ( key == "Args" )       { m_Args = value; }
+        else if ( key == "ToolChainKey" ) { m_ToolChainKey = strtoull( value.Get(), nullptr, 16 ); }
+        else if ( key == "ToolFile" )   { m_ToolFiles.Append( value ); }
+        else if ( key == "PCHKey" )     { m_PCHKey = strtoull( value.Get(), nullptr, 16 ); }
+        // Unknown keys are ignored
+    }
+    return true;
+}
+
+// GetSidecarId
+//------------------------------------------------------------------------------
+/*static*/ void CacheKeyComponents::GetSidecarId( const AString & object, AString & outSidecarId )
+{
+    // format example: 2377DE32AB045A2D.keys
+    outSidecarId.Format( "%016" PRIX64 ".keys", xxHash3::Calc64( object ) );
+}
+
+// DiffLists
+//------------------------------------------------------------------------------
+/*static*/ bool CacheKeyComponents::DiffLists( const Array< AString > & current,
+                                               const Array< AString > & previous,
+                                               const AString & currentWorkingDir,
+                                               const AString & previousWorkingDir,
+                                               AString & outExplanation )
+{
+    // Both lists are sorted, so items only in one of them are found by merging
+    Array< const AString * > added;
+    Array< const AString * > removed;
+    size_t i = 0;
+    size_t j = 0;
+    while ( ( i < current.GetSize() ) || ( j < previous.GetSize() ) )
+    {
+        if ( j == previous.GetSize() )
+        {
+            added.Append( &current[ i++ ] );
+        }
+        else if ( i == current.GetSize() )
+        {
+            removed.Append( &previous[ j++ ] );
+        }
+        else if ( current[ i ] < previous[ j ] )
+        {
+            added.Append( &current[ i++ ] );
+        }
+        else if ( previous[ j ] < current[ i ] )
+        {
+            removed.Append( &previous[ j++ ] );
+        }
+        else
+        {
+            ++i;
+            ++j;
+        }
+    }
+
+    const Array< const AString * > * const lists[ 2 ] = { &added, &removed };
+    const char prefixes[ 2 ] = { '+', '-' };
+    for ( size_t list = 0; list < 2; ++list )
+    {
+        const Array< const AString * > & items = *lists[ list ];
+        for ( size_t k = 0; k < items.GetSize(); ++k )
+        {
+            if ( k == kMaxListedDifferences )
+            {
+                outExplanation.AppendFormat( "     %c ... and %zu more\n", prefixes[ list ], ( items.GetSize() - k ) );
+                break;
+            }
+            const AString & item = *items[ k ];
+            const bool absolute = ContainsWorkingDir( item, currentWorkingDir ) ||
+                                  ContainsWorkingDir( item, previousWorkingDir );
+            outExplanation.AppendFormat( "     %c %s%s\n", prefixes[ list ], item.Get(), absolute ? " (absolute path)" : "" );
+        }
+    }
+    return ( added.IsEmpty() == false ) || ( removed.IsEmpty() == false );
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,65 @@
+// CacheKeyComponents - The inputs which make up the cache key of an object
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+// Core
+#include "Core/Containers/Array.h"
+#include "Core/Env/Types.h"
+#include "Core/Strings/AString.h"
+
+// Forward Declarations
+//------------------------------------------------------------------------------
+class ICache;
+
+// CacheKeyComponents
+//  - Recorded (with -cachekeys) in a compact sidecar alongside each cache
+//    entry stored, so an unexpected miss can be explained (with -cacheexplain)
+//  - The sidecar is stored in the cache under an id derived from the name of
+//    the object (relative to the working dir), so the nearest existing entry
+//    is the one most recently stored for the same object, from any machine
+//------------------------------------------------------------------------------
+class CacheKeyComponents
+{
+public:
+    CacheKeyComponents();
+    ~CacheKeyComponents();
+
+    // Summarize the pre-processed source, or the files hashed by the LightCache
+    void SetSourceFromPreprocessedOutput( uint64_t sourceKey, const void * data, size_t dataSize );
+    void SetSourceFromLightCache( uint64_t lightCacheKey, const Array< AString > & includes );
+
+    // Store and retrieve the sidecar for an object
+    bool Publish( ICache & cache ) const;
+    bool Retrieve( ICache & cache, const AString & object );
+
+    // Name each component which differs from another (previously recorded) key
+    void Explain( const CacheKeyComponents & previous, AString & outExplanation ) const;
+
+    // Text representation (exposed for tests)
+    void Serialize( AString & outText ) const;
+    bool Deserialize( const AString & text );
+
+    static void GetSidecarId( const AString & object, AString & outSidecarId );
+
+    AString             m_Object;           // Object name, relative to the working dir
+    AString             m_CacheId;
+    AString             m_WorkingDir;
+    uint64_t            m_SourceKey = 0;    // Hash of the pre-processed source (or LightCache key)
+    uint64_t            m_SourceSize = 0;   // Size of the pre-processed source (0 for LightCache)
+    Array< AString >    m_SourceFiles;      // Files contributing to the source (sorted)
+    AString             m_Args;             // Normalised args, as hashed
+    uint64_t            m_ToolChainKey = 0;
+    Array< AString >    m_ToolFiles;        // "<hash> <file>" for each file in the tool manifest (sorted)
+    uint64_t            m_PCHKey = 0;
+
+private:
+    static bool DiffLists( const Array< AString > & current,
+                           const Array< AString > & previous,
+                           const AString & currentWorkingDir,
+                           const AString & previousWorkingDir,
+                           AString & outExplanation );
+};
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,174 @@
+// CachePathNormalizer - Remove the workspace root from cache key inputs
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "CachePathNormalizer.h"
+
+// Core
+#include "Core/FileIO/PathUtils.h"
+#include "Core/Math/xxHash.h"
+#include "Core/Profile/Profile.h"
+#include "Core/Strings/AStackString.h"
+
+// system
+#include <string.h> // for memchr
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+CachePathNormalizer::CachePathNormalizer( const AString & root )
+{
+    // An empty root normalizes nothing
+    if ( root.IsEmpty() )
+    {
+        return;
+    }
+
+    AStackString<> nativeRoot( root );
+    PathUtils::EnsureTrailingSlash( nativeRoot );
+    m_Roots.Append( nativeRoot );
+
+    #if defined( __WINDOWS__ )
+        // Paths in args may use either slash direction
+        AStackString<> otherRoot( nativeRoot );
+        otherRoot.Replace( NATIVE_SLASH, OTHER_SLASH );
+        m_Roots.Append( otherRoot );
+
+        // Line markers escape backslashes
+        AStackString<> escapedRoot( nativeRoot );
+        escapedRoot.Replace( "\\", "\\\\" );
+        m_Roots.Append( escapedRoot );
+    #endif
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+CachePathNormalizer::~CachePathNormalizer() = default;
+
+// NormalizeArgs
+//------------------------------------------------------------------------------
+void CachePathNormalizer::NormalizeArgs( AString & args ) const
+{
+    AStackString< 8192 > normalized;
+    const char * copied = args.Get(); // Args before this have been copied
+    const char * pos = args.Get();
+    const char * const end = args.GetEnd();
+    while ( pos < end )
+    {
+        const size_t rootLength = MatchRoot( pos, end );
+        if ( rootLength == 0 )
+        {
+            ++pos;
+            continue;
+        }
+        normalized.Append( copied, pos );
+        pos += rootLength;
+        copied = pos;
+    }
+
+    // Avoid the copy if the root was not found
+    if ( copied != args.Get() )
+    {
+        normalized.Append( copied, end );
+        args = normalized;
+    }
+}
+
+// HashPreprocessedOutput
+//------------------------------------------------------------------------------
+uint64_t CachePathNormalizer::HashPreprocessedOutput( const void * data, size_t dataSize ) const
+{
+    PROFILE_FUNCTION;
+
+    // Files are named by line markers, which take the form:
+    //   # <line> "<file>" ...      (GCC/Clang)
+    //   #line <line> "<file>"      (MSVC)
+    // Other uses of the root (__FILE__ for example) are left to the compiler
+    // to remap, as they affect the compiler output
+    const char * const begin = static_cast< const char * >( data );
+    const char * const end = ( begin + dataSize );
+    const char * copied = begin; // Data before this has been copied
+    AString normalized;
+    const char * pos = begin;
+    while ( pos < end )
+    {
+        const char * lineEnd = static_cast< const char * >( memchr( pos, '\n', (size_t)( end - pos ) ) );
+        if ( lineEnd == nullptr )
+        {
+            lineEnd = end;
+        }
+        if ( *pos == '#' )
+        {
+            const char * const quote = static_cast< const char * >( memchr( pos, '"', (size_t)( lineEnd - pos ) ) );
+            if ( quote )
+            {
+                const char * const path = ( quote + 1 );
+                const size_t rootLength = MatchRoot( path, lineEnd );
+                if ( rootLength > 0 )
+                {
+                    if ( copied == begin )
+                    {
+                        normalized.SetReserved( dataSize );
+                    }
+                    normalized.Append( copied, path );
+                    copied = ( path + rootLength );
+                }
+            }
+        }
+        pos = ( lineEnd + 1 );
+    }
+
+    // Avoid the copy if the root was not found
+    if ( copied == begin )
+    {
+        return xxHash3::Calc64( data, dataSize );
+    }
+    normalized.Append( copied, end );
+    return xxHash3::Calc64( normalized );
+}
+
+// MatchRoot
+//------------------------------------------------------------------------------
+size_t CachePathNormalizer::MatchRoot( const char * pos, const char * end ) const
+{
+    const size_t available = static_cast< size_t >( end - pos );
+    const auto matches = [ pos, available ]( const AString & root, size_t length ) -> bool
+    {
+        if ( ( length == 0 ) || ( length > available ) )
+        {
+            return false;
+        }
+        #if defined( __WINDOWS__ )
+            return ( AString::StrNCmpI( pos, root.Get(), length ) == 0 );
+        #else
+            return ( AString::StrNCmp( pos, root.Get(), length ) == 0 );
+        #endif
+    };
+
+    for ( const AString & root : m_Roots )
+    {
+        // Paths under the root
+        if ( matches( root, root.GetLength() ) )
+        {
+            return root.GetLength();
+        }
+
+        // The root itself (in a prefix map arg for example)
+        size_t length = root.GetLength();
+        while ( ( length > 0 ) && ( ( root[ length - 1 ] == NATIVE_SLASH ) || ( root[ length - 1 ] == OTHER_SLASH ) ) )
+        {
+            --length;
+        }
+        if ( matches( root, length ) )
+        {
+            const char next = ( length < available ) ? pos[ length ] : ' ';
+            if ( ( next == ' ' ) || ( next == '"' ) || ( next == '=' ) )
+            {
+                return length;
+            }
+        }
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,38 @@
+// CachePathNormalizer - Remove the workspace root from cache key inputs
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+// Core
+#include "Core/Containers/Array.h"
+#include "Core/Env/Types.h"
+#include "Core/Strings/AString.h"
+
+// CachePathNormalizer
+//  - Paths under the root are treated as relative to it, so workspaces in
+//    different locations compute the same cache keys
+//  - On Windows, the root is matched with either slash direction, and with
+//    backslashes escaped as they are in line markers
+//  - The root itself is matched when not followed by more of a path
+//  - An empty root leaves everything unchanged
+//------------------------------------------------------------------------------
+class CachePathNormalizer
+{
+public:
+    explicit CachePathNormalizer( const AString & root );
+    ~CachePathNormalizer();
+
+    // Remove the root from all paths in the args
+    void NormalizeArgs( AString & args ) const;
+
+    // Hash pre-processed output, ignoring the root in line markers
+    uint64_t HashPreprocessedOutput( const void * data, size_t dataSize ) const;
+
+private:
+    size_t MatchRoot( const char * pos, const char * end ) const; // Length of root matched at pos, or 0
+
+    Array< AString >    m_Roots; // Forms of the root, each slash terminated
+};
+
+//------------------------------------------------------------------------------
@@ -7,6 +7,7 @@
 
 // FBuild
 #include "Tools/FBuild/FBuildCore/FLog.h"
+#include "Tools/FBuild/FBuildCore/Helpers/Metrics.h"
 
 // Core
 #include "Core/Env/ErrorFormat.h"
@@ -176,7 +177,13 @@ void * CachePlugin::GetFunction( const char * name, const char * mangledName, bo
 
     if ( m_PublishFunc )
     {
-        return (*m_PublishFunc)( cacheId.Get(), data, dataSize );
+        const bool ok = (*m_PublishFunc)( cacheId.Get(), data, dataSize );
+        if ( ok )
+        {
+            Metrics::s_CacheStores.Add();
+            Metrics::s_CacheBytesWritten.Add( dataSize );
+        }
+        return ok;
     }
     return false;
 }
@@ -195,6 +202,15 @@ void * CachePlugin::GetFunction( const char * name, const char * mangledName, bo
         unsigned long long size;
         const bool ok = (*m_RetrieveFunc)( cacheId.Get(), data, size );
         dataSize = (size_t)size;
+        if ( ok )
+        {
+            Metrics::s_CacheHits.Add();
+            Metrics::s_CacheBytesRead.Add( dataSize );
+        }
+        else
+        {
+            Metrics::s_CacheMisses.Add();
+        }
         return ok;
     }
     return false;
@@ -213,6 +229,15 @@ void * CachePlugin::GetFunction( const char * name, const char * mangledName, bo
     (*m_FreeMemoryFunc)( data, dataSize );
 }
 
+// Quarantine
+//------------------------------------------------------------------------------
+/*virtual*/ bool CachePlugin::Quarantine( const AString & /*cacheId*/ )
+{
+    // Not supported by the plugin interface. The corrupt entry
+    // will be replaced when the object is next stored.
+    return false;
+}
+
 // OutputInfo
 //------------------------------------------------------------------------------
 /*virtual*/ bool CachePlugin::OutputInfo( bool showProgress )
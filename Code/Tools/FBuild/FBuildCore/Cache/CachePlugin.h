@@ -31,6 +31,7 @@ public:
     virtual void FreeMemory( void * data, size_t dataSize ) override;
     virtual bool OutputInfo( bool showProgress ) override;
     virtual bool Trim( bool showProgress, uint32_t sizeMiB ) override;
+    virtual bool Quarantine( const AString & cacheId ) override;
 private:
     void * GetFunction( const char * friendlyName, const char * mangledName = nullptr, bool optional = false );
 
@@ -30,6 +30,7 @@ public:
     virtual void FreeMemory( void * data, size_t dataSize ) = 0;
     virtual bool OutputInfo( bool showProgress ) = 0;
     virtual bool Trim( bool showProgress, uint32_t sizeMiB ) = 0;
+    virtual bool Quarantine( const AString & cacheId ) = 0; // Remove a corrupt entry from use (returns true if removed)
 
     // Helper functions
     static void GetCacheId( const uint64_t preprocessedSourceKey,
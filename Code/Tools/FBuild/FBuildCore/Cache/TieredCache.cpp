@@ -0,0 +1,338 @@
+// TieredCache - Local cache in front of a shared cache
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "TieredCache.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/Cache/CacheEntry.h"
+#include "Tools/FBuild/FBuildCore/FLog.h"
+#include "Tools/FBuild/FBuildCore/Helpers/Metrics.h"
+
+// Core
+#include "Core/FileIO/FileIO.h"
+#include "Core/Math/Conversions.h"
+#include "Core/Mem/Mem.h"
+#include "Core/Profile/Profile.h"
+#include "Core/Strings/AStackString.h"
+#include "Core/Tracing/Tracing.h"
+
+// system
+#include <memory.h> // for memcpy
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+TieredCache::TieredCache( ICache * sharedCache, const AString & localCachePath, uint32_t localCacheSizeMiB )
+    : m_SharedCache( sharedCache )
+    , m_LocalCache( true ) // isLocalTier
+    , m_LocalCachePath( localCachePath )
+    , m_LocalCacheSizeMiB( localCacheSizeMiB )
+    , m_LocalCacheValid( false )
+    , m_Verbose( false )
+    , m_WriteThreadExit( false )
+    , m_PendingWrites( 1024 )
+    , m_PendingWriteBytes( 0 )
+    , m_LocalWritesAtLastSizeCheck( 0 )
+{
+    ASSERT( m_SharedCache );
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+TieredCache::~TieredCache()
+{
+    ASSERT( m_WriteThread.IsRunning() == false ); // Shutdown should have been called
+    ASSERT( m_PendingWrites.IsEmpty() );
+    FDELETE m_SharedCache;
+}
+
+// Init
+//------------------------------------------------------------------------------
+/*virtual*/ bool TieredCache::Init( const AString & cachePath,
+                                    const AString & cachePathMountPoint,
+                                    bool cacheRead,
+                                    bool cacheWrite,
+                                    bool cacheVerbose,
+                                    const AString & pluginDLLConfig )
+{
+    PROFILE_FUNCTION;
+
+    // Caching is only disabled if the shared cache is unavailable
+    if ( m_SharedCache->Init( cachePath, cachePathMountPoint, cacheRead, cacheWrite, cacheVerbose, pluginDLLConfig ) == false )
+    {
+        return false;
+    }
+    m_Verbose = cacheVerbose;
+
+    if ( FileIO::EnsurePathExists( m_LocalCachePath ) == false )
+    {
+        FLOG_WARN( "Local cache inaccessible - Using shared cache only (Path '%s')", m_LocalCachePath.Get() );
+        return true;
+    }
+    m_LocalCacheValid = m_LocalCache.Init( m_LocalCachePath, AString::GetEmpty(), cacheRead, cacheWrite, cacheVerbose, AString::GetEmpty() );
+    if ( m_LocalCacheValid )
+    {
+        m_WriteThread.Start( WriteThreadFuncStatic, "CacheWrite", this );
+    }
+    return true;
+}
+
+// Shutdown
+//------------------------------------------------------------------------------
+/*virtual*/ void TieredCache::Shutdown()
+{
+    PROFILE_FUNCTION;
+
+    if ( m_WriteThread.IsRunning() )
+    {
+        // Thread completes pending writes before exiting
+        m_WriteThreadExit.Store( true );
+        m_WriteSemaphore.Signal();
+        m_WriteThread.Join();
+    }
+
+    // Keep local cache within its limit
+    if ( m_NumLocalWrites.Load() != m_LocalWritesAtLastSizeCheck )
+    {
+        m_LocalCache.EnforceSizeLimit( m_LocalCacheSizeMiB );
+    }
+
+    if ( m_Verbose && m_LocalCacheValid )
+    {
+        OUTPUT( "Tiered Cache:\n"
+                " - Local Hits    : %u (%u corrupt)\n"
+                " - Shared Hits   : %u\n"
+                " - Local Writes  : %u\n"
+                " - Shared Writes : %u (%u failed)\n",
+                m_NumLocalHits.Load(),
+                m_NumLocalCorrupt.Load(),
+                m_NumSharedHits.Load(),
+                m_NumLocalWrites.Load(),
+                m_NumSharedWrites.Load(),
+                m_NumSharedWriteFailures.Load() );
+    }
+
+    m_LocalCache.Shutdown();
+    m_SharedCache->Shutdown();
+}
+
+// Publish
+//------------------------------------------------------------------------------
+/*virtual*/ bool TieredCache::Publish( const AString & cacheId, const void * data, size_t dataSize )
+{
+    if ( m_LocalCacheValid == false )
+    {
+        return m_SharedCache->Publish( cacheId, data, dataSize );
+    }
+
+    if ( m_LocalCache.Publish( cacheId, data, dataSize ) )
+    {
+        m_NumLocalWrites.Increment();
+    }
+    QueueWrite( cacheId, data, dataSize, false ); // toLocalCache
+    return true;
+}
+
+// Retrieve
+//------------------------------------------------------------------------------
+/*virtual*/ bool TieredCache::Retrieve( const AString & cacheId, void * & data, size_t & dataSize )
+{
+    if ( m_LocalCacheValid && m_LocalCache.Retrieve( cacheId, data, dataSize ) )
+    {
+        // A corrupt local entry is replaced from the shared cache
+        AStackString<> problem;
+        if ( CacheEntry::Verify( data, dataSize, problem ) )
+        {
+            // Local cache doesn't record metrics itself
+            m_NumLocalHits.Increment();
+            Metrics::s_CacheHits.Add();
+            Metrics::s_CacheLocalHits.Add();
+            Metrics::s_CacheBytesRead.Add( dataSize );
+            return true;
+        }
+        FLOG_WARN( "Local cache entry corrupt - quarantined (Key: %s, Problem: %s)", cacheId.Get(), problem.Get() );
+        m_LocalCache.FreeMemory( data, dataSize );
+        m_LocalCache.Quarantine( cacheId );
+        m_NumLocalCorrupt.Increment();
+    }
+
+    void * sharedData = nullptr;
+    size_t sharedDataSize = 0;
+    if ( m_SharedCache->Retrieve( cacheId, sharedData, sharedDataSize ) == false )
+    {
+        data = nullptr;
+        dataSize = 0;
+        return false;
+    }
+    m_NumSharedHits.Increment();
+
+    // Take a copy so memory from either cache can be freed the same way
+    data = ALLOC( sharedDataSize );
+    memcpy( data, sharedData, sharedDataSize );
+    dataSize = sharedDataSize;
+    m_SharedCache->FreeMemory( sharedData, sharedDataSize );
+
+    if ( m_LocalCacheValid )
+    {
+        QueueWrite( cacheId, data, dataSize, true ); // toLocalCache
+    }
+    return true;
+}
+
+// FreeMemory
+//------------------------------------------------------------------------------
+/*virtual*/ void TieredCache::FreeMemory( void * data, size_t /*dataSize*/ )
+{
+    FREE( data );
+}
+
+// OutputInfo
+//------------------------------------------------------------------------------
+/*virtual*/ bool TieredCache::OutputInfo( bool showProgress )
+{
+    if ( m_LocalCacheValid )
+    {
+        OUTPUT( "Local Cache: '%s'\n", m_LocalCachePath.Get() );
+        m_LocalCache.OutputInfo( showProgress );
+        OUTPUT( "Shared Cache:\n" );
+    }
+    return m_SharedCache->OutputInfo( showProgress );
+}
+
+// Trim
+//------------------------------------------------------------------------------
+/*virtual*/ bool TieredCache::Trim( bool showProgress, uint32_t sizeMiB )
+{
+    if ( m_LocalCacheValid )
+    {
+        OUTPUT( "Local Cache: '%s'\n", m_LocalCachePath.Get() );
+        m_LocalCache.Trim( showProgress, Math::Min( sizeMiB, m_LocalCacheSizeMiB ) );
+        OUTPUT( "Shared Cache:\n" );
+    }
+    return m_SharedCache->Trim( showProgress, sizeMiB );
+}
+
+// Quarantine
+//------------------------------------------------------------------------------
+/*virtual*/ bool TieredCache::Quarantine( const AString & cacheId )
+{
+    // Retrieve only returns intact local entries, so corrupt data came from
+    // the shared cache (and was not copied to the local cache)
+    return m_SharedCache->Quarantine( cacheId );
+}
+
+// QueueWrite
+//------------------------------------------------------------------------------
+void TieredCache::QueueWrite( const AString & cacheId, const void * data, size_t dataSize, bool toLocalCache )
+{
+    PendingWrite * write = FNEW( PendingWrite );
+    write->m_CacheId = cacheId;
+    write->m_DataSize = dataSize;
+    write->m_ToLocalCache = toLocalCache;
+
+    {
+        MutexHolder mh( m_PendingWritesMutex );
+        if ( ( m_PendingWriteBytes + dataSize ) <= kMaxPendingWriteBytes )
+        {
+            write->m_Data = ALLOC( dataSize );
+            memcpy( write->m_Data, data, dataSize );
+            m_PendingWriteBytes += dataSize;
+            m_PendingWrites.Append( write );
+            m_WriteSemaphore.Signal();
+            return;
+        }
+    }
+
+    // Too much is pending, so write on the calling thread, without a copy
+    write->m_Data = const_cast< void * >( data );
+    ProcessWrite( *write );
+    FDELETE write;
+}
+
+// ProcessWrite
+//------------------------------------------------------------------------------
+void TieredCache::ProcessWrite( const PendingWrite & write )
+{
+    PROFILE_FUNCTION;
+
+    if ( write.m_ToLocalCache )
+    {
+        // Don't propagate corruption from the shared cache
+        AStackString<> problem;
+        if ( CacheEntry::Verify( write.m_Data, write.m_DataSize, problem ) &&
+             m_LocalCache.Publish( write.m_CacheId, write.m_Data, write.m_DataSize ) )
+        {
+            m_NumLocalWrites.Increment();
+        }
+        return;
+    }
+
+    if ( m_SharedCache->Publish( write.m_CacheId, write.m_Data, write.m_DataSize ) )
+    {
+        m_NumSharedWrites.Increment();
+    }
+    else
+    {
+        m_NumSharedWriteFailures.Increment();
+        FLOG_WARN( "Failed to write to shared cache (Key: %s)", write.m_CacheId.Get() );
+    }
+}
+
+// WriteThreadFuncStatic
+//------------------------------------------------------------------------------
+/*static*/ uint32_t TieredCache::WriteThreadFuncStatic( void * param )
+{
+    PROFILE_SET_THREAD_NAME( "CacheWriteThread" );
+
+    TieredCache * cache = static_cast< TieredCache * >( param );
+    cache->WriteThreadFunc();
+    return 0;
+}
+
+// WriteThreadFunc
+//------------------------------------------------------------------------------
+void TieredCache::WriteThreadFunc()
+{
+    for ( ;; )
+    {
+        m_WriteSemaphore.Wait();
+
+        // Take the oldest write
+        PendingWrite * write = nullptr;
+        {
+            MutexHolder mh( m_PendingWritesMutex );
+            if ( m_PendingWrites.IsEmpty() == false )
+            {
+                write = m_PendingWrites[ 0 ];
+                m_PendingWrites.PopFront();
+            }
+        }
+
+        // The exit signal follows the signals for all pending writes
+        if ( write == nullptr )
+        {
+            ASSERT( m_WriteThreadExit.Load() );
+            return;
+        }
+
+        ProcessWrite( *write );
+
+        {
+            MutexHolder mh( m_PendingWritesMutex );
+            m_PendingWriteBytes -= write->m_DataSize;
+        }
+        FREE( write->m_Data );
+        FDELETE write;
+
+        // Keep local cache within its limit during long builds
+        const uint32_t numLocalWrites = m_NumLocalWrites.Load();
+        if ( ( numLocalWrites - m_LocalWritesAtLastSizeCheck ) >= kLocalWritesPerSizeCheck )
+        {
+            m_LocalWritesAtLastSizeCheck = numLocalWrites;
+            m_LocalCache.EnforceSizeLimit( m_LocalCacheSizeMiB );
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,96 @@
+// TieredCache - Local cache in front of a shared cache
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Cache.h"
+
+// Core
+#include "Core/Containers/Array.h"
+#include "Core/Process/Atomic.h"
+#include "Core/Process/Mutex.h"
+#include "Core/Process/Semaphore.h"
+#include "Core/Process/Thread.h"
+#include "Core/Strings/AString.h"
+
+// TieredCache
+//  - Retrievals are served from the local cache when possible, falling back to
+//    the shared cache. Entries retrieved from the shared cache are copied to
+//    the local cache for subsequent builds
+//  - Local entries are verified when retrieved. Corrupt ones are quarantined
+//    and retrieved from the shared cache instead
+//  - Publications are written to the local cache immediately, and to the
+//    shared cache in the background so slow shared storage doesn't hold up
+//    the build. Pending writes are completed at Shutdown
+//  - The local cache is kept under its size limit by removing the least
+//    recently used entries, periodically during the build and at Shutdown
+//------------------------------------------------------------------------------
+class TieredCache : public ICache
+{
+public:
+    // Takes ownership of the shared cache
+    explicit TieredCache( ICache * sharedCache, const AString & localCachePath, uint32_t localCacheSizeMiB );
+    virtual ~TieredCache() override;
+
+    virtual bool Init( const AString & cachePath,
+                       const AString & cachePathMountPoint,
+                       bool cacheRead,
+                       bool cacheWrite,
+                       bool cacheVerbose,
+                       const AString & pluginDLLConfig ) override;
+    virtual void Shutdown() override;
+    virtual bool Publish( const AString & cacheId, const void * data, size_t dataSize ) override;
+    virtual bool Retrieve( const AString & cacheId, void * & data, size_t & dataSize ) override;
+    virtual void FreeMemory( void * data, size_t dataSize ) override;
+    virtual bool OutputInfo( bool showProgress ) override;
+    virtual bool Trim( bool showProgress, uint32_t sizeMiB ) override;
+    virtual bool Quarantine( const AString & cacheId ) override;
+
+private:
+    class PendingWrite
+    {
+    public:
+        AString     m_CacheId;
+        void *      m_Data;
+        size_t      m_DataSize;
+        bool        m_ToLocalCache; // Otherwise to shared cache
+    };
+
+    void            QueueWrite( const AString & cacheId, const void * data, size_t dataSize, bool toLocalCache );
+    void            ProcessWrite( const PendingWrite & write );
+    static uint32_t WriteThreadFuncStatic( void * param );
+    void            WriteThreadFunc();
+
+    // Limit memory held by pending writes. Beyond this, writes are synchronous
+    enum : uint64_t { kMaxPendingWriteBytes = ( 256 * 1024 * 1024 ) };
+
+    // How often the local cache size is checked during the build
+    enum : uint32_t { kLocalWritesPerSizeCheck = 1000 };
+
+    ICache *                m_SharedCache;
+    Cache                   m_LocalCache;
+    AString                 m_LocalCachePath;
+    uint32_t                m_LocalCacheSizeMiB;
+    bool                    m_LocalCacheValid;
+    bool                    m_Verbose;
+
+    // Background writes
+    Thread                  m_WriteThread;
+    Semaphore               m_WriteSemaphore;
+    Atomic< bool >          m_WriteThreadExit;
+    Mutex                   m_PendingWritesMutex;
+    Array< PendingWrite * > m_PendingWrites;
+    uint64_t                m_PendingWriteBytes;
+    uint32_t                m_LocalWritesAtLastSizeCheck; // Only accessed by write thread (until Shutdown)
+
+    // Stats
+    Atomic< uint32_t >      m_NumLocalHits;
+    Atomic< uint32_t >      m_NumLocalCorrupt;
+    Atomic< uint32_t >      m_NumSharedHits;
+    Atomic< uint32_t >      m_NumLocalWrites;
+    Atomic< uint32_t >      m_NumSharedWrites;
+    Atomic< uint32_t >      m_NumSharedWriteFailures;
+};
+
+//------------------------------------------------------------------------------
@@ -744,6 +744,14 @@
     FormatError( iter, 1504u, function, "CSAssembly requires a C# Compiler." );
 }
 
+// Error_1505_NormalizeCachePathsIncompatibleWithCompiler
+//------------------------------------------------------------------------------
+/*static*/ void Error::Error_1505_NormalizeCachePathsIncompatibleWithCompiler( const BFFToken * iter,
+                                                                               const Function * function )
+{
+    FormatError( iter, 1505u, function, "NormalizeCachePaths only compatible with GCC and Clang Compilers." );
+}
+
 // Error_1600_TooManyConcurrencyGroups
 //------------------------------------------------------------------------------
 /*static*/ void Error::Error_1600_TooManyConcurrencyGroups( const BFFToken * iter,
@@ -226,6 +226,8 @@ public:
                                                               const Function * function );
     static void Error_1504_CSAssemblyRequiresACSharpCompiler( const BFFToken * iter,
                                                               const Function * function );
+    static void Error_1505_NormalizeCachePathsIncompatibleWithCompiler( const BFFToken * iter,
+                                                                       const Function * function );
 
     // 1600-1699 : Concurrency Group Errors
     //------------------------------------------------------------------------------
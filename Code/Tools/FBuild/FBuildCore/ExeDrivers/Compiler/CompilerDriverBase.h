@@ -27,6 +27,7 @@ public:
 
     void SetForceColoredDiagnostics( bool forceColoredDiagnostics ) { m_ForceColoredDiagnostics = forceColoredDiagnostics; }
     void SetUseSourceMapping( const AString & sourceMapping ) { m_SourceMapping = sourceMapping; }
+    void SetNormalizedPathRoot( const AString & normalizedPathRoot ) { m_NormalizedPathRoot = normalizedPathRoot; }
     void SetRelativeBasePath( const AString & relativeBasePath ) { m_RelativeBasePath = relativeBasePath; }
     void SetOverrideSourceFile( const AString & overrideSourceFile ) { m_OverrideSourceFile= overrideSourceFile; }
 
@@ -72,6 +73,7 @@ protected:
     const ObjectNode *  m_ObjectNode                = nullptr;
     bool                m_ForceColoredDiagnostics   = false;
     AString             m_SourceMapping;
+    AString             m_NormalizedPathRoot;
     AString             m_RelativeBasePath;
     AString             m_OverrideSourceFile;
     AString             m_RemoteSourceRoot;
@@ -191,6 +191,27 @@ CompilerDriver_GCCClang::~CompilerDriver_GCCClang() = default;
         tmp.Format(" \"-fdebug-prefix-map=%s=%s\"", workingDir.Get(), m_SourceMapping.Get());
         outFullArgs += tmp;
     }
+
+    // Add args for cache path normalization
+    if ( ( m_NormalizedPathRoot.IsEmpty() == false ) && isLocal )
+    {
+        // Paths under the root are made relative, so outputs match across workspaces
+        // (as do cache keys, which ignore the root). -ffile-prefix-map also remaps
+        // debug info, so only __FILE__ is remapped when source mapping is used.
+        // The root is mapped without a trailing slash so the compilation dir (which
+        // is the root itself) is remapped too.
+        AStackString<> tmp;
+        if ( m_ObjectNode->GetCompiler()->SupportsFilePrefixMap() )
+        {
+            tmp.Format( " \"-f%s-prefix-map=%s=.\"", m_SourceMapping.IsEmpty() ? "file" : "macro", m_NormalizedPathRoot.Get() );
+        }
+        else if ( m_SourceMapping.IsEmpty() )
+        {
+            // Older compilers (before GCC 8 and Clang 10) can only remap debug info
+            tmp.Format( " \"-fdebug-prefix-map=%s=.\"", m_NormalizedPathRoot.Get() );
+        }
+        outFullArgs += tmp;
+    }
 }
 
 // ProcessArg_PreparePreprocessedForRemote
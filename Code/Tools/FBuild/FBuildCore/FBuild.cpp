@@ -12,12 +12,18 @@
 #include "Cache/Cache.h"
 #include "Cache/CachePlugin.h"
 #include "Cache/LightCache.h"
+#include "Cache/TieredCache.h"
 #include "Graph/Node.h"
 #include "Graph/NodeGraph.h"
 #include "Graph/NodeProxy.h"
 #include "Graph/SettingsNode.h"
+#include "Helpers/BuildHistory.h"
 #include "Helpers/BuildProfiler.h"
+#include "Helpers/BuildTrace.h"
 #include "Helpers/CompilationDatabase.h"
+#include "Helpers/HeaderImpact.h"
+#include "Helpers/MetricsServer.h"
+#include "Helpers/Report/Report.h"
 #include "Protocol/Client.h"
 #include "Protocol/Protocol.h"
 #include "WorkerPool/JobQueue.h"
@@ -108,6 +114,16 @@ FBuild::FBuild( const FBuildOptions & options )
     {
         FNEW( BuildProfiler );
     }
+    if ( options.m_Trace )
+    {
+        FNEW( BuildTrace );
+    }
+
+    if ( options.m_MetricsPort )
+    {
+        m_MetricsServer = FNEW( MetricsServer );
+        m_MetricsServer->Start( options.m_MetricsPort );
+    }
 
     Function::Create();
 
@@ -124,6 +140,7 @@ FBuild::~FBuild()
 
     FDELETE m_DependencyGraph;
     FDELETE m_Client;
+    FDELETE m_MetricsServer;
     FREE( m_EnvironmentString );
 
     if ( m_Cache )
@@ -145,6 +162,10 @@ FBuild::~FBuild()
     {
         FDELETE( &BuildProfiler::Get() );
     }
+    if ( BuildTrace::IsValid() )
+    {
+        FDELETE( &BuildTrace::Get() );
+    }
 
     FDELETE m_ThreadPool;
 }
@@ -172,26 +193,7 @@ bool FBuild::Initialize( const char * nodeGraphDBFile )
     }
     else
     {
-        if ( m_Options.m_DBFile.IsEmpty() )
-        {
-            m_DependencyGraphFile = bffFile;
-            if ( m_DependencyGraphFile.EndsWithI( ".bff" ) )
-            {
-                m_DependencyGraphFile.SetLength( m_DependencyGraphFile.GetLength() - 4 );
-            }
-            #if defined( __WINDOWS__ )
-                m_DependencyGraphFile += ".windows.fdb";
-            #elif defined( __OSX__ )
-                m_DependencyGraphFile += ".osx.fdb";
-            #elif defined( __LINUX__ )
-                m_DependencyGraphFile += ".linux.fdb";
-            #endif
-        }
-        else
-        {
-            // DB filename explicitly set on command line
-            m_DependencyGraphFile = m_Options.m_DBFile;
-        }
+        GetDependencyGraphFileName( m_Options, m_DependencyGraphFile );
     }
 
     m_DependencyGraph = NodeGraph::Initialize( bffFile, m_DependencyGraphFile.Get(), m_Options.m_ForceDBMigration_Debug );
@@ -215,6 +217,12 @@ bool FBuild::Initialize( const char * nodeGraphDBFile )
             m_Cache = FNEW( Cache() );
         }
 
+        // Optional local cache in front of the shared cache
+        if ( !settings->GetCacheLocalPath().IsEmpty() )
+        {
+            m_Cache = FNEW( TieredCache( m_Cache, settings->GetCacheLocalPath(), settings->GetCacheLocalSizeMiB() ) );
+        }
+
         if ( m_Cache->Init( settings->GetCachePath(),
                             settings->GetCachePathMountPoint(),
                             m_Options.m_UseCacheRead,
@@ -389,8 +397,13 @@ void FBuild::SaveDependencyGraph( MemoryStream & stream, const char* nodeGraphDB
 {
     ASSERT( nodeToBuild );
 
-    AtomicStoreRelaxed( &s_StopBuild, false ); // allow multiple runs in same process
-    AtomicStoreRelaxed( &s_AbortBuild, false ); // allow multiple runs in same process
+    ResetStopBuild(); // allow multiple runs in same process
+
+    // check files in parallel while the thread pool is idle (before the worker threads take it over)
+    if ( m_ThreadPool && m_Options.m_PrefetchFileStamps )
+    {
+        NodeGraph::PrefetchFileStamps( nodeToBuild, *m_ThreadPool, m_Options.m_ForceCleanBuild, m_Options.m_UseContentHash, m_FileTimeCache );
+    }
 
     // create worker threads
     m_JobQueue = FNEW( JobQueue( m_Options.m_NumWorkerThreads, m_ThreadPool ) );
@@ -439,6 +452,9 @@ void FBuild::SaveDependencyGraph( MemoryStream & stream, const char* nodeGraphDB
         BuildProfiler::Get().StartMetricsGathering();
     }
 
+    // prioritize jobs on the critical path, using build times from previous builds
+    NodeGraph::ComputeCriticalPathCosts( nodeToBuild );
+
     bool stopping( false );
 
     // keep doing build passes until completed/failed
@@ -543,9 +559,75 @@ void FBuild::SaveDependencyGraph( MemoryStream & stream, const char* nodeGraphDB
 
     m_BuildStats.OnBuildStop( *m_DependencyGraph, nodeToBuild );
 
+    // record build history and compare with the previous build
+    if ( m_Options.m_History )
+    {
+        UpdateBuildHistory( timeTaken );
+    }
+
     return ( nodeToBuild->GetState() == Node::UP_TO_DATE );
 }
 
+// UpdateBuildHistory
+//------------------------------------------------------------------------------
+void FBuild::UpdateBuildHistory( float totalBuildTime )
+{
+    PROFILE_FUNCTION;
+
+    AStackString<> historyFile( m_DependencyGraphFile );
+    historyFile += ".history";
+
+    BuildHistory history;
+    if ( history.Load( historyFile ) == false )
+    {
+        FLOG_WARN( "Build history is invalid and will be reset: '%s'", historyFile.Get() );
+    }
+
+    if ( m_Options.m_Compare )
+    {
+        AString report( 4096 );
+        history.Compare( *m_DependencyGraph, totalBuildTime, report );
+        OUTPUT( "%s", report.Get() );
+    }
+
+    history.AddBuild( *m_DependencyGraph, totalBuildTime );
+    if ( history.Save( historyFile ) == false )
+    {
+        FLOG_WARN( "Failed to save build history: '%s'", historyFile.Get() );
+    }
+}
+
+// PrepareForNextBuild
+//------------------------------------------------------------------------------
+void FBuild::PrepareForNextBuild()
+{
+    m_DependencyGraph->ResetNodeStates();
+    m_BuildStats = FBuildStats();
+
+    // Cached include parsing results can't be selectively invalidated
+    // (they include the non-existence of files)
+    LightCache::ClearCachedFiles();
+}
+
+// IsDependencyGraphOutOfDate
+//------------------------------------------------------------------------------
+bool FBuild::IsDependencyGraphOutOfDate() const
+{
+    if ( m_DependencyGraph->HaveUsedFilesChanged() )
+    {
+        return true;
+    }
+
+    bool added;
+    const AString * changedFile = m_FileExistsInfo.CheckForChanges( added );
+    if ( changedFile )
+    {
+        FLOG_VERBOSE( "File used in file_exists was %s '%s'", added ? "added" : "removed", changedFile->Get() );
+        return true;
+    }
+    return false;
+}
+
 // SetEnvironmentString
 //------------------------------------------------------------------------------
 void FBuild::SetEnvironmentString( const char * envString, uint32_t size, const AString & libEnvVar )
@@ -656,6 +738,14 @@ void FBuild::AbortBuild()
     return AtomicLoadRelaxed( &s_StopBuild );
 }
 
+// ResetStopBuild
+//------------------------------------------------------------------------------
+/*static*/ void FBuild::ResetStopBuild()
+{
+    AtomicStoreRelaxed( &s_StopBuild, false );
+    AtomicStoreRelaxed( &s_AbortBuild, false );
+}
+
 // UpdateBuildStatus
 //------------------------------------------------------------------------------
 void FBuild::UpdateBuildStatus( const Node * node )
@@ -731,6 +821,33 @@ void FBuild::UpdateBuildStatus( const Node * node )
     return "fbuild.bff";
 }
 
+// GetDependencyGraphFileName
+//------------------------------------------------------------------------------
+/*static*/ void FBuild::GetDependencyGraphFileName( const FBuildOptions & options, AString & outFileName )
+{
+    if ( options.m_DBFile.IsEmpty() == false )
+    {
+        // DB filename explicitly set on command line
+        outFileName = options.m_DBFile;
+        return;
+    }
+
+    // Named after the bff
+    outFileName = options.m_ConfigFile.IsEmpty() ? GetDefaultBFFFileName()
+                                                 : options.m_ConfigFile.Get();
+    if ( outFileName.EndsWithI( ".bff" ) )
+    {
+        outFileName.SetLength( outFileName.GetLength() - 4 );
+    }
+    #if defined( __WINDOWS__ )
+        outFileName += ".windows.fdb";
+    #elif defined( __OSX__ )
+        outFileName += ".osx.fdb";
+    #elif defined( __LINUX__ )
+        outFileName += ".linux.fdb";
+    #endif
+}
+
 // DisplayTargetList
 //------------------------------------------------------------------------------
 void FBuild::DisplayTargetList( bool showHidden ) const
@@ -860,6 +977,23 @@ bool FBuild::GenerateCompilationDatabase( const Array< AString > & targets ) con
     return true;
 }
 
+// GenerateHeaderImpactReport
+//------------------------------------------------------------------------------
+bool FBuild::GenerateHeaderImpactReport( const AString & reportType ) const
+{
+    HeaderImpact headerImpact;
+    headerImpact.Analyze( *m_DependencyGraph, m_ThreadPool );
+
+    const char * const reportFileName = ( reportType == "json" ) ? "headerimpact.json" : "headerimpact.html";
+    OUTPUT( "Saving header impact report for %u headers to '%s'\n", (uint32_t)headerImpact.GetHeaders().GetSize(), reportFileName );
+    if ( Report::GenerateHeaderImpact( reportType, headerImpact ) == false )
+    {
+        FLOG_ERROR( "Failed to write header impact report '%s'", reportFileName );
+        return false;
+    }
+    return true;
+}
+
 // GetTempDir
 //------------------------------------------------------------------------------
 /*static*/ bool FBuild::GetTempDir( AString & outTempDir )
@@ -22,8 +22,10 @@
 class Client;
 class Dependencies;
 class FileStream;
+class FileTimeCache;
 class ICache;
 class MemoryStream;
+class MetricsServer;
 class JobQueue;
 class Node;
 class NodeGraph;
@@ -47,6 +49,11 @@ public:
     bool Build( const Array< AString > & targets );
     virtual bool Build( Node * nodeToBuild ); // Virtual to allow for testing
 
+    // long-lived processes can build repeatedly (see BuildDaemon)
+    void SetFileTimeCache( FileTimeCache * fileTimeCache ) { m_FileTimeCache = fileTimeCache; }
+    void PrepareForNextBuild();
+    bool IsDependencyGraphOutOfDate() const;
+
     // after a build we can store progress/parsed rules for next time
     bool SaveDependencyGraph( const char * nodeGraphDBFile ) const;
     void SaveDependencyGraph( MemoryStream & memorySteam, const char* nodeGraphDBFile ) const;
@@ -56,6 +63,7 @@ public:
     const AString & GetWorkingDir() const { return m_Options.GetWorkingDir(); }
 
     static const char * GetDefaultBFFFileName();
+    static void GetDependencyGraphFileName( const FBuildOptions & options, AString & outFileName );
 
     inline const SettingsNode * GetSettings() const { return m_DependencyGraph->GetSettings(); }
 
@@ -67,6 +75,7 @@ public:
     bool DisplayDependencyDB( const Array< AString > & targets ) const;
     bool GenerateDotGraph( const Array< AString > & targets, const bool fullGraph ) const;
     bool GenerateCompilationDatabase( const Array< AString > & targets ) const;
+    bool GenerateHeaderImpactReport( const AString & reportType ) const;
 
     class EnvironmentVarAndHash
     {
@@ -103,6 +112,7 @@ public:
     static        void AbortBuild();
     static        void OnBuildError();
     static        bool GetStopBuild();
+    static        void ResetStopBuild();
     static inline volatile bool * GetAbortBuildPointer() { return &s_AbortBuild; }
 
     inline ICache * GetCache() const { return m_Cache; }
@@ -118,6 +128,7 @@ protected:
     bool GetTargets( const Array< AString > & targets, Dependencies & outDeps ) const;
 
     void UpdateBuildStatus( const Node * node );
+    void UpdateBuildHistory( float totalBuildTime );
 
     // Retrieve status of targets on build end
     enum : uint32_t
@@ -133,12 +144,14 @@ protected:
 
     NodeGraph * m_DependencyGraph;
     ThreadPool * m_ThreadPool = nullptr;
+    FileTimeCache * m_FileTimeCache = nullptr;
     JobQueue * m_JobQueue;
     mutable Mutex m_ClientLifetimeMutex;
     Client * m_Client; // manage connections to worker servers
 
     AString m_DependencyGraphFile;
     ICache * m_Cache;
+    MetricsServer * m_MetricsServer = nullptr;
 
     Timer m_Timer;
     float m_LastProgressOutputTime;
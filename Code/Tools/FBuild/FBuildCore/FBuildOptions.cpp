@@ -140,6 +140,17 @@ FBuildOptions::OptionsResult FBuildOptions::ProcessCommandLine( int argc, char *
                 m_CacheInfo = true;
                 continue;
             }
+            else if ( thisArg == "-cacheexplain" )
+            {
+                m_CacheExplain = true;
+                m_CacheKeys = true; // -cacheexplain implies -cachekeys
+                continue;
+            }
+            else if ( thisArg == "-cachekeys" )
+            {
+                m_CacheKeys = true;
+                continue;
+            }
             else if ( thisArg == "-cachetrim" )
             {
                 const int sizeIndex = ( i + 1 );
@@ -207,6 +218,12 @@ FBuildOptions::OptionsResult FBuildOptions::ProcessCommandLine( int argc, char *
                 m_ForceCleanBuild = true;
                 continue;
             }
+            else if ( thisArg == "-compare" )
+            {
+                m_Compare = true;
+                m_History = true; // -compare implies -history
+                continue;
+            }
             else if ( thisArg == "-compdb" )
             {
                 m_GenerateCompilationDatabase = true;
@@ -231,6 +248,16 @@ FBuildOptions::OptionsResult FBuildOptions::ProcessCommandLine( int argc, char *
                 m_Args += '"';
                 continue;
             }
+            else if ( thisArg == "-contenthash" )
+            {
+                m_UseContentHash = true;
+                continue;
+            }
+            else if ( thisArg == "-daemon" )
+            {
+                m_DaemonMode = true;
+                continue;
+            }
             else if ( thisArg == "-dbfile" )
             {
                 const int32_t pathIndex = ( i + 1 );
@@ -281,6 +308,11 @@ FBuildOptions::OptionsResult FBuildOptions::ProcessCommandLine( int argc, char *
                 m_GenerateDotGraphFull = true;
                 continue;
             }
+            else if ( thisArg == "-earlycutoff" )
+            {
+                m_EarlyCutoff = true;
+                continue;
+            }
             else if ( thisArg == "-fastcancel" )
             {
                 // This is on by default now
@@ -299,11 +331,36 @@ FBuildOptions::OptionsResult FBuildOptions::ProcessCommandLine( int argc, char *
                 m_AllowLocalRace = false;
                 continue;
             }
+            else if ( thisArg.BeginsWith( "-headerimpact" ) )
+            {
+                StackArray<AString> reportTokens;
+                thisArg.Tokenize( reportTokens, '=' );
+
+                // report type is html unless specified after the '=' sign
+                m_HeaderImpactReportType = "html";
+                if ( reportTokens.GetSize() > 1 )
+                {
+                    m_HeaderImpactReportType = reportTokens[ 1 ];
+                    m_HeaderImpactReportType.ToLower();
+                    if ( ( m_HeaderImpactReportType != "html" ) && ( m_HeaderImpactReportType != "json" ) )
+                    {
+                        OUTPUT( "FBuild: Error: Invalid report type '%s' for '-headerimpact'\n", m_HeaderImpactReportType.Get() );
+                        OUTPUT( "Try \"%s -help\"\n", programName.Get() );
+                        return OPTIONS_ERROR;
+                    }
+                }
+                continue;
+            }
             else if ( thisArg == "-help" )
             {
                 DisplayHelp( programName );
                 return OPTIONS_OK_AND_QUIT; // exit app
             }
+            else if ( thisArg == "-history" )
+            {
+                m_History = true;
+                continue;
+            }
             else if ( ( thisArg == "-ide" ) || ( thisArg == "-vs" ) )
             {
                 m_ShowProgress = false;
@@ -323,6 +380,26 @@ FBuildOptions::OptionsResult FBuildOptions::ProcessCommandLine( int argc, char *
                     continue; // 'numWorkers' will contain value now
                 }
             }
+            else if ( thisArg == "-metricsport" )
+            {
+                const int portIndex = ( i + 1 );
+                uint32_t port = 0;
+                if ( ( portIndex >= argc ) ||
+                     ( AString::ScanS( argv[ portIndex ], "%u", &port ) != 1 ) ||
+                     ( port == 0 ) || ( port > 65535 ) )
+                {
+                    OUTPUT( "FBuild: Error: Missing or bad <port> for '-metricsport' argument\n" );
+                    OUTPUT( "Try \"%s -help\"\n", programName.Get() );
+                    return OPTIONS_ERROR;
+                }
+                m_MetricsPort = (uint16_t)port;
+                i++; // skip extra arg we've consumed
+
+                // add to args we might pass to subprocess
+                m_Args += ' ';
+                m_Args += argv[ portIndex ];
+                continue;
+            }
             else if ( thisArg == "-monitor" )
             {
                 m_EnableMonitor = true;
@@ -338,6 +415,11 @@ FBuildOptions::OptionsResult FBuildOptions::ProcessCommandLine( int argc, char *
                 m_AllowLocalRace = false;
                 continue;
             }
+            else if ( thisArg == "-noprefetch" )
+            {
+                m_PrefetchFileStamps = false;
+                continue;
+            }
             else if ( thisArg == "-noprogress" )
             {
                 m_ShowProgress = false;
@@ -432,6 +514,35 @@ FBuildOptions::OptionsResult FBuildOptions::ProcessCommandLine( int argc, char *
                 m_ShowSummary = true;
                 continue;
             }
+            else if ( thisArg == "-trace" )
+            {
+                m_Trace = true;
+                continue;
+            }
+            else if ( thisArg == "-traceconvert" )
+            {
+                const int32_t pathIndex = ( i + 1 );
+                if ( pathIndex >= argc )
+                {
+                    OUTPUT( "FBuild: Error: Missing <path> for '-traceconvert' argument\n" );
+                    OUTPUT( "Try \"%s -help\"\n", programName.Get() );
+                    return OPTIONS_ERROR;
+                }
+                m_TraceConvertFile = argv[ pathIndex ];
+                i++; // skip extra arg we've consumed
+
+                // add to args we might pass to subprocess
+                m_Args += ' ';
+                m_Args += '"'; // surround trace file with quotes to avoid problems with spaces in the path
+                m_Args += m_TraceConvertFile;
+                m_Args += '"';
+                continue;
+            }
+            else if ( thisArg == "-usedaemon" )
+            {
+                m_UseDaemon = true;
+                continue;
+            }
             else if ( thisArg == "-verbose" )
             {
                 m_ShowVerbose = true;
@@ -649,14 +760,26 @@ void FBuildOptions::DisplayHelp( const AString & programName ) const
             "                   - <= -1 : less compression, with -128 being the lowest\n"
             "                   - ==  0 : disable compression\n"
             "                   - >=  1 : more compression, with 12 being the highest\n"
+            " -cacheexplain     Explain each cache miss by naming the key components\n"
+            "                   which differ from the entry last stored for the same\n"
+            "                   object. Implies -cachekeys.\n"
             " -cacheinfo        Output cache statistics.\n"
+            " -cachekeys        Record the components of each cache key stored, for\n"
+            "                   use by -cacheexplain.\n"
             " -cachetrim <size> Trim the cache to the given size in MiB.\n"
             " -cacheverbose     Emit details about cache interactions.\n"
             " -clean            Force a clean build.\n"
+            " -compare          Compare with the previous build recorded by -history,\n"
+            "                   ranking the nodes and changed headers contributing most\n"
+            "                   to any regression. Implies -history.\n"
             " -compdb           Generate JSON compilation database for targets.\n"
             " -config <path>    Explicitly specify the config file to use.\n"
+            " -contenthash      Detect changes to input files using a hash of their\n"
+            "                   contents instead of their timestamps.\n"
             " -continueafterdbmove\n"
             "       Allow builds after a DB move.\n"
+            " -daemon           Stay resident, keeping the dependency graph in memory to\n"
+            "                   service builds requested with -usedaemon.\n"
             " -dbfile <path>    Explicitly specify the dependency database file to use.\n"
             " -debug            (Windows) Break at startup, to attach debugger.\n"
             " -dist             Allow distributed compilation.\n"
@@ -668,17 +791,29 @@ void FBuildOptions::DisplayHelp( const AString & programName ) const
             "                   - >=  1 : more compression, with 12 being the highest\n"
             " -dot[full]        Emit known dependency tree info for specified targets to an\n"
             "                   fbuild.gv file in DOT format.\n"
+            " -earlycutoff      Don't rebuild dependents of a file which is rebuilt with\n"
+            "                   identical contents.\n"
             " -fixuperrorpaths  Reformat error paths to be Visual Studio friendly.\n"
             " -forceremote      Force distributable jobs to only be built remotely.\n"
+            " -headerimpact[=json|html]\n"
+            "                   Rank headers by the cost of rebuilding everything which\n"
+            "                   depends on them, using the dependency database, and exit.\n"
+            "                   - =html : outputs a headerimpact.html file (default)\n"
+            "                   - =json : outputs a headerimpact.json file\n"
             " -help             Show this help.\n"
+            " -history          Record a compact history of recent builds alongside the\n"
+            "                   dependency database, for use by -compare.\n"
             " -ide              Enable multiple options when building from an IDE.\n"
             "                   Enables: -noprogress, -fixuperrorpaths &\n"
             "                   -wrapper (Windows)\n"
             " -j<x>             Explicitly set LOCAL worker thread count X, instead of\n"
             "                   default of hardware thread count.\n"
+            " -metricsport <port>\n"
+            "                   Serve live metrics on http://127.0.0.1:<port>/metrics\n"
             " -monitor          Emit a machine-readable file while building.\n"
             " -nofastcancel     Disable aborting other tasks as soon any task fails.\n"
             " -nolocalrace      Disable local race of remotely started jobs.\n"
+            " -noprefetch       Don't check files in parallel before building.\n"
             " -noprogress       Don't show the progress bar while building.\n"
             " -nounity          (Experimental) Build files individually, ignoring Unity.\n"
             " -nostoponerror    On error, favor building as much as possible.\n"
@@ -696,6 +831,13 @@ void FBuildOptions::DisplayHelp( const AString & programName ) const
             " -showtargets      Display primary targets, excluding those marked \"Hidden\".\n"
             " -showalltargets   Display primary targets, including those marked \"Hidden\".\n"
             " -summary          Show a summary at the end of the build.\n"
+            " -trace            Record a compact binary trace of the build to fbuild.trace.\n"
+            "                   Cheaper than -profile and suitable for every build.\n"
+            " -traceconvert <path>\n"
+            "                   Convert a trace from -trace to <path>.json, in the same\n"
+            "                   format as -profile, and exit.\n"
+            " -usedaemon        Forward the build to a -daemon for the working dir, if\n"
+            "                   one is running.\n"
             " -verbose          Show detailed diagnostic info. (Increases built time)\n"
             " -version          Print version and exit.\n"
             " -vs               VisualStudio mode. Same as -ide.\n"
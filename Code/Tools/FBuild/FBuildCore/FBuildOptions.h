@@ -60,13 +60,21 @@ public:
     bool        m_GenerateDotGraph                  = false;
     bool        m_GenerateDotGraphFull              = false;
     bool        m_GenerateCompilationDatabase       = false;
+    AString     m_HeaderImpactReportType;                    // Report header impact (html or json) instead of building
     bool        m_NoUnity                           = false;
+    bool        m_UseContentHash                    = false; // Stamp input files by content, not time
+    bool        m_EarlyCutoff                       = false; // Dependents compare content of built files
+    bool        m_PrefetchFileStamps                = true;  // Check input files in parallel before building
+    bool        m_DaemonMode                        = false;
+    bool        m_UseDaemon                         = false;
 
     // Cache
     bool        m_UseCacheRead                      = false;
     bool        m_UseCacheWrite                     = false;
     bool        m_CacheInfo                         = false;
     bool        m_CacheVerbose                      = false;
+    bool        m_CacheKeys                         = false; // Record the components of each key stored
+    bool        m_CacheExplain                      = false; // Explain misses using the recorded components
     uint32_t    m_CacheTrim                         = 0;
     int16_t     m_CacheCompressionLevel             = 1; // See Compressor.h
     bool        m_NoCache                           = false; // forbid cache
@@ -94,6 +102,11 @@ public:
     AString     m_ReportType;
     bool        m_EnableMonitor                     = false;
     bool        m_Profile                           = false;
+    bool        m_Trace                             = false; // Record a compact binary trace
+    AString     m_TraceConvertFile;                          // Convert this trace to JSON and exit
+    bool        m_History                           = false; // Record a history of recent builds
+    bool        m_Compare                           = false; // Compare with the previous build in the history
+    uint16_t    m_MetricsPort                       = 0; // Serve live metrics on this port (0 = disabled)
 
     // DB loading/saving
     bool        m_SaveDBOnCompletion                = false;
@@ -115,6 +128,7 @@ public:
     inline const AString & GetMainProcessMutexName() const      { return m_ProcessMutexName; }
     inline const AString & GetFinalProcessMutexName( ) const    { return m_FinalProcessMutexName; }
     inline const AString & GetSharedMemoryName() const          { return m_SharedMemoryName; }
+    inline uint16_t GetDaemonPort() const                       { return (uint16_t)( Protocol::DAEMON_PORT + ( m_WorkingDirHash % Protocol::DAEMON_PORT_RANGE ) ); }
 
 private:
     void DisplayHelp( const AString & programName ) const;
@@ -127,4 +141,60 @@ private:
     AString     m_SharedMemoryName;
 };
 
+// FBUILD_OPTIONS_AFFECTING_BUILD
+//  - Options captured by an FBuild on creation, which a build must agree on to
+//    re-use an existing FBuild (see BuildDaemon). New options belong here unless
+//    they only affect how FBuild is invoked (or are passed to FBuild explicitly)
+//------------------------------------------------------------------------------
+#define FBUILD_OPTIONS_AFFECTING_BUILD( OPTION )  \
+    OPTION( m_ForceCleanBuild )                 \
+    OPTION( m_StopOnFirstError )                \
+    OPTION( m_FastCancel )                      \
+    OPTION( m_UseContentHash )                  \
+    OPTION( m_EarlyCutoff )                     \
+    OPTION( m_PrefetchFileStamps )              \
+    OPTION( m_NoUnity )                         \
+    OPTION( m_UseCacheRead )                    \
+    OPTION( m_UseCacheWrite )                   \
+    OPTION( m_CacheInfo )                       \
+    OPTION( m_CacheVerbose )                    \
+    OPTION( m_CacheKeys )                       \
+    OPTION( m_CacheExplain )                    \
+    OPTION( m_CacheTrim )                       \
+    OPTION( m_CacheCompressionLevel )           \
+    OPTION( m_NoCache )                         \
+    OPTION( m_AllowDistributed )                \
+    OPTION( m_DistVerbose )                     \
+    OPTION( m_NoLocalConsumptionOfRemoteJobs )  \
+    OPTION( m_AllowLocalRace )                  \
+    OPTION( m_DistributionPort )                \
+    OPTION( m_DistributionCompressionLevel )    \
+    OPTION( m_ShowVerbose )                     \
+    OPTION( m_ShowBuildReason )                 \
+    OPTION( m_ShowCommandSummary )              \
+    OPTION( m_ShowCommandLines )                \
+    OPTION( m_ShowCommandOutput )               \
+    OPTION( m_ShowErrors )                      \
+    OPTION( m_ShowProgress )                    \
+    OPTION( m_ShowSummary )                     \
+    OPTION( m_ShowTotalTimeTaken )              \
+    OPTION( m_ShowPrintStatements )             \
+    OPTION( m_NoSummaryOnError )                \
+    OPTION( m_ReportType )                      \
+    OPTION( m_EnableMonitor )                   \
+    OPTION( m_Profile )                         \
+    OPTION( m_Trace )                           \
+    OPTION( m_History )                         \
+    OPTION( m_Compare )                         \
+    OPTION( m_MetricsPort )                     \
+    OPTION( m_SaveDBOnCompletion )              \
+    OPTION( m_FixupErrorPaths )                 \
+    OPTION( m_ForceDBMigration_Debug )          \
+    OPTION( m_ContinueAfterDBMove )             \
+    OPTION( m_DBFile )                          \
+    OPTION( m_NumWorkerThreads )                \
+    OPTION( m_ConfigFile )                      \
+    OPTION( m_CoordinatorAddress )              \
+    OPTION( m_BrokeragePath )
+
 //------------------------------------------------------------------------------
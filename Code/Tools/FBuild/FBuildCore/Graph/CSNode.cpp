@@ -12,6 +12,7 @@
 #include "Tools/FBuild/FBuildCore/Graph/DirectoryListNode.h"
 #include "Tools/FBuild/FBuildCore/Helpers/Args.h"
 #include "Tools/FBuild/FBuildCore/Helpers/ResponseFile.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/Job.h"
 
 #include "Core/Env/ErrorFormat.h"
 #include "Core/FileIO/FileIO.h"
@@ -207,6 +208,7 @@ CSNode::~CSNode() = default;
 
     // Get result
     const int result = p.WaitForExit();
+    job->OnProcessExited( p );
     if ( p.HasAborted() )
     {
         return BuildResult::eAborted;
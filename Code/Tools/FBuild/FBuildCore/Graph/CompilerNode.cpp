@@ -11,8 +11,12 @@
 
 #include "Core/FileIO/IOStream.h"
 #include "Core/FileIO/PathUtils.h"
+#include "Core/Process/Process.h"
 #include "Core/Strings/AStackString.h"
 
+// system
+#include <stdlib.h> // for atoi
+
 
 // Reflection
 //------------------------------------------------------------------------------
@@ -34,10 +38,12 @@ REFLECT_NODE_BEGIN( CompilerNode, Node, MetaNone() )
     REFLECT( m_UseLightCache,       "UseLightCache_Experimental", MetaOptional() )
     REFLECT( m_UseRelativePaths,    "UseRelativePaths_Experimental", MetaOptional() )
     REFLECT( m_SourceMapping,       "SourceMapping_Experimental", MetaOptional() )
+    REFLECT( m_NormalizeCachePaths, "NormalizeCachePaths_Experimental", MetaOptional() )
 
     // Internal
     REFLECT( m_CompilerFamilyEnum,  "CompilerFamilyEnum",   MetaHidden() )
     REFLECT_STRUCT( m_Manifest,     "Manifest", ToolManifest, MetaHidden() + MetaIgnoreForComparison() )
+    REFLECT( m_SupportsFilePrefixMap, "SupportsFilePrefixMap", MetaHidden() + MetaIgnoreForComparison() )
 REFLECT_END( CompilerNode )
 
 // CONSTRUCTOR
@@ -56,6 +62,8 @@ CompilerNode::CompilerNode()
     , m_SimpleDistributionMode( false )
     , m_UseLightCache( false )
     , m_UseRelativePaths( false )
+    , m_NormalizeCachePaths( false )
+    , m_SupportsFilePrefixMap( false )
     , m_EnvironmentString( nullptr )
 {
 }
@@ -140,6 +148,13 @@ CompilerNode::CompilerNode()
         return false;
     }
 
+    // Cache path normalization relies on the compiler remapping paths in its output
+    if ( m_NormalizeCachePaths && ( m_CompilerFamilyEnum != GCC ) && ( m_CompilerFamilyEnum != CLANG ) )
+    {
+        Error::Error_1505_NormalizeCachePathsIncompatibleWithCompiler( iter, function );
+        return false;
+    }
+
     m_Manifest.Initialize( m_ExecutableRootPath, m_StaticDependencies, m_CustomEnvironmentVariables );
 
     return true;
@@ -371,6 +386,16 @@ CompilerNode::~CompilerNode()
         return BuildResult::eFailed; // Generate will have emitted error
     }
 
+    // Check how the compiler can remap paths for cache path normalization
+    if ( m_NormalizeCachePaths )
+    {
+        m_SupportsFilePrefixMap = DetectFilePrefixMapSupport();
+        if ( FBuild::GetStopBuild() )
+        {
+            return BuildResult::eAborted;
+        }
+    }
+
     m_Stamp = m_Manifest.GetTimeStamp();
     return BuildResult::eOk;
 }
@@ -391,6 +416,39 @@ const char * CompilerNode::GetEnvironmentString() const
 
     // Migrate the timestamp/hash info stored for the files in the ToolManifest
     m_Manifest.Migrate( oldNode.CastTo<CompilerNode>()->GetManifest() );
+
+    // Keep detected capabilities, as the compiler won't be rebuilt if unchanged
+    m_SupportsFilePrefixMap = oldNode.CastTo<CompilerNode>()->m_SupportsFilePrefixMap;
+}
+
+// DetectFilePrefixMapSupport
+//------------------------------------------------------------------------------
+bool CompilerNode::DetectFilePrefixMapSupport() const
+{
+    // -ffile-prefix-map and -fmacro-prefix-map require GCC 8+ or Clang 10+
+    Process process( FBuild::Get().GetAbortBuildPointer() );
+    if ( process.Spawn( GetExecutable().Get(), "-dumpversion", nullptr, GetEnvironmentString() ) == false )
+    {
+        return false;
+    }
+    AString memOut;
+    AString memErr;
+    process.ReadAllData( memOut, memErr );
+    if ( ( process.WaitForExit() != 0 ) || process.HasAborted() )
+    {
+        return false;
+    }
+
+    // Output is "major[.minor[.patch]]". Clang before 8 reports GCC 4.2.1 which
+    // is correctly treated as too old
+    const int32_t majorVersion = atoi( memOut.Get() );
+    #if defined( __OSX__ )
+        // Apple Clang has its own versioning, with 12 being the first based on Clang 10
+        const int32_t minVersion = ( m_CompilerFamilyEnum == CLANG ) ? 12 : 8;
+    #else
+        const int32_t minVersion = ( m_CompilerFamilyEnum == CLANG ) ? 10 : 8;
+    #endif
+    return ( majorVersion >= minVersion );
 }
 
 //------------------------------------------------------------------------------
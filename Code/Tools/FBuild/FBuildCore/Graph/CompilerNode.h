@@ -30,6 +30,8 @@ public:
     inline bool SimpleDistributionMode() const { return m_SimpleDistributionMode; }
     inline bool GetUseLightCache() const { return m_UseLightCache; }
     inline bool GetUseRelativePaths() const { return m_UseRelativePaths; }
+    inline bool GetNormalizeCachePaths() const { return m_NormalizeCachePaths; }
+    inline bool SupportsFilePrefixMap() const { return m_SupportsFilePrefixMap; }
     inline bool CanBeDistributed() const { return m_AllowDistribution; }
     inline bool CanUseResponseFile() const { return m_AllowResponseFile; }
     inline bool ShouldForceResponseFileUse() const { return m_ForceResponseFile; }
@@ -69,6 +71,8 @@ private:
     virtual BuildResult DoBuild( Job * job ) override;
     virtual void Migrate( const Node & oldNode ) override;
 
+    bool DetectFilePrefixMapSupport() const;
+
     // Exposed params
     AString                 m_Executable;
     Array< AString >        m_ExtraFiles;
@@ -86,11 +90,13 @@ private:
     bool                    m_SimpleDistributionMode;
     bool                    m_UseLightCache;
     bool                    m_UseRelativePaths;
+    bool                    m_NormalizeCachePaths;
     ToolManifest            m_Manifest;
     Array< AString >        m_Environment;
     AString                 m_SourceMapping;
 
     // Internal state
+    bool                    m_SupportsFilePrefixMap; // Detected for GCC/Clang when normalizing cache paths
     mutable const char *    m_EnvironmentString;
 };
 
@@ -10,12 +10,18 @@
 #include "Tools/FBuild/FBuildCore/Graph/NodeGraph.h"
 
 // Core
+#include "Core/Containers/UnorderedMap.h"
+#include "Core/Env/Env.h"
 #include "Core/FileIO/FileIO.h"
 #include "Core/FileIO/MemoryStream.h"
 #include "Core/FileIO/PathUtils.h"
+#include "Core/Math/Conversions.h"
 #include "Core/Math/xxHash.h"
+#include "Core/Process/Atomic.h"
+#include "Core/Process/Thread.h"
 #include "Core/Profile/Profile.h"
 #include "Core/Strings/AStackString.h"
+#include "Core/Time/Time.h"
 
 // Reflection
 //------------------------------------------------------------------------------
@@ -28,88 +34,101 @@ REFLECT_NODE_BEGIN( DirectoryListNode, Node, MetaNone() )
     REFLECT( m_Recursive,               "Recursive",        MetaHidden() )
     REFLECT( m_IncludeReadOnlyStatusInHash, "IncludeReadOnlyStatusInHash", MetaHidden() )
     REFLECT( m_IncludeDirs,             "IncludeDirs",      MetaHidden() )
+
+    // Internal state
+    REFLECT_ARRAY_OF_STRUCT( m_Snapshots, "Snapshots", DirectorySnapshot, MetaHidden() + MetaIgnoreForComparison() )
 REFLECT_END( DirectoryListNode )
 
-// DirectoryListNodeGetFilesHelper
+REFLECT_STRUCT_BEGIN( DirectorySnapshotFile, Struct, MetaNone() )
+    REFLECT( m_Name,                    "Name",             MetaHidden() )
+    REFLECT( m_Attributes,              "Attributes",       MetaHidden() )
+    REFLECT( m_LastWriteTime,           "LastWriteTime",    MetaHidden() )
+    REFLECT( m_Size,                    "Size",             MetaHidden() )
+REFLECT_END( DirectorySnapshotFile )
+
+REFLECT_STRUCT_BEGIN( DirectorySnapshot, Struct, MetaNone() )
+    REFLECT( m_Path,                    "Path",             MetaHidden() )
+    REFLECT( m_LastWriteTime,           "LastWriteTime",    MetaHidden() )
+    REFLECT_ARRAY_OF_STRUCT( m_Files,   "Files",            DirectorySnapshotFile, MetaHidden() )
+    REFLECT_ARRAY( m_SubDirs,           "SubDirs",          MetaHidden() )
+REFLECT_END( DirectorySnapshot )
+
+// DirectorySnapshotUpdater
+//  - Shared state for threads updating the snapshots of one level of the tree
 //------------------------------------------------------------------------------
-class DirectoryListNodeGetFilesHelper : public GetFilesHelper
+class DirectorySnapshotUpdater
 {
 public:
-    //--------------------------------------------------------------------------
-    DirectoryListNodeGetFilesHelper( const Array<AString> & patterns,
-                                     const Array<AString> & excludePaths,
-                                     const Array<AString> & filesToExclude,
-                                     const Array<AString> & excludePatterns,
-                                     bool recurse,
-                                     bool includeDirs )
-        : GetFilesHelper( patterns )
-        , m_ExcludePaths( excludePaths )
-        , m_FilesToExclude( filesToExclude )
-        , m_ExcludePatterns( excludePatterns )
-        , m_IncludeDirs( includeDirs )
+    DirectorySnapshotUpdater( DirectoryListNode & node,
+                              Array< DirectorySnapshot > & oldSnapshots,
+                              UnorderedMap< AString, uint32_t > & oldSnapshotIndices,
+                              uint32_t begin,
+                              uint32_t end )
+        : m_Node( node )
+        , m_OldSnapshots( oldSnapshots )
+        , m_OldSnapshotIndices( oldSnapshotIndices )
+        , m_NextIndex( begin )
+        , m_End( end )
     {
-        m_Recurse = recurse;
     }
 
-    //--------------------------------------------------------------------------
-    virtual bool OnDirectory( const AString & path ) override
+    // Returns the number of directories which had to be read
+    uint32_t Run()
     {
-        if ( m_IncludeDirs )
+        // Use additional threads if there are enough directories to be
+        // worthwhile, with the calling thread helping out
+        const uint32_t kMinDirsPerThread = 32;
+        const uint32_t kMaxThreads = 8;
+        const uint32_t numThreads = Math::Min( Math::Min( Env::GetNumProcessors(), kMaxThreads ),
+                                               ( m_End - m_NextIndex ) / kMinDirsPerThread );
+        Thread threads[ kMaxThreads ];
+        for ( uint32_t i = 0; i < numThreads; ++i )
         {
-            m_Directories.EmplaceBack( path );
+            threads[ i ].Start( ThreadFunc, "DirectoryList", this );
         }
-
-        if ( m_Recurse == false )
+        Process();
+        for ( uint32_t i = 0; i < numThreads; ++i )
         {
-            return false;
+            threads[ i ].Join();
         }
+        return m_NumRead;
+    }
 
-        // Filter excluded paths
-        for ( const AString & excludedPath : m_ExcludePaths )
-        {
-            if ( PathUtils::PathBeginsWith( path, excludedPath ) )
-            {
-                return false; // Don't recurse into dir
-            }
-        }
+    DirectorySnapshotUpdater & operator =( DirectorySnapshotUpdater & ) = delete;
 
-        return true; // Recurse into directory
+private:
+    static uint32_t ThreadFunc( void * userData )
+    {
+        static_cast< DirectorySnapshotUpdater * >( userData )->Process();
+        return 0;
     }
 
-    //--------------------------------------------------------------------------
-    virtual void OnFile( FileIO::FileInfo && info ) override
+    void Process()
     {
-        // filter excluded files
-        for ( const AString & fileToExclude : m_FilesToExclude )
+        // Each thread takes the next directory until none remain
+        for ( ;; )
         {
-            if ( PathUtils::PathEndsWithFile( info.m_Name, fileToExclude ) )
+            const uint32_t index = ( AtomicInc( &m_NextIndex ) - 1 );
+            if ( index >= m_End )
             {
-                return; // Exclude
+                return;
             }
-        }
-
-        // Filter excluded patterns
-        for ( const AString & excludePattern : m_ExcludePatterns )
-        {
-            if ( PathUtils::IsWildcardMatch( excludePattern.Get(), info.m_Name.Get() ) )
+            DirectorySnapshot & snapshot = m_Node.m_Snapshots[ index ];
+            const UnorderedMap< AString, uint32_t >::KeyValue * oldIndex = m_OldSnapshotIndices.Find( snapshot.m_Path );
+            DirectorySnapshot * oldSnapshot = oldIndex ? &m_OldSnapshots[ oldIndex->m_Value ] : nullptr;
+            if ( m_Node.UpdateSnapshot( snapshot, oldSnapshot ) )
             {
-                return; // Exclude
+                AtomicInc( &m_NumRead );
             }
         }
-
-        // Keep file info
-        m_Files.EmplaceBack( Move( info ) );
     }
 
-    Array<AString>& GetDirectories() { return m_Directories; }
-
-    DirectoryListNodeGetFilesHelper& operator =(DirectoryListNodeGetFilesHelper&) = delete;
-protected:
-    const Array<AString> & m_ExcludePaths;
-    const Array<AString> & m_FilesToExclude;
-    const Array<AString> & m_ExcludePatterns;
-    const bool m_IncludeDirs;
-    Array<AString> m_Directories;
+    DirectoryListNode &                 m_Node;
+    Array< DirectorySnapshot > &        m_OldSnapshots;
+    UnorderedMap< AString, uint32_t > & m_OldSnapshotIndices;
+    uint32_t                            m_NextIndex;
+    const uint32_t                      m_End;
+    uint32_t                            m_NumRead = 0;
 };
 
 // CONSTRUCTOR
@@ -222,19 +241,31 @@ DirectoryListNode::~DirectoryListNode() = default;
     // NOTE: The DirectoryListNode makes no assumptions about whether no files
     // is an error or not.  That's up to the dependent nodes to decide.
 
+    // Get the list of files, filtered in various ways
+    UpdateSnapshots();
+    m_Files.Clear();
+    m_Directories.Clear();
+    for ( const DirectorySnapshot & snapshot : m_Snapshots )
     {
-        // Get the list of files, filtered in various ways
-        DirectoryListNodeGetFilesHelper helper( m_Patterns,
-                                                m_ExcludePaths,
-                                                m_FilesToExclude,
-                                                m_ExcludePatterns,
-                                                m_Recursive,
-                                                m_IncludeDirs );
-        FileIO::GetFiles( m_Path, helper );
-
-        // Transfer ownership of filtered list
-        m_Files = Move( helper.GetFiles() );
-        m_Directories = Move( helper.GetDirectories() );
+        for ( const DirectorySnapshotFile & file : snapshot.m_Files )
+        {
+            FileIO::FileInfo & info = m_Files.EmplaceBack();
+            info.m_Name.SetReserved( snapshot.m_Path.GetLength() + file.m_Name.GetLength() );
+            info.m_Name = snapshot.m_Path;
+            info.m_Name += file.m_Name;
+            info.m_Attributes = file.m_Attributes;
+            info.m_LastWriteTime = file.m_LastWriteTime;
+            info.m_Size = file.m_Size;
+        }
+        if ( m_IncludeDirs )
+        {
+            for ( const AString & subDir : snapshot.m_SubDirs )
+            {
+                AString & dir = m_Directories.EmplaceBack( snapshot.m_Path );
+                dir += subDir;
+                dir += NATIVE_SLASH;
+            }
+        }
     }
 
     MakePrettyName();
@@ -242,9 +273,11 @@ DirectoryListNode::~DirectoryListNode() = default;
     if ( FLog::ShowVerbose() )
     {
         AStackString<> buffer;
-        buffer.AppendFormat( "Dir: '%s' (%zu files)\n",
+        buffer.AppendFormat( "Dir: '%s' (%zu files, %u of %zu dirs read)\n",
                              m_Name.Get(),
-                             m_Files.GetSize() );
+                             m_Files.GetSize(),
+                             m_NumDirectoriesRead,
+                             m_Snapshots.GetSize() );
         for ( const FileIO::FileInfo & file : m_Files )
         {
             buffer.AppendFormat( " - %s\n", file.m_Name.Get() );
@@ -292,6 +325,17 @@ DirectoryListNode::~DirectoryListNode() = default;
     return BuildResult::eOk;
 }
 
+// Migrate
+//------------------------------------------------------------------------------
+/*virtual*/ void DirectoryListNode::Migrate( const Node & oldNode )
+{
+    // Migrate Node level properties
+    Node::Migrate( oldNode );
+
+    // Keep snapshots so unchanged directories don't need to be read again
+    m_Snapshots = oldNode.CastTo< DirectoryListNode >()->m_Snapshots;
+}
+
 // MakePrettyName
 //------------------------------------------------------------------------------
 void DirectoryListNode::MakePrettyName()
@@ -316,4 +360,189 @@ void DirectoryListNode::MakePrettyName()
     m_PrettyName = prettyName;
 }
 
+// UpdateSnapshots
+//------------------------------------------------------------------------------
+void DirectoryListNode::UpdateSnapshots()
+{
+    PROFILE_FUNCTION;
+
+    // Snapshots from the previous build, by path
+    Array< DirectorySnapshot > oldSnapshots( Move( m_Snapshots ) );
+    UnorderedMap< AString, uint32_t > oldSnapshotIndices;
+    for ( size_t i = 0; i < oldSnapshots.GetSize(); ++i )
+    {
+        oldSnapshotIndices.Insert( oldSnapshots[ i ].m_Path, static_cast< uint32_t >( i ) );
+    }
+
+    // Update the tree one level at a time. Sub-directories are only known once
+    // their parent is up-to-date, but directories within a level are independent
+    m_Snapshots.Clear();
+    m_Snapshots.EmplaceBack( m_Path );
+    m_NumDirectoriesRead = 0;
+    uint32_t levelBegin = 0;
+    while ( levelBegin < m_Snapshots.GetSize() )
+    {
+        const uint32_t levelEnd = static_cast< uint32_t >( m_Snapshots.GetSize() );
+        DirectorySnapshotUpdater updater( *this, oldSnapshots, oldSnapshotIndices, levelBegin, levelEnd );
+        m_NumDirectoriesRead += updater.Run();
+
+        // Queue sub-directories for the next level
+        for ( uint32_t i = levelBegin; i < levelEnd; ++i )
+        {
+            const size_t numSubDirs = m_Snapshots[ i ].m_SubDirs.GetSize();
+            for ( size_t j = 0; j < numSubDirs; ++j )
+            {
+                AStackString<> subDir( m_Snapshots[ i ].m_Path );
+                subDir += m_Snapshots[ i ].m_SubDirs[ j ];
+                subDir += NATIVE_SLASH;
+                if ( ShouldRecurseInto( subDir ) )
+                {
+                    m_Snapshots.EmplaceBack( subDir ); // NOTE: Can invalidate references to m_Snapshots
+                }
+            }
+        }
+        levelBegin = levelEnd;
+    }
+}
+
+// UpdateSnapshot
+//------------------------------------------------------------------------------
+bool DirectoryListNode::UpdateSnapshot( DirectorySnapshot & snapshot, DirectorySnapshot * oldSnapshot ) const
+{
+    // Re-use previous contents if the directory has not changed
+    if ( oldSnapshot &&
+         ( oldSnapshot->m_LastWriteTime != 0 ) &&
+         ( FileIO::GetFileLastWriteTime( snapshot.m_Path ) == oldSnapshot->m_LastWriteTime ) )
+    {
+        // Changing the read-only status of a file doesn't modify the directory,
+        // so the status must be checked if it is significant
+        bool upToDate = true;
+        if ( m_IncludeReadOnlyStatusInHash )
+        {
+            AStackString<> fileName;
+            FileIO::FileInfo info;
+            for ( DirectorySnapshotFile & file : oldSnapshot->m_Files )
+            {
+                fileName = snapshot.m_Path;
+                fileName += file.m_Name;
+                if ( FileIO::GetFileInfo( fileName, info ) == false )
+                {
+                    upToDate = false;
+                    break;
+                }
+                file.m_Attributes = info.m_Attributes;
+                file.m_LastWriteTime = info.m_LastWriteTime;
+                file.m_Size = info.m_Size;
+            }
+        }
+
+        // NOTE: The time and size of unchanged files are those from when the
+        // directory was last read
+        if ( upToDate )
+        {
+            snapshot = Move( *oldSnapshot );
+            return false;
+        }
+    }
+
+    ReadDirectory( snapshot );
+    return true;
+}
+
+// ReadDirectory
+//------------------------------------------------------------------------------
+void DirectoryListNode::ReadDirectory( DirectorySnapshot & snapshot ) const
+{
+    snapshot.m_LastWriteTime = 0;
+    snapshot.m_Files.Clear();
+    snapshot.m_SubDirs.Clear();
+
+    const uint64_t readTime = Time::GetCurrentFileTime();
+    uint64_t lastWriteTime = 0;
+    Array< FileIO::FileInfo > files;
+    Array< AString > subDirs;
+    // The root may be a symlink (but symlinks to sub-directories are not followed)
+    const bool isRoot = ( snapshot.m_Path == m_Path );
+    if ( FileIO::GetDirectoryContents( snapshot.m_Path, &m_Patterns, isRoot, lastWriteTime, files, subDirs ) == false )
+    {
+        return; // Missing directories are checked again next time
+    }
+
+    // A change made in the same time interval as the read would not change the
+    // time of the directory, so recently modified directories can't be trusted
+    // (depending on the file system, timestamps can be up to 2s apart)
+    if ( Time::FileTimeToSeconds( readTime ) > ( Time::FileTimeToSeconds( lastWriteTime ) + 2 ) )
+    {
+        snapshot.m_LastWriteTime = lastWriteTime;
+    }
+
+    const uint32_t pathLength = snapshot.m_Path.GetLength();
+    snapshot.m_Files.SetCapacity( files.GetSize() );
+    for ( const FileIO::FileInfo & info : files )
+    {
+        if ( IsFileExcluded( info.m_Name ) )
+        {
+            continue;
+        }
+
+        DirectorySnapshotFile & file = snapshot.m_Files.EmplaceBack();
+        file.m_Name = ( info.m_Name.Get() + pathLength );
+        file.m_Attributes = info.m_Attributes;
+        file.m_LastWriteTime = info.m_LastWriteTime;
+        file.m_Size = info.m_Size;
+    }
+
+    snapshot.m_SubDirs.SetCapacity( subDirs.GetSize() );
+    for ( const AString & subDir : subDirs )
+    {
+        snapshot.m_SubDirs.EmplaceBack( subDir.Get() + pathLength, subDir.GetEnd() - 1 ); // Without trailing slash
+    }
+}
+
+// IsFileExcluded
+//------------------------------------------------------------------------------
+bool DirectoryListNode::IsFileExcluded( const AString & fileName ) const
+{
+    // Filter excluded files
+    for ( const AString & fileToExclude : m_FilesToExclude )
+    {
+        if ( PathUtils::PathEndsWithFile( fileName, fileToExclude ) )
+        {
+            return true;
+        }
+    }
+
+    // Filter excluded patterns
+    for ( const AString & excludePattern : m_ExcludePatterns )
+    {
+        if ( PathUtils::IsWildcardMatch( excludePattern.Get(), fileName.Get() ) )
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// ShouldRecurseInto
+//------------------------------------------------------------------------------
+bool DirectoryListNode::ShouldRecurseInto( const AString & path ) const
+{
+    if ( m_Recursive == false )
+    {
+        return false;
+    }
+
+    // Filter excluded paths
+    for ( const AString & excludedPath : m_ExcludePaths )
+    {
+        if ( PathUtils::PathBeginsWith( path, excludedPath ) )
+        {
+            return false; // Don't recurse into dir
+        }
+    }
+
+    return true; // Recurse into directory
+}
+
 //------------------------------------------------------------------------------
@@ -9,6 +9,35 @@
 // Core
 #include "Core/FileIO/FileIO.h"
 
+// DirectorySnapshotFile
+//------------------------------------------------------------------------------
+class DirectorySnapshotFile : public Struct
+{
+    REFLECT_STRUCT_DECLARE( DirectorySnapshotFile )
+public:
+    AString     m_Name;             // Name within directory
+    uint32_t    m_Attributes = 0;
+    uint64_t    m_LastWriteTime = 0;
+    uint64_t    m_Size = 0;
+};
+
+// DirectorySnapshot
+//  - Contents of a single directory, as of when it was last read. The directory
+//    is only read again if its own last write time changes
+//------------------------------------------------------------------------------
+class DirectorySnapshot : public Struct
+{
+    REFLECT_STRUCT_DECLARE( DirectorySnapshot )
+public:
+    DirectorySnapshot() = default;
+    explicit DirectorySnapshot( const AString & path ) : m_Path( path ) {}
+
+    AString                         m_Path;                 // With trailing slash
+    uint64_t                        m_LastWriteTime = 0;    // Of the directory, or 0 if it must be read again
+    Array< DirectorySnapshotFile >  m_Files;                // Files passing the DirectoryListNode filters
+    Array< AString >                m_SubDirs;              // Names of all sub-directories
+};
+
 // DirectoryListNode
 //------------------------------------------------------------------------------
 class DirectoryListNode : public Node
@@ -41,9 +70,18 @@ public:
 
 private:
     virtual BuildResult DoBuild( Job * job ) override;
+    virtual void Migrate( const Node & oldNode ) override;
 
     void MakePrettyName();
 
+    // Update snapshots, only reading directories which have changed
+    void UpdateSnapshots();
+    friend class DirectorySnapshotUpdater;
+    bool UpdateSnapshot( DirectorySnapshot & snapshot, DirectorySnapshot * oldSnapshot ) const;
+    void ReadDirectory( DirectorySnapshot & snapshot ) const;
+    bool IsFileExcluded( const AString & fileName ) const;
+    bool ShouldRecurseInto( const AString & path ) const;
+
     friend class CompilationDatabase; // For DoBuild - TODO:C This is not ideal
 
     // Reflected Properties
@@ -62,6 +100,8 @@ private:
     Array< FileIO::FileInfo > m_Files;
     Array<AString> m_Directories;
     AString m_PrettyName;
+    Array< DirectorySnapshot > m_Snapshots;
+    uint32_t m_NumDirectoriesRead = 0; // During last build
 };
 
 //------------------------------------------------------------------------------
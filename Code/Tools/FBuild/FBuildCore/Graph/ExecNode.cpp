@@ -6,22 +6,41 @@
 #include "ExecNode.h"
 
 #include "Tools/FBuild/FBuildCore/BFF/Functions/Function.h"
+#include "Tools/FBuild/FBuildCore/Cache/CacheEntry.h"
+#include "Tools/FBuild/FBuildCore/Cache/ICache.h"
+#include "Tools/FBuild/FBuildCore/Error.h"
 #include "Tools/FBuild/FBuildCore/FBuild.h"
 #include "Tools/FBuild/FBuildCore/FLog.h"
+#include "Tools/FBuild/FBuildCore/Graph/CompilerNode.h"
 #include "Tools/FBuild/FBuildCore/Graph/NodeGraph.h"
 #include "Tools/FBuild/FBuildCore/Graph/DirectoryListNode.h"
+#include "Tools/FBuild/FBuildCore/Graph/MetaData/Meta_AllowNonFile.h"
+#include "Tools/FBuild/FBuildCore/Graph/SettingsNode.h"
+#include "Tools/FBuild/FBuildCore/Helpers/BuildProfiler.h"
+#include "Tools/FBuild/FBuildCore/Helpers/Compressor.h"
+#include "Tools/FBuild/FBuildCore/Helpers/Metrics.h"
+#include "Tools/FBuild/FBuildCore/Helpers/MultiBuffer.h"
+#include "Tools/FBuild/FBuildCore/Helpers/ToolManifest.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/Job.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/WorkerThread.h"
 
 #include "Core/Env/ErrorFormat.h"
+#include "Core/FileIO/ConstMemoryStream.h"
 #include "Core/FileIO/FileIO.h"
 #include "Core/FileIO/FileStream.h"
+#include "Core/FileIO/MemoryStream.h"
+#include "Core/FileIO/PathUtils.h"
 #include "Core/Math/Conversions.h"
+#include "Core/Math/xxHash.h"
+#include "Core/Profile/Profile.h"
 #include "Core/Strings/AStackString.h"
 #include "Core/Process/Process.h"
+#include "Core/Time/Timer.h"
 
 // Reflection
 //------------------------------------------------------------------------------
 REFLECT_NODE_BEGIN( ExecNode, Node, MetaName( "ExecOutput" ) + MetaFile() )
-    REFLECT(        m_ExecExecutable,           "ExecExecutable",           MetaFile() )
+    REFLECT(        m_ExecExecutable,           "ExecExecutable",           MetaFile() + MetaAllowNonFile( Node::COMPILER_NODE ) )
     REFLECT_ARRAY(  m_ExecInput,                "ExecInput",                MetaOptional() + MetaFile() )
     REFLECT_ARRAY(  m_ExecInputPath,            "ExecInputPath",            MetaOptional() + MetaPath() )
     REFLECT_ARRAY(  m_ExecInputPattern,         "ExecInputPattern",         MetaOptional() )
@@ -35,6 +54,8 @@ REFLECT_NODE_BEGIN( ExecNode, Node, MetaName( "ExecOutput" ) + MetaFile() )
     REFLECT(        m_ExecAlwaysShowOutput,     "ExecAlwaysShowOutput",     MetaOptional() )
     REFLECT(        m_ExecUseStdOutAsOutput,    "ExecUseStdOutAsOutput",    MetaOptional() )
     REFLECT(        m_ExecAlways,               "ExecAlways",               MetaOptional() )
+    REFLECT(        m_ExecCacheable,            "ExecCacheable",            MetaOptional() )
+    REFLECT(        m_ExecDistributable,        "ExecDistributable",        MetaOptional() )
     REFLECT_ARRAY(  m_PreBuildDependencyNames,  "PreBuildDependencies",     MetaOptional() + MetaFile() + MetaAllowNonFile() )
     REFLECT_ARRAY(  m_Environment,              "Environment",              MetaOptional() )
     REFLECT(        m_ConcurrencyGroupName,     "ConcurrencyGroupName",     MetaOptional() )
@@ -53,6 +74,8 @@ ExecNode::ExecNode()
     , m_ExecUseStdOutAsOutput( false )
     , m_ExecAlways( false )
     , m_ExecInputPathRecurse( true )
+    , m_ExecCacheable( false )
+    , m_ExecDistributable( false )
     , m_NumExecInputFiles( 0 )
 {
     m_Type = EXEC_NODE;
@@ -78,12 +101,25 @@ ExecNode::ExecNode()
 
     // .ExecExecutable
     Dependencies executable;
-    if ( !Function::GetFileNode( nodeGraph, iter, function, m_ExecExecutable, "ExecExecutable", executable ) )
+    Node * compilerNode = nodeGraph.FindNodeExact( m_ExecExecutable );
+    if ( compilerNode && ( compilerNode->GetType() == Node::COMPILER_NODE ) )
+    {
+        // A Compiler() declares all the files making up the tool
+        executable.Add( compilerNode );
+    }
+    else if ( !Function::GetFileNode( nodeGraph, iter, function, m_ExecExecutable, "ExecExecutable", executable ) )
     {
         return false; // GetFileNode will have emitted an error
     }
     ASSERT( executable.GetSize() == 1 ); // Should only be possible to be one
 
+    // Remote workers receive the tool via the Compiler's ToolManifest
+    if ( m_ExecDistributable && ( executable[ 0 ].GetNode()->GetType() != Node::COMPILER_NODE ) )
+    {
+        Error::Error_1102_UnexpectedType( iter, function, "ExecExecutable", m_ExecExecutable, executable[ 0 ].GetNode()->GetType(), Node::COMPILER_NODE );
+        return false;
+    }
+
     // .ExecInput
     Dependencies execInputFiles;
     if ( !Function::GetFileNodes( nodeGraph, iter, function, m_ExecInput, "ExecInput", execInputFiles ) )
@@ -189,17 +225,129 @@ ExecNode::~ExecNode()
     const char * workingDir = m_ExecWorkingDir.IsEmpty() ? nullptr : m_ExecWorkingDir.Get();
 
     // Format compiler args string
+    Array< AString > inputFiles;
+    GetInputFileNames( inputFiles );
     AStackString< 4 * KILOBYTE > fullArgs;
-    GetFullArgs(fullArgs);
+    GetFullArgs( inputFiles, fullArgs );
 
     const char * environment = Node::GetEnvironmentString( m_Environment, m_EnvironmentString );
 
+    // Try the cache
+    AStackString<> cacheName;
+    const bool useCache = ShouldUseCache() && GetCacheName( fullArgs, cacheName );
+    if ( useCache && RetrieveFromCache( cacheName ) )
+    {
+        return BuildResult::eOk;
+    }
+
+    // can we do the rest of the work remotely?
+    if ( ShouldDistribute() && PackInputs( job, inputFiles ) )
+    {
+        // Results are written to the cache when the job completes
+        if ( useCache )
+        {
+            job->SetCacheName( cacheName );
+        }
+
+        // yes... re-queue for secondary build
+        return BuildResult::eNeedSecondPass;
+    }
+
     EmitCompilationMessage( fullArgs );
 
+    const BuildResult result = Run( job, GetExecutable(), fullArgs, workingDir, environment );
+    if ( result != BuildResult::eOk )
+    {
+        return result; // Run will have emitted an error for eFailed
+    }
+
+    if ( useCache )
+    {
+        WriteToCache( cacheName );
+    }
+
+    // record new file time
+    RecordStampFromBuiltFile();
+
+    return BuildResult::eOk;
+}
+
+// DoBuild2
+//------------------------------------------------------------------------------
+/*virtual*/ Node::BuildResult ExecNode::DoBuild2( Job * job, bool racingRemoteJob )
+{
+    job->GetBuildProfilerScope()->SetStepName( racingRemoteJob ? "Run (Race)" : "Run" );
+
+    if ( job->IsLocal() == false )
+    {
+        return DoBuildRemote( job );
+    }
+
+    // Stealing or racing a remote job, so inputs are available locally
+    Array< AString > inputFiles;
+    GetInputFileNames( inputFiles );
+    AStackString< 4 * KILOBYTE > fullArgs;
+    GetFullArgs( inputFiles, fullArgs );
+
+    EmitCompilationMessage( fullArgs, true, racingRemoteJob ); // stealingRemoteJob
+
+    const char * workingDir = m_ExecWorkingDir.IsEmpty() ? nullptr : m_ExecWorkingDir.Get();
+    const char * environment = Node::GetEnvironmentString( m_Environment, m_EnvironmentString );
+    const BuildResult result = Run( job, GetExecutable(), fullArgs, workingDir, environment );
+    if ( result != BuildResult::eOk )
+    {
+        return result; // Run will have emitted an error for eFailed
+    }
+
+    // Cache name is set when the job was queued for distribution
+    if ( job->GetCacheName().IsEmpty() == false )
+    {
+        WriteToCache( job->GetCacheName() );
+    }
+
+    // record new file time
+    RecordStampFromBuiltFile();
+
+    return BuildResult::eOk;
+}
+
+// DoBuildRemote
+//------------------------------------------------------------------------------
+Node::BuildResult ExecNode::DoBuildRemote( Job * job )
+{
+    ASSERT( job->GetToolManifest() );
+
+    AStackString<> tmpDirectory;
+    Array< AString > inputFiles;
+    BuildResult result = BuildResult::eFailed;
+    if ( ExtractInputs( job, tmpDirectory, inputFiles ) )
+    {
+        // Inputs and output refer to the files on this worker
+        AStackString< 4 * KILOBYTE > fullArgs;
+        GetFullArgs( inputFiles, fullArgs );
+
+        // Use the remotely synchronized tool
+        AStackString<> executable;
+        AStackString<> workingDir;
+        job->GetToolManifest()->GetRemoteFilePath( 0, executable );
+        job->GetToolManifest()->GetRemotePath( workingDir );
+
+        result = Run( job, executable, fullArgs, workingDir.Get(), job->GetToolManifest()->GetRemoteEnvironmentString() );
+    }
+
+    DeleteExtractedInputs( tmpDirectory, inputFiles.GetSize() );
+
+    return result;
+}
+
+// Run
+//------------------------------------------------------------------------------
+Node::BuildResult ExecNode::Run( Job * job, const AString & executable, const AString & args, const char * workingDir, const char * environment )
+{
     // spawn the process
-    Process p( FBuild::Get().GetAbortBuildPointer() );
-    const bool spawnOK = p.Spawn( GetExecutable()->GetName().Get(),
-                            fullArgs.Get(),
+    Process p( FBuild::GetAbortBuildPointer(), job->GetAbortFlagPointer() );
+    const bool spawnOK = p.Spawn( executable.Get(),
+                            args.Get(),
                             workingDir,
                             environment );
 
@@ -210,7 +358,11 @@ ExecNode::~ExecNode()
             return BuildResult::eAborted;
         }
 
-        FLOG_ERROR( "Failed to spawn process for '%s'", GetName().Get() );
+        job->Error( "Failed to spawn process for '%s'", GetName().Get() );
+        if ( job->IsLocal() == false )
+        {
+            job->OnSystemError(); // Problem with this worker, so can be retried on another
+        }
         return BuildResult::eFailed;
     }
 
@@ -221,16 +373,17 @@ ExecNode::~ExecNode()
 
     // Get result
     const int result = p.WaitForExit();
+    job->OnProcessExited( p );
     if ( p.HasAborted() )
     {
         return BuildResult::eAborted;
     }
     const bool buildFailed = ( result != m_ExecReturnCode );
 
-    // Print output if appropriate
+    // Print output if appropriate (remote output is returned with the job)
     if ( buildFailed ||
         m_ExecAlwaysShowOutput ||
-        FBuild::Get().GetOptions().m_ShowCommandOutput )
+        ( job->IsLocal() && FBuild::Get().GetOptions().m_ShowCommandOutput ) )
     {
         Node::DumpOutput( job, memOut );
         Node::DumpOutput( job, memErr );
@@ -239,7 +392,7 @@ ExecNode::~ExecNode()
     // did the executable fail?
     if ( buildFailed )
     {
-        FLOG_ERROR( "Execution failed. Error: %s Target: '%s'", ERROR_STR( result ), GetName().Get() );
+        job->Error( "Execution failed. Error: %s Target: '%s'", ERROR_STR( result ), GetName().Get() );
         return BuildResult::eFailed;
     }
 
@@ -255,15 +408,410 @@ ExecNode::~ExecNode()
         f.Close();
     }
 
+    return BuildResult::eOk;
+}
+
+// GetExecutable
+//------------------------------------------------------------------------------
+const AString & ExecNode::GetExecutable() const
+{
+    const Node * n = m_StaticDependencies[ 0 ].GetNode();
+    return ( n->GetType() == Node::COMPILER_NODE ) ? n->CastTo< CompilerNode >()->GetExecutable()
+                                                   : n->GetName();
+}
+
+// GetCompiler
+//------------------------------------------------------------------------------
+CompilerNode * ExecNode::GetCompiler() const
+{
+    // Only valid for distributable Execs, which must use a Compiler()
+    ASSERT( m_ExecDistributable );
+    return m_StaticDependencies[ 0 ].GetNode()->CastTo< CompilerNode >();
+}
+
+// ShouldUseCache
+//------------------------------------------------------------------------------
+bool ExecNode::ShouldUseCache() const
+{
+    return m_ExecCacheable &&
+           ( FBuild::Get().GetOptions().m_UseCacheRead || FBuild::Get().GetOptions().m_UseCacheWrite );
+}
+
+// GetCacheName
+//------------------------------------------------------------------------------
+bool ExecNode::GetCacheName( const AString & fullArgs, AString & outCacheName ) const
+{
+    PROFILE_FUNCTION;
+
+    // Contents of all inputs
+    StackArray< uint64_t > inputHashes;
+    const auto hashInputs = [ &inputHashes ]( const Dependencies & deps, size_t startIndex ) -> bool
+    {
+        for ( size_t i = startIndex; i < deps.GetSize(); ++i )
+        {
+            const Node * n = deps[ i ].GetNode();
+            if ( n->GetType() == Node::DIRECTORY_LIST_NODE )
+            {
+                continue; // Files are dynamic dependencies
+            }
+            uint64_t hash = 0;
+            if ( HashFileContents( n->GetName(), hash ) == false )
+            {
+                FLOG_WARN( "Failed to read input for cache key '%s'", n->GetName().Get() );
+                return false;
+            }
+            inputHashes.Append( hash );
+        }
+        return true;
+    };
+    if ( !hashInputs( m_StaticDependencies, 1 ) || !hashInputs( m_DynamicDependencies, 0 ) ) // Skip executable
+    {
+        return false;
+    }
+    const uint64_t inputsKey = xxHash3::Calc64( inputHashes.Begin(), inputHashes.GetSize() * sizeof( uint64_t ) );
+
+    // Everything else affecting the output
+    AStackString< 4 * KILOBYTE > commandLine( fullArgs );
+    commandLine.AppendFormat( "|%s|%i|%u", m_ExecWorkingDir.Get(), m_ExecReturnCode, (uint32_t)m_ExecUseStdOutAsOutput );
+    for ( const AString & envVar : m_Environment )
+    {
+        commandLine += '|';
+        commandLine += envVar;
+    }
+    const uint32_t commandLineKey = xxHash::Calc32( commandLine );
+
+    // The tool itself: A Compiler() covers all files in its manifest
+    uint64_t toolKey = 0;
+    const Node * executable = m_StaticDependencies[ 0 ].GetNode();
+    if ( executable->GetType() == Node::COMPILER_NODE )
+    {
+        toolKey = executable->CastTo< CompilerNode >()->GetManifest().GetToolId();
+    }
+    else if ( HashFileContents( executable->GetName(), toolKey ) == false )
+    {
+        FLOG_WARN( "Failed to read executable for cache key '%s'", executable->GetName().Get() );
+        return false;
+    }
+
+    ICache::GetCacheId( inputsKey, commandLineKey, toolKey, 0, outCacheName );
+    return true;
+}
+
+// RetrieveFromCache
+//------------------------------------------------------------------------------
+bool ExecNode::RetrieveFromCache( const AString & cacheName )
+{
+    if ( FBuild::Get().GetOptions().m_UseCacheRead == false )
+    {
+        return false;
+    }
+
+    PROFILE_FUNCTION;
+
+    const Timer t;
+
+    ICache * cache = FBuild::Get().GetCache();
+    ASSERT( cache );
+
+    void * cacheData( nullptr );
+    size_t cacheDataSize( 0 );
+    if ( cache->Retrieve( cacheName, cacheData, cacheDataSize ) == false )
+    {
+        if ( FBuild::Get().GetOptions().m_CacheVerbose )
+        {
+            FLOG_OUTPUT( "Run: %s\n"
+                         " - Cache Miss: %u ms '%s'\n",
+                         GetName().Get(), uint32_t( t.GetElapsedMS() ), cacheName.Get() );
+        }
+        SetStatFlag( Node::STATS_CACHE_MISS );
+        return false;
+    }
+
+    // Check entry is intact
+    AStackString<> problem;
+    if ( CacheEntry::Verify( cacheData, cacheDataSize, problem ) == false )
+    {
+        FLOG_WARN( "Cache returned corrupt data (quarantined)\n"
+                   " - File   : '%s'\n"
+                   " - Key    : %s\n"
+                   " - Problem: %s\n",
+                   m_Name.Get(), cacheName.Get(), problem.Get() );
+        cache->FreeMemory( cacheData, cacheDataSize );
+        cache->Quarantine( cacheName );
+        Metrics::s_CacheCorrupt.Add();
+        SetStatFlag( Node::STATS_CACHE_CORRUPT );
+        SetStatFlag( Node::STATS_CACHE_MISS );
+        return false;
+    }
+
+    MultiBuffer buffer( CacheEntry::GetPayload( cacheData ), CacheEntry::GetPayloadSize( cacheData ) );
+    const bool extracted = buffer.Decompress() &&
+                           EnsurePathExistsForFile( m_Name ) &&
+                           buffer.ExtractFile( 0, m_Name );
+    cache->FreeMemory( cacheData, cacheDataSize );
+    if ( extracted == false )
+    {
+        FLOG_WARN( "Cache returned invalid data\n"
+                   " - File: '%s'\n"
+                   " - Key : %s\n",
+                   m_Name.Get(), cacheName.Get() );
+        SetStatFlag( Node::STATS_CACHE_MISS );
+        return false;
+    }
+
+    // Update file modification time
+    if ( FileIO::SetFileLastWriteTimeToNow( m_Name ) == false )
+    {
+        FLOG_ERROR( "Failed to set timestamp after cache hit. Error: %s Target: '%s'", LAST_ERROR_STR, m_Name.Get() );
+        return false;
+    }
+
     // record new file time
     RecordStampFromBuiltFile();
 
-    return BuildResult::eOk;
+    if ( FBuild::Get().GetOptions().m_ShowCommandSummary ||
+         FBuild::Get().GetOptions().m_CacheVerbose )
+    {
+        AStackString<> output;
+        output.Format( "Run: %s <CACHE>\n", GetName().Get() );
+        if ( FBuild::Get().GetOptions().m_CacheVerbose )
+        {
+            output.AppendFormat( " - Cache Hit: %u ms '%s'\n", uint32_t( t.GetElapsedMS() ), cacheName.Get() );
+        }
+        FLOG_OUTPUT( output );
+    }
+
+    SetStatFlag( Node::STATS_CACHE_HIT );
+    return true;
+}
+
+// WriteToCache
+//------------------------------------------------------------------------------
+void ExecNode::WriteToCache( const AString & cacheName )
+{
+    if ( FBuild::Get().GetOptions().m_UseCacheWrite == false )
+    {
+        return;
+    }
+
+    PROFILE_FUNCTION;
+
+    const Timer t;
+
+    // Load and compress output
+    Array< AString > fileNames( 1 );
+    fileNames.Append( m_Name );
+    MultiBuffer buffer;
+    bool stored = false;
+    if ( buffer.CreateFromFiles( fileNames ) )
+    {
+        const int16_t compressionLevel = FBuild::Get().GetOptions().m_CacheCompressionLevel;
+        buffer.Compress( compressionLevel, ( compressionLevel > 0 ) ); // Zstd for higher compression levels
+        CacheEntry entry;
+        entry.Create( buffer.GetData(), (size_t)buffer.GetDataSize() );
+        stored = FBuild::Get().GetCache()->Publish( cacheName, entry.GetData(), entry.GetDataSize() );
+    }
+
+    if ( stored )
+    {
+        SetStatFlag( Node::STATS_CACHE_STORE );
+        AddCachingTime( uint32_t( t.GetElapsedMS() ) );
+    }
+
+    if ( FBuild::Get().GetOptions().m_CacheVerbose )
+    {
+        FLOG_OUTPUT( "Run: %s\n"
+                     " - Cache Store%s: %u ms '%s'\n",
+                     GetName().Get(), stored ? "" : " Fail", uint32_t( t.GetElapsedMS() ), cacheName.Get() );
+    }
+}
+
+// ShouldDistribute
+//------------------------------------------------------------------------------
+bool ExecNode::ShouldDistribute() const
+{
+    if ( ( m_ExecDistributable == false ) ||
+         ( FBuild::Get().GetOptions().m_AllowDistributed == false ) ||
+         ( GetCompiler()->CanBeDistributed() == false ) )
+    {
+        return false;
+    }
+    return ( ( Job::GetTotalLocalDataMemoryUsage() / MEGABYTE ) < FBuild::Get().GetSettings()->GetDistributableJobMemoryLimitMiB() );
+}
+
+// PackInputs
+//------------------------------------------------------------------------------
+bool ExecNode::PackInputs( Job * job, const Array< AString > & inputFiles ) const
+{
+    PROFILE_FUNCTION;
+
+    // Each input is stored with its name, so the worker can recreate it
+    MemoryStream ms;
+    ms.Write( (uint32_t)inputFiles.GetSize() );
+    for ( const AString & inputFile : inputFiles )
+    {
+        FileStream f;
+        if ( f.Open( inputFile.Get(), FileStream::READ_ONLY ) == false )
+        {
+            return false; // Build locally, which will report the problem
+        }
+        const uint64_t fileSize = f.GetFileSize();
+        ms.Write( inputFile );
+        ms.Write( fileSize );
+        if ( ms.WriteBuffer( f, fileSize ) != fileSize )
+        {
+            return false; // Build locally, which will report the problem
+        }
+    }
+
+    // compress job data
+    job->RecordPhaseTime( Job::PHASE_COMPRESS_BEGIN );
+    Compressor c;
+    c.Compress( ms.GetData(), ms.GetSize(), FBuild::Get().GetOptions().m_DistributionCompressionLevel );
+    const size_t compressedSize = c.GetResultSize();
+    job->OwnData( c.ReleaseResult(), compressedSize, true );
+    job->RecordPhaseTime( Job::PHASE_COMPRESS_END );
+    return true;
+}
+
+// ExtractInputs
+//------------------------------------------------------------------------------
+bool ExecNode::ExtractInputs( Job * job, AString & tmpDirectory, Array< AString > & outInputFiles ) const
+{
+    ASSERT( job->IsDataCompressed() );
+
+    job->RecordPhaseTime( Job::PHASE_WORKER_DECOMPRESS_BEGIN );
+    Compressor c;
+    if ( c.Decompress( job->GetData() ) == false )
+    {
+        // Decompression failure would indicate a bug
+        job->Error( "Decompression failed. Target: '%s'", GetName().Get() );
+        job->OnSystemError();
+        return false;
+    }
+    job->RecordPhaseTime( Job::PHASE_WORKER_DECOMPRESS_END );
+
+    WorkerThread::GetTempFileDirectory( tmpDirectory );
+    tmpDirectory.AppendFormat( "%08X%c", xxHash::Calc32( GetName() ), NATIVE_SLASH );
+
+    ConstMemoryStream ms( c.GetResult(), c.GetResultSize() );
+    uint32_t numInputFiles = 0;
+    ms.Read( numInputFiles );
+    for ( uint32_t i = 0; i < numInputFiles; ++i )
+    {
+        AStackString<> inputFile;
+        uint64_t fileSize = 0;
+        if ( ( ms.Read( inputFile ) == false ) ||
+             ( ms.Read( fileSize ) == false ) ||
+             ( ( ms.Tell() + fileSize ) > ms.GetSize() ) )
+        {
+            job->Error( "Invalid job data. Target: '%s'", GetName().Get() );
+            job->OnSystemError();
+            return false;
+        }
+
+        // Each input gets its own directory, so files keep their names
+        // without colliding
+        AStackString<> tmpFileName( tmpDirectory );
+        tmpFileName.AppendFormat( "%u%c", i, NATIVE_SLASH );
+        const char * lastSlash = inputFile.FindLast( NATIVE_SLASH );
+        tmpFileName += lastSlash ? ( lastSlash + 1 ) : inputFile.Get();
+
+        FileStream tmpFile;
+        if ( ( FileIO::EnsurePathExistsForFile( tmpFileName ) == false ) ||
+             ( WorkerThread::CreateTempFile( tmpFileName, tmpFile ) == false ) )
+        {
+            job->Error( "Failed to create temp file. Error: %s TmpFile: '%s' Target: '%s'", LAST_ERROR_STR, tmpFileName.Get(), GetName().Get() );
+            job->OnSystemError();
+            return false;
+        }
+        outInputFiles.Append( tmpFileName );
+        const void * fileData = ( static_cast< const char * >( ms.GetData() ) + ms.Tell() );
+        if ( tmpFile.WriteBuffer( fileData, fileSize ) != fileSize )
+        {
+            job->Error( "Failed to write to temp file. Error: %s TmpFile: '%s' Target: '%s'", LAST_ERROR_STR, tmpFileName.Get(), GetName().Get() );
+            job->OnSystemError();
+            return false;
+        }
+        tmpFile.Close();
+        ms.Seek( ms.Tell() + fileSize );
+    }
+
+    // Free compressed buffer as we don't need it anymore
+    job->OwnData( nullptr, 0, false );
+
+    return true;
+}
+
+// DeleteExtractedInputs
+//------------------------------------------------------------------------------
+/*static*/ void ExecNode::DeleteExtractedInputs( const AString & tmpDirectory, size_t numInputFiles )
+{
+    if ( tmpDirectory.IsEmpty() )
+    {
+        return;
+    }
+
+    // Remove inputs, and anything the executable wrote alongside them
+    Array< AString > files;
+    FileIO::GetFiles( tmpDirectory, AStackString<>( "*" ), true, &files );
+    for ( const AString & file : files )
+    {
+        FileIO::FileDelete( file.Get() );
+    }
+    for ( size_t i = 0; i < numInputFiles; ++i )
+    {
+        AStackString<> inputDirectory( tmpDirectory );
+        inputDirectory.AppendFormat( "%u", (uint32_t)i );
+        FileIO::DirectoryDelete( inputDirectory );
+    }
+    FileIO::DirectoryDelete( tmpDirectory );
+}
+
+// SaveRemote
+//------------------------------------------------------------------------------
+/*virtual*/ void ExecNode::SaveRemote( IOStream & stream ) const
+{
+    // Save minimal information for the remote worker
+    // (inputs are sent with the job data)
+    stream.Write( m_Name );
+    stream.Write( m_ExecArguments );
+    stream.Write( m_ExecReturnCode );
+    stream.Write( m_ExecAlwaysShowOutput );
+    stream.Write( m_ExecUseStdOutAsOutput );
+}
+
+// LoadRemote
+//------------------------------------------------------------------------------
+/*static*/ Node * ExecNode::LoadRemote( IOStream & stream )
+{
+    AString name;
+    AStackString<> arguments;
+    int32_t returnCode;
+    bool alwaysShowOutput;
+    bool useStdOutAsOutput;
+    if ( ( stream.Read( name ) == false ) ||
+         ( stream.Read( arguments ) == false ) ||
+         ( stream.Read( returnCode ) == false ) ||
+         ( stream.Read( alwaysShowOutput ) == false ) ||
+         ( stream.Read( useStdOutAsOutput ) == false ) )
+    {
+        return nullptr;
+    }
+
+    ExecNode * node = FNEW( ExecNode() );
+    node->SetName( Move( name ) );
+    node->m_ExecArguments = arguments;
+    node->m_ExecReturnCode = returnCode;
+    node->m_ExecAlwaysShowOutput = alwaysShowOutput;
+    node->m_ExecUseStdOutAsOutput = useStdOutAsOutput;
+    node->m_ExecDistributable = true;
+    return node;
 }
 
 // EmitCompilationMessage
 //------------------------------------------------------------------------------
-void ExecNode::EmitCompilationMessage( const AString & args ) const
+void ExecNode::EmitCompilationMessage( const AString & args, bool stealingRemoteJob, bool racingRemoteJob ) const
 {
     // basic info
     AStackString< 2048 > output;
@@ -271,6 +819,14 @@ void ExecNode::EmitCompilationMessage( const AString & args ) const
     {
         output += "Run: ";
         output += GetName();
+        if ( racingRemoteJob )
+        {
+            output += " <LOCAL RACE>";
+        }
+        else if ( stealingRemoteJob )
+        {
+            output += " <LOCAL>";
+        }
         output += '\n';
     }
 
@@ -279,7 +835,7 @@ void ExecNode::EmitCompilationMessage( const AString & args ) const
     {
         AStackString< 1024 > verboseOutput;
         verboseOutput.Format( "%s %s\nWorkingDir: %s\nExpectedReturnCode: %i\n",
-                              GetExecutable()->GetName().Get(),
+                              GetExecutable().Get(),
                               args.Get(),
                               m_ExecWorkingDir.Get(),
                               m_ExecReturnCode );
@@ -290,9 +846,33 @@ void ExecNode::EmitCompilationMessage( const AString & args ) const
     FLOG_OUTPUT( output );
 }
 
+// GetInputFileNames
+//------------------------------------------------------------------------------
+void ExecNode::GetInputFileNames( Array< AString > & outInputFiles ) const
+{
+    for ( size_t i=1; i < m_StaticDependencies.GetSize(); ++i ) // Note: Skip first dep (executable)
+    {
+        const Node * n = m_StaticDependencies[ i ].GetNode();
+
+        // Handle directory lists
+        if ( n->GetType() == Node::DIRECTORY_LIST_NODE )
+        {
+            const DirectoryListNode * dln = n->CastTo< DirectoryListNode >();
+            const Array< FileIO::FileInfo > & files = dln->GetFiles();
+            for ( const FileIO::FileInfo & file : files )
+            {
+                outInputFiles.Append( file.m_Name );
+            }
+            continue;
+        }
+
+        outInputFiles.Append( n->GetName() );
+    }
+}
+
 // GetFullArgs
 //------------------------------------------------------------------------------
-void ExecNode::GetFullArgs(AString & fullArgs) const
+void ExecNode::GetFullArgs( const Array< AString > & inputFiles, AString & fullArgs ) const
 {
     // split into tokens
     Array< AString > tokens( 1024 );
@@ -312,7 +892,7 @@ void ExecNode::GetFullArgs(AString & fullArgs) const
             }
 
             // concatenate files, unquoted
-            GetInputFiles(fullArgs, pre, AString::GetEmpty());
+            GetInputFiles(inputFiles, fullArgs, pre, AString::GetEmpty());
         }
         else if (token.EndsWith("\"%1\""))
         {
@@ -320,7 +900,7 @@ void ExecNode::GetFullArgs(AString & fullArgs) const
             AStackString<> pre(token.Get(), token.GetEnd() - 3); // 3 instead of 4 to include quote
 
             // concatenate files, quoted
-            GetInputFiles(fullArgs, pre, quote);
+            GetInputFiles(inputFiles, fullArgs, pre, quote);
         }
         else if (token.EndsWith("%2"))
         {
@@ -350,39 +930,17 @@ void ExecNode::GetFullArgs(AString & fullArgs) const
 
 // GetInputFiles
 //------------------------------------------------------------------------------
-void ExecNode::GetInputFiles(AString & fullArgs, const AString & pre, const AString & post) const
+void ExecNode::GetInputFiles( const Array< AString > & inputFiles, AString & fullArgs, const AString & pre, const AString & post ) const
 {
     bool first = true; // Handle comma separation
-    for ( size_t i=1; i < m_StaticDependencies.GetSize(); ++i ) // Note: Skip first dep (executable)
+    for ( const AString & inputFile : inputFiles )
     {
-        const Dependency & dep = m_StaticDependencies[ i ];
-        const Node * n = dep.GetNode();
-
-        // Handle directory lists
-        if ( n->GetType() == Node::DIRECTORY_LIST_NODE )
-        {
-            const DirectoryListNode * dln = n->CastTo< DirectoryListNode >();
-            const Array< FileIO::FileInfo > & files = dln->GetFiles();
-            for ( const FileIO::FileInfo & file : files )
-            {
-                if ( !first )
-                {
-                    fullArgs += ' ';
-                }
-                fullArgs += pre;
-                fullArgs += file.m_Name;
-                fullArgs += post;
-                first = false;
-            }
-            continue;
-        }
-
         if ( !first )
         {
             fullArgs += ' ';
         }
         fullArgs += pre;
-        fullArgs += dep.GetNode()->GetName();
+        fullArgs += inputFile;
         fullArgs += post;
         first = false;
     }
@@ -9,6 +9,7 @@
 
 // Forward Declarations
 //------------------------------------------------------------------------------
+class CompilerNode;
 
 // ExecNode
 //------------------------------------------------------------------------------
@@ -22,16 +23,39 @@ public:
 
     static inline Node::Type GetTypeS() { return Node::EXEC_NODE; }
 
+    // Distribution
+    virtual void SaveRemote( IOStream & stream ) const override;
+    static Node * LoadRemote( IOStream & stream );
+    CompilerNode * GetCompiler() const;
+
 private:
     virtual bool DoDynamicDependencies( NodeGraph & nodeGraph ) override;
     virtual bool DetermineNeedToBuildStatic() const override;
     virtual BuildResult DoBuild( Job * job ) override;
+    virtual BuildResult DoBuild2( Job * job, bool racingRemoteJob ) override;
+
+    BuildResult DoBuildRemote( Job * job );
+    BuildResult Run( Job * job, const AString & executable, const AString & args, const char * workingDir, const char * environment );
+
+    const AString & GetExecutable() const;
+    void GetInputFileNames( Array< AString > & outInputFiles ) const;
+    void GetFullArgs( const Array< AString > & inputFiles, AString & fullArgs ) const;
+    void GetInputFiles( const Array< AString > & inputFiles, AString & fullArgs, const AString & pre, const AString & post ) const;
+
+    void EmitCompilationMessage( const AString & args, bool stealingRemoteJob = false, bool racingRemoteJob = false ) const;
 
-    const FileNode * GetExecutable() const { return m_StaticDependencies[0].GetNode()->CastTo< FileNode >(); }
-    void GetFullArgs(AString & fullArgs) const;
-    void GetInputFiles(AString & fullArgs, const AString & pre, const AString & post) const;
+    // Distribution
+    bool ShouldDistribute() const;
+    bool PackInputs( Job * job, const Array< AString > & inputFiles ) const;
+    bool ExtractInputs( Job * job, AString & tmpDirectory, Array< AString > & outInputFiles ) const;
+    static void DeleteExtractedInputs( const AString & tmpDirectory, size_t numInputFiles );
 
-    void EmitCompilationMessage( const AString & args ) const;
+    // Cache
+    friend class Client;
+    bool ShouldUseCache() const;
+    bool GetCacheName( const AString & fullArgs, AString & outCacheName ) const;
+    bool RetrieveFromCache( const AString & cacheName );
+    void WriteToCache( const AString & cacheName );
 
     // Exposed Properties
     AString             m_ExecExecutable;
@@ -48,6 +72,8 @@ private:
     bool                m_ExecUseStdOutAsOutput;
     bool                m_ExecAlways;
     bool                m_ExecInputPathRecurse;
+    bool                m_ExecCacheable;
+    bool                m_ExecDistributable;
     Array< AString >    m_PreBuildDependencyNames;
     Array< AString >    m_Environment;
     AString             m_ConcurrencyGroupName;
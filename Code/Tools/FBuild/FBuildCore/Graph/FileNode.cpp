@@ -45,11 +45,47 @@ FileNode::~FileNode() = default;
     #endif
 
     // NOTE: Not calling RecordStampFromBuiltFile as this is not a built file
-    m_Stamp = FileIO::GetFileLastWriteTime( m_Name );
+    const bool useContentHash = FBuild::IsValid() && FBuild::Get().GetOptions().m_UseContentHash;
+    m_Stamp = ObtainStamp( useContentHash );
     // Don't assert m_Stamp != 0 as input file might not exist
     return BuildResult::eOk;
 }
 
+// ObtainStamp
+//------------------------------------------------------------------------------
+uint64_t FileNode::ObtainStamp( bool useContentHash )
+{
+    if ( useContentHash == false )
+    {
+        return FileIO::GetFileLastWriteTime( m_Name );
+    }
+
+    FileIO::FileInfo info;
+    if ( FileIO::GetFileInfo( m_Name, info ) == false )
+    {
+        return 0; // Missing
+    }
+
+    // Hash from a previous build is valid if the file is unchanged
+    if ( ( m_ContentHash != 0 ) &&
+         ( m_HashedFileTime == info.m_LastWriteTime ) &&
+         ( m_HashedFileSize == info.m_Size ) )
+    {
+        return m_ContentHash;
+    }
+
+    uint64_t hash;
+    if ( HashFileContents( m_Name, hash ) == false )
+    {
+        return 0; // Treat unreadable file as missing
+    }
+
+    m_HashedFileTime = info.m_LastWriteTime;
+    m_HashedFileSize = info.m_Size;
+    m_ContentHash = hash;
+    return hash;
+}
+
 // HandleWarningsMSVC
 //------------------------------------------------------------------------------
 void FileNode::HandleWarningsMSVC( Job * job, const AString & name, const AString & data )
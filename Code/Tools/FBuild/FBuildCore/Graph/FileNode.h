@@ -19,6 +19,10 @@ public:
 
     virtual bool IsAFile() const override { return true; }
 
+    // Obtain the stamp for the file: its last write time or, if using content
+    // hashes, a hash of its contents. Returns 0 if the file doesn't exist.
+    uint64_t ObtainStamp( bool useContentHash );
+
     static void HandleWarningsMSVC( Job * job, const AString & name, const AString & data );
     static void HandleWarningsClangCl( Job * job, const AString & name, const AString & data );
     static void HandleWarningsClangGCC( Job * job, const AString & name, const AString & data );
@@ -30,6 +34,13 @@ protected:
     static void HandleWarnings( Job * job, const AString & name, const AString & data, const char * warningString );
 
     friend class Client;
+    friend class Node; // Save/Load
+    friend class NodeGraph; // MigrateNode
+
+    // Content hash, re-used while the file's time and size are unchanged
+    uint64_t    m_HashedFileTime    = 0;
+    uint64_t    m_HashedFileSize    = 0;
+    uint64_t    m_ContentHash       = 0;
 };
 
 //------------------------------------------------------------------------------
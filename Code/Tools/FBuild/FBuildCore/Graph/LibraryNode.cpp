@@ -16,13 +16,19 @@
 #include "Tools/FBuild/FBuildCore/Graph/NodeGraph.h"
 #include "Tools/FBuild/FBuildCore/Graph/ObjectListNode.h"
 #include "Tools/FBuild/FBuildCore/Graph/ObjectNode.h"
+#include "Tools/FBuild/FBuildCore/Helpers/ArchiveWriter.h"
 #include "Tools/FBuild/FBuildCore/Helpers/Args.h"
 #include "Tools/FBuild/FBuildCore/Helpers/ResponseFile.h"
 #include "Tools/FBuild/FBuildCore/WorkerPool/Job.h"
 
 // Core
+#include "Core/Containers/UnorderedMap.h"
+#include "Core/Env/Env.h"
 #include "Core/Env/ErrorFormat.h"
+#include "Core/Math/Conversions.h"
+#include "Core/Process/Atomic.h"
 #include "Core/Process/Process.h"
+#include "Core/Process/Thread.h"
 #include "Core/Strings/AStackString.h"
 
 // Reflection
@@ -39,8 +45,84 @@ REFLECT_NODE_BEGIN( LibraryNode, ObjectListNode, MetaName( "LibrarianOutput" ) +
     REFLECT( m_NumLibrarianAdditionalInputs,    "NumLibrarianAdditionalInputs", MetaHidden() )
     REFLECT( m_LibrarianFlags,                  "LibrarianFlags",               MetaHidden() )
     REFLECT_ARRAY( m_Environment,               "Environment",                  MetaOptional() )
+    REFLECT_ARRAY_OF_STRUCT( m_ArchiveMembers,  "ArchiveMembers", LibraryArchiveMember, MetaHidden() + MetaIgnoreForComparison() )
 REFLECT_END( LibraryNode )
 
+REFLECT_STRUCT_BEGIN( LibraryArchiveMember, Struct, MetaNone() )
+    REFLECT( m_FileName,                        "FileName",                     MetaHidden() )
+    REFLECT( m_LastWriteTime,                   "LastWriteTime",                MetaHidden() )
+    REFLECT( m_Size,                            "Size",                         MetaHidden() )
+    REFLECT_ARRAY( m_Symbols,                   "Symbols",                      MetaHidden() )
+REFLECT_END( LibraryArchiveMember )
+
+// ArchiveMemberScanner
+//  - Shared state for threads obtaining the symbols of archive members
+//------------------------------------------------------------------------------
+class ArchiveMemberScanner
+{
+public:
+    ArchiveMemberScanner( Array< LibraryArchiveMember > & members, const Array< uint32_t > & membersToScan )
+        : m_Members( members )
+        , m_MembersToScan( membersToScan )
+    {
+    }
+
+    // Returns false if any member could not be read
+    bool Run()
+    {
+        // Use additional threads if there are enough members to be
+        // worthwhile, with the calling thread helping out
+        const uint32_t kMinMembersPerThread = 16;
+        const uint32_t kMaxThreads = 8;
+        const uint32_t numThreads = Math::Min( Math::Min( Env::GetNumProcessors(), kMaxThreads ),
+                                               (uint32_t)m_MembersToScan.GetSize() / kMinMembersPerThread );
+        Thread threads[ kMaxThreads ];
+        for ( uint32_t i = 0; i < numThreads; ++i )
+        {
+            threads[ i ].Start( ThreadFunc, "ArchiveMemberScanner", this );
+        }
+        Process();
+        for ( uint32_t i = 0; i < numThreads; ++i )
+        {
+            threads[ i ].Join();
+        }
+        return ( AtomicLoadRelaxed( &m_Failed ) == false );
+    }
+
+    ArchiveMemberScanner & operator =( ArchiveMemberScanner & ) = delete;
+
+private:
+    static uint32_t ThreadFunc( void * userData )
+    {
+        static_cast< ArchiveMemberScanner * >( userData )->Process();
+        return 0;
+    }
+
+    void Process()
+    {
+        // Each thread takes the next member until none remain
+        for ( ;; )
+        {
+            const uint32_t index = ( AtomicInc( &m_NextIndex ) - 1 );
+            if ( index >= m_MembersToScan.GetSize() )
+            {
+                return;
+            }
+            LibraryArchiveMember & member = m_Members[ m_MembersToScan[ index ] ];
+            if ( ArchiveWriter::GetSymbols( member.m_FileName, member.m_Symbols ) == false )
+            {
+                FLOG_ERROR( "Failed to read archive member '%s'", member.m_FileName.Get() );
+                AtomicStoreRelaxed( &m_Failed, true );
+            }
+        }
+    }
+
+    Array< LibraryArchiveMember > & m_Members;
+    const Array< uint32_t > &       m_MembersToScan;
+    uint32_t                        m_NextIndex = 0;
+    bool                            m_Failed = false;
+};
+
 // CONSTRUCTOR
 //------------------------------------------------------------------------------
 LibraryNode::LibraryNode()
@@ -67,7 +149,10 @@ LibraryNode::LibraryNode()
     m_StaticDependencies.Add( librarian );
     m_ObjectListInputStartIndex += 1; // Ensure librarian is not treated as an input
 
-    // .LibrarianOptions
+    m_LibrarianFlags = DetermineFlags( m_LibrarianType, m_Librarian, m_LibrarianOptions );
+
+    // .LibrarianOptions (not used by the built-in archiver)
+    if ( GetFlag( LIB_FLAG_BUILTIN_AR ) == false )
     {
         if ( m_LibrarianOptions.Find( "%1" ) == nullptr )
         {
@@ -100,8 +185,6 @@ LibraryNode::LibraryNode()
     m_StaticDependencies.Add( librarianAdditionalInputs );
     // m_ObjectListInputEndIndex // NOTE: Deliberately not added to m_ObjectListInputEndIndex, since we don't want to try and compile these things
 
-    m_LibrarianFlags = DetermineFlags( m_LibrarianType, m_Librarian, m_LibrarianOptions );
-
     return true;
 }
 
@@ -144,6 +227,8 @@ LibraryNode::~LibraryNode()
 //------------------------------------------------------------------------------
 /*virtual*/ Node::BuildResult LibraryNode::DoBuild( Job * job )
 {
+    RecordUnityCompileTimes();
+
     // Delete library from previous build (if present) if:
     // - A clean build is being triggered
     // - A non-msvc librarian is used (librarians like ar can cause duplicate
@@ -157,6 +242,11 @@ LibraryNode::~LibraryNode()
         }
     }
 
+    if ( GetFlag( LIB_FLAG_BUILTIN_AR ) )
+    {
+        return BuildArchive();
+    }
+
     // Format compiler args string
     Args fullArgs;
     if ( !BuildArgs( fullArgs ) )
@@ -196,6 +286,7 @@ LibraryNode::~LibraryNode()
 
     // Get result
     const int result = p.WaitForExit();
+    job->OnProcessExited( p );
     if ( p.HasAborted() )
     {
         return BuildResult::eAborted;
@@ -233,6 +324,96 @@ LibraryNode::~LibraryNode()
     return BuildResult::eOk;
 }
 
+// Migrate
+//------------------------------------------------------------------------------
+/*virtual*/ void LibraryNode::Migrate( const Node & oldNode )
+{
+    // Migrate Node level properties
+    Node::Migrate( oldNode );
+
+    // Migrate lazily evaluated properties
+    const LibraryNode * oldLibraryNode = oldNode.CastTo< LibraryNode >();
+    m_ArchiveMembers = oldLibraryNode->m_ArchiveMembers;
+}
+
+// BuildArchive
+//------------------------------------------------------------------------------
+Node::BuildResult LibraryNode::BuildArchive()
+{
+    if ( FBuild::Get().GetOptions().m_ShowCommandSummary )
+    {
+        AStackString<> output( "Lib: " );
+        output += GetName();
+        output += '\n';
+        FLOG_OUTPUT( output );
+    }
+
+    StackArray< AString > inputs;
+    GetInputFiles( true, inputs );
+
+    // Members from the previous build
+    UnorderedMap< AString, uint32_t > previousMembers;
+    for ( size_t i = 0; i < m_ArchiveMembers.GetSize(); ++i )
+    {
+        previousMembers.Insert( m_ArchiveMembers[ i ].m_FileName, static_cast< uint32_t >( i ) );
+    }
+
+    // Re-use symbols of unmodified members, and scan the others
+    Array< LibraryArchiveMember > members( inputs.GetSize() );
+    Array< uint32_t > membersToScan( inputs.GetSize() );
+    for ( const AString & input : inputs )
+    {
+        FileIO::FileInfo info;
+        if ( FileIO::GetFileInfo( input, info ) == false )
+        {
+            FLOG_ERROR( "Missing input '%s' for Library '%s'", input.Get(), GetName().Get() );
+            return BuildResult::eFailed;
+        }
+
+        LibraryArchiveMember & member = members.EmplaceBack();
+        member.m_FileName = input;
+        member.m_LastWriteTime = info.m_LastWriteTime;
+        member.m_Size = info.m_Size;
+
+        const UnorderedMap< AString, uint32_t >::KeyValue * previous = previousMembers.Find( input );
+        if ( previous )
+        {
+            LibraryArchiveMember & previousMember = m_ArchiveMembers[ previous->m_Value ];
+            if ( ( previousMember.m_LastWriteTime == member.m_LastWriteTime ) &&
+                 ( previousMember.m_Size == member.m_Size ) )
+            {
+                member.m_Symbols = Move( previousMember.m_Symbols );
+                continue;
+            }
+        }
+        membersToScan.Append( static_cast< uint32_t >( members.GetSize() - 1 ) );
+    }
+    m_ArchiveMembers.Destruct(); // Symbols may have been moved from
+
+    ArchiveMemberScanner scanner( members, membersToScan );
+    if ( scanner.Run() == false )
+    {
+        return BuildResult::eFailed; // Run will have emitted an error
+    }
+    m_NumArchiveMembersScanned = static_cast< uint32_t >( membersToScan.GetSize() );
+
+    ArchiveWriter writer( GetFlag( LIB_FLAG_THIN ) );
+    for ( const LibraryArchiveMember & member : members )
+    {
+        writer.AddMember( member.m_FileName, member.m_Size, member.m_Symbols );
+    }
+    if ( writer.Write( GetName() ) == false )
+    {
+        return BuildResult::eFailed; // Write will have emitted an error
+    }
+    m_ArchiveMembers = Move( members );
+
+    // record new file time
+    RecordStampFromBuiltFile();
+
+    return BuildResult::eOk;
+}
+
 // BuildArgs
 //------------------------------------------------------------------------------
 bool LibraryNode::BuildArgs( Args & fullArgs ) const
@@ -374,6 +555,14 @@ bool LibraryNode::BuildArgs( Args & fullArgs ) const
         {
             flags |= LIB_FLAG_GREENHILLS_AX;
         }
+        else if ( librarianType == "builtin-ar" )
+        {
+            flags |= ( LIB_FLAG_AR | LIB_FLAG_BUILTIN_AR );
+        }
+        else if ( librarianType == "builtin-ar-thin" )
+        {
+            flags |= ( LIB_FLAG_AR | LIB_FLAG_BUILTIN_AR | LIB_FLAG_THIN );
+        }
     }
 
     if ( flags & LIB_FLAG_LIB )
@@ -16,6 +16,20 @@ class NodeGraph;
 class ObjectNode;
 enum class ArgsResponseFileMode : uint32_t;
 
+// LibraryArchiveMember
+//  - Member of an archive created by the built-in archiver, retained so
+//    unmodified members don't need to be scanned for symbols again
+//------------------------------------------------------------------------------
+class LibraryArchiveMember : public Struct
+{
+    REFLECT_STRUCT_DECLARE( LibraryArchiveMember )
+public:
+    AString             m_FileName;
+    uint64_t            m_LastWriteTime = 0;
+    uint64_t            m_Size          = 0;
+    Array< AString >    m_Symbols;
+};
+
 // LibraryNode
 //------------------------------------------------------------------------------
 class LibraryNode : public ObjectListNode
@@ -37,13 +51,22 @@ public:
         LIB_FLAG_ORBIS_AR=0x04, // Orbis ar.exe
         LIB_FLAG_GREENHILLS_AX=0x08, // Greenhills (WiiU) ax.exe
         LIB_FLAG_WARNINGS_AS_ERRORS_MSVC = 0x10,
+        LIB_FLAG_BUILTIN_AR = 0x20, // Archive is created by FASTBuild
+        LIB_FLAG_THIN   = 0x40, // Thin archive (with LIB_FLAG_BUILTIN_AR)
     };
     static uint32_t DetermineFlags( const AString & librarianType, const AString & librarianName, const AString & args );
+
+    // Number of archive members scanned for symbols during the last build
+    inline uint32_t GetNumArchiveMembersScanned() const { return m_NumArchiveMembersScanned; }
+
 private:
     friend class FunctionLibrary;
+    friend class ArchiveMemberScanner;
 
     virtual bool GatherDynamicDependencies( NodeGraph & nodeGraph ) override;
     virtual BuildResult DoBuild( Job * job ) override;
+    virtual void Migrate( const Node & oldNode ) override;
+    BuildResult BuildArchive();
 
     // internal helpers
     bool BuildArgs( Args & fullArgs ) const;
@@ -67,6 +90,8 @@ private:
     uint32_t            m_NumLibrarianAdditionalInputs  = 0;
     uint32_t            m_LibrarianFlags                = 0;
     mutable const char * m_EnvironmentString            = nullptr;
+    Array< LibraryArchiveMember > m_ArchiveMembers;
+    uint32_t            m_NumArchiveMembersScanned      = 0;
 };
 
 //------------------------------------------------------------------------------
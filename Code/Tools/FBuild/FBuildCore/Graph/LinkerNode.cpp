@@ -255,6 +255,7 @@ LinkerNode::~LinkerNode()
 
         // Get result
         const int result = p.WaitForExit();
+        job->OnProcessExited( p );
         if ( p.HasAborted() )
         {
             return BuildResult::eAborted;
@@ -366,6 +367,7 @@ LinkerNode::~LinkerNode()
 
         // Get result
         const int result = stampProcess.WaitForExit();
+        job->OnProcessExited( stampProcess );
         if ( stampProcess.HasAborted() )
         {
             return BuildResult::eAborted;
@@ -42,9 +42,11 @@
 
 // Core
 #include "Core/Containers/Array.h"
+#include "Core/Containers/UniquePtr.h"
 #include "Core/Env/Env.h"
 #include "Core/FileIO/ConstMemoryStream.h"
 #include "Core/FileIO/FileIO.h"
+#include "Core/FileIO/FileStream.h"
 #include "Core/FileIO/IOStream.h"
 #include "Core/FileIO/PathUtils.h"
 #include "Core/Math/xxHash.h"
@@ -59,6 +61,7 @@
 
 // Static Data
 //------------------------------------------------------------------------------
+/*static*/ uint32_t Node::s_PrefetchedFileTimeTag( 0 );
 /*static*/ const char * const Node::s_NodeTypeNames[] =
 {
     "Proxy",
@@ -164,7 +167,11 @@ Node::~Node() = default;
     // Handle missing or modified files
     if ( IsAFile() )
     {
-        const uint64_t lastWriteTime = FileIO::GetFileLastWriteTime( m_Name );
+        uint64_t lastWriteTime;
+        if ( ConsumePrefetchedFileTime( lastWriteTime ) == false )
+        {
+            lastWriteTime = FileIO::GetFileLastWriteTime( m_Name );
+        }
 
         if ( lastWriteTime == 0 )
         {
@@ -212,7 +219,7 @@ bool Node::DetermineNeedToBuild( const Dependencies & deps ) const
 
         const Node * n = dep.GetNode();
 
-        const uint64_t stamp = n->GetStamp();
+        const uint64_t stamp = n->GetDependencyStamp();
         if ( stamp == 0 )
         {
             // file missing - this may be ok, but node needs to build to find out
@@ -265,7 +272,7 @@ bool Node::DetermineNeedToBuild( const Dependencies & deps ) const
             // If built, it's possible to have a zero stamp due to missing files
             ASSERT( dep.GetNode()->GetStatFlag( Node::STATS_BUILT ) ||
                     dep.GetNode()->GetStamp() );
-            dep.Stamp( dep.GetNode()->GetStamp() );
+            dep.Stamp( dep.GetNode()->GetDependencyStamp() );
         }
     }
 
@@ -324,6 +331,35 @@ void Node::SetLastBuildTime( uint32_t ms )
     AtomicStoreRelaxed( &m_LastBuildTimeMs, ms );
 }
 
+// GetLastPeakMemoryMiB
+//------------------------------------------------------------------------------
+uint32_t Node::GetLastPeakMemoryMiB() const
+{
+    return AtomicLoadRelaxed( &m_LastPeakMemoryMiB );
+}
+
+// SetLastPeakMemoryMiB
+//------------------------------------------------------------------------------
+void Node::SetLastPeakMemoryMiB( uint32_t memoryMiB )
+{
+    AtomicStoreRelaxed( &m_LastPeakMemoryMiB, memoryMiB );
+}
+
+// ConsumePrefetchedFileTime
+//------------------------------------------------------------------------------
+bool Node::ConsumePrefetchedFileTime( uint64_t & outFileTime ) const
+{
+    if ( ( m_PrefetchedFileTimeTag == 0 ) || ( m_PrefetchedFileTimeTag != s_PrefetchedFileTimeTag ) )
+    {
+        return false; // Not obtained for this build
+    }
+
+    // Only valid for the first check, as the file may be modified by the build
+    m_PrefetchedFileTimeTag = 0;
+    outFileTime = m_PrefetchedFileTime;
+    return true;
+}
+
 // Load
 //------------------------------------------------------------------------------
 /*static*/ Node * Node::Load( NodeGraph & nodeGraph, ConstMemoryStream & stream )
@@ -342,9 +378,13 @@ void Node::SetLastBuildTime( uint32_t ms )
     Node * n = nodeGraph.CreateNode( (Type)nodeType, Move( name ), nameHash );
     ASSERT( n );
 
-    // Early out for FileNode
+    // FileNodes only have their content hash
     if ( nodeType == Node::FILE_NODE )
     {
+        FileNode * fn = n->CastTo< FileNode >();
+        VERIFY( stream.Read( fn->m_HashedFileTime ) );
+        VERIFY( stream.Read( fn->m_HashedFileSize ) );
+        VERIFY( stream.Read( fn->m_ContentHash ) );
         return n;
     }
 
@@ -357,6 +397,14 @@ void Node::SetLastBuildTime( uint32_t ms )
     VERIFY( stream.Read( lastTimeToBuild ) );
     n->SetLastBuildTime( lastTimeToBuild );
 
+    // Peak memory
+    uint32_t lastPeakMemoryMiB;
+    VERIFY( stream.Read( lastPeakMemoryMiB ) );
+    n->SetLastPeakMemoryMiB( lastPeakMemoryMiB );
+
+    // Output hash
+    VERIFY( stream.Read( n->m_OutputHash ) );
+
     // Deserialize properties
     Deserialize( stream, n, *n->GetReflectionInfoV() );
 
@@ -405,8 +453,13 @@ void Node::SetLastBuildTime( uint32_t ms )
     // - their stamp is obtained every build, so doesn't need saving
     // - they take sub 1ms to check, so don't need their build time saved
     // - they have no reflected properties
+    // Their content hash is saved so unchanged files needn't be hashed again
     if ( nodeType == Node::FILE_NODE )
     {
+        const FileNode * fn = node->CastTo< FileNode >();
+        stream.Write( fn->m_HashedFileTime );
+        stream.Write( fn->m_HashedFileSize );
+        stream.Write( fn->m_ContentHash );
         return;
     }
 
@@ -418,6 +471,13 @@ void Node::SetLastBuildTime( uint32_t ms )
     const uint32_t lastBuildTime = node->GetLastBuildTime();
     stream.Write( lastBuildTime );
 
+    // Peak memory
+    const uint32_t lastPeakMemoryMiB = node->GetLastPeakMemoryMiB();
+    stream.Write( lastPeakMemoryMiB );
+
+    // Output hash
+    stream.Write( node->m_OutputHash );
+
     // Properties
     const ReflectionInfo * const ri = node->GetReflectionInfoV();
     Serialize( stream, node, *ri );
@@ -451,8 +511,12 @@ void Node::SetLastBuildTime( uint32_t ms )
     }
 
     // read contents
-    ASSERT( (Node::Type)nodeType == Node::OBJECT_NODE );
-    return ObjectNode::LoadRemote( stream );
+    switch ( (Node::Type)nodeType )
+    {
+        case Node::OBJECT_NODE: return ObjectNode::LoadRemote( stream );
+        case Node::EXEC_NODE:   return ExecNode::LoadRemote( stream );
+        default:                ASSERT( false ); return nullptr; // Unexpected type
+    }
 }
 
 // SaveRemote
@@ -461,8 +525,8 @@ void Node::SetLastBuildTime( uint32_t ms )
 {
     ASSERT( node );
 
-    // only 1 type of node is ever serialized over the network
-    ASSERT( node->GetType() == Node::OBJECT_NODE );
+    // only these types of node are ever serialized over the network
+    ASSERT( ( node->GetType() == Node::OBJECT_NODE ) || ( node->GetType() == Node::EXEC_NODE ) );
 
     // save type
     const uint32_t nodeType = (uint32_t)node->GetType();
@@ -615,9 +679,11 @@ void Node::SetLastBuildTime( uint32_t ms )
 {
     // Transfer the stamp used to determine if the node has changed
     m_Stamp = oldNode.m_Stamp;
+    m_OutputHash = oldNode.m_OutputHash;
 
-    // Transfer previous build costs used for progress estimates
+    // Transfer previous build costs used for progress estimates and scheduling
     m_LastBuildTimeMs = oldNode.m_LastBuildTimeMs;
+    m_LastPeakMemoryMiB = oldNode.m_LastPeakMemoryMiB;
 }
 
 // Deserialize
@@ -1215,6 +1281,24 @@ void Node::RecordStampFromBuiltFile()
         return;
     }
 
+    // Dependents compare the contents, so an identical file doesn't cause them to rebuild
+    if ( FBuild::IsValid() && FBuild::Get().GetOptions().m_EarlyCutoff )
+    {
+        const uint64_t previousHash = m_OutputHash;
+        if ( HashFileContents( m_Name, m_OutputHash ) == false )
+        {
+            m_OutputHash = 0; // Fall back to the timestamp
+        }
+        else if ( m_OutputHash == previousHash )
+        {
+            FLOG_BUILD_REASON( "Output unchanged '%s' (dependents will not rebuild)\n", GetName().Get() );
+        }
+    }
+    else
+    {
+        m_OutputHash = 0;
+    }
+
     // On OS X, the 'ar' tool (for making libraries) appears to clamp the
     // modification time of libraries to whole seconds. On HFS/HFS+ file systems,
     // this doesn't matter because the resolution of the file system is 1 second.
@@ -1252,4 +1336,28 @@ void Node::RecordStampFromBuiltFile()
     #endif
 }
 
+// HashFileContents
+//------------------------------------------------------------------------------
+/*static*/ bool Node::HashFileContents( const AString & fileName, uint64_t & outHash )
+{
+    FileStream fs;
+    if ( fs.Open( fileName.Get(), FileStream::READ_ONLY ) == false )
+    {
+        return false;
+    }
+    const uint64_t fileSize = fs.GetFileSize();
+    UniquePtr< void, FreeDeletor > mem( ALLOC( fileSize ? fileSize : 1 ) );
+    if ( fs.ReadBuffer( mem.Get(), fileSize ) != fileSize )
+    {
+        return false;
+    }
+
+    outHash = xxHash3::Calc64( mem.Get(), fileSize );
+    if ( outHash == 0 )
+    {
+        outHash = 1; // 0 is reserved to indicate missing files
+    }
+    return true;
+}
+
 //------------------------------------------------------------------------------
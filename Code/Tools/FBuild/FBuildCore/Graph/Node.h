@@ -102,6 +102,7 @@ public:
         STATS_BUILT_REMOTE  = 0x40, // node was built remotely
         STATS_FAILED        = 0x80, // node needed building, but failed
         STATS_FIRST_BUILD   = 0x100,// node has never been built before
+        STATS_CACHE_CORRUPT = 0x200,// needed building, was cacheable, but cache entry was corrupt
     };
 
     enum class BuildResult
@@ -142,6 +143,7 @@ public:
     inline void SetStatFlag( StatsFlag flag ) const { m_StatsFlags |= flag; }
 
     uint32_t GetLastBuildTime() const;
+    uint32_t GetLastPeakMemoryMiB() const;
     inline uint32_t GetProcessingTime() const   { return m_ProcessingTime; }
     inline uint32_t GetCachingTime() const      { return m_CachingTime; }
     inline uint32_t GetRecursiveCost() const    { return m_RecursiveCost; }
@@ -163,6 +165,11 @@ public:
 
     inline uint64_t GetStamp() const { return m_Stamp; }
 
+    // Stamp recorded and compared by dependents. With -earlycutoff, this is a hash
+    // of a built file's contents, so re-building an identical file doesn't cause
+    // dependents to be rebuilt.
+    inline uint64_t GetDependencyStamp() const { return ( m_Stamp && m_OutputHash ) ? m_OutputHash : m_Stamp; }
+
     static void DumpOutput( Job * job,
                             const AString & output,
                             const Array< AString > * exclusions = nullptr );
@@ -219,6 +226,13 @@ protected:
     bool DetermineNeedToBuild( const Dependencies & deps ) const;
 
     void SetLastBuildTime( uint32_t ms );
+    void SetLastPeakMemoryMiB( uint32_t memoryMiB );
+
+    // File stamp obtained in advance by NodeGraph::PrefetchFileStamps
+    inline void SetPrefetchedFileTime( uint64_t fileTime )  { m_PrefetchedFileTime = fileTime; m_PrefetchedFileTimeTag = s_PrefetchedFileTimeTag; }
+    bool        ConsumePrefetchedFileTime( uint64_t & outFileTime ) const;
+    static void DiscardPrefetchedFileTimes()                { ++s_PrefetchedFileTimeTag; }
+
     inline void     AddProcessingTime( uint32_t ms )  { m_ProcessingTime += ms; }
     inline void     AddCachingTime( uint32_t ms )     { m_CachingTime += ms; }
 
@@ -248,6 +262,7 @@ protected:
                                               const char * & inoutCachedEnvString );
 
     void RecordStampFromBuiltFile();
+    static bool HashFileContents( const AString & fileName, uint64_t & outHash );
 
     // Members are ordered to minimize wasted bytes due to padding.
     // Most frequently accessed members are favored for placement in the first cache line.
@@ -265,6 +280,10 @@ protected:
     Node *              m_Next = nullptr;           // Node map in-place linked list pointer
     uint32_t            m_NameHash;                 // Hash of mName
     uint32_t            m_LastBuildTimeMs = 0;      // Time it took to do last known full build of this node
+    uint32_t            m_LastPeakMemoryMiB = 0;    // Peak memory of processes spawned by last known full build of this node
+    mutable uint32_t    m_PrefetchedFileTimeTag = 0; // m_PrefetchedFileTime is valid if this matches s_PrefetchedFileTimeTag
+    uint64_t            m_PrefetchedFileTime = 0;   // File timestamp obtained before the build started
+    uint64_t            m_OutputHash = 0;           // Hash of built file contents (with -earlycutoff)
     uint32_t            m_ProcessingTime = 0;       // Time spent on this node during this build
     uint32_t            m_CachingTime = 0;          // Time spent caching this node
     mutable uint32_t    m_ProgressAccumulator = 0;  // Used to estimate build progress percentage
@@ -275,6 +294,7 @@ protected:
 
     // Static Data
     static const char * const s_NodeTypeNames[];
+    static uint32_t s_PrefetchedFileTimeTag; // Incremented to invalidate all prefetched file times
 };
 
 //------------------------------------------------------------------------------
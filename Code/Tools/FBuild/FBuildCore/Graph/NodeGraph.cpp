@@ -10,6 +10,7 @@
 #include "Tools/FBuild/FBuildCore/FLog.h"
 #include "Tools/FBuild/FBuildCore/FBuild.h"
 #include "Tools/FBuild/FBuildCore/Graph/MetaData/Meta_IgnoreForComparison.h"
+#include "Tools/FBuild/FBuildCore/Helpers/FileTimeCache.h"
 #include "Tools/FBuild/FBuildCore/WorkerPool/JobQueue.h"
 
 #include "AliasNode.h"
@@ -45,9 +46,13 @@
 #include "Core/FileIO/FileStream.h"
 #include "Core/FileIO/MemoryStream.h"
 #include "Core/FileIO/PathUtils.h"
+#include "Core/Math/Conversions.h"
 #include "Core/Math/xxHash.h"
 #include "Core/Mem/Mem.h"
+#include "Core/Process/Atomic.h"
+#include "Core/Process/Semaphore.h"
 #include "Core/Process/Thread.h"
+#include "Core/Process/ThreadPool.h"
 #include "Core/Profile/Profile.h"
 #include "Core/Reflection/ReflectedProperty.h"
 #include "Core/Strings/AStackString.h"
@@ -1017,6 +1022,20 @@ void NodeGraph::BuildRecurse( Node * nodeToBuild, uint32_t cost )
     {
         case Node::NOT_PROCESSED:
         {
+            // Files stamped by PrefetchFileStamps don't need a job
+            if ( nodeToBuild->GetType() == Node::FILE_NODE )
+            {
+                uint64_t fileTime;
+                if ( nodeToBuild->ConsumePrefetchedFileTime( fileTime ) )
+                {
+                    nodeToBuild->m_Stamp = fileTime;
+                    nodeToBuild->SetStatFlag( Node::STATS_PROCESSED );
+                    nodeToBuild->SetStatFlag( Node::STATS_BUILT );
+                    nodeToBuild->SetState( Node::UP_TO_DATE );
+                    return;
+                }
+            }
+
             // check pre-build dependencies
             const bool allDependenciesUpToDate = CheckDependencies( nodeToBuild, nodeToBuild->GetPreBuildDependencies(), cost );
             if ( allDependenciesUpToDate == false )
@@ -1081,7 +1100,12 @@ void NodeGraph::BuildRecurse( Node * nodeToBuild, uint32_t cost )
             if ( ( nodeToBuild->GetStamp() == 0 ) || // Avoid redundant work in DetermineNeedToBuild
                  nodeToBuild->DetermineNeedToBuildDynamic() )
             {
-                nodeToBuild->m_RecursiveCost = cost;
+                // Cost from the critical path pass accounts for all dependents, but nodes
+                // created during this build were not seen by it, so keep whichever is larger
+                if ( cost > nodeToBuild->m_RecursiveCost )
+                {
+                    nodeToBuild->m_RecursiveCost = cost;
+                }
                 JobQueue::Get().AddJobToBatch( nodeToBuild );
             }
             else
@@ -1198,6 +1222,37 @@ void NodeGraph::SetBuildPassTagForAllNodes( uint32_t value ) const
     }
 }
 
+// ResetNodeStates
+//------------------------------------------------------------------------------
+void NodeGraph::ResetNodeStates()
+{
+    for ( Node * node : m_AllNodes )
+    {
+        node->m_State = Node::NOT_PROCESSED;
+        node->m_StatsFlags = 0;
+        node->m_ProcessingTime = 0;
+        node->m_CachingTime = 0;
+        node->m_ProgressAccumulator = 0;
+    }
+}
+
+// HaveUsedFilesChanged
+//------------------------------------------------------------------------------
+bool NodeGraph::HaveUsedFilesChanged() const
+{
+    // A changed timestamp is enough to require the BFF to be re-evaluated
+    // (Load will avoid re-parsing if the contents are unchanged)
+    for ( const UsedFile & usedFile : m_UsedFiles )
+    {
+        if ( FileIO::GetFileLastWriteTime( usedFile.m_FileName ) != usedFile.m_TimeStamp )
+        {
+            FLOG_VERBOSE( "BFF file '%s' has changed", usedFile.m_FileName.Get() );
+            return true;
+        }
+    }
+    return false;
+}
+
 // FindNodeSourceToken
 //------------------------------------------------------------------------------
 const BFFToken * NodeGraph::FindNodeSourceToken( const Node * node ) const
@@ -1560,6 +1615,233 @@ void NodeGraph::FindNearestNodesInternal( const AString & fullPath, Array< NodeW
     }
 }
 
+// ComputeCriticalPathCosts
+//------------------------------------------------------------------------------
+/*static*/ void NodeGraph::ComputeCriticalPathCosts( Node * nodeToBuild )
+{
+    PROFILE_FUNCTION;
+
+    // Order nodes so that every node appears after all of its dependencies
+    Array< Node * > nodes( 1024 );
+    GatherNodesInDependencyOrder( nodeToBuild, nodes );
+
+    // Discard costs from any previous build
+    for ( Node * node : nodes )
+    {
+        node->m_RecursiveCost = 0;
+    }
+
+    // Walk from the root towards the leaves. By the time a node is visited, all
+    // of its dependents have been, so it holds the longest chain of dependent work
+    // which must follow it. Adding its own build time gives the length of the
+    // critical path through the node, which is used to prioritize its job.
+    for ( size_t i = nodes.GetSize(); i > 0; --i )
+    {
+        Node * node = nodes[ i - 1 ];
+        const uint32_t cost = ( node->m_RecursiveCost + node->GetLastBuildTime() );
+        node->m_RecursiveCost = cost;
+
+        const Dependencies * depsList[] = { &node->m_PreBuildDependencies,
+                                            &node->m_StaticDependencies,
+                                            &node->m_DynamicDependencies };
+        for ( const Dependencies * deps : depsList )
+        {
+            for ( const Dependency & dep : *deps )
+            {
+                Node * depNode = dep.GetNode();
+                if ( cost > depNode->m_RecursiveCost )
+                {
+                    depNode->m_RecursiveCost = cost;
+                }
+            }
+        }
+    }
+}
+
+// FileStampPrefetcher
+//  - Shared state for threads obtaining file timestamps
+//------------------------------------------------------------------------------
+class FileStampPrefetcher
+{
+public:
+    explicit FileStampPrefetcher( const Array< Node * > & nodes, bool useContentHash )
+        : m_Nodes( nodes )
+        , m_UseContentHash( useContentHash )
+    {
+        m_FileTimes.SetSize( nodes.GetSize() );
+    }
+
+    static void ThreadFunc( void * userData )
+    {
+        FileStampPrefetcher * self = static_cast< FileStampPrefetcher * >( userData );
+        self->Process();
+        self->m_ThreadsCompleted.Signal();
+    }
+
+    void Process()
+    {
+        // Each thread takes the next node until none remain
+        const uint32_t numNodes = static_cast< uint32_t >( m_Nodes.GetSize() );
+        for ( ;; )
+        {
+            const uint32_t index = ( AtomicInc( &m_NextIndex ) - 1 );
+            if ( index >= numNodes )
+            {
+                return;
+            }
+            Node * node = m_Nodes[ index ];
+            if ( node->GetType() == Node::FILE_NODE )
+            {
+                // Input files may be stamped by content
+                m_FileTimes[ index ] = node->CastTo< FileNode >()->ObtainStamp( m_UseContentHash );
+            }
+            else
+            {
+                m_FileTimes[ index ] = FileIO::GetFileLastWriteTime( node->GetName() );
+            }
+        }
+    }
+
+    const Array< Node * > & m_Nodes;
+    const bool              m_UseContentHash;
+    Array< uint64_t >       m_FileTimes;
+    uint32_t                m_NextIndex = 0;
+    Semaphore               m_ThreadsCompleted;
+};
+
+// PrefetchFileStamps
+//------------------------------------------------------------------------------
+/*static*/ void NodeGraph::PrefetchFileStamps( Node * nodeToBuild, ThreadPool & threadPool, bool forceCleanBuild, bool useContentHash, FileTimeCache * fileTimeCache )
+{
+    PROFILE_FUNCTION;
+
+    Array< Node * > nodes( 1024 );
+    GatherNodesInDependencyOrder( nodeToBuild, nodes );
+
+    // The build checks the timestamp of every input file, and the outputs of
+    // previously built nodes (to detect external modification). Checking them
+    // one at a time as the build progresses is very slow on network file
+    // systems, so obtain them all up-front. The results are only used until
+    // the first job completes (see JobQueue::FinalizeCompletedJobs), which covers
+    // everything reached by the initial sweep of the graph.
+    Array< Node * > files( nodes.GetSize() );
+    for ( Node * node : nodes )
+    {
+        if ( node->GetType() == Node::FILE_NODE )
+        {
+            files.Append( node );
+        }
+        else if ( ( forceCleanBuild == false ) &&
+                  ( node->GetType() != Node::PROXY_NODE ) &&
+                  node->IsAFile() &&
+                  ( node->GetStamp() != 0 ) &&
+                  ( ( node->m_ControlFlags & Node::FLAG_ALWAYS_BUILD ) == 0 ) )
+        {
+            files.Append( node );
+        }
+    }
+    ++Node::s_PrefetchedFileTimeTag; // Invalidate results from previous builds
+
+    // Files known to be unchanged since a previous build don't need checking
+    if ( fileTimeCache )
+    {
+        fileTimeCache->Update();
+
+        size_t numUncached = 0;
+        for ( Node * file : files )
+        {
+            uint64_t fileTime;
+            if ( fileTimeCache->GetFileTime( file->GetName(), fileTime ) )
+            {
+                file->SetPrefetchedFileTime( fileTime );
+                continue;
+            }
+
+            // Watch before checking so no change can be missed
+            fileTimeCache->WatchDirectoryOf( file->GetName() );
+            files[ numUncached++ ] = file;
+        }
+        files.SetSize( numUncached );
+    }
+    if ( files.IsEmpty() )
+    {
+        return;
+    }
+
+    // Use the thread pool (if there are enough files to be worthwhile), with
+    // the main thread helping out. Hashing is much more expensive than a stat.
+    const uint32_t kMinFilesPerThread = useContentHash ? 4 : 64;
+    const uint32_t numThreads = Math::Min( threadPool.GetNumThreads(),
+                                           static_cast< uint32_t >( files.GetSize() / kMinFilesPerThread ) );
+    FileStampPrefetcher prefetcher( files, useContentHash );
+    for ( uint32_t i = 0; i < numThreads; ++i )
+    {
+        threadPool.EnqueueJob( FileStampPrefetcher::ThreadFunc, &prefetcher );
+    }
+    prefetcher.Process();
+    for ( uint32_t i = 0; i < numThreads; ++i )
+    {
+        prefetcher.m_ThreadsCompleted.Wait();
+    }
+
+    // Make results available to the build
+    for ( size_t i = 0; i < files.GetSize(); ++i )
+    {
+        files[ i ]->SetPrefetchedFileTime( prefetcher.m_FileTimes[ i ] );
+        if ( fileTimeCache )
+        {
+            fileTimeCache->StoreFileTime( files[ i ]->GetName(), prefetcher.m_FileTimes[ i ] );
+        }
+    }
+}
+
+// GatherNodesInDependencyOrder
+//------------------------------------------------------------------------------
+/*static*/ void NodeGraph::GatherNodesInDependencyOrder( Node * nodeToBuild, Array< Node * > & outNodes )
+{
+    s_BuildPassTag++;
+
+    // A proxy for multiple targets is not part of the graph, so must not be
+    // tagged (it is not reset by SetBuildPassTagForAllNodes)
+    if ( nodeToBuild->GetType() == Node::PROXY_NODE )
+    {
+        GatherNodesInDependencyOrderRecurse( nodeToBuild->GetStaticDependencies(), outNodes );
+        outNodes.Append( nodeToBuild );
+        return;
+    }
+
+    GatherNodesInDependencyOrderRecurse( nodeToBuild, outNodes );
+}
+
+// GatherNodesInDependencyOrderRecurse
+//------------------------------------------------------------------------------
+/*static*/ void NodeGraph::GatherNodesInDependencyOrderRecurse( Node * node, Array< Node * > & outNodes )
+{
+    // don't recurse the same node multiple times in the same pass
+    const uint32_t buildPassTag = s_BuildPassTag;
+    if ( node->GetBuildPassTag() == buildPassTag )
+    {
+        return;
+    }
+    node->SetBuildPassTag( buildPassTag );
+
+    GatherNodesInDependencyOrderRecurse( node->GetPreBuildDependencies(), outNodes );
+    GatherNodesInDependencyOrderRecurse( node->GetStaticDependencies(), outNodes );
+    GatherNodesInDependencyOrderRecurse( node->GetDynamicDependencies(), outNodes );
+
+    outNodes.Append( node );
+}
+
+// GatherNodesInDependencyOrderRecurse
+//------------------------------------------------------------------------------
+/*static*/ void NodeGraph::GatherNodesInDependencyOrderRecurse( const Dependencies & dependencies, Array< Node * > & outNodes )
+{
+    for ( const Dependency & dep : dependencies )
+    {
+        GatherNodesInDependencyOrderRecurse( dep.GetNode(), outNodes );
+    }
+}
+
 // CheckForCyclicDependencies
 //------------------------------------------------------------------------------
 /*static*/ bool NodeGraph::CheckForCyclicDependencies( const Node * node )
@@ -1827,9 +2109,20 @@ void NodeGraph::MigrateNode( const NodeGraph & oldNodeGraph, Node & newNode, con
     }
     newNode.SetBuildPassTag( s_BuildPassTag );
 
-    // FileNodes (inputs to the build) build every time so don't need migration
+    // FileNodes (inputs to the build) build every time so only need their
+    // content hash (if any) migrating
     if ( newNode.GetType() == Node::FILE_NODE )
     {
+        const Node * oldNode = oldNodeHint ? oldNodeHint
+                                           : oldNodeGraph.FindNodeInternal( newNode.GetName(), newNode.GetNameHash() );
+        if ( oldNode && ( oldNode->GetType() == Node::FILE_NODE ) )
+        {
+            FileNode * newFileNode = newNode.CastTo< FileNode >();
+            const FileNode * oldFileNode = oldNode->CastTo< FileNode >();
+            newFileNode->m_HashedFileTime = oldFileNode->m_HashedFileTime;
+            newFileNode->m_HashedFileSize = oldFileNode->m_HashedFileSize;
+            newFileNode->m_ContentHash = oldFileNode->m_ContentHash;
+        }
         return;
     }
 
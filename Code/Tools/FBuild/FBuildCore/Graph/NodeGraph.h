@@ -28,6 +28,7 @@ class DLLNode;
 class ExeNode;
 class ExecNode;
 class FileNode;
+class FileTimeCache;
 class IOStream;
 class LibraryNode;
 class LinkerNode;
@@ -41,6 +42,7 @@ class ReflectedProperty;
 class RemoveDirNode;
 class SettingsNode;
 class SLNNode;
+class ThreadPool;
 class TestNode;
 class TextFileNode;
 class UnityNode;
@@ -64,7 +66,7 @@ public:
     }
     inline ~NodeGraphHeader() = default;
 
-    enum : uint8_t { NODE_GRAPH_CURRENT_VERSION = 176 };
+    enum : uint8_t { NODE_GRAPH_CURRENT_VERSION = 189 };
 
     bool IsValid() const;
     bool IsCompatibleVersion() const { return m_Version == NODE_GRAPH_CURRENT_VERSION; }
@@ -133,6 +135,10 @@ public:
     // Non-build operations that use the BuildPassTag can set it to a known value
     void SetBuildPassTagForAllNodes( uint32_t value ) const;
 
+    // Allow the graph to be built again (see BuildDaemon)
+    void ResetNodeStates();
+    bool HaveUsedFilesChanged() const;
+
     const BFFToken * FindNodeSourceToken( const Node * node ) const;
 
     static void CleanPath( AString & name, bool makeFullPath = true );
@@ -144,6 +150,17 @@ public:
     static void UpdateBuildStatus( const Node * node,
                                    uint32_t & nodesBuiltTime,
                                    uint32_t & totalNodeTime );
+
+    // Prioritize jobs using the critical path through the graph (from last known build times)
+    static void ComputeCriticalPathCosts( Node * nodeToBuild );
+
+    // Obtain the timestamps (or content hashes for input files if useContentHash
+    // is set) of files which will be checked during the build in parallel
+    static void PrefetchFileStamps( Node * nodeToBuild,
+                                    ThreadPool & threadPool,
+                                    bool forceCleanBuild,
+                                    bool useContentHash,
+                                    FileTimeCache * fileTimeCache = nullptr );
 private:
     friend class FBuild;
 
@@ -160,6 +177,10 @@ private:
                                           uint32_t & nodesBuiltTime,
                                           uint32_t & totalNodeTime );
 
+    static void GatherNodesInDependencyOrder( Node * nodeToBuild, Array< Node * > & outNodes );
+    static void GatherNodesInDependencyOrderRecurse( Node * node, Array< Node * > & outNodes );
+    static void GatherNodesInDependencyOrderRecurse( const Dependencies & dependencies, Array< Node * > & outNodes );
+
     static bool CheckForCyclicDependencies( const Node * node );
     static bool CheckForCyclicDependenciesRecurse( const Node * node, Array< const Node * > & dependencyStack );
     static bool CheckForCyclicDependenciesRecurse( const Dependencies & dependencies,
@@ -563,6 +563,8 @@ ObjectListNode::~ObjectListNode() = default;
 //------------------------------------------------------------------------------
 /*virtual*/ Node::BuildResult ObjectListNode::DoBuild( Job * /*job*/ )
 {
+    RecordUnityCompileTimes();
+
     // Generate stamp
     if ( m_DynamicDependencies.IsEmpty() )
     {
@@ -575,7 +577,7 @@ ObjectListNode::~ObjectListNode() = default;
         {
             const ObjectNode * on = dep.GetNode()->CastTo< ObjectNode >();
             ASSERT( on->GetStamp() );
-            stamps.Append( on->GetStamp() );
+            stamps.Append( on->GetDependencyStamp() );
         }
         m_Stamp = xxHash3::Calc64( &stamps[0], ( stamps.GetSize() * sizeof(uint64_t) ) );
     }
@@ -583,6 +585,25 @@ ObjectListNode::~ObjectListNode() = default;
     return BuildResult::eOk;
 }
 
+// RecordUnityCompileTimes
+//------------------------------------------------------------------------------
+void ObjectListNode::RecordUnityCompileTimes()
+{
+    // Unity nodes balancing by cost learn from the compile times of their objects
+    for ( size_t i = m_ObjectListInputStartIndex; i < m_ObjectListInputEndIndex; ++i )
+    {
+        Node * node = m_StaticDependencies[ i ].GetNode();
+        if ( node->GetType() == Node::UNITY_NODE )
+        {
+            UnityNode * un = node->CastTo< UnityNode >();
+            if ( un->IsBalancingByCost() )
+            {
+                un->RecordCompileTimes( m_DynamicDependencies );
+            }
+        }
+    }
+}
+
 // GetInputFiles
 //------------------------------------------------------------------------------
 void ObjectListNode::GetInputFiles( bool objectsInsteadOfLibs, Array<AString> & outInputs ) const
@@ -59,6 +59,7 @@ protected:
                                   const AString & baseDir,
                                   bool isUnityNode = false,
                                   bool isIsolatedFromUnityNode = false );
+    void RecordUnityCompileTimes();
     ObjectNode * CreateObjectNode( NodeGraph & nodeGraph,
                                    const BFFToken * iter,
                                    const Function * function,
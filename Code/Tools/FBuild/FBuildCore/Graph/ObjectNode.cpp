@@ -6,6 +6,9 @@
 #include "ObjectNode.h"
 
 #include "Tools/FBuild/FBuildCore/BFF/Functions/FunctionObjectList.h"
+#include "Tools/FBuild/FBuildCore/Cache/CacheEntry.h"
+#include "Tools/FBuild/FBuildCore/Cache/CacheKeyComponents.h"
+#include "Tools/FBuild/FBuildCore/Cache/CachePathNormalizer.h"
 #include "Tools/FBuild/FBuildCore/Cache/ICache.h"
 #include "Tools/FBuild/FBuildCore/ExeDrivers/Compiler/CompilerDriverBase.h"
 #include "Tools/FBuild/FBuildCore/ExeDrivers/Compiler/CompilerDriver_CL.h"
@@ -29,6 +32,7 @@
 #include "Tools/FBuild/FBuildCore/Helpers/BuildProfiler.h"
 #include "Tools/FBuild/FBuildCore/Helpers/CIncludeParser.h"
 #include "Tools/FBuild/FBuildCore/Helpers/Compressor.h"
+#include "Tools/FBuild/FBuildCore/Helpers/Metrics.h"
 #include "Tools/FBuild/FBuildCore/Helpers/MultiBuffer.h"
 #include "Tools/FBuild/FBuildCore/Helpers/ResponseFile.h"
 #include "Tools/FBuild/FBuildCore/Helpers/ToolManifest.h"
@@ -518,10 +522,12 @@ Node::BuildResult ObjectNode::DoBuildWithPreProcessor( Job * job, bool useDeopti
     if ( canDistribute && belowMemoryLimit )
     {
         // compress job data
+        job->RecordPhaseTime( Job::PHASE_COMPRESS_BEGIN );
         Compressor c;
         c.Compress( job->GetData(), job->GetDataSize(), FBuild::Get().GetOptions().m_DistributionCompressionLevel );
         const size_t compressedSize = c.GetResultSize();
         job->OwnData( c.ReleaseResult(), compressedSize, true );
+        job->RecordPhaseTime( Job::PHASE_COMPRESS_END );
 
         // yes... re-queue for secondary build
         return BuildResult::eNeedSecondPass;
@@ -1130,10 +1136,12 @@ bool ObjectNode::ProcessIncludesWithPreProcessor( Job * job )
         // * Creation of the PCH must be done locally to generate a usable PCH
         // * Objective C/C++ cannot be distributed
         // * Source mappings are not currently forwarded so can only compiled locally
+        // * Cache path normalization remaps paths under the local working dir, so can only compile locally
         // * Remote compilation with Gcov coverage is disabled as it has some issues:
         //   1. .gcno files will contain incorrect build root path (working directory on the worker).
         //   2. Object files compiled remotely will create .gcda files in the directory where these object files were stored on the worker.
-        if ( !creatingPCH && !objectiveC && !hasSourceMapping && !flags.IsUsingGcovCoverage() )
+        const bool normalizesCachePaths = compilerNode->GetNormalizeCachePaths();
+        if ( !creatingPCH && !objectiveC && !hasSourceMapping && !normalizesCachePaths && !flags.IsUsingGcovCoverage() )
         {
             if ( isDistributableCompiler )
             {
@@ -1355,30 +1363,16 @@ const AString & ObjectNode::GetCacheName( Job * job ) const
 
     // hash the pre-processed input data
     ASSERT( m_LightCacheKey || job->GetData() );
-    const uint64_t preprocessedSourceKey = m_LightCacheKey ? m_LightCacheKey : xxHash3::Calc64( job->GetData(), job->GetDataSize() );
+    const uint64_t preprocessedSourceKey = m_LightCacheKey ? m_LightCacheKey : GetPreprocessedSourceKey( job, job->GetData(), job->GetDataSize() );
     ASSERT( preprocessedSourceKey );
 
     // hash the build "environment"
     // TODO:B Exclude preprocessor control defines (the preprocessed input has considered those already)
     uint32_t commandLineKey;
     {
-        Args args;
-        const bool useDeoptimization = false;
-        const bool showIncludes = false;
-        const bool useSourceMapping = false; // Source mapping compiler flags contain local paths, so we treat them specially
-        const bool finalize = false; // Don't write args to response file
-        BuildArgs( job, args, PASS_COMPILE_PREPROCESSED, useDeoptimization, showIncludes, useSourceMapping, finalize );
-
-        if ( job->IsLocal() )
-        {
-            // Append the source mapping destination only, so different machines with different
-            // working directory local paths compute consistent keys.
-            const AString& sourceMapping = job->GetNode()->CastTo<ObjectNode>()->GetCompiler()->GetSourceMapping();
-            args.AddDelimiter();
-            args += sourceMapping;
-        }
-
-        commandLineKey = xxHash::Calc32( args.GetRawArgs().Get(), args.GetRawArgs().GetLength() );
+        AStackString< 8192 > args;
+        GetCacheKeyArgs( job, args );
+        commandLineKey = xxHash::Calc32( args.Get(), args.GetLength() );
     }
     ASSERT( commandLineKey );
 
@@ -1401,6 +1395,104 @@ const AString & ObjectNode::GetCacheName( Job * job ) const
     return job->GetCacheName();
 }
 
+// GetCacheKeyArgs
+//------------------------------------------------------------------------------
+void ObjectNode::GetCacheKeyArgs( Job * job, AString & outArgs ) const
+{
+    Args args;
+    const bool useDeoptimization = false;
+    const bool showIncludes = false;
+    const bool useSourceMapping = false; // Source mapping compiler flags contain local paths, so we treat them specially
+    const bool finalize = false; // Don't write args to response file
+    BuildArgs( job, args, PASS_COMPILE_PREPROCESSED, useDeoptimization, showIncludes, useSourceMapping, finalize );
+
+    if ( job->IsLocal() )
+    {
+        // Append the source mapping destination only, so different machines with different
+        // working directory local paths compute consistent keys.
+        const AString& sourceMapping = job->GetNode()->CastTo<ObjectNode>()->GetCompiler()->GetSourceMapping();
+        args.AddDelimiter();
+        args += sourceMapping;
+    }
+
+    outArgs = args.GetRawArgs();
+
+    // Remove the workspace root so different workspaces compute consistent keys
+    if ( job->IsLocal() && GetCompiler()->GetNormalizeCachePaths() )
+    {
+        const CachePathNormalizer normalizer( FBuild::Get().GetWorkingDir() );
+        normalizer.NormalizeArgs( outArgs );
+    }
+}
+
+// GetPreprocessedSourceKey
+//------------------------------------------------------------------------------
+uint64_t ObjectNode::GetPreprocessedSourceKey( const Job * job, const void * data, size_t dataSize ) const
+{
+    // Ignore the workspace root in line markers so different workspaces compute consistent keys
+    if ( job->IsLocal() && GetCompiler()->GetNormalizeCachePaths() )
+    {
+        const CachePathNormalizer normalizer( FBuild::Get().GetWorkingDir() );
+        return normalizer.HashPreprocessedOutput( data, dataSize );
+    }
+    return xxHash3::Calc64( data, dataSize );
+}
+
+// GetCacheKeyComponents
+//------------------------------------------------------------------------------
+void ObjectNode::GetCacheKeyComponents( Job * job, CacheKeyComponents & outComponents ) const
+{
+    PROFILE_FUNCTION;
+
+    const AString & workingDir = FBuild::Get().GetWorkingDir();
+    PathUtils::GetRelativePath( workingDir, m_Name, outComponents.m_Object );
+    outComponents.m_CacheId = GetCacheName( job );
+    outComponents.m_WorkingDir = workingDir;
+
+    // Pre-processed source (which may have been compressed for distribution)
+    if ( m_LightCacheKey )
+    {
+        outComponents.SetSourceFromLightCache( m_LightCacheKey, m_Includes );
+    }
+    else if ( job->GetData() )
+    {
+        if ( job->IsDataCompressed() )
+        {
+            Compressor c;
+            if ( c.Decompress( job->GetData() ) )
+            {
+                const uint64_t sourceKey = GetPreprocessedSourceKey( job, c.GetResult(), c.GetResultSize() );
+                outComponents.SetSourceFromPreprocessedOutput( sourceKey, c.GetResult(), c.GetResultSize() );
+            }
+        }
+        else
+        {
+            const uint64_t sourceKey = GetPreprocessedSourceKey( job, job->GetData(), job->GetDataSize() );
+            outComponents.SetSourceFromPreprocessedOutput( sourceKey, job->GetData(), job->GetDataSize() );
+        }
+    }
+
+    // Args, exactly as hashed
+    GetCacheKeyArgs( job, outComponents.m_Args );
+
+    // ToolChain
+    const ToolManifest & manifest = GetCompiler()->CastTo< CompilerNode >()->GetManifest();
+    outComponents.m_ToolChainKey = manifest.GetToolId();
+    for ( const ToolManifestFile & file : manifest.GetFiles() )
+    {
+        AStackString<> toolFile;
+        toolFile.Format( "%08X %s", file.GetHash(), file.GetName().Get() );
+        outComponents.m_ToolFiles.Append( toolFile );
+    }
+    outComponents.m_ToolFiles.Sort();
+
+    // PCH dependency
+    if ( IsUsingPCH() && IsMSVC() )
+    {
+        outComponents.m_PCHKey = GetPrecompiledHeader()->m_PCHCacheKey;
+    }
+}
+
 // RetrieveFromCache
 //------------------------------------------------------------------------------
 bool ObjectNode::RetrieveFromCache( Job * job )
@@ -1425,16 +1517,33 @@ bool ObjectNode::RetrieveFromCache( Job * job )
     {
         const uint32_t retrieveTime = uint32_t( t.GetElapsedMS() );
 
-        // Hash the PCH result if we will need it later
+        // Check entry is intact
+        AStackString<> problem;
+        if ( CacheEntry::Verify( cacheData, cacheDataSize, problem ) == false )
+        {
+            FLOG_WARN( "Cache returned corrupt data (quarantined)\n"
+                       " - File   : '%s'\n"
+                       " - Key    : %s\n"
+                       " - Problem: %s\n",
+                       m_Name.Get(), cacheFileName.Get(), problem.Get() );
+            cache->FreeMemory( cacheData, cacheDataSize );
+            cache->Quarantine( cacheFileName );
+            Metrics::s_CacheCorrupt.Add();
+            SetStatFlag( Node::STATS_CACHE_CORRUPT );
+            SetStatFlag( Node::STATS_CACHE_MISS );
+            return false;
+        }
+
+        // The PCH result will be needed later
         uint64_t pchKey = 0;
         if ( IsCreatingPCH() && IsMSVC() )
         {
-            pchKey = xxHash3::Calc64( cacheData, cacheDataSize );
+            pchKey = CacheEntry::GetPayloadHash( cacheData );
         }
 
         const uint32_t startDecompress = uint32_t( t.GetElapsedMS() );
 
-        MultiBuffer buffer( cacheData, cacheDataSize );
+        MultiBuffer buffer( CacheEntry::GetPayload( cacheData ), CacheEntry::GetPayloadSize( cacheData ) );
 
         // do decompression
         if ( buffer.Decompress() == false )
@@ -1444,6 +1553,7 @@ bool ObjectNode::RetrieveFromCache( Job * job )
                        " - Key : %s\n",
                        m_Name.Get(), cacheFileName.Get() );
             cache->FreeMemory( cacheData, cacheDataSize );
+            SetStatFlag( Node::STATS_CACHE_MISS );
             return false;
         }
         const size_t uncompressedDataSize = buffer.GetDataSize();
@@ -1519,6 +1629,28 @@ bool ObjectNode::RetrieveFromCache( Job * job )
                      GetName().Get(), uint32_t( t.GetElapsedMS() ), cacheFileName.Get() );
     }
 
+    // Explain the miss by comparing with the key last stored for this object
+    if ( FBuild::Get().GetOptions().m_CacheExplain )
+    {
+        CacheKeyComponents components;
+        GetCacheKeyComponents( job, components );
+
+        AStackString< 4096 > output;
+        output.Format( "Obj: %s\n"
+                       " - Cache Miss Explained: '%s'\n",
+                       GetName().Get(), cacheFileName.Get() );
+        CacheKeyComponents previous;
+        if ( previous.Retrieve( *cache, components.m_Object ) )
+        {
+            components.Explain( previous, output );
+        }
+        else
+        {
+            output += "   No key components recorded for this object (use -cachekeys when storing)\n";
+        }
+        FLOG_OUTPUT( output );
+    }
+
     SetStatFlag( Node::STATS_CACHE_MISS );
     return false;
 }
@@ -1613,7 +1745,9 @@ void ObjectNode::WriteToCache_FromCompressedData( Job * job,
     // Commit to cache
     const Timer t;
     const uint32_t startPublish( (uint32_t)t.GetElapsedMS() );
-    if ( FBuild::Get().GetCache()->Publish( cacheFileName, compressedData, compressedDataSize ) )
+    CacheEntry entry;
+    entry.Create( compressedData, compressedDataSize );
+    if ( FBuild::Get().GetCache()->Publish( cacheFileName, entry.GetData(), entry.GetDataSize() ) )
     {
         // cache store complete
         const uint32_t publishTime = ( (uint32_t)t.GetElapsedMS() - startPublish );
@@ -1623,7 +1757,15 @@ void ObjectNode::WriteToCache_FromCompressedData( Job * job,
         // Dependent objects need to know the PCH key to be able to pull from the cache
         if ( IsCreatingPCH() && IsMSVC() )
         {
-            m_PCHCacheKey = xxHash3::Calc64( compressedData, compressedDataSize );
+            m_PCHCacheKey = CacheEntry::GetPayloadHash( entry.GetData() );
+        }
+
+        // Record the key components, so future misses can be explained
+        if ( FBuild::Get().GetOptions().m_CacheKeys )
+        {
+            CacheKeyComponents components;
+            GetCacheKeyComponents( job, components );
+            components.Publish( *FBuild::Get().GetCache() );
         }
 
         const uint32_t cachingTime = uint32_t( t.GetElapsedMS() );
@@ -1788,6 +1930,17 @@ bool ObjectNode::BuildArgs( const Job * job, Args & fullArgs, Pass pass, bool us
         PathUtils::EnsureTrailingSlash( basePath );
     }
 
+    // Get root for cache path normalization if needed
+    AStackString<> normalizedPathRoot;
+    if ( job->IsLocal() && GetCompiler()->GetNormalizeCachePaths() )
+    {
+        normalizedPathRoot = FBuild::Get().GetOptions().GetWorkingDir(); // NOTE: FBuild only valid locally
+        if ( normalizedPathRoot.EndsWith( NATIVE_SLASH ) )
+        {
+            normalizedPathRoot.Trim( 0, 1 ); // So the root itself is remapped too
+        }
+    }
+
     const CompilerFlags & flags = useDedicatedPreprocessor ? m_PreprocessorFlags : m_CompilerFlags;
 
     const bool forceColoredDiagnostics = ( flags.IsDiagnosticsColorAuto() && ( Env::IsStdOutRedirected() == false ) );
@@ -1799,6 +1952,7 @@ bool ObjectNode::BuildArgs( const Job * job, Args & fullArgs, Pass pass, bool us
     driver->SetRelativeBasePath( basePath );
     driver->SetForceColoredDiagnostics( forceColoredDiagnostics );
     driver->SetUseSourceMapping( ( useSourceMapping && job->IsLocal() ) ? GetCompiler()->GetSourceMapping() : AString::GetEmpty() );
+    driver->SetNormalizedPathRoot( normalizedPathRoot );
 
     // Adjust args for as needed for the given compiler
     const size_t numTokens = tokens.GetSize();
@@ -2196,6 +2350,7 @@ bool ObjectNode::WriteTmpFile( Job * job, AString & tmpDirectory, AString & tmpF
     Compressor c; // scoped here so we can access decompression buffer
     if ( job->IsDataCompressed() )
     {
+        job->RecordPhaseTime( Job::PHASE_WORKER_DECOMPRESS_BEGIN );
         if( c.Decompress( dataToWrite ) == false )
         {
             // Decompression failure would indicate a bug
@@ -2205,6 +2360,7 @@ bool ObjectNode::WriteTmpFile( Job * job, AString & tmpDirectory, AString & tmpF
         }
         dataToWrite = c.GetResult();
         dataToWriteSize = c.GetResultSize();
+        job->RecordPhaseTime( Job::PHASE_WORKER_DECOMPRESS_END );
     }
 
     WorkerThread::GetTempFileDirectory( tmpDirectory );
@@ -2401,6 +2557,7 @@ Node::BuildResult ObjectNode::CompileHelper::SpawnCompiler( Job * job,
 
     // Get result
     m_Result = m_Process.WaitForExit();
+    job->OnProcessExited( m_Process );
     if ( m_Process.HasAborted() )
     {
         return BuildResult::eAborted;
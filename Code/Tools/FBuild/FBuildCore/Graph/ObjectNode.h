@@ -16,6 +16,7 @@
 // Forward Declarations
 //------------------------------------------------------------------------------
 class Args;
+class CacheKeyComponents;
 class CompilerDriverBase;
 class ConstMemoryStream;
 class Function;
@@ -113,6 +114,7 @@ public:
         uint32_t m_Flags = 0;
     };
     const CompilerFlags& GetCompilerFlags() const { return m_CompilerFlags; }
+    const AString & GetCompilerOptions() const { return m_CompilerOptions; }
 
     static CompilerFlags DetermineFlags( const CompilerNode * compilerNode,
                                          const AString & args,
@@ -201,6 +203,9 @@ private:
     bool ProcessIncludesWithPreProcessor( Job * job );
 
     const AString & GetCacheName( Job * job ) const;
+    void GetCacheKeyArgs( Job * job, AString & outArgs ) const;
+    uint64_t GetPreprocessedSourceKey( const Job * job, const void * data, size_t dataSize ) const;
+    void GetCacheKeyComponents( Job * job, CacheKeyComponents & outComponents ) const;
     bool RetrieveFromCache( Job * job );
     void WriteToCache_FromDisk( Job * job );
     void WriteToCache_FromUncompressedData( Job * job,
@@ -22,6 +22,9 @@
 #define DIST_MEMORY_LIMIT_MIN ( 16 ) // 16MiB
 #define DIST_MEMORY_LIMIT_MAX ( ( sizeof(void *) == 8 ) ? 64 * 1024 : 2048 ) // 64 GiB or 2 GiB
 #define DIST_MEMORY_LIMIT_DEFAULT ( ( sizeof(void *) == 8 ) ? 2048 : 1024 ) // 2 GiB or 1 GiB
+#define CACHE_LOCAL_SIZE_MIN ( 64 ) // 64 MiB
+#define CACHE_LOCAL_SIZE_MAX ( 16 * 1024 * 1024 ) // 16 TiB
+#define CACHE_LOCAL_SIZE_DEFAULT ( 10 * 1024 ) // 10 GiB
 
 // REFLECTION
 //------------------------------------------------------------------------------
@@ -31,6 +34,8 @@ REFLECT_NODE_BEGIN( SettingsNode, Node, MetaNone() )
     REFLECT(        m_CachePathMountPoint,      "CachePathMountPoint",      MetaOptional() )
     REFLECT(        m_CachePluginDLL,           "CachePluginDLL",           MetaOptional() )
     REFLECT(        m_CachePluginDLLConfig,     "CachePluginDLLConfig",     MetaOptional() )
+    REFLECT(        m_CacheLocalPath,           "CacheLocalPath",           MetaOptional() )
+    REFLECT(        m_CacheLocalSizeMiB,        "CacheLocalSizeMiB",        MetaOptional() + MetaRange( CACHE_LOCAL_SIZE_MIN, CACHE_LOCAL_SIZE_MAX ) )
     REFLECT_ARRAY(  m_Workers,                  "Workers",                  MetaOptional() )
     REFLECT(        m_WorkerConnectionLimit,    "WorkerConnectionLimit",    MetaOptional() )
     REFLECT(        m_DistributableJobMemoryLimitMiB, "DistributableJobMemoryLimitMiB", MetaOptional() + MetaRange( DIST_MEMORY_LIMIT_MIN, DIST_MEMORY_LIMIT_MAX ) )
@@ -50,6 +55,7 @@ REFLECT_END( ConcurrencyGroup )
 //------------------------------------------------------------------------------
 SettingsNode::SettingsNode()
     : Node( Node::SETTINGS_NODE )
+    , m_CacheLocalSizeMiB( CACHE_LOCAL_SIZE_DEFAULT )
     , m_WorkerConnectionLimit( 15 )
     , m_DistributableJobMemoryLimitMiB( DIST_MEMORY_LIMIT_DEFAULT )
 {
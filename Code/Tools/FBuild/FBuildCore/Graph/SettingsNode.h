@@ -30,6 +30,8 @@ public:
     const AString &                     GetCachePathMountPoint() const;
     const AString &                     GetCachePluginDLL() const;
     const AString &                     GetCachePluginDLLConfig() const;
+    const AString &                     GetCacheLocalPath() const { return m_CacheLocalPath; }
+    uint32_t                            GetCacheLocalSizeMiB() const { return m_CacheLocalSizeMiB; }
     inline const Array< AString > &     GetWorkerList() const { return m_Workers; }
     uint32_t                            GetWorkerConnectionLimit() const { return m_WorkerConnectionLimit; }
     uint32_t                            GetDistributableJobMemoryLimitMiB() const { return m_DistributableJobMemoryLimitMiB; }
@@ -54,6 +56,8 @@ private:
     AString             m_CachePathMountPoint;
     AString             m_CachePluginDLL;
     AString             m_CachePluginDLLConfig;
+    AString             m_CacheLocalPath;
+    uint32_t            m_CacheLocalSizeMiB;
     Array< AString  >   m_Workers;
     uint32_t            m_WorkerConnectionLimit;
     uint32_t            m_DistributableJobMemoryLimitMiB;
@@ -69,6 +73,7 @@ public:
     const AString & GetName() const { return m_ConcurrencyGroupName; }
     uint32_t        GetLimit() const { return m_Limit; }
     uint8_t         GetIndex() const { return m_Index; }
+    uint32_t        GetMemoryPerJobMiB() const { return m_ConcurrencyPerJobMiB; }
 
     enum : uint32_t { eUnlimited = 0xFFFFFFFF };
 
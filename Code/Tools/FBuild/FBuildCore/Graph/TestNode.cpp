@@ -9,14 +9,21 @@
 #include "Tools/FBuild/FBuildCore/FLog.h"
 #include "Tools/FBuild/FBuildCore/Graph/NodeGraph.h"
 #include "Tools/FBuild/FBuildCore/Graph/DirectoryListNode.h"
+#include "Tools/FBuild/FBuildCore/Graph/SettingsNode.h"
 #include "Tools/FBuild/FBuildCore/BFF/Functions/Function.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/Job.h"
 
+#include "Core/Env/Env.h"
 #include "Core/Env/ErrorFormat.h"
 #include "Core/FileIO/FileIO.h"
 #include "Core/FileIO/FileStream.h"
 #include "Core/Math/Conversions.h"
+#include "Core/Math/xxHash.h"
 #include "Core/Strings/AStackString.h"
+#include "Core/Process/Atomic.h"
+#include "Core/Process/Mutex.h"
 #include "Core/Process/Process.h"
+#include "Core/Process/Thread.h"
 
 // Reflection
 //------------------------------------------------------------------------------
@@ -32,6 +39,9 @@ REFLECT_NODE_BEGIN( TestNode, Node, MetaName( "TestOutput" ) + MetaFile() )
     REFLECT(        m_TestArguments,            "TestArguments",            MetaOptional() )
     REFLECT(        m_TestWorkingDir,           "TestWorkingDir",           MetaOptional() + MetaPath() )
     REFLECT(        m_TestTimeOut,              "TestTimeOut",              MetaOptional() + MetaRange( 0, 4 * 60 * 60 ) ) // 4hrs
+    REFLECT(        m_TestShards,               "TestShards",               MetaOptional() + MetaRange( 1, 256 ) )
+    REFLECT(        m_TestShardArgs,            "TestShardArgs",            MetaOptional() )
+    REFLECT(        m_TestCacheResults,         "TestCacheResults",         MetaOptional() )
     REFLECT(        m_TestAlwaysShowOutput,     "TestAlwaysShowOutput",     MetaOptional() )
     REFLECT_ARRAY(  m_PreBuildDependencyNames,  "PreBuildDependencies",     MetaOptional() + MetaFile() + MetaAllowNonFile() )
     REFLECT_ARRAY(  m_Environment,              "Environment",              MetaOptional() )
@@ -40,8 +50,161 @@ REFLECT_NODE_BEGIN( TestNode, Node, MetaName( "TestOutput" ) + MetaFile() )
     // Internal State
     REFLECT(        m_NumTestInputFiles,        "NumTestInputFiles",        MetaHidden() )
     REFLECT(        m_ConcurrencyGroupIndex,    "ConcurrencyGroupIndex",    MetaHidden() )
+    REFLECT(        m_ResultHash,               "ResultHash",               MetaHidden() + MetaIgnoreForComparison() )
 REFLECT_END( TestNode )
 
+// TestShardRunner
+//  - Runs each shard of a test in its own process, concurrently up to the
+//    worker thread count and the node's ConcurrencyGroup limit
+//------------------------------------------------------------------------------
+class TestShardRunner
+{
+public:
+    explicit TestShardRunner( const TestNode & node, Job * job, const char * workingDir )
+        : m_Node( node )
+        , m_WorkingDir( workingDir )
+        , m_NumShards( node.m_TestShards )
+        , m_Shards( FNEW_ARRAY( Shard[ node.m_TestShards ] ) )
+    {
+        // Processes can be aborted along with the build or the job (i.e. a race is lost)
+        for ( uint32_t i = 0; i < m_NumShards; ++i )
+        {
+            m_Shards[ i ].m_Process = FNEW( Process( FBuild::Get().GetAbortBuildPointer(), job->GetAbortFlagPointer() ) );
+        }
+
+        // Sharding via arguments or via the environment
+        StackArray< AString > environment;
+        if ( ( m_NumShards > 1 ) && node.m_TestShardArgs.IsEmpty() )
+        {
+            node.GetShardEnvironment( environment );
+        }
+        for ( uint32_t i = 0; i < m_NumShards; ++i )
+        {
+            Shard & shard = m_Shards[ i ];
+            node.GetShardArguments( i, shard.m_Args );
+            if ( environment.IsEmpty() )
+            {
+                continue;
+            }
+            environment[ environment.GetSize() - 2 ].Format( "GTEST_TOTAL_SHARDS=%u", m_NumShards );
+            environment[ environment.GetSize() - 1 ].Format( "GTEST_SHARD_INDEX=%u", i );
+            shard.m_EnvironmentString = Env::AllocEnvironmentString( environment );
+        }
+    }
+
+    ~TestShardRunner()
+    {
+        FDELETE_ARRAY m_Shards;
+    }
+
+    TestShardRunner & operator =( TestShardRunner & ) = delete;
+
+    void Run()
+    {
+        // Each shard blocks its thread while the process runs, so each
+        // concurrent shard gets a thread, with the calling thread running one
+        // of them. Threads take the next shard as they finish
+        const uint32_t numThreads = ( GetMaxConcurrentShards() - 1 );
+        Thread * threads = ( numThreads > 0 ) ? FNEW_ARRAY( Thread[ numThreads ] ) : nullptr;
+        for ( uint32_t i = 0; i < numThreads; ++i )
+        {
+            threads[ i ].Start( ThreadFunc, "TestShardRunner", this );
+        }
+        RunShards();
+        for ( uint32_t i = 0; i < numThreads; ++i )
+        {
+            threads[ i ].Join();
+        }
+        FDELETE_ARRAY threads;
+    }
+
+    struct Shard
+    {
+        ~Shard()
+        {
+            FDELETE m_Process;
+            FREE( (void *)m_EnvironmentString );
+        }
+
+        Process *       m_Process = nullptr;
+        AString         m_Args;
+        const char *    m_EnvironmentString = nullptr;
+        AString         m_Out;
+        AString         m_Err;
+        bool            m_Spawned = false;
+        bool            m_TimedOut = false;
+        int32_t         m_Result = 0;
+    };
+
+    inline uint32_t         GetNumShards() const                { return m_NumShards; }
+    inline uint32_t         GetMaxShardsRunConcurrently() const { return m_MaxRunning; }
+    inline Shard &          GetShard( uint32_t index )          { return m_Shards[ index ]; }
+
+private:
+    uint32_t GetMaxConcurrentShards() const
+    {
+        // This job already occupies a worker thread and a slot in its
+        // ConcurrencyGroup, so shards share those rather than adding to them
+        const ConcurrencyGroup & group = FBuild::Get().GetSettings()->GetConcurrencyGroup( m_Node.GetConcurrencyGroupIndex() );
+        uint32_t maxShards = Math::Min( m_NumShards, FBuild::Get().GetOptions().m_NumWorkerThreads );
+        maxShards = Math::Min( maxShards, group.GetLimit() );
+        return Math::Max( maxShards, 1U );
+    }
+
+    static uint32_t ThreadFunc( void * userData )
+    {
+        static_cast< TestShardRunner * >( userData )->RunShards();
+        return 0;
+    }
+
+    void RunShards()
+    {
+        // Each thread takes the next shard until none remain
+        for ( ;; )
+        {
+            const uint32_t index = ( AtomicInc( &m_NextIndex ) - 1 );
+            if ( index >= m_NumShards )
+            {
+                return;
+            }
+            Shard & shard = m_Shards[ index ];
+            const char * environmentString = shard.m_EnvironmentString ? shard.m_EnvironmentString
+                                                                       : m_Node.GetEnvironmentString();
+            shard.m_Spawned = shard.m_Process->Spawn( m_Node.GetTestExecutable()->GetName().Get(),
+                                                     shard.m_Args.Get(),
+                                                     m_WorkingDir,
+                                                     environmentString );
+            if ( shard.m_Spawned == false )
+            {
+                continue;
+            }
+            {
+                MutexHolder mh( m_NumRunningMutex );
+                ++m_NumRunning;
+                m_MaxRunning = Math::Max( m_MaxRunning, m_NumRunning );
+            }
+
+            // capture all of the stdout and stderr
+            shard.m_TimedOut = !shard.m_Process->ReadAllData( shard.m_Out, shard.m_Err, m_Node.m_TestTimeOut * 1000 );
+            shard.m_Result = shard.m_Process->WaitForExit();
+
+            {
+                MutexHolder mh( m_NumRunningMutex );
+                --m_NumRunning;
+            }
+        }
+    }
+
+    const TestNode &    m_Node;
+    const char *        m_WorkingDir;
+    const uint32_t      m_NumShards;
+    Shard *             m_Shards;
+    uint32_t            m_NextIndex = 0;
+    Mutex               m_NumRunningMutex;
+    uint32_t            m_NumRunning = 0;
+    uint32_t            m_MaxRunning = 0;
+};
+
 // CONSTRUCTOR
 //------------------------------------------------------------------------------
 TestNode::TestNode()
@@ -50,10 +213,15 @@ TestNode::TestNode()
     , m_TestArguments()
     , m_TestWorkingDir()
     , m_TestTimeOut( 0 )
+    , m_TestShards( 1 )
     , m_TestAlwaysShowOutput( false )
     , m_TestInputPathRecurse( true )
+    , m_TestCacheResults( false )
     , m_NumTestInputFiles( 0 )
+    , m_ResultHash( 0 )
     , m_EnvironmentString( nullptr )
+    , m_NumShardsRun( 0 )
+    , m_MaxShardsRunConcurrently( 0 )
 {
     m_Type = Node::TEST_NODE;
 }
@@ -179,57 +347,113 @@ const char * TestNode::GetEnvironmentString() const
 //------------------------------------------------------------------------------
 /*virtual*/ Node::BuildResult TestNode::DoBuild( Job * job )
 {
+    m_NumShardsRun = 0;
+    m_MaxShardsRunConcurrently = 0;
+
+    // Skip the test if nothing it depends on has changed since it last passed
+    uint64_t resultHash = 0;
+    if ( m_TestCacheResults && CalcResultHash( resultHash ) )
+    {
+        if ( ( resultHash == m_ResultHash ) && FileIO::FileExists( GetName().Get() ) )
+        {
+            FLOG_BUILD_REASON( "Test inputs unchanged since last pass '%s' (skipped)\n", GetName().Get() );
+            if ( m_TestAlwaysShowOutput )
+            {
+                FileStream fs;
+                if ( fs.Open( GetName().Get(), FileStream::READ_ONLY ) )
+                {
+                    AString output;
+                    output.SetLength( (uint32_t)fs.GetFileSize() );
+                    if ( fs.ReadBuffer( output.Get(), output.GetLength() ) == output.GetLength() )
+                    {
+                        Node::DumpOutput( job, output );
+                    }
+                }
+            }
+            RecordStampFromBuiltFile();
+            return BuildResult::eOk;
+        }
+    }
+    m_ResultHash = 0; // Only recorded on success
+
     // If the workingDir is empty, use the current dir for the process
     const char * workingDir = m_TestWorkingDir.IsEmpty() ? nullptr : m_TestWorkingDir.Get();
 
     EmitCompilationMessage( workingDir );
 
-    // spawn the process
-    Process p( FBuild::Get().GetAbortBuildPointer() );
-    const char * environmentString = GetEnvironmentString();
-
-    const bool spawnOK = p.Spawn( GetTestExecutable()->GetName().Get(),
-                                  m_TestArguments.Get(),
-                                  workingDir,
-                                  environmentString );
+    // spawn the process(es)
+    TestShardRunner runner( *this, job, workingDir );
+    runner.Run();
+    m_MaxShardsRunConcurrently = runner.GetMaxShardsRunConcurrently();
 
-    if ( !spawnOK )
+    // Process results in shard order so output is deterministic
+    bool failed = false;
+    bool aborted = false;
+    AString output;
+    for ( uint32_t i = 0; i < runner.GetNumShards(); ++i )
     {
-        if ( p.HasAborted() )
+        TestShardRunner::Shard & shard = runner.GetShard( i );
+        if ( !shard.m_Spawned )
         {
-            return BuildResult::eAborted;
+            if ( shard.m_Process->HasAborted() )
+            {
+                aborted = true;
+                continue;
+            }
+
+            FLOG_ERROR( "Failed to spawn process for '%s'", GetName().Get() );
+            failed = true;
+            continue;
         }
+        ++m_NumShardsRun;
 
-        FLOG_ERROR( "Failed to spawn process for '%s'", GetName().Get() );
-        return BuildResult::eFailed;
-    }
+        job->OnProcessExited( *shard.m_Process );
+        if ( shard.m_Process->HasAborted() )
+        {
+            aborted = true;
+            continue;
+        }
 
-    // capture all of the stdout and stderr
-    AString memOut;
-    AString memErr;
-    const bool timedOut = !p.ReadAllData( memOut, memErr, m_TestTimeOut * 1000 );
+        const bool timedOut = shard.m_TimedOut;
+        const int result = shard.m_Result;
+        if ( ( timedOut == true ) || ( result != 0 ) || ( m_TestAlwaysShowOutput == true ) )
+        {
+            // something went wrong, print details
+            Node::DumpOutput( job, shard.m_Out );
+            Node::DumpOutput( job, shard.m_Err );
+        }
 
-    // Get result
-    const int result = p.WaitForExit();
-    if ( p.HasAborted() )
-    {
-        return BuildResult::eAborted;
-    }
+        AStackString<> shardInfo;
+        if ( runner.GetNumShards() > 1 )
+        {
+            shardInfo.Format( " Shard: %u/%u", i, runner.GetNumShards() );
+        }
+        if ( timedOut == true )
+        {
+            FLOG_ERROR( "Test timed out after %u s (%s)%s", m_TestTimeOut, m_TestExecutable.Get(), shardInfo.Get() );
+            failed = true;
+        }
+        else if ( result != 0 )
+        {
+            FLOG_ERROR( "Test failed. Error: %s Target: '%s'%s", ERROR_STR( result ), GetName().Get(), shardInfo.Get() );
+            failed = true;
+        }
 
-    if ( ( timedOut == true ) || ( result != 0 ) || ( m_TestAlwaysShowOutput == true ) )
-    {
-        // something went wrong, print details
-        Node::DumpOutput( job, memOut );
-        Node::DumpOutput( job, memErr );
+        // merge output of all shards
+        if ( runner.GetNumShards() > 1 )
+        {
+            output.AppendFormat( "[==== Shard %u/%u ====]\n", i, runner.GetNumShards() );
+        }
+        output += shard.m_Out;
+        output += shard.m_Err;
     }
-
-    if ( timedOut == true )
+    if ( aborted )
     {
-        FLOG_ERROR( "Test timed out after %u s (%s)", m_TestTimeOut, m_TestExecutable.Get() );
+        return BuildResult::eAborted;
     }
-    else if ( result != 0 )
+    if ( m_NumShardsRun < runner.GetNumShards() )
     {
-        FLOG_ERROR( "Test failed. Error: %s Target: '%s'", ERROR_STR( result ), GetName().Get() );
+        return BuildResult::eFailed; // Spawn failure will have emitted an error
     }
 
     // write the test output (saved for pass or fail)
@@ -239,8 +463,7 @@ const char * TestNode::GetEnvironmentString() const
         FLOG_ERROR( "Failed to open test output file '%s'", GetName().Get() );
         return BuildResult::eFailed;
     }
-    if ( ( ( memOut.IsEmpty() == false ) && ( fs.Write( memOut.Get(), memOut.GetLength() ) != memOut.GetLength() ) ) ||
-         ( ( memErr.IsEmpty() == false ) && ( fs.Write( memErr.Get(), memErr.GetLength() ) != memErr.GetLength() ) ) )
+    if ( ( output.IsEmpty() == false ) && ( fs.Write( output.Get(), output.GetLength() ) != output.GetLength() ) )
     {
         FLOG_ERROR( "Failed to write test output file '%s'", GetName().Get() );
         return BuildResult::eFailed;
@@ -248,12 +471,13 @@ const char * TestNode::GetEnvironmentString() const
     fs.Close();
 
     // did the test fail?
-    if ( ( timedOut == true ) || ( result != 0 ) )
+    if ( failed )
     {
         return BuildResult::eFailed;
     }
 
     // test passed
+    m_ResultHash = resultHash;
 
     // record new file time
     RecordStampFromBuiltFile();
@@ -261,6 +485,127 @@ const char * TestNode::GetEnvironmentString() const
     return BuildResult::eOk;
 }
 
+// Migrate
+//------------------------------------------------------------------------------
+/*virtual*/ void TestNode::Migrate( const Node & oldNode )
+{
+    // Migrate Node level properties
+    Node::Migrate( oldNode );
+
+    // Migrate result of last passing run (hash covers all options affecting it)
+    m_ResultHash = oldNode.CastTo< TestNode >()->m_ResultHash;
+}
+
+// GetShardArguments
+//------------------------------------------------------------------------------
+void TestNode::GetShardArguments( uint32_t shardIndex, AString & outArgs ) const
+{
+    outArgs = m_TestArguments;
+    if ( ( m_TestShards == 1 ) || m_TestShardArgs.IsEmpty() )
+    {
+        return;
+    }
+
+    // Append shard args, replacing %1 with the shard index and %2 with the shard count
+    AStackString<> index;
+    AStackString<> count;
+    index.Format( "%u", shardIndex );
+    count.Format( "%u", (uint32_t)m_TestShards );
+    AStackString<> shardArgs( m_TestShardArgs );
+    shardArgs.Replace( "%1", index.Get() );
+    shardArgs.Replace( "%2", count.Get() );
+    if ( outArgs.IsEmpty() == false )
+    {
+        outArgs += ' ';
+    }
+    outArgs += shardArgs;
+}
+
+// GetShardEnvironment
+//------------------------------------------------------------------------------
+void TestNode::GetShardEnvironment( Array< AString > & outEnvironment ) const
+{
+    // Start with the environment the test would otherwise inherit
+    const char * envString = ( m_Environment.IsEmpty() && FBuild::IsValid() ) ? FBuild::Get().GetEnvironmentString() : nullptr;
+    if ( m_Environment.IsEmpty() == false )
+    {
+        outEnvironment = m_Environment;
+    }
+    else if ( envString )
+    {
+        for ( const char * pos = envString; *pos; pos += ( AString::StrLen( pos ) + 1 ) )
+        {
+            outEnvironment.EmplaceBack( pos );
+        }
+    }
+    else
+    {
+        Env::GetEnvironment( outEnvironment );
+    }
+
+    // Remove any existing sharding vars
+    for ( size_t i = outEnvironment.GetSize(); i > 0; --i )
+    {
+        const AString & var = outEnvironment[ i - 1 ];
+        if ( var.BeginsWith( "GTEST_TOTAL_SHARDS=" ) || var.BeginsWith( "GTEST_SHARD_INDEX=" ) )
+        {
+            outEnvironment.EraseIndex( i - 1 );
+        }
+    }
+
+    // Space for sharding vars, set per shard
+    outEnvironment.EmplaceBack();
+    outEnvironment.EmplaceBack();
+}
+
+// CalcResultHash
+//------------------------------------------------------------------------------
+bool TestNode::CalcResultHash( uint64_t & outHash ) const
+{
+    StackArray< uint64_t > hashes;
+
+    // Executable and input files
+    const auto hashDependencies = [ &hashes ]( const Dependencies & deps ) -> bool
+    {
+        for ( const Dependency & dep : deps )
+        {
+            const Node * node = dep.GetNode();
+            if ( node->GetType() == Node::DIRECTORY_LIST_NODE )
+            {
+                continue; // Files are dynamic dependencies
+            }
+            uint64_t hash = node->GetStamp();
+            if ( node->IsAFile() && ( HashFileContents( node->GetName(), hash ) == false ) )
+            {
+                return false;
+            }
+            hashes.Append( hash );
+        }
+        return true;
+    };
+    if ( !hashDependencies( m_StaticDependencies ) || !hashDependencies( m_DynamicDependencies ) )
+    {
+        return false;
+    }
+
+    // Options that affect how the test runs
+    AString options;
+    options.Format( "%s|%s|%u|%s", m_TestArguments.Get(), m_TestShardArgs.Get(), m_TestShards, m_TestWorkingDir.Get() );
+    for ( const AString & var : m_Environment )
+    {
+        options += '|';
+        options += var;
+    }
+    hashes.Append( xxHash3::Calc64( options ) );
+
+    outHash = xxHash3::Calc64( hashes.Begin(), hashes.GetSize() * sizeof( uint64_t ) );
+    if ( outHash == 0 )
+    {
+        outHash = 1; // 0 is reserved to indicate no successful run
+    }
+    return true;
+}
+
 // EmitCompilationMessage
 //------------------------------------------------------------------------------
 void TestNode::EmitCompilationMessage( const char * workingDir ) const
@@ -270,6 +615,10 @@ void TestNode::EmitCompilationMessage( const char * workingDir ) const
     {
         output += "Running Test: ";
         output += GetName();
+        if ( m_TestShards > 1 )
+        {
+            output.AppendFormat( " (%u shards)", m_TestShards );
+        }
         output += '\n';
     }
     if ( FBuild::Get().GetOptions().m_ShowCommandLines )
@@ -25,11 +25,20 @@ public:
     inline const Node* GetTestExecutable() const { return m_StaticDependencies[0].GetNode(); }
     const char * GetEnvironmentString() const;
 
+    inline uint32_t GetNumShardsRun() const { return m_NumShardsRun; }
+    inline uint32_t GetMaxShardsRunConcurrently() const { return m_MaxShardsRunConcurrently; }
+
 private:
+    friend class TestShardRunner;
+
     virtual bool DoDynamicDependencies( NodeGraph & nodeGraph ) override;
     virtual BuildResult DoBuild( Job * job ) override;
+    virtual void Migrate( const Node & oldNode ) override;
 
     void EmitCompilationMessage( const char * workingDir ) const;
+    void GetShardArguments( uint32_t shardIndex, AString & outArgs ) const;
+    void GetShardEnvironment( Array< AString > & outEnvironment ) const;
+    bool CalcResultHash( uint64_t & outHash ) const;
 
     AString             m_TestExecutable;
     Array< AString >    m_TestInput;
@@ -41,15 +50,21 @@ private:
     AString             m_TestArguments;
     AString             m_TestWorkingDir;
     uint32_t            m_TestTimeOut;
+    uint32_t            m_TestShards;
+    AString             m_TestShardArgs;
     bool                m_TestAlwaysShowOutput;
     bool                m_TestInputPathRecurse;
+    bool                m_TestCacheResults;
     Array< AString >    m_PreBuildDependencyNames;
     Array< AString >    m_Environment;
     AString             m_ConcurrencyGroupName;
 
     // Internal State
     uint32_t            m_NumTestInputFiles;
+    uint64_t            m_ResultHash;       // Hash of inputs of last passing run (with .TestCacheResults)
     mutable const char * m_EnvironmentString;
+    uint32_t            m_NumShardsRun;     // Processes run by last build (not persisted)
+    uint32_t            m_MaxShardsRunConcurrently; // Most processes running at once in last build (not persisted)
 };
 
 //------------------------------------------------------------------------------
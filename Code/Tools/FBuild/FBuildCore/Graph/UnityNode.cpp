@@ -15,9 +15,11 @@
 
 // Core
 #include "Core/Containers/UniquePtr.h"
+#include "Core/Containers/UnorderedMap.h"
 #include "Core/FileIO/FileIO.h"
 #include "Core/FileIO/FileStream.h"
 #include "Core/FileIO/PathUtils.h"
+#include "Core/Math/Conversions.h"
 #include "Core/Math/xxHash.h"
 #include "Core/Process/Process.h"
 #include "Core/Strings/AStackString.h"
@@ -39,15 +41,21 @@ REFLECT_NODE_BEGIN( UnityNode, Node, MetaNone() )
     REFLECT( m_NumUnityFilesToCreate,   "UnityNumFiles",                        MetaOptional() + MetaRange( 1, 1048576 ) )
     REFLECT( m_MaxIsolatedFiles,        "UnityInputIsolateWritableFilesLimit",  MetaOptional() + MetaRange( 0, 1048576 ) )
     REFLECT( m_IsolateWritableFiles,    "UnityInputIsolateWritableFiles",       MetaOptional() )
+    REFLECT( m_IsolateChangedFiles,     "UnityInputIsolateChangedFiles",        MetaOptional() )
+    REFLECT( m_IsolateChangedFilesBuilds, "UnityInputIsolateChangedFilesBuilds", MetaOptional() + MetaRange( 1, 1048576 ) )
     REFLECT( m_IsolateListFile,         "UnityInputIsolateListFile",            MetaOptional() + MetaFile() )
     REFLECT( m_PrecompiledHeader,       "UnityPCH",                             MetaOptional() + MetaFile( true ) ) // relative
     REFLECT_ARRAY( m_PreBuildDependencyNames,   "PreBuildDependencies",         MetaOptional() + MetaFile() + MetaAllowNonFile() )
     REFLECT( m_Hidden,                  "Hidden",                               MetaOptional() )
     REFLECT( m_UseRelativePaths_Experimental, "UseRelativePaths_Experimental",  MetaOptional() )
+    REFLECT( m_BalanceByCost,           "UnityBalanceByCost",                   MetaOptional() )
 
     // Internal state
     REFLECT_ARRAY( m_UnityFileNames,    "UnityFileNames",                       MetaHidden() + MetaIgnoreForComparison() )
     REFLECT_ARRAY_OF_STRUCT( m_IsolatedFiles, "IsolatedFiles", UnityIsolatedFile, MetaHidden() + MetaIgnoreForComparison() )
+    REFLECT_ARRAY_OF_STRUCT( m_BalancedFiles, "BalancedFiles", UnityBalancedFile, MetaHidden() + MetaIgnoreForComparison() )
+    REFLECT_ARRAY_OF_STRUCT( m_FileHistory, "FileHistory", UnityFileHistory, MetaHidden() + MetaIgnoreForComparison() )
+    REFLECT( m_ChangeGeneration,        "ChangeGeneration",                     MetaHidden() + MetaIgnoreForComparison() )
 REFLECT_END( UnityNode )
 
 REFLECT_STRUCT_BEGIN( UnityIsolatedFile, Struct, MetaNone() )
@@ -55,6 +63,20 @@ REFLECT_STRUCT_BEGIN( UnityIsolatedFile, Struct, MetaNone() )
     REFLECT( m_DirListOriginPath,       "DirListOriginPath",                    MetaHidden() )
 REFLECT_END( UnityIsolatedFile )
 
+REFLECT_STRUCT_BEGIN( UnityBalancedFile, Struct, MetaNone() )
+    REFLECT( m_FileName,                "FileName",                             MetaHidden() )
+    REFLECT( m_Size,                    "Size",                                 MetaHidden() )
+    REFLECT( m_CompileTimeMs,           "CompileTimeMs",                        MetaHidden() )
+    REFLECT( m_UnityIndex,              "UnityIndex",                           MetaHidden() )
+    REFLECT( m_Isolated,                "Isolated",                             MetaHidden() )
+REFLECT_END( UnityBalancedFile )
+
+REFLECT_STRUCT_BEGIN( UnityFileHistory, Struct, MetaNone() )
+    REFLECT( m_FileName,                "FileName",                             MetaHidden() )
+    REFLECT( m_LastWriteTime,           "LastWriteTime",                        MetaHidden() )
+    REFLECT( m_LastChange,              "LastChange",                           MetaHidden() )
+REFLECT_END( UnityFileHistory )
+
 // CONSTRUCTOR (UnityIsolatedFile)
 //------------------------------------------------------------------------------
 UnityIsolatedFile::UnityIsolatedFile() = default;
@@ -170,10 +192,14 @@ UnityNode::UnityNode()
     , m_FilesToExclude( 0 )
     , m_IsolateWritableFiles( false )
     , m_MaxIsolatedFiles( 0 )
+    , m_IsolateChangedFiles( false )
+    , m_IsolateChangedFilesBuilds( 10 )
     , m_ExcludePatterns( 0 )
     , m_UseRelativePaths_Experimental( false )
+    , m_BalanceByCost( false )
     , m_IsolatedFiles( 0 )
     , m_UnityFileNames( 0 )
+    , m_ChangeGeneration( 0 )
 {
     m_InputPattern.EmplaceBack( "*.cpp" );
     m_LastBuildTimeMs = 100; // higher default than a file node
@@ -272,6 +298,14 @@ UnityNode::~UnityNode()
         return true;
     }
 
+    // Modification of files doesn't change the stamps of our dependencies, so
+    // we must always check for changes to isolate.
+    if ( m_IsolateChangedFiles )
+    {
+        FLOG_BUILD_REASON( "Need to build '%s' (UnityInputIsolateChangedFiles = true)\n", GetName().Get() );
+        return true;
+    }
+
     // Check if any output files have been deleted. This special case is required
     // because we output multiple files. It would be good to eliminate this in
     // the future.
@@ -342,17 +376,50 @@ UnityNode::~UnityNode()
         return BuildResult::eFailed; // GetFiles will have emitted an error
     }
 
-    // how many files should go in each unity file?
+    // find recently modified files
+    Array< bool > recentlyChanged;
+    if ( m_IsolateChangedFiles )
+    {
+        UpdateFileHistory( files, recentlyChanged );
+    }
+    else
+    {
+        m_FileHistory.Destruct();
+    }
+
+    // which unity file should each file go in?
     const size_t numFiles = files.GetSize();
-    const float numFilesPerUnity = (float)numFiles / (float)m_NumUnityFilesToCreate;
-    float remainingInThisUnity( 0.0 );
+    Array< uint32_t > unityIndices;
+    AssignFiles( files, unityIndices );
+
+    // Group files by unity file, keeping them in order
+    Array< uint32_t > filesByUnity;
+    filesByUnity.SetSize( numFiles );
+    Array< uint32_t > unityStarts( m_NumUnityFilesToCreate + 1 );
+    for ( size_t i = 0; i <= m_NumUnityFilesToCreate; ++i )
+    {
+        unityStarts.Append( 0 );
+    }
+    for ( const uint32_t unityIndex : unityIndices )
+    {
+        ++unityStarts[ unityIndex + 1 ];
+    }
+    for ( size_t i = 1; i < unityStarts.GetSize(); ++i )
+    {
+        unityStarts[ i ] += unityStarts[ i - 1 ];
+    }
+    {
+        Array< uint32_t > unityEnds( unityStarts );
+        for ( uint32_t fileIndex = 0; fileIndex < numFiles; ++fileIndex )
+        {
+            filesByUnity[ unityEnds[ unityIndices[ fileIndex ] ]++ ] = fileIndex;
+        }
+    }
 
     #if defined(ASSERTS_ENABLED)
         uint32_t numFilesWritten( 0 );
     #endif
 
-    size_t index = 0;
-
     const bool noUnity = FBuild::Get().GetOptions().m_NoUnity;
 
     AString output;
@@ -371,9 +438,6 @@ UnityNode::~UnityNode()
     // create each unity file
     for ( size_t i=0; i<m_NumUnityFilesToCreate; ++i )
     {
-        // add allocation to this unity
-        remainingInThisUnity += numFilesPerUnity;
-
         // header
         output = "// Auto-generated Unity file - do not modify\r\n\r\n";
 
@@ -394,24 +458,15 @@ UnityNode::~UnityNode()
             output += "\"\r\n\r\n";
         }
 
-        // make sure any remaining files are added to the last unity to account
-        // for floating point imprecision
-
         // determine allocation of includes for this unity file
         Array< UnityFileAndOrigin > filesInThisUnity( 256 );
+        Array< uint32_t > fileIndicesInThisUnity( 256 );
         uint32_t numIsolated( 0 );
-        const bool lastUnity = ( i == ( m_NumUnityFilesToCreate - 1 ) );
-        while ( ( remainingInThisUnity > 0.0f ) || lastUnity )
+        for ( uint32_t j = unityStarts[ i ]; j < unityStarts[ i + 1 ]; ++j )
         {
-            remainingInThisUnity -= 1.0f; // reduce allocation, but leave rounding
-
-            // handle cases where there's more unity files than source files
-            if ( index >= numFiles )
-            {
-                break;
-            }
-
+            const uint32_t index = filesByUnity[ j ];
             filesInThisUnity.Append( files[index ] );
+            fileIndicesInThisUnity.Append( index );
 
             // files which are modified (writable) can optionally be excluded from the unity
             bool isolate = false;
@@ -430,6 +485,12 @@ UnityNode::~UnityNode()
                 isolate = ( isolatedFilesFromList.Find( files[ index ].GetName() ) != nullptr );
             }
 
+            // files modified recently can optionally be excluded from the unity
+            if ( !isolate && m_IsolateChangedFiles )
+            {
+                isolate = recentlyChanged[ index ];
+            }
+
             if ( isolate )
             {
                 numIsolated++;
@@ -439,7 +500,6 @@ UnityNode::~UnityNode()
             }
 
             // count the file, whether we wrote it or not, to keep unity files stable
-            index++;
             #if defined(ASSERTS_ENABLED)
                 numFilesWritten++;
             #endif
@@ -447,8 +507,10 @@ UnityNode::~UnityNode()
 
         // write allocation of includes for this unity file
         size_t numFilesActuallyIsolatedInThisUnity( 0 );
-        for ( const UnityFileAndOrigin & file : filesInThisUnity )
+        for ( size_t j = 0; j < filesInThisUnity.GetSize(); ++j )
         {
+            const UnityFileAndOrigin & file = filesInThisUnity[ j ];
+
             // files which are modified can optionally be excluded from the unity
             bool isolateThisFile = false;
             if ( ( m_MaxIsolatedFiles == 0 ) || ( numIsolated <= m_MaxIsolatedFiles ) )
@@ -472,6 +534,10 @@ UnityNode::~UnityNode()
                 // We still generate the unity.cpp the same way to avoid changing it unnecessarily
                 m_IsolatedFiles.EmplaceBack( file.GetName(), file.GetDirListOrigin() );
             }
+            if ( m_BalanceByCost )
+            {
+                m_BalancedFiles[ fileIndicesInThisUnity[ j ] ].m_Isolated = ( isolateThisFile || noUnity );
+            }
 
             // Get relative file path
             AStackString<> relativePath;
@@ -514,13 +580,8 @@ UnityNode::~UnityNode()
         output += "\r\n";
 
         // generate the destination unity file name
-        AStackString<> unityName( m_OutputPath );
-        unityName += m_OutputPattern;
-        {
-            AStackString<> tmp;
-            tmp.Format( "%u", (uint32_t)i + 1 ); // number from 1
-            unityName.Replace( "*", tmp.Get() );
-        }
+        AStackString<> unityName;
+        GetUnityFileName( (uint32_t)i, unityName );
 
         // only keep track of non-empty unity files (to avoid link errors with empty objects)
         // additionally, if -nounity is in use we also don't want to link these objects
@@ -633,6 +694,377 @@ UnityNode::~UnityNode()
     const UnityNode * oldUnityNode = oldNode.CastTo< UnityNode >();
     m_IsolatedFiles = oldUnityNode->m_IsolatedFiles;
     m_UnityFileNames = oldUnityNode->m_UnityFileNames;
+    m_BalancedFiles = oldUnityNode->m_BalancedFiles;
+    m_FileHistory = oldUnityNode->m_FileHistory;
+    m_ChangeGeneration = oldUnityNode->m_ChangeGeneration;
+}
+
+// UpdateFileHistory
+//------------------------------------------------------------------------------
+void UnityNode::UpdateFileHistory( const Array< UnityFileAndOrigin > & files, Array< bool > & outRecentlyChanged )
+{
+    // Previous modification times
+    UnorderedMap< AString, uint32_t > previousFiles;
+    for ( size_t i = 0; i < m_FileHistory.GetSize(); ++i )
+    {
+        previousFiles.Insert( m_FileHistory[ i ].m_FileName, static_cast< uint32_t >( i ) );
+    }
+
+    // Directory listings don't track modification of files, so we check them
+    // ourselves
+    Array< UnityFileHistory > fileHistory( files.GetSize() );
+    bool anyChanged = false;
+    for ( const UnityFileAndOrigin & file : files )
+    {
+        UnityFileHistory & history = fileHistory.EmplaceBack();
+        history.m_FileName = file.GetName();
+        history.m_LastWriteTime = FileIO::GetFileLastWriteTime( file.GetName() );
+
+        // New files have not been modified (they have no history)
+        const UnorderedMap< AString, uint32_t >::KeyValue * previous = previousFiles.Find( file.GetName() );
+        if ( previous )
+        {
+            const UnityFileHistory & previousHistory = m_FileHistory[ previous->m_Value ];
+            history.m_LastChange = previousHistory.m_LastChange;
+            if ( history.m_LastWriteTime != previousHistory.m_LastWriteTime )
+            {
+                history.m_LastChange = ( m_ChangeGeneration + 1 );
+                anyChanged = true;
+            }
+        }
+    }
+
+    // Files remain isolated until others have been modified several times, so
+    // the unity layout returns to normal once a file is no longer being worked on
+    if ( anyChanged )
+    {
+        ++m_ChangeGeneration;
+    }
+    outRecentlyChanged.SetCapacity( fileHistory.GetSize() );
+    for ( const UnityFileHistory & history : fileHistory )
+    {
+        const bool recentlyChanged = ( history.m_LastChange != 0 ) &&
+                                     ( ( m_ChangeGeneration - history.m_LastChange ) < m_IsolateChangedFilesBuilds );
+        outRecentlyChanged.Append( recentlyChanged );
+    }
+
+    m_FileHistory = Move( fileHistory );
+}
+
+// AssignFiles
+//------------------------------------------------------------------------------
+void UnityNode::AssignFiles( const Array< UnityFileAndOrigin > & files, Array< uint32_t > & outUnityIndices )
+{
+    const uint32_t numFiles = static_cast< uint32_t >( files.GetSize() );
+    if ( m_BalanceByCost == false )
+    {
+        m_BalancedFiles.Destruct();
+        AssignFilesByCount( numFiles, m_NumUnityFilesToCreate, outUnityIndices );
+        return;
+    }
+
+    MutexHolder mh( m_BalancedFilesMutex );
+
+    // Previous assignments and compile times
+    UnorderedMap< AString, uint32_t > previousFiles;
+    uint64_t totalTimeMs = 0;
+    uint64_t totalSizeOfTimedFiles = 0;
+    for ( size_t i = 0; i < m_BalancedFiles.GetSize(); ++i )
+    {
+        const UnityBalancedFile & file = m_BalancedFiles[ i ];
+        previousFiles.Insert( file.m_FileName, static_cast< uint32_t >( i ) );
+        if ( file.m_CompileTimeMs )
+        {
+            totalTimeMs += file.m_CompileTimeMs;
+            totalSizeOfTimedFiles += file.m_Size;
+        }
+    }
+
+    // Files without a known compile time are estimated from their size, using
+    // the compile times of other files (if any) to relate size to time
+    const double msPerByte = totalSizeOfTimedFiles ? ( (double)totalTimeMs / (double)totalSizeOfTimedFiles ) : 0.0;
+
+    Array< UnityBalancedFile > balancedFiles( files.GetSize() );
+    Array< uint64_t > costs( files.GetSize() );
+    Array< uint32_t > previousUnityIndices( files.GetSize() );
+    for ( const UnityFileAndOrigin & file : files )
+    {
+        UnityBalancedFile & balancedFile = balancedFiles.EmplaceBack();
+        balancedFile.m_FileName = file.GetName();
+        // NOTE: Sizes from directory listings are current, as the read-only
+        // status is included in their hash so files in unchanged directories
+        // are checked again
+        balancedFile.m_Size = file.GetSize();
+
+        const UnorderedMap< AString, uint32_t >::KeyValue * previous = previousFiles.Find( file.GetName() );
+        if ( previous )
+        {
+            const UnityBalancedFile & previousFile = m_BalancedFiles[ previous->m_Value ];
+            balancedFile.m_CompileTimeMs = previousFile.m_CompileTimeMs;
+            previousUnityIndices.Append( previousFile.m_UnityIndex );
+        }
+        else
+        {
+            previousUnityIndices.Append( NO_UNITY_INDEX );
+        }
+
+        // Cost in microseconds (or bytes if no compile times are known)
+        uint64_t cost;
+        if ( balancedFile.m_CompileTimeMs )
+        {
+            cost = ( (uint64_t)balancedFile.m_CompileTimeMs * 1000 );
+        }
+        else if ( msPerByte > 0.0 )
+        {
+            cost = (uint64_t)( (double)balancedFile.m_Size * msPerByte * 1000.0 );
+        }
+        else
+        {
+            cost = balancedFile.m_Size;
+        }
+        costs.Append( Math::Max( cost, (uint64_t)1 ) );
+    }
+
+    AssignFilesByCost( costs, previousUnityIndices, m_NumUnityFilesToCreate, outUnityIndices );
+
+    for ( size_t i = 0; i < balancedFiles.GetSize(); ++i )
+    {
+        balancedFiles[ i ].m_UnityIndex = outUnityIndices[ i ];
+    }
+    m_BalancedFiles = Move( balancedFiles );
+}
+
+// AssignFilesByCount
+//------------------------------------------------------------------------------
+/*static*/ void UnityNode::AssignFilesByCount( uint32_t numFiles, uint32_t numUnityFiles, Array< uint32_t > & outUnityIndices )
+{
+    // how many files should go in each unity file?
+    const float numFilesPerUnity = (float)numFiles / (float)numUnityFiles;
+    float remainingInThisUnity( 0.0 );
+
+    outUnityIndices.SetCapacity( numFiles );
+    for ( uint32_t i = 0; i < numUnityFiles; ++i )
+    {
+        // add allocation to this unity
+        remainingInThisUnity += numFilesPerUnity;
+
+        // make sure any remaining files are added to the last unity to account
+        // for floating point imprecision
+        const bool lastUnity = ( i == ( numUnityFiles - 1 ) );
+        while ( ( remainingInThisUnity > 0.0f ) || lastUnity )
+        {
+            remainingInThisUnity -= 1.0f; // reduce allocation, but leave rounding
+
+            // handle cases where there's more unity files than source files
+            if ( outUnityIndices.GetSize() >= numFiles )
+            {
+                break;
+            }
+
+            outUnityIndices.Append( i );
+        }
+    }
+}
+
+// AssignFilesByCost
+//------------------------------------------------------------------------------
+/*static*/ void UnityNode::AssignFilesByCost( const Array< uint64_t > & costs,
+                                              const Array< uint32_t > & previousUnityIndices,
+                                              uint32_t numUnityFiles,
+                                              Array< uint32_t > & outUnityIndices )
+{
+    ASSERT( costs.GetSize() == previousUnityIndices.GetSize() );
+    const uint32_t numFiles = static_cast< uint32_t >( costs.GetSize() );
+
+    // Keep files in their previous unity file where possible, so that changes
+    // to the set of files don't modify every unity file
+    Array< uint64_t > loads( numUnityFiles );
+    for ( uint32_t i = 0; i < numUnityFiles; ++i )
+    {
+        loads.Append( 0 );
+    }
+    uint64_t totalCost = 0;
+    outUnityIndices.SetCapacity( numFiles );
+    for ( uint32_t i = 0; i < numFiles; ++i )
+    {
+        const uint32_t previousUnityIndex = previousUnityIndices[ i ];
+        const bool keep = ( previousUnityIndex < numUnityFiles );
+        outUnityIndices.Append( keep ? previousUnityIndex : (uint32_t)NO_UNITY_INDEX );
+        if ( keep )
+        {
+            loads[ previousUnityIndex ] += costs[ i ];
+        }
+        totalCost += costs[ i ];
+    }
+
+    // Files to (re)assign, most expensive first
+    Array< uint32_t > byCost( numFiles );
+    for ( uint32_t i = 0; i < numFiles; ++i )
+    {
+        byCost.Append( i );
+    }
+    byCost.Sort( [ &costs ]( uint32_t a, uint32_t b )
+    {
+        return ( costs[ a ] != costs[ b ] ) ? ( costs[ a ] > costs[ b ] ) : ( a < b );
+    } );
+
+    // Remove files from over-full unity files (more than 20% above average),
+    // most expensive first. A file which makes up the majority of its unity
+    // file is left in place, as moving it would not help.
+    const uint64_t overFullLoad = ( totalCost + ( totalCost / 5 ) ) / numUnityFiles;
+    for ( const uint32_t fileIndex : byCost )
+    {
+        const uint32_t unityIndex = outUnityIndices[ fileIndex ];
+        if ( ( unityIndex == NO_UNITY_INDEX ) ||
+             ( loads[ unityIndex ] <= overFullLoad ) ||
+             ( costs[ fileIndex ] > ( loads[ unityIndex ] - costs[ fileIndex ] ) ) )
+        {
+            continue;
+        }
+        loads[ unityIndex ] -= costs[ fileIndex ];
+        outUnityIndices[ fileIndex ] = NO_UNITY_INDEX;
+    }
+
+    // Assign remaining files to the least loaded unity file, most expensive first
+    for ( const uint32_t fileIndex : byCost )
+    {
+        if ( outUnityIndices[ fileIndex ] != NO_UNITY_INDEX )
+        {
+            continue;
+        }
+        uint32_t leastLoaded = 0;
+        for ( uint32_t i = 1; i < numUnityFiles; ++i )
+        {
+            if ( loads[ i ] < loads[ leastLoaded ] )
+            {
+                leastLoaded = i;
+            }
+        }
+        loads[ leastLoaded ] += costs[ fileIndex ];
+        outUnityIndices[ fileIndex ] = leastLoaded;
+    }
+}
+
+// RecordCompileTimes
+//------------------------------------------------------------------------------
+void UnityNode::RecordCompileTimes( const Dependencies & objects )
+{
+    ASSERT( m_BalanceByCost );
+
+    MutexHolder mh( m_BalancedFilesMutex );
+
+    // Index files by name
+    UnorderedMap< AString, uint32_t > fileIndices;
+    for ( size_t i = 0; i < m_BalancedFiles.GetSize(); ++i )
+    {
+        fileIndices.Insert( m_BalancedFiles[ i ].m_FileName, static_cast< uint32_t >( i ) );
+    }
+
+    for ( const Dependency & dep : objects )
+    {
+        // Only consider objects compiled during this build (not retrieved from the cache)
+        if ( dep.GetNode()->GetType() != Node::OBJECT_NODE )
+        {
+            continue;
+        }
+        const ObjectNode * on = dep.GetNode()->CastTo< ObjectNode >();
+        if ( ( on->GetStatFlag( Node::STATS_BUILT ) == false ) ||
+             ( ( on->IsUnity() || on->IsIsolatedFromUnity() ) == false ) )
+        {
+            continue;
+        }
+        const AString & sourceFile = on->GetSourceFile()->GetName();
+        const uint32_t timeMs = on->GetLastBuildTime();
+
+        // Isolated file?
+        const UnorderedMap< AString, uint32_t >::KeyValue * fileIndex = fileIndices.Find( sourceFile );
+        if ( fileIndex )
+        {
+            m_BalancedFiles[ fileIndex->m_Value ].m_CompileTimeMs = Math::Max( timeMs, 1u );
+            continue;
+        }
+
+        // Unity file?
+        uint32_t unityIndex;
+        if ( GetUnityIndex( sourceFile, unityIndex ) == false )
+        {
+            continue;
+        }
+
+        // Share time between files in unity, in proportion to their previous
+        // compile times (if all are known) or sizes
+        uint64_t totalTime = 0;
+        uint64_t totalSize = 0;
+        bool allTimesKnown = true;
+        for ( const UnityBalancedFile & file : m_BalancedFiles )
+        {
+            if ( ( file.m_UnityIndex == unityIndex ) && ( file.m_Isolated == false ) )
+            {
+                totalTime += file.m_CompileTimeMs;
+                totalSize += ( file.m_Size + 1 );
+                allTimesKnown &= ( file.m_CompileTimeMs != 0 );
+            }
+        }
+        for ( UnityBalancedFile & file : m_BalancedFiles )
+        {
+            if ( ( file.m_UnityIndex == unityIndex ) && ( file.m_Isolated == false ) )
+            {
+                const double share = allTimesKnown ? ( (double)file.m_CompileTimeMs / (double)totalTime )
+                                                   : ( (double)( file.m_Size + 1 ) / (double)totalSize );
+                file.m_CompileTimeMs = Math::Max( (uint32_t)( (double)timeMs * share ), 1u );
+            }
+        }
+    }
+}
+
+// GetUnityFileName
+//------------------------------------------------------------------------------
+void UnityNode::GetUnityFileName( uint32_t unityIndex, AString & outName ) const
+{
+    outName = m_OutputPath;
+    outName += m_OutputPattern;
+    AStackString<> tmp;
+    tmp.Format( "%u", unityIndex + 1 ); // number from 1
+    outName.Replace( "*", tmp.Get() );
+}
+
+// GetUnityIndex
+//------------------------------------------------------------------------------
+bool UnityNode::GetUnityIndex( const AString & unityFileName, uint32_t & outUnityIndex ) const
+{
+    // Split pattern around the number
+    const char * const star = m_OutputPattern.Find( '*' );
+    if ( star == nullptr )
+    {
+        return false;
+    }
+    AStackString<> prefix( m_OutputPath );
+    prefix.Append( m_OutputPattern.Get(), (size_t)( star - m_OutputPattern.Get() ) );
+    const char * const suffix = ( star + 1 );
+    const size_t suffixLength = AString::StrLen( suffix );
+    if ( ( unityFileName.BeginsWith( prefix ) == false ) ||
+         ( unityFileName.EndsWith( suffix ) == false ) ||
+         ( unityFileName.GetLength() <= ( prefix.GetLength() + suffixLength ) ) )
+    {
+        return false;
+    }
+
+    // Parse number
+    uint32_t number = 0;
+    for ( const char * pos = unityFileName.Get() + prefix.GetLength(); pos < ( unityFileName.GetEnd() - suffixLength ); ++pos )
+    {
+        if ( ( *pos < '0' ) || ( *pos > '9' ) || ( number > 1048576 ) )
+        {
+            return false;
+        }
+        number = ( number * 10 ) + (uint32_t)( *pos - '0' );
+    }
+    if ( ( number == 0 ) || ( number > m_NumUnityFilesToCreate ) )
+    {
+        return false;
+    }
+    outUnityIndex = ( number - 1 ); // number from 1
+    return true;
 }
 
 // GetFiles
@@ -699,6 +1131,15 @@ bool UnityNode::GetFiles( Array< UnityFileAndOrigin > & files )
                     fi->m_Attributes = 0; // No writable bits set
                 #endif
                 fi->m_Size = 0;
+                if ( m_BalanceByCost )
+                {
+                    // Size is needed to estimate the cost of the file
+                    FileIO::FileInfo info;
+                    if ( FileIO::GetFileInfo( file, info ) )
+                    {
+                        fi->m_Size = info.m_Size;
+                    }
+                }
                 files.EmplaceBack( fi, nullptr );
             }
         }
@@ -7,6 +7,7 @@
 #include "FileNode.h"
 #include "Core/Containers/Array.h"
 #include "Core/FileIO/FileIO.h"
+#include "Core/Process/Mutex.h"
 
 // Forward Declarations
 //------------------------------------------------------------------------------
@@ -32,6 +33,33 @@ protected:
     AString m_DirListOriginPath;
 };
 
+// UnityBalancedFile
+//  - Unity file assignment and cost history of an input file, when balancing
+//    unity files by cost
+//------------------------------------------------------------------------------
+class UnityBalancedFile : public Struct
+{
+    REFLECT_STRUCT_DECLARE( UnityBalancedFile )
+public:
+    AString     m_FileName;
+    uint64_t    m_Size          = 0;
+    uint32_t    m_CompileTimeMs = 0;        // Estimated from compilation of unity, or 0 if unknown
+    uint32_t    m_UnityIndex    = 0;
+    bool        m_Isolated      = false;    // Was compiled individually
+};
+
+// UnityFileHistory
+//  - Modification history of an input file, when isolating changed files
+//------------------------------------------------------------------------------
+class UnityFileHistory : public Struct
+{
+    REFLECT_STRUCT_DECLARE( UnityFileHistory )
+public:
+    AString     m_FileName;
+    uint64_t    m_LastWriteTime = 0;
+    uint32_t    m_LastChange    = 0;    // Change generation of most recent modification, or 0 if never modified
+};
+
 // UnityNode
 //------------------------------------------------------------------------------
 class UnityNode : public Node
@@ -51,6 +79,21 @@ public:
 
     void EnumerateInputFiles( void (*callback)( const AString & inputFile, const AString & baseDir, void * userData ), void * userData ) const;
 
+    // Cost balancing (.UnityBalanceByCost)
+    inline bool IsBalancingByCost() const { return m_BalanceByCost; }
+    void RecordCompileTimes( const Dependencies & objects );
+
+    // Partition files into unity files
+    //  - by count, preserving order
+    //  - by cost, with files remaining in their previous unity file (if any)
+    //    unless it is over-full
+    static void AssignFilesByCount( uint32_t numFiles, uint32_t numUnityFiles, Array< uint32_t > & outUnityIndices );
+    static void AssignFilesByCost( const Array< uint64_t > & costs,
+                                   const Array< uint32_t > & previousUnityIndices,
+                                   uint32_t numUnityFiles,
+                                   Array< uint32_t > & outUnityIndices );
+    enum : uint32_t { NO_UNITY_INDEX = 0xFFFFFFFF };
+
 protected:
     virtual bool DetermineNeedToBuildStatic() const override;
     virtual BuildResult DoBuild( Job * job ) override;
@@ -65,6 +108,7 @@ protected:
         UnityFileAndOrigin( FileIO::FileInfo * info, DirectoryListNode * dirListOrigin );
 
         inline const AString &              GetName() const             { return m_Info->m_Name; }
+        inline uint64_t                     GetSize() const             { return m_Info->m_Size; }
         inline bool                         IsReadOnly() const          { return m_Info->IsReadOnly(); }
         inline const DirectoryListNode *    GetDirListOrigin() const    { return m_DirListOrigin; }
 
@@ -83,6 +127,10 @@ protected:
     bool GetFiles( Array< UnityFileAndOrigin > & files );
     bool GetIsolatedFilesFromList( Array< AString > & files ) const;
     void FilterForceIsolated( Array< UnityFileAndOrigin > & files, Array< UnityIsolatedFile > & isolatedFiles );
+    void AssignFiles( const Array< UnityFileAndOrigin > & files, Array< uint32_t > & outUnityIndices );
+    void GetUnityFileName( uint32_t unityIndex, AString & outName ) const;
+    bool GetUnityIndex( const AString & unityFileName, uint32_t & outUnityIndex ) const;
+    void UpdateFileHistory( const Array< UnityFileAndOrigin > & files, Array< bool > & outRecentlyChanged );
 
     // Exposed properties
     Array< AString > m_InputPaths;
@@ -99,10 +147,13 @@ protected:
     Array< AString > m_FilesToIsolate;
     bool m_IsolateWritableFiles;
     uint32_t m_MaxIsolatedFiles;
+    bool m_IsolateChangedFiles;
+    uint32_t m_IsolateChangedFilesBuilds;
     AString m_IsolateListFile;
     Array< AString > m_ExcludePatterns;
     Array< AString > m_PreBuildDependencyNames;
     bool m_UseRelativePaths_Experimental;
+    bool m_BalanceByCost;
 
     // Temporary data
     Array< FileIO::FileInfo* > m_FilesInfo;
@@ -110,6 +161,10 @@ protected:
     // Internal data persisted between builds
     Array< UnityIsolatedFile > m_IsolatedFiles;
     Array< AString > m_UnityFileNames;
+    Array< UnityBalancedFile > m_BalancedFiles;
+    Mutex m_BalancedFilesMutex;
+    Array< UnityFileHistory > m_FileHistory;
+    uint32_t m_ChangeGeneration;        // Incremented each time files are modified
 };
 
 //------------------------------------------------------------------------------
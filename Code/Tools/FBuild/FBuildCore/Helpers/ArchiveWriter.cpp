@@ -0,0 +1,471 @@
+// ArchiveWriter - Create static libraries in the GNU ar format
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "ArchiveWriter.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/FLog.h"
+
+// Core
+#include "Core/Containers/UniquePtr.h"
+#include "Core/FileIO/FileStream.h"
+#include "Core/FileIO/MemoryStream.h"
+#include "Core/FileIO/PathUtils.h"
+#include "Core/Profile/Profile.h"
+#include "Core/Strings/AStackString.h"
+
+// system
+#include <stdio.h> // for snprintf
+#include <string.h> // for memcmp, memcpy
+
+// Helpers
+//------------------------------------------------------------------------------
+namespace
+{
+    // Read a little-endian value from an ELF file, with bounds checking
+    template < class T >
+    bool ReadELF( const uint8_t * data, size_t dataSize, uint64_t offset, T & outValue )
+    {
+        if ( ( offset > dataSize ) || ( ( dataSize - offset ) < sizeof( T ) ) )
+        {
+            return false;
+        }
+        memcpy( &outValue, data + offset, sizeof( T ) );
+        return true;
+    }
+
+    // Write a big-endian offset, as used by the archive symbol table
+    void WriteBigEndian( MemoryStream & stream, uint64_t value, size_t numBytes )
+    {
+        for ( size_t i = 0; i < numBytes; ++i )
+        {
+            const uint8_t byte = (uint8_t)( value >> ( ( numBytes - 1 - i ) * 8 ) );
+            stream.Write( byte );
+        }
+    }
+
+    const char * const  kArchiveMagic       = "!<arch>\n";
+    const char * const  kThinArchiveMagic   = "!<thin>\n";
+    const size_t        kMagicSize          = 8;
+    const size_t        kHeaderSize         = 60;
+}
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+ArchiveWriter::ArchiveWriter( bool thin )
+    : m_Thin( thin )
+{
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+ArchiveWriter::~ArchiveWriter() = default;
+
+// AddMember
+//------------------------------------------------------------------------------
+void ArchiveWriter::AddMember( const AString & fileName, uint64_t size, const Array< AString > & symbols )
+{
+    Member & member = m_Members.EmplaceBack();
+    member.m_FileName = fileName;
+    member.m_Size = size;
+    member.m_Symbols = &symbols; // Must remain valid until archive is written
+}
+
+// Write
+//------------------------------------------------------------------------------
+bool ArchiveWriter::Write( const AString & archiveFileName ) const
+{
+    PROFILE_FUNCTION;
+
+    // Directory of archive, which paths of thin archive members are relative to
+    AStackString<> archiveDir;
+    if ( m_Thin )
+    {
+        const char * lastSlash = archiveFileName.FindLast( NATIVE_SLASH );
+        archiveDir.Assign( archiveFileName.Get(), lastSlash ? ( lastSlash + 1 ) : archiveFileName.Get() );
+    }
+
+    // Build the name table and determine each member's name
+    // - thin archives store all names (paths) in the table
+    // - regular archives only store names which don't fit in the header
+    AString nameTable;
+    Array< AString > memberNames( m_Members.GetSize() );
+    for ( const Member & member : m_Members )
+    {
+        AStackString<> name;
+        if ( m_Thin )
+        {
+            PathUtils::GetRelativePath( archiveDir, member.m_FileName, name );
+        }
+        else
+        {
+            const char * lastSlash = member.m_FileName.FindLast( NATIVE_SLASH );
+            name = lastSlash ? ( lastSlash + 1 ) : member.m_FileName.Get();
+        }
+        #if defined( __WINDOWS__ )
+            name.Replace( BACK_SLASH, FORWARD_SLASH );
+        #endif
+
+        AString & memberName = memberNames.EmplaceBack();
+        if ( ( m_Thin == false ) && ( name.GetLength() < 16 ) )
+        {
+            memberName.Format( "%s/", name.Get() );
+        }
+        else
+        {
+            memberName.Format( "/%u", (uint32_t)nameTable.GetLength() );
+            nameTable += name;
+            nameTable += "/\n";
+        }
+    }
+    if ( nameTable.GetLength() & 1 )
+    {
+        nameTable += '\n'; // Members must be 2-byte aligned
+    }
+
+    // Determine size of symbol table and the offset of each member
+    size_t numSymbols = 0;
+    size_t symbolNamesSize = 0;
+    for ( const Member & member : m_Members )
+    {
+        numSymbols += member.m_Symbols->GetSize();
+        for ( const AString & symbol : *member.m_Symbols )
+        {
+            symbolNamesSize += ( symbol.GetLength() + 1 );
+        }
+    }
+    Array< uint64_t > memberOffsets( m_Members.GetSize() );
+    size_t offsetSize = 4;
+    uint64_t symbolTableSize = 0;
+    for ( ;; )
+    {
+        symbolTableSize = 0;
+        if ( numSymbols > 0 )
+        {
+            symbolTableSize = ( offsetSize * ( 1 + numSymbols ) ) + symbolNamesSize;
+            symbolTableSize += ( symbolTableSize & 1 ); // Members must be 2-byte aligned
+        }
+        uint64_t offset = kMagicSize;
+        if ( symbolTableSize > 0 )
+        {
+            offset += ( kHeaderSize + symbolTableSize );
+        }
+        if ( nameTable.IsEmpty() == false )
+        {
+            offset += ( kHeaderSize + nameTable.GetLength() );
+        }
+        memberOffsets.Clear();
+        for ( const Member & member : m_Members )
+        {
+            memberOffsets.Append( offset );
+            offset += kHeaderSize;
+            if ( m_Thin == false )
+            {
+                offset += ( member.m_Size + ( member.m_Size & 1 ) );
+            }
+        }
+
+        // Use a 64-bit symbol table for archives larger than 4 GiB
+        if ( ( offsetSize == 4 ) && ( memberOffsets.IsEmpty() == false ) && ( memberOffsets.Top() > 0xFFFFFFFF ) )
+        {
+            offsetSize = 8;
+            continue;
+        }
+        break;
+    }
+
+    // Magic, symbol table and name table
+    MemoryStream prefix;
+    prefix.WriteBuffer( m_Thin ? kThinArchiveMagic : kArchiveMagic, kMagicSize );
+    if ( symbolTableSize > 0 )
+    {
+        WriteHeader( prefix, HEADER_SYMBOL_TABLE, ( offsetSize == 4 ) ? "/" : "/SYM64/", symbolTableSize );
+        WriteBigEndian( prefix, numSymbols, offsetSize );
+        for ( size_t i = 0; i < m_Members.GetSize(); ++i )
+        {
+            for ( size_t j = 0; j < m_Members[ i ].m_Symbols->GetSize(); ++j )
+            {
+                WriteBigEndian( prefix, memberOffsets[ i ], offsetSize );
+            }
+        }
+        for ( const Member & member : m_Members )
+        {
+            for ( const AString & symbol : *member.m_Symbols )
+            {
+                prefix.WriteBuffer( symbol.Get(), symbol.GetLength() + 1 ); // Include terminator
+            }
+        }
+        if ( ( symbolNamesSize + ( offsetSize * ( 1 + numSymbols ) ) ) & 1 )
+        {
+            prefix.Write( (uint8_t)0 );
+        }
+    }
+    if ( nameTable.IsEmpty() == false )
+    {
+        WriteHeader( prefix, HEADER_NAME_TABLE, "//", nameTable.GetLength() );
+        prefix.WriteBuffer( nameTable.Get(), nameTable.GetLength() );
+    }
+
+    FileStream f;
+    if ( f.Open( archiveFileName.Get(), FileStream::WRITE_ONLY ) == false )
+    {
+        FLOG_ERROR( "Failed to create archive '%s'", archiveFileName.Get() );
+        return false;
+    }
+
+    // Thin archives only need member headers, so can be written in one go
+    if ( m_Thin )
+    {
+        for ( size_t i = 0; i < m_Members.GetSize(); ++i )
+        {
+            WriteHeader( prefix, HEADER_MEMBER, memberNames[ i ].Get(), m_Members[ i ].m_Size );
+        }
+    }
+    if ( f.WriteBuffer( prefix.GetData(), prefix.GetSize() ) != prefix.GetSize() )
+    {
+        FLOG_ERROR( "Failed to write archive '%s'", archiveFileName.Get() );
+        return false;
+    }
+    if ( m_Thin )
+    {
+        return true;
+    }
+
+    // Regular archives contain the members
+    MemoryStream header;
+    UniquePtr< char, FreeDeletor > buffer;
+    uint64_t bufferSize = 0;
+    for ( size_t i = 0; i < m_Members.GetSize(); ++i )
+    {
+        const Member & member = m_Members[ i ];
+
+        FileStream memberFile;
+        if ( ( memberFile.Open( member.m_FileName.Get(), FileStream::READ_ONLY ) == false ) ||
+             ( memberFile.GetFileSize() != member.m_Size ) )
+        {
+            FLOG_ERROR( "Failed to read archive member '%s' (or file was modified)", member.m_FileName.Get() );
+            return false;
+        }
+
+        header.Reset();
+        WriteHeader( header, HEADER_MEMBER, memberNames[ i ].Get(), member.m_Size );
+        if ( f.WriteBuffer( header.GetData(), header.GetSize() ) != header.GetSize() )
+        {
+            FLOG_ERROR( "Failed to write archive '%s'", archiveFileName.Get() );
+            return false;
+        }
+
+        // Copy contents, with padding for alignment
+        const uint64_t paddedSize = ( member.m_Size + ( member.m_Size & 1 ) );
+        if ( paddedSize > bufferSize )
+        {
+            buffer = (char *)ALLOC( paddedSize );
+            bufferSize = paddedSize;
+        }
+        if ( memberFile.ReadBuffer( buffer.Get(), member.m_Size ) != member.m_Size )
+        {
+            FLOG_ERROR( "Failed to read archive member '%s'", member.m_FileName.Get() );
+            return false;
+        }
+        if ( member.m_Size & 1 )
+        {
+            buffer.Get()[ member.m_Size ] = '\n';
+        }
+        if ( f.WriteBuffer( buffer.Get(), paddedSize ) != paddedSize )
+        {
+            FLOG_ERROR( "Failed to write archive '%s'", archiveFileName.Get() );
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// GetSymbols
+//------------------------------------------------------------------------------
+/*static*/ bool ArchiveWriter::GetSymbols( const void * data, size_t dataSize, Array< AString > & outSymbols )
+{
+    const uint8_t * bytes = static_cast< const uint8_t * >( data );
+
+    // ELF identification
+    if ( ( dataSize < 16 ) || ( memcmp( bytes, "\x7f" "ELF", 4 ) != 0 ) )
+    {
+        return false; // Not an ELF file
+    }
+    const bool is64 = ( bytes[ 4 ] == 2 );
+    if ( ( ( bytes[ 4 ] != 1 ) && ( bytes[ 4 ] != 2 ) ) ||
+         ( bytes[ 5 ] != 1 ) ) // Only little-endian is supported
+    {
+        return false;
+    }
+
+    // Section headers
+    uint64_t sectionHeadersOffset = 0;
+    uint16_t sectionHeaderSize = 0;
+    uint16_t numSections16 = 0;
+    if ( is64 )
+    {
+        if ( !ReadELF( bytes, dataSize, 0x28, sectionHeadersOffset ) ||
+             !ReadELF( bytes, dataSize, 0x3A, sectionHeaderSize ) ||
+             !ReadELF( bytes, dataSize, 0x3C, numSections16 ) )
+        {
+            return false;
+        }
+    }
+    else
+    {
+        uint32_t offset32 = 0;
+        if ( !ReadELF( bytes, dataSize, 0x20, offset32 ) ||
+             !ReadELF( bytes, dataSize, 0x2E, sectionHeaderSize ) ||
+             !ReadELF( bytes, dataSize, 0x30, numSections16 ) )
+        {
+            return false;
+        }
+        sectionHeadersOffset = offset32;
+    }
+
+    // Read the offset, size, link and entry size of a section
+    auto readSection = [ & ]( uint64_t index, uint64_t & outOffset, uint64_t & outSize, uint32_t & outLink, uint64_t & outEntrySize ) -> bool
+    {
+        const uint64_t base = ( sectionHeadersOffset + ( index * sectionHeaderSize ) );
+        if ( is64 )
+        {
+            return ReadELF( bytes, dataSize, base + 0x18, outOffset ) &&
+                   ReadELF( bytes, dataSize, base + 0x20, outSize ) &&
+                   ReadELF( bytes, dataSize, base + 0x28, outLink ) &&
+                   ReadELF( bytes, dataSize, base + 0x38, outEntrySize );
+        }
+        uint32_t offset32 = 0;
+        uint32_t size32 = 0;
+        uint32_t entrySize32 = 0;
+        const bool ok = ReadELF( bytes, dataSize, base + 0x10, offset32 ) &&
+                        ReadELF( bytes, dataSize, base + 0x14, size32 ) &&
+                        ReadELF( bytes, dataSize, base + 0x18, outLink ) &&
+                        ReadELF( bytes, dataSize, base + 0x24, entrySize32 );
+        outOffset = offset32;
+        outSize = size32;
+        outEntrySize = entrySize32;
+        return ok;
+    };
+
+    // Large section counts are stored in the first section header
+    uint64_t numSections = numSections16;
+    if ( ( numSections == 0 ) && ( sectionHeadersOffset != 0 ) )
+    {
+        uint64_t unusedOffset, unusedEntrySize;
+        uint32_t unusedLink;
+        if ( !readSection( 0, unusedOffset, numSections, unusedLink, unusedEntrySize ) )
+        {
+            return false;
+        }
+    }
+
+    for ( uint64_t i = 0; i < numSections; ++i )
+    {
+        uint32_t sectionType = 0;
+        if ( !ReadELF( bytes, dataSize, sectionHeadersOffset + ( i * sectionHeaderSize ) + 4, sectionType ) )
+        {
+            return false;
+        }
+        if ( sectionType != 2 ) // SHT_SYMTAB
+        {
+            continue;
+        }
+
+        // Symbol table and associated string table
+        uint64_t symbolsOffset, symbolsSize, symbolSize, stringsOffset, stringsSize, unusedEntrySize;
+        uint32_t stringsSection, unusedLink;
+        if ( !readSection( i, symbolsOffset, symbolsSize, stringsSection, symbolSize ) ||
+             !readSection( stringsSection, stringsOffset, stringsSize, unusedLink, unusedEntrySize ) ||
+             ( symbolSize == 0 ) ||
+             ( stringsOffset > dataSize ) ||
+             ( ( dataSize - stringsOffset ) < stringsSize ) )
+        {
+            return false;
+        }
+
+        // First symbol is always undefined
+        const uint64_t numSymbols = ( symbolsSize / symbolSize );
+        for ( uint64_t j = 1; j < numSymbols; ++j )
+        {
+            const uint64_t symbol = ( symbolsOffset + ( j * symbolSize ) );
+            uint32_t nameOffset = 0;
+            uint8_t info = 0;
+            uint16_t sectionIndex = 0;
+            if ( !ReadELF( bytes, dataSize, symbol, nameOffset ) ||
+                 !ReadELF( bytes, dataSize, symbol + ( is64 ? 4 : 12 ), info ) ||
+                 !ReadELF( bytes, dataSize, symbol + ( is64 ? 6 : 14 ), sectionIndex ) )
+            {
+                return false;
+            }
+
+            // Global, weak or unique symbols defined by this object
+            const uint8_t binding = ( info >> 4 );
+            if ( ( ( binding != 1 ) && ( binding != 2 ) && ( binding != 10 ) ) || // STB_GLOBAL, STB_WEAK, STB_GNU_UNIQUE
+                 ( sectionIndex == 0 ) ) // SHN_UNDEF
+            {
+                continue;
+            }
+
+            // Name must be terminated within the string table
+            if ( nameOffset >= stringsSize )
+            {
+                return false;
+            }
+            const char * name = reinterpret_cast< const char * >( bytes + stringsOffset + nameOffset );
+            const char * stringsEnd = reinterpret_cast< const char * >( bytes + stringsOffset + stringsSize );
+            const char * nameEnd = static_cast< const char * >( memchr( name, 0, (size_t)( stringsEnd - name ) ) );
+            if ( nameEnd == nullptr )
+            {
+                return false;
+            }
+            outSymbols.EmplaceBack( name, nameEnd );
+        }
+    }
+
+    return true;
+}
+
+// GetSymbols
+//------------------------------------------------------------------------------
+/*static*/ bool ArchiveWriter::GetSymbols( const AString & fileName, Array< AString > & outSymbols )
+{
+    FileStream f;
+    if ( f.Open( fileName.Get(), FileStream::READ_ONLY ) == false )
+    {
+        return false;
+    }
+    const size_t fileSize = (size_t)f.GetFileSize();
+    UniquePtr< char, FreeDeletor > mem( (char *)ALLOC( fileSize ? fileSize : 1 ) );
+    if ( f.ReadBuffer( mem.Get(), fileSize ) != fileSize )
+    {
+        return false;
+    }
+    if ( GetSymbols( mem.Get(), fileSize, outSymbols ) == false )
+    {
+        outSymbols.Clear(); // Not an object file we understand
+    }
+    return true;
+}
+
+// WriteHeader
+//------------------------------------------------------------------------------
+/*static*/ void ArchiveWriter::WriteHeader( IOStream & stream, HeaderType type, const char * name, uint64_t size )
+{
+    // Timestamps, owners and modes are fixed so output is deterministic
+    const char * const fields = ( type == HEADER_NAME_TABLE ) ? "" : "0";
+    char header[ kHeaderSize + 1 ];
+    snprintf( header, sizeof( header ), "%-16s%-12s%-6s%-6s%-8s%-10" PRIu64 "`\n",
+              name,
+              fields,                                       // date
+              fields,                                       // uid
+              fields,                                       // gid
+              ( type == HEADER_MEMBER ) ? "644" : fields,   // mode
+              size );
+    ASSERT( AString::StrLen( header ) == kHeaderSize );
+    stream.WriteBuffer( header, kHeaderSize );
+}
+
+//------------------------------------------------------------------------------
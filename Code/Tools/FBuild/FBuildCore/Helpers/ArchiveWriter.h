@@ -0,0 +1,61 @@
+// ArchiveWriter - Create static libraries in the GNU ar format
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Core/Containers/Array.h"
+#include "Core/Env/Types.h"
+#include "Core/Strings/AString.h"
+
+// Forward Declarations
+//------------------------------------------------------------------------------
+class IOStream;
+
+// ArchiveWriter
+//  - Writes archives in the GNU (SysV) ar format, as used by GNU and BSD ar
+//    for ELF targets, with a symbol table so no separate ranlib step is needed
+//  - Thin archives reference member files instead of containing them
+//  - Symbols must be provided for each member (see GetSymbols)
+//------------------------------------------------------------------------------
+class ArchiveWriter
+{
+public:
+    explicit ArchiveWriter( bool thin );
+    ~ArchiveWriter();
+
+    // Members are stored in the order added. Symbols must remain valid until
+    // the archive is written.
+    void AddMember( const AString & fileName, uint64_t size, const Array< AString > & symbols );
+
+    // Write the archive, reading member contents (unless thin)
+    bool Write( const AString & archiveFileName ) const;
+
+    // Obtain the global symbols defined by an object file. Only ELF files are
+    // supported, and other files are considered to define no symbols.
+    //  - returns false if the data is not a valid ELF file
+    static bool GetSymbols( const void * data, size_t dataSize, Array< AString > & outSymbols );
+    //  - returns false if the file could not be read
+    static bool GetSymbols( const AString & fileName, Array< AString > & outSymbols );
+
+private:
+    struct Member
+    {
+        AString                 m_FileName;
+        uint64_t                m_Size;
+        const Array< AString > * m_Symbols;
+    };
+
+    enum HeaderType : uint8_t
+    {
+        HEADER_SYMBOL_TABLE,
+        HEADER_NAME_TABLE,
+        HEADER_MEMBER,
+    };
+    static void WriteHeader( IOStream & stream, HeaderType type, const char * name, uint64_t size );
+
+    bool            m_Thin;
+    Array< Member > m_Members;
+};
+
+//------------------------------------------------------------------------------
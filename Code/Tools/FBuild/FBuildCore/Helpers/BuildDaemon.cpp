@@ -0,0 +1,572 @@
+// BuildDaemon - Service builds from a resident process
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "BuildDaemon.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/FBuild.h"
+#include "Tools/FBuild/FBuildCore/FLog.h"
+#include "Tools/FBuild/FBuildCore/Helpers/BuildProfiler.h"
+#include "Tools/FBuild/FBuildCore/Helpers/BuildTrace.h"
+
+// Core
+#include "Core/FileIO/ConstMemoryStream.h"
+#include "Core/FileIO/FileIO.h"
+#include "Core/FileIO/FileStream.h"
+#include "Core/FileIO/MemoryStream.h"
+#include "Core/FileIO/PathUtils.h"
+#include "Core/Math/Random.h"
+#include "Core/Process/Atomic.h"
+#include "Core/Profile/Profile.h"
+#include "Core/Strings/AStackString.h"
+#include "Core/Tracing/Tracing.h"
+
+// system
+#include <string.h> // for memcpy
+
+// Static Data
+//------------------------------------------------------------------------------
+/*static*/ BuildDaemon * BuildDaemon::s_Instance = nullptr;
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+BuildDaemon::BuildDaemon( const FBuildOptions & options )
+    : TCPConnectionPool()
+    , m_Options( options )
+    , m_PendingRequests( 4 )
+{
+    ASSERT( s_Instance == nullptr );
+    s_Instance = this;
+
+    // As per requests (see ProcessRequest)
+    m_Options.m_SaveDBOnCompletion = true;
+    m_Options.m_ShowProgress = false;
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+BuildDaemon::~BuildDaemon()
+{
+    ShutdownAllConnections();
+
+    for ( Request * request : m_PendingRequests )
+    {
+        FDELETE request;
+    }
+    FDELETE m_FBuild;
+
+    ASSERT( s_Instance == this );
+    s_Instance = nullptr;
+}
+
+// Run
+//------------------------------------------------------------------------------
+bool BuildDaemon::Run()
+{
+    // Only accept requests from the user running the daemon
+    if ( CreateToken() == false )
+    {
+        OUTPUT( "FBuild: Error: Failed to create daemon token '%s'\n", m_TokenFile.Get() );
+        return false;
+    }
+
+    // Only accept connections from this machine
+    const uint16_t port = m_Options.GetDaemonPort();
+    if ( Listen( port, true ) == false )
+    {
+        OUTPUT( "FBuild: Error: Failed to listen for daemon requests on port %u\n", (uint32_t)port );
+        FileIO::FileDelete( m_TokenFile.Get() );
+        return false;
+    }
+
+    // Prepare the graph so the first request is fast. If this fails, it will
+    // be attempted again (reporting errors to the client) by the first request
+    CreateFBuild( m_Options );
+
+    OUTPUT( "FBuild: Daemon serving '%s' (port %u). Press Ctrl-C while idle to stop.\n", m_Options.GetWorkingDir().Get(), (uint32_t)port );
+
+    Tracing::AddCallbackOutput( &OutputCallback );
+    while ( ( AtomicLoadRelaxed( &m_StopRequested ) == false ) && ( FBuild::GetStopBuild() == false ) )
+    {
+        if ( m_RequestAvailable.Wait( 500 ) == false )
+        {
+            continue;
+        }
+
+        Request * request = nullptr;
+        {
+            MutexHolder mh( m_Mutex );
+            if ( m_PendingRequests.IsEmpty() )
+            {
+                continue; // Client disconnected before request was processed
+            }
+            request = m_PendingRequests[ 0 ];
+            m_PendingRequests.PopFront();
+            m_ActiveConnection = request->m_Connection;
+        }
+
+        const Result result = ProcessRequest( request->m_WorkingDir, request->m_Args );
+        FDELETE request;
+
+        // A failed or cancelled build should not stop the daemon
+        FBuild::ResetStopBuild();
+
+        // Notify client of completion
+        {
+            MutexHolder mh( m_Mutex );
+            if ( m_ActiveConnection )
+            {
+                MemoryStream ms;
+                ms.Write( static_cast< uint8_t >( MSG_RESULT ) );
+                ms.Write( static_cast< uint32_t >( result ) );
+                Send( m_ActiveConnection, ms.GetData(), ms.GetSize() );
+                m_ActiveConnection = nullptr;
+            }
+        }
+    }
+    Tracing::RemoveCallbackOutput( &OutputCallback );
+
+    ShutdownAllConnections();
+    FileIO::FileDelete( m_TokenFile.Get() );
+    return true;
+}
+
+// ProcessRequest
+//------------------------------------------------------------------------------
+BuildDaemon::Result BuildDaemon::ProcessRequest( const AString & workingDir, const Array< AString > & args )
+{
+    PROFILE_FUNCTION;
+
+    // A daemon only serves the working dir it was started in
+    if ( workingDir != m_Options.GetWorkingDir() )
+    {
+        OUTPUT( "FBuild: Daemon is serving '%s', not '%s'\n", m_Options.GetWorkingDir().Get(), workingDir.Get() );
+        return RESULT_WRONG_WORKING_DIR;
+    }
+
+    // Process args as the client would have
+    Array< char * > argv( args.GetSize() );
+    for ( const AString & arg : args )
+    {
+        argv.Append( const_cast< char * >( arg.Get() ) );
+    }
+    FBuildOptions options;
+    options.SetWorkingDir( workingDir );
+    options.m_SaveDBOnCompletion = true; // Override default (as per Main)
+    switch ( options.ProcessCommandLine( static_cast< int >( argv.GetSize() ), argv.begin() ) )
+    {
+        case FBuildOptions::OPTIONS_OK:             break;
+        case FBuildOptions::OPTIONS_OK_AND_QUIT:    return RESULT_OK;
+        case FBuildOptions::OPTIONS_ERROR:          return RESULT_BAD_ARGS;
+    }
+    options.m_ShowProgress = false; // Progress bar is written directly to the console
+
+    // Determine if the resident graph can be re-used
+    if ( m_FBuild )
+    {
+        bool recreate = false;
+        if ( AreOptionsCompatible( m_Options, options ) == false )
+        {
+            FLOG_VERBOSE( "Daemon: Options differ from previous build" );
+            recreate = true;
+        }
+        else if ( m_FBuild->IsDependencyGraphOutOfDate() )
+        {
+            recreate = true;
+        }
+        else if ( options.m_Profile )
+        {
+            recreate = true; // Profile must only contain this build
+        }
+
+        if ( recreate )
+        {
+            FDELETE m_FBuild;
+            m_FBuild = nullptr;
+        }
+        else
+        {
+            m_FBuild->PrepareForNextBuild();
+        }
+    }
+    if ( ( m_FBuild == nullptr ) && ( CreateFBuild( options ) == false ) )
+    {
+        return RESULT_ERROR_LOADING_BFF;
+    }
+
+    // Handle the request like Main
+    bool result = false;
+    if ( options.m_DisplayTargetList )
+    {
+        m_FBuild->DisplayTargetList( options.m_ShowHiddenTargets );
+        result = true; // DisplayTargetList cannot fail
+    }
+    else if ( options.m_DisplayDependencyDB )
+    {
+        result = m_FBuild->DisplayDependencyDB( options.m_Targets );
+    }
+    else if ( options.m_GenerateDotGraph )
+    {
+        result = m_FBuild->GenerateDotGraph( options.m_Targets, options.m_GenerateDotGraphFull );
+    }
+    else if ( options.m_GenerateCompilationDatabase )
+    {
+        result = m_FBuild->GenerateCompilationDatabase( options.m_Targets );
+    }
+    else if ( options.m_HeaderImpactReportType.IsEmpty() == false )
+    {
+        result = m_FBuild->GenerateHeaderImpactReport( options.m_HeaderImpactReportType );
+    }
+    else if ( options.m_CacheInfo )
+    {
+        result = m_FBuild->CacheOutputInfo();
+    }
+    else if ( options.m_CacheTrim )
+    {
+        result = m_FBuild->CacheTrim();
+    }
+    else
+    {
+        result = m_FBuild->Build( options.m_Targets );
+    }
+
+    if ( options.m_Profile )
+    {
+        if ( BuildProfiler::Get().SaveJSON( options, "fbuild_profile.json" ) == false )
+        {
+            result = false;
+        }
+    }
+    if ( options.m_Trace )
+    {
+        if ( BuildTrace::Get().Save( options, "fbuild.trace" ) == false )
+        {
+            result = false;
+        }
+    }
+
+    return result ? RESULT_OK : RESULT_BUILD_FAILED;
+}
+
+// OnReceive
+//------------------------------------------------------------------------------
+/*virtual*/ void BuildDaemon::OnReceive( const ConnectionInfo * connection, void * data, uint32_t size, bool & /*keepMemory*/ )
+{
+    ConstMemoryStream ms( data, size );
+    uint8_t msgType = 0;
+    uint32_t version = 0;
+    if ( ( ms.Read( msgType ) == false ) || ( msgType != MSG_REQUEST ) ||
+         ( ms.Read( version ) == false ) || ( version != DAEMON_PROTOCOL_VERSION ) )
+    {
+        Disconnect( connection ); // Incompatible client
+        return;
+    }
+
+    // Client must prove it can read the token file
+    AStackString<> token;
+    if ( ( ms.Read( token ) == false ) || ( token != m_Token ) )
+    {
+        MemoryStream response;
+        response.Write( static_cast< uint8_t >( MSG_RESULT ) );
+        response.Write( static_cast< uint32_t >( RESULT_NOT_AUTHORIZED ) );
+        Send( connection, response.GetData(), response.GetSize() );
+        return;
+    }
+
+    Request * request = FNEW( Request );
+    request->m_Connection = connection;
+    if ( ( ms.Read( request->m_WorkingDir ) == false ) ||
+         ( ms.Read( request->m_Args ) == false ) )
+    {
+        FDELETE request;
+        Disconnect( connection );
+        return;
+    }
+
+    {
+        MutexHolder mh( m_Mutex );
+        m_PendingRequests.Append( request );
+    }
+    m_RequestAvailable.Signal();
+}
+
+// OnDisconnected
+//------------------------------------------------------------------------------
+/*virtual*/ void BuildDaemon::OnDisconnected( const ConnectionInfo * connection )
+{
+    MutexHolder mh( m_Mutex );
+
+    // Client went away (i.e. Ctrl-C) so stop building for it
+    if ( m_ActiveConnection == connection )
+    {
+        m_ActiveConnection = nullptr;
+        FBuild::AbortBuild();
+    }
+
+    // Discard any requests which have not been started
+    for ( size_t i = m_PendingRequests.GetSize(); i > 0; --i )
+    {
+        if ( m_PendingRequests[ i - 1 ]->m_Connection == connection )
+        {
+            FDELETE m_PendingRequests[ i - 1 ];
+            m_PendingRequests.EraseIndex( i - 1 );
+        }
+    }
+}
+
+// GetTokenFileName
+//------------------------------------------------------------------------------
+/*static*/ void BuildDaemon::GetTokenFileName( const FBuildOptions & options, AString & outFileName )
+{
+    AStackString<> dbFile;
+    FBuild::GetDependencyGraphFileName( options, dbFile );
+    if ( PathUtils::IsFullPath( dbFile ) )
+    {
+        outFileName = dbFile;
+    }
+    else
+    {
+        outFileName = options.GetWorkingDir();
+        PathUtils::EnsureTrailingSlash( outFileName );
+        outFileName += dbFile;
+    }
+    outFileName += ".daemontoken";
+}
+
+// CreateToken
+//------------------------------------------------------------------------------
+bool BuildDaemon::CreateToken()
+{
+    GetTokenFileName( m_Options, m_TokenFile );
+
+    uint8_t bytes[ 16 ];
+    if ( Random::GetSecureRandomBytes( bytes, sizeof( bytes ) ) == false )
+    {
+        return false;
+    }
+    m_Token.Clear();
+    for ( const uint8_t byte : bytes )
+    {
+        m_Token.AppendFormat( "%02x", (uint32_t)byte );
+    }
+
+    // Replace any file left by a previous daemon, as permissions only apply
+    // to a newly created file on some platforms
+    FileIO::FileDelete( m_TokenFile.Get() );
+    FileStream f;
+    if ( ( FileIO::EnsurePathExistsForFile( m_TokenFile ) == false ) ||
+         ( f.Open( m_TokenFile.Get(), FileStream::WRITE_ONLY | FileStream::OWNER_ONLY ) == false ) )
+    {
+        return false;
+    }
+    return ( f.WriteBuffer( m_Token.Get(), m_Token.GetLength() ) == m_Token.GetLength() );
+}
+
+// CreateFBuild
+//------------------------------------------------------------------------------
+bool BuildDaemon::CreateFBuild( const FBuildOptions & options )
+{
+    ASSERT( m_FBuild == nullptr );
+
+    if ( &options != &m_Options )
+    {
+        // Cached stamps of input files are hashes or times depending on mode
+        if ( options.m_UseContentHash != m_Options.m_UseContentHash )
+        {
+            m_FileTimeCache.Clear();
+        }
+        m_Options = options;
+    }
+    m_FBuild = FNEW( FBuild( m_Options ) );
+    if ( m_FBuild->Initialize() == false )
+    {
+        FDELETE m_FBuild;
+        m_FBuild = nullptr;
+        return false;
+    }
+    m_FBuild->SetFileTimeCache( &m_FileTimeCache );
+    return true;
+}
+
+// AreOptionsCompatible
+//  - Can a build with options "b" re-use an FBuild created with options "a"?
+//------------------------------------------------------------------------------
+/*static*/ bool BuildDaemon::AreOptionsCompatible( const FBuildOptions & a, const FBuildOptions & b )
+{
+    #define CHECK_OPTION( option )      \
+        if ( a.option != b.option )     \
+        {                               \
+            return false;               \
+        }
+    FBUILD_OPTIONS_AFFECTING_BUILD( CHECK_OPTION )
+    #undef CHECK_OPTION
+    return true;
+}
+
+// OutputCallback
+//------------------------------------------------------------------------------
+/*static*/ bool BuildDaemon::OutputCallback( const char * message )
+{
+    if ( s_Instance )
+    {
+        s_Instance->SendOutput( message );
+    }
+    return true; // Output is also shown by the daemon
+}
+
+// SendOutput
+//------------------------------------------------------------------------------
+void BuildDaemon::SendOutput( const char * message )
+{
+    MutexHolder mh( m_Mutex );
+    if ( m_ActiveConnection == nullptr )
+    {
+        return;
+    }
+
+    MemoryStream ms;
+    ms.Write( static_cast< uint8_t >( MSG_OUTPUT ) );
+    ms.WriteBuffer( message, AString::StrLen( message ) );
+    Send( m_ActiveConnection, ms.GetData(), ms.GetSize() );
+}
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+BuildDaemonClient::BuildDaemonClient() = default;
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+BuildDaemonClient::~BuildDaemonClient()
+{
+    ShutdownAllConnections();
+}
+
+// Build
+//------------------------------------------------------------------------------
+bool BuildDaemonClient::Build( const FBuildOptions & options, const Array< AString > & args, BuildDaemon::Result & outResult )
+{
+    PROFILE_FUNCTION;
+
+    // Only a daemon run by the same user can be used
+    AStackString<> tokenFile;
+    BuildDaemon::GetTokenFileName( options, tokenFile );
+    AStackString<> token;
+    {
+        FileStream f;
+        if ( f.Open( tokenFile.Get(), FileStream::READ_ONLY ) == false )
+        {
+            return false; // No daemon running
+        }
+        const uint64_t tokenSize = f.GetFileSize();
+        if ( tokenSize > 256 ) // Sanity check
+        {
+            return false;
+        }
+        token.SetLength( (uint32_t)tokenSize );
+        if ( f.ReadBuffer( token.Get(), tokenSize ) != tokenSize )
+        {
+            return false;
+        }
+    }
+
+    const ConnectionInfo * connection = Connect( AStackString<>( "127.0.0.1" ), options.GetDaemonPort() );
+    if ( connection == nullptr )
+    {
+        return false; // No daemon running
+    }
+
+    MemoryStream ms;
+    ms.Write( static_cast< uint8_t >( BuildDaemon::MSG_REQUEST ) );
+    ms.Write( static_cast< uint32_t >( BuildDaemon::DAEMON_PROTOCOL_VERSION ) );
+    ms.Write( token );
+    ms.Write( options.GetWorkingDir() );
+    ms.Write( args );
+    if ( Send( connection, ms.GetData(), ms.GetSize() ) == false )
+    {
+        ShutdownAllConnections();
+        return false;
+    }
+
+    // Wait for the daemon to finish. Disconnecting cancels the build.
+    while ( m_Completed.Wait( 100 ) == false )
+    {
+        if ( FBuild::GetStopBuild() )
+        {
+            break;
+        }
+    }
+    ShutdownAllConnections();
+
+    if ( m_ReceivedResult == false )
+    {
+        if ( FBuild::GetStopBuild() == false )
+        {
+            OUTPUT( "FBuild: Error: Lost connection to daemon\n" );
+        }
+        outResult = BuildDaemon::RESULT_BUILD_FAILED;
+        return true;
+    }
+
+    // A daemon for another working dir (or with another token) is using our port
+    if ( ( m_Result == BuildDaemon::RESULT_WRONG_WORKING_DIR ) ||
+         ( m_Result == BuildDaemon::RESULT_NOT_AUTHORIZED ) )
+    {
+        return false;
+    }
+
+    outResult = m_Result;
+    return true;
+}
+
+// OnOutput
+//------------------------------------------------------------------------------
+/*virtual*/ void BuildDaemonClient::OnOutput( const char * message )
+{
+    Tracing::Output( message );
+}
+
+// OnReceive
+//------------------------------------------------------------------------------
+/*virtual*/ void BuildDaemonClient::OnReceive( const ConnectionInfo * /*connection*/, void * data, uint32_t size, bool & /*keepMemory*/ )
+{
+    if ( size < 1 )
+    {
+        return;
+    }
+
+    const char * payload = static_cast< const char * >( data ) + 1;
+    const uint32_t payloadSize = ( size - 1 );
+    switch ( static_cast< const uint8_t * >( data )[ 0 ] )
+    {
+        case BuildDaemon::MSG_OUTPUT:
+        {
+            const AString message( payload, payload + payloadSize );
+            OnOutput( message.Get() );
+            break;
+        }
+        case BuildDaemon::MSG_RESULT:
+        {
+            if ( payloadSize >= sizeof( uint32_t ) )
+            {
+                uint32_t result;
+                memcpy( &result, payload, sizeof( uint32_t ) );
+                m_Result = static_cast< BuildDaemon::Result >( result );
+                m_ReceivedResult = true;
+            }
+            m_Completed.Signal();
+            break;
+        }
+        default: break; // Ignore unknown messages
+    }
+}
+
+// OnDisconnected
+//------------------------------------------------------------------------------
+/*virtual*/ void BuildDaemonClient::OnDisconnected( const ConnectionInfo * /*connection*/ )
+{
+    m_Completed.Signal();
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,124 @@
+// BuildDaemon - Service builds from a resident process
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Tools/FBuild/FBuildCore/FBuildOptions.h"
+#include "Tools/FBuild/FBuildCore/Helpers/FileTimeCache.h"
+
+#include "Core/Containers/Array.h"
+#include "Core/Network/TCPConnectionPool.h"
+#include "Core/Process/Atomic.h"
+#include "Core/Process/Mutex.h"
+#include "Core/Process/Semaphore.h"
+#include "Core/Strings/AString.h"
+
+// Forward Declarations
+//------------------------------------------------------------------------------
+class FBuild;
+
+// BuildDaemon
+//  - Started with -daemon, keeps the dependency graph and file timestamps in
+//    memory between builds
+//  - Builds are requested by BuildDaemonClient (-usedaemon) over a local
+//    connection, with output forwarded back to the client
+//  - Requests must include a random token, which the daemon stores in a file
+//    (next to the DB) that only the user running the daemon can read
+//  - The graph is re-created if the BFF changes or a build requires different
+//    options
+//------------------------------------------------------------------------------
+class BuildDaemon : public TCPConnectionPool
+{
+public:
+    explicit BuildDaemon( const FBuildOptions & options );
+    virtual ~BuildDaemon() override;
+
+    enum Result : uint32_t
+    {
+        RESULT_OK,
+        RESULT_BUILD_FAILED,
+        RESULT_BAD_ARGS,
+        RESULT_ERROR_LOADING_BFF,
+        RESULT_WRONG_WORKING_DIR,
+        RESULT_NOT_AUTHORIZED,
+    };
+
+    // Service requests until interrupted (Ctrl-C while idle) or stopped
+    bool Run();
+    void Stop() { AtomicStoreRelaxed( &m_StopRequested, true ); }
+
+    // Perform a build in the resident FBuild, as if invoked with the given args
+    Result ProcessRequest( const AString & workingDir, const Array< AString > & args );
+
+    enum MessageType : uint8_t
+    {
+        MSG_REQUEST = 1,    // Daemon <- Client : Token, working dir and args
+        MSG_OUTPUT  = 2,    // Daemon -> Client : Build output
+        MSG_RESULT  = 3,    // Daemon -> Client : Build has completed
+    };
+    enum : uint32_t { DAEMON_PROTOCOL_VERSION = 2 };
+
+    // File containing the token required by a daemon for the given options
+    static void GetTokenFileName( const FBuildOptions & options, AString & outFileName );
+
+protected:
+    // TCPConnectionPool interface
+    virtual void OnReceive( const ConnectionInfo * connection, void * data, uint32_t size, bool & keepMemory ) override;
+    virtual void OnDisconnected( const ConnectionInfo * connection ) override;
+
+    bool CreateToken();
+    bool CreateFBuild( const FBuildOptions & options );
+    static bool AreOptionsCompatible( const FBuildOptions & a, const FBuildOptions & b );
+
+    static bool OutputCallback( const char * message );
+    void SendOutput( const char * message );
+
+    struct Request
+    {
+        const ConnectionInfo *  m_Connection;
+        AString                 m_WorkingDir;
+        Array< AString >        m_Args;
+    };
+
+    FBuildOptions               m_Options;          // Options used to create the current FBuild
+    FBuild *                    m_FBuild = nullptr;
+    FileTimeCache               m_FileTimeCache;
+    bool                        m_StopRequested = false;
+    AString                     m_Token;            // Required in requests
+    AString                     m_TokenFile;
+
+    Mutex                       m_Mutex;            // Protects members below
+    Array< Request * >          m_PendingRequests;
+    const ConnectionInfo *      m_ActiveConnection = nullptr; // Client of request being processed
+    Semaphore                   m_RequestAvailable;
+
+    static BuildDaemon *        s_Instance;
+};
+
+// BuildDaemonClient
+//  - Forwards a build to a BuildDaemon running for the same working dir
+//------------------------------------------------------------------------------
+class BuildDaemonClient : public TCPConnectionPool
+{
+public:
+    BuildDaemonClient();
+    virtual ~BuildDaemonClient() override;
+
+    // Returns false if no daemon is available
+    bool Build( const FBuildOptions & options, const Array< AString > & args, BuildDaemon::Result & outResult );
+
+protected:
+    // Output forwarded from the daemon
+    virtual void OnOutput( const char * message );
+
+    // TCPConnectionPool interface
+    virtual void OnReceive( const ConnectionInfo * connection, void * data, uint32_t size, bool & keepMemory ) override;
+    virtual void OnDisconnected( const ConnectionInfo * connection ) override;
+
+    bool                    m_ReceivedResult = false;
+    BuildDaemon::Result     m_Result = BuildDaemon::RESULT_BUILD_FAILED;
+    Semaphore               m_Completed;
+};
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,566 @@
+// BuildHistory - Compact record of recent builds, for build-over-build comparison
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "BuildHistory.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/Graph/Dependencies.h"
+#include "Tools/FBuild/FBuildCore/Graph/Node.h"
+#include "Tools/FBuild/FBuildCore/Graph/NodeGraph.h"
+#include "Tools/FBuild/FBuildCore/Helpers/FBuildStats.h"
+
+// Core
+#include "Core/FileIO/FileIO.h"
+#include "Core/FileIO/FileStream.h"
+#include "Core/Math/Conversions.h"
+#include "Core/Math/xxHash.h"
+#include "Core/Profile/Profile.h"
+#include "Core/Strings/AStackString.h"
+#include "Core/Strings/AString.h"
+
+// system
+#include <time.h>
+
+// Defines
+//------------------------------------------------------------------------------
+#define BUILD_HISTORY_MAGIC     ( 'F' | ( 'B' << 8 ) | ( 'H' << 16 ) | ( 'S' << 24 ) )
+#define BUILD_HISTORY_VERSION   ( 1 )
+
+namespace
+{
+    // Node flags which are recorded
+    const Node::StatsFlag kRecordedFlags[] =
+    {
+        Node::STATS_BUILT,
+        Node::STATS_CACHE_HIT,
+        Node::STATS_CACHE_MISS,
+        Node::STATS_CACHE_STORE,
+        Node::STATS_BUILT_REMOTE,
+        Node::STATS_FAILED,
+    };
+
+    // Build pass tags used to visit each header once
+    enum : uint32_t
+    {
+        TAG_HEADER_NOT_SEEN     = 0,
+        TAG_HEADER_SEEN         = 1,
+        TAG_HEADER_CHANGED      = 2, // Index of header in list of changed headers is added
+    };
+
+    enum : uint32_t { NUM_REGRESSIONS_TO_DISPLAY = 20 };
+    enum : uint32_t { NUM_HEADERS_TO_DISPLAY = 20 };
+
+    // A node which took longer than in the previous build
+    struct Regression
+    {
+        const Node *    m_Node;
+        uint32_t        m_BeforeMS;
+        uint32_t        m_AfterMS;
+        uint16_t        m_BeforeFlags;
+        uint16_t        m_AfterFlags;
+        bool            m_InPrevious;
+
+        int64_t GetChange() const { return ( (int64_t)m_AfterMS - (int64_t)m_BeforeMS ); }
+    };
+
+    // A header which changed since the previous build and the cost of the
+    // rebuilt objects which use it
+    struct HeaderImpact
+    {
+        const Node *    m_Header;
+        uint64_t        m_TimeMS;
+        uint32_t        m_NumObjects;
+
+        bool operator < ( const HeaderImpact & other ) const { return ( m_TimeMS > other.m_TimeMS ); }
+    };
+
+    // Totals for a build
+    struct Totals
+    {
+        uint32_t        m_NumBuilt      = 0;
+        uint32_t        m_NumCacheHits  = 0;
+        uint32_t        m_NumCacheMisses= 0;
+        uint32_t        m_NumRemote     = 0;
+        uint32_t        m_NumFailed     = 0;
+        uint64_t        m_TimeMS[ Node::NUM_NODE_TYPES ] = {};
+
+        void Accumulate( uint8_t type, uint32_t timeMS, uint16_t flags )
+        {
+            m_NumBuilt += ( flags & Node::STATS_BUILT ) ? 1 : 0;
+            m_NumCacheHits += ( flags & Node::STATS_CACHE_HIT ) ? 1 : 0;
+            m_NumCacheMisses += ( flags & Node::STATS_CACHE_MISS ) ? 1 : 0;
+            m_NumRemote += ( flags & Node::STATS_BUILT_REMOTE ) ? 1 : 0;
+            m_NumFailed += ( flags & Node::STATS_FAILED ) ? 1 : 0;
+            if ( type < Node::NUM_NODE_TYPES )
+            {
+                m_TimeMS[ type ] += timeMS;
+            }
+        }
+    };
+
+    // Keep the largest regressions in descending order
+    void AddRegression( Array< Regression > & regressions, const Regression & regression )
+    {
+        const int64_t change = regression.GetChange();
+        if ( ( regressions.GetSize() == NUM_REGRESSIONS_TO_DISPLAY ) &&
+             ( change <= regressions.Top().GetChange() ) )
+        {
+            return; // Not one of the largest
+        }
+
+        if ( regressions.GetSize() == NUM_REGRESSIONS_TO_DISPLAY )
+        {
+            regressions.Pop();
+        }
+        regressions.Append( regression );
+        for ( size_t i = ( regressions.GetSize() - 1 ); ( i > 0 ) && ( regressions[ i - 1 ].GetChange() < change ); --i )
+        {
+            const Regression tmp = regressions[ i - 1 ];
+            regressions[ i - 1 ] = regressions[ i ];
+            regressions[ i ] = tmp;
+        }
+    }
+
+    // Records are stored directly, preceded by their count
+    template < class T >
+    bool ReadRecords( FileStream & f, Array< T > & outRecords )
+    {
+        uint32_t num = 0;
+        if ( ( f.Read( num ) == false ) ||
+             ( ( (uint64_t)num * sizeof( T ) ) > ( f.GetFileSize() - f.Tell() ) ) ) // Corrupt count
+        {
+            return false;
+        }
+        outRecords.SetSize( num );
+        return ( ( num == 0 ) || ( f.ReadBuffer( outRecords.Begin(), num * sizeof( T ) ) == ( num * sizeof( T ) ) ) );
+    }
+
+    template < class T >
+    bool WriteRecords( FileStream & f, const Array< T > & records )
+    {
+        const uint32_t num = (uint32_t)records.GetSize();
+        return ( f.Write( num ) &&
+                 ( ( num == 0 ) || ( f.WriteBuffer( records.Begin(), num * sizeof( T ) ) == ( num * sizeof( T ) ) ) ) );
+    }
+
+    void DescribeFlags( uint16_t flags, AString & outDescription )
+    {
+        outDescription.Clear();
+        if ( flags & Node::STATS_FAILED )           { outDescription += "failed"; }
+        else if ( flags & Node::STATS_CACHE_HIT )   { outDescription += "cache hit"; }
+        else if ( flags & Node::STATS_BUILT_REMOTE ){ outDescription += "remote"; }
+        else if ( flags & Node::STATS_BUILT )       { outDescription += "local"; }
+        else                                        { outDescription += "up-to-date"; }
+        if ( flags & Node::STATS_CACHE_MISS )       { outDescription += ", cache miss"; }
+    }
+
+    void FormatChangeMS( int64_t changeMS, AString & outBuffer )
+    {
+        outBuffer.Format( "%c%.3f", ( changeMS < 0 ) ? '-' : '+', (double)( ( changeMS < 0 ) ? -changeMS : changeMS ) / 1000.0 );
+    }
+}
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+BuildHistory::BuildHistory() = default;
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+BuildHistory::~BuildHistory() = default;
+
+// Load
+//------------------------------------------------------------------------------
+bool BuildHistory::Load( const AString & fileName )
+{
+    PROFILE_FUNCTION;
+
+    static_assert( sizeof( NodeRecord ) == 16, "NodeRecord is stored directly" );
+    static_assert( sizeof( HeaderRecord ) == 16, "HeaderRecord is stored directly" );
+
+    m_Builds.Clear();
+
+    if ( FileIO::FileExists( fileName.Get() ) == false )
+    {
+        return true; // No history yet
+    }
+
+    FileStream f;
+    if ( f.Open( fileName.Get(), FileStream::READ_ONLY ) == false )
+    {
+        return false;
+    }
+
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint32_t numBuilds = 0;
+    if ( ( f.Read( magic ) == false ) ||
+         ( magic != BUILD_HISTORY_MAGIC ) ||
+         ( f.Read( version ) == false ) ||
+         ( version != BUILD_HISTORY_VERSION ) ||
+         ( f.Read( numBuilds ) == false ) ||
+         ( numBuilds > MAX_BUILDS ) )
+    {
+        return false;
+    }
+
+    m_Builds.SetCapacity( numBuilds );
+    for ( uint32_t i = 0; i < numBuilds; ++i )
+    {
+        Build & build = m_Builds.EmplaceBack();
+        if ( ( f.Read( build.m_Time ) == false ) ||
+             ( f.Read( build.m_TotalTimeMS ) == false ) ||
+             ( ReadRecords( f, build.m_Nodes ) == false ) ||
+             ( ReadRecords( f, build.m_Headers ) == false ) )
+        {
+            m_Builds.Clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+// Save
+//------------------------------------------------------------------------------
+bool BuildHistory::Save( const AString & fileName ) const
+{
+    PROFILE_FUNCTION;
+
+    FileStream f;
+    if ( f.Open( fileName.Get(), FileStream::WRITE_ONLY ) == false )
+    {
+        return false;
+    }
+
+    bool ok = f.Write( (uint32_t)BUILD_HISTORY_MAGIC );
+    ok &= f.Write( (uint32_t)BUILD_HISTORY_VERSION );
+    ok &= f.Write( (uint32_t)m_Builds.GetSize() );
+    for ( const Build & build : m_Builds )
+    {
+        ok &= f.Write( build.m_Time );
+        ok &= f.Write( build.m_TotalTimeMS );
+        ok &= WriteRecords( f, build.m_Nodes );
+        ok &= WriteRecords( f, build.m_Headers );
+    }
+    return ok;
+}
+
+// AddBuild
+//------------------------------------------------------------------------------
+void BuildHistory::AddBuild( const NodeGraph & nodeGraph, float totalBuildTime )
+{
+    PROFILE_FUNCTION;
+
+    // Discard the oldest builds
+    while ( m_Builds.GetSize() >= MAX_BUILDS )
+    {
+        m_Builds.PopFront();
+    }
+
+    Build & build = m_Builds.EmplaceBack();
+    build.m_Time = (uint64_t)time( nullptr );
+    build.m_TotalTimeMS = (uint32_t)( totalBuildTime * 1000.0f );
+
+    nodeGraph.SetBuildPassTagForAllNodes( TAG_HEADER_NOT_SEEN );
+    const size_t numNodes = nodeGraph.GetNodeCount();
+    for ( size_t i = 0; i < numNodes; ++i )
+    {
+        const Node * node = nodeGraph.GetNodeByIndex( i );
+
+        // Nodes which performed work
+        if ( ShouldRecord( node ) )
+        {
+            NodeRecord & record = build.m_Nodes.EmplaceBack();
+            record.m_NameHash = xxHash3::Calc64( node->GetName() );
+            record.m_TimeMS = node->GetProcessingTime();
+            record.m_Flags = GetFlags( node );
+            record.m_Type = (uint8_t)node->GetType();
+        }
+
+        // Headers used by objects in this build
+        if ( ( node->GetType() == Node::OBJECT_NODE ) && node->GetStatFlag( Node::STATS_PROCESSED ) )
+        {
+            for ( const Dependency & dep : node->GetDynamicDependencies() )
+            {
+                const Node * header = dep.GetNode();
+                if ( ( header->GetBuildPassTag() != TAG_HEADER_NOT_SEEN ) ||
+                     ( header->GetType() != Node::FILE_NODE ) ||
+                     ( header->GetStatFlag( Node::STATS_PROCESSED ) == false ) )
+                {
+                    continue;
+                }
+                header->SetBuildPassTag( TAG_HEADER_SEEN );
+
+                HeaderRecord & record = build.m_Headers.EmplaceBack();
+                record.m_NameHash = xxHash3::Calc64( header->GetName() );
+                record.m_Stamp = header->GetStamp();
+            }
+        }
+    }
+
+    // Sort for lookups when comparing
+    build.m_Nodes.Sort();
+    build.m_Headers.Sort();
+}
+
+// Compare
+//------------------------------------------------------------------------------
+void BuildHistory::Compare( const NodeGraph & nodeGraph, float totalBuildTime, AString & outReport ) const
+{
+    PROFILE_FUNCTION;
+
+    outReport += "--- Comparison With Previous Build ------------------------------\n";
+    if ( m_Builds.IsEmpty() )
+    {
+        outReport += "No previous build recorded. Use -history or -compare to record builds.\n";
+        outReport += "-----------------------------------------------------------------\n";
+        return;
+    }
+    const Build & previous = m_Builds.Top();
+
+    // Totals for the previous build
+    Totals before;
+    for ( const NodeRecord & record : previous.m_Nodes )
+    {
+        before.Accumulate( record.m_Type, record.m_TimeMS, record.m_Flags );
+    }
+
+    // Compare nodes in this build with the previous build in a single pass.
+    // Only the largest regressions are retained, and objects which rebuilt
+    // are attributed to the changed headers they use.
+    Totals after;
+    Array< Regression > regressions( NUM_REGRESSIONS_TO_DISPLAY );
+    Array< HeaderImpact > changedHeaders;
+    uint32_t numRebuiltWithoutHeaderChange = 0;
+    nodeGraph.SetBuildPassTagForAllNodes( TAG_HEADER_NOT_SEEN );
+    const size_t numNodes = nodeGraph.GetNodeCount();
+    for ( size_t i = 0; i < numNodes; ++i )
+    {
+        const Node * node = nodeGraph.GetNodeByIndex( i );
+
+        int64_t changeMS = 0;
+        if ( ShouldRecord( node ) )
+        {
+            Regression regression;
+            regression.m_Node = node;
+            regression.m_AfterMS = node->GetProcessingTime();
+            regression.m_AfterFlags = GetFlags( node );
+            const NodeRecord * record = FindRecord( previous.m_Nodes, xxHash3::Calc64( node->GetName() ) );
+            regression.m_InPrevious = ( record != nullptr );
+            regression.m_BeforeMS = record ? record->m_TimeMS : 0;
+            regression.m_BeforeFlags = record ? record->m_Flags : 0;
+
+            after.Accumulate( (uint8_t)node->GetType(), regression.m_AfterMS, regression.m_AfterFlags );
+
+            changeMS = regression.GetChange();
+            if ( changeMS > 0 )
+            {
+                AddRegression( regressions, regression );
+            }
+        }
+
+        if ( ( node->GetType() != Node::OBJECT_NODE ) || ( node->GetStatFlag( Node::STATS_PROCESSED ) == false ) )
+        {
+            continue;
+        }
+
+        // Find headers which have changed, visiting each header only once
+        uint32_t numChanged = 0;
+        const Dependencies & headers = node->GetDynamicDependencies();
+        for ( const Dependency & dep : headers )
+        {
+            const Node * header = dep.GetNode();
+            if ( ( header->GetType() != Node::FILE_NODE ) ||
+                 ( header->GetStatFlag( Node::STATS_PROCESSED ) == false ) )
+            {
+                continue;
+            }
+            if ( header->GetBuildPassTag() == TAG_HEADER_NOT_SEEN )
+            {
+                const HeaderRecord * record = FindRecord( previous.m_Headers, xxHash3::Calc64( header->GetName() ) );
+                if ( record && ( record->m_Stamp != header->GetStamp() ) )
+                {
+                    header->SetBuildPassTag( TAG_HEADER_CHANGED + (uint32_t)changedHeaders.GetSize() );
+                    changedHeaders.Append( HeaderImpact{ header, 0, 0 } );
+                }
+                else
+                {
+                    header->SetBuildPassTag( TAG_HEADER_SEEN );
+                }
+            }
+            numChanged += ( header->GetBuildPassTag() >= TAG_HEADER_CHANGED ) ? 1 : 0;
+        }
+
+        // Share the regression between the changed headers
+        if ( changeMS <= 0 )
+        {
+            continue;
+        }
+        if ( numChanged == 0 )
+        {
+            ++numRebuiltWithoutHeaderChange;
+            continue;
+        }
+        for ( const Dependency & dep : headers )
+        {
+            const uint32_t tag = dep.GetNode()->GetBuildPassTag();
+            if ( tag >= TAG_HEADER_CHANGED )
+            {
+                HeaderImpact & impact = changedHeaders[ tag - TAG_HEADER_CHANGED ];
+                impact.m_TimeMS += ( (uint64_t)changeMS / numChanged );
+                impact.m_NumObjects++;
+            }
+        }
+    }
+
+    // Overall
+    AStackString<> buffer;
+    AStackString<> buffer2;
+    {
+        time_t previousTime = (time_t)previous.m_Time;
+        PRAGMA_DISABLE_PUSH_MSVC( 4996 ) // This function or variable may be unsafe...
+        PRAGMA_DISABLE_PUSH_CLANG_WINDOWS( "-Wdeprecated-declarations" ) // 'localtime' is deprecated: This function or variable may be unsafe...
+        const struct tm * timeinfo = localtime( &previousTime );
+        PRAGMA_DISABLE_POP_CLANG_WINDOWS // -Wdeprecated-declarations
+        PRAGMA_DISABLE_POP_MSVC // 4996
+        char timeBuffer[ 256 ];
+        if ( timeinfo && ( strftime( timeBuffer, sizeof( timeBuffer ), "%a %d-%b-%Y - %H:%M:%S", timeinfo ) > 0 ) )
+        {
+            outReport.AppendFormat( "Previous     : %s\n", timeBuffer );
+        }
+    }
+    const uint32_t totalMS = (uint32_t)( totalBuildTime * 1000.0f );
+    FBuildStats::FormatTime( (float)previous.m_TotalTimeMS / 1000.0f, buffer );
+    FBuildStats::FormatTime( totalBuildTime, buffer2 );
+    outReport.AppendFormat( "Time         : %s -> %s", buffer.Get(), buffer2.Get() );
+    if ( previous.m_TotalTimeMS > 0 )
+    {
+        outReport.AppendFormat( " (%+.1f %%)", ( ( (double)totalMS - (double)previous.m_TotalTimeMS ) * 100.0 ) / (double)previous.m_TotalTimeMS );
+    }
+    outReport += '\n';
+
+    // Counts
+    outReport += "Items:          Before    After     Change\n";
+    const struct { const char * m_Name; uint32_t m_Before; uint32_t m_After; } counts[] =
+    {
+        { "Built",      before.m_NumBuilt,          after.m_NumBuilt },
+        { "Cache Hits", before.m_NumCacheHits,      after.m_NumCacheHits },
+        { "Cache Miss", before.m_NumCacheMisses,    after.m_NumCacheMisses },
+        { "Remote",     before.m_NumRemote,         after.m_NumRemote },
+        { "Failed",     before.m_NumFailed,         after.m_NumFailed },
+    };
+    for ( const auto & count : counts )
+    {
+        outReport.AppendFormat( " - %-10s : %-10u%-10u%+i\n", count.m_Name, count.m_Before, count.m_After, (int32_t)count.m_After - (int32_t)count.m_Before );
+    }
+
+    // CPU time by node type
+    outReport += "CPU (s):        Before    After     Change\n";
+    for ( uint32_t type = 0; type < Node::NUM_NODE_TYPES; ++type )
+    {
+        if ( ( before.m_TimeMS[ type ] == 0 ) && ( after.m_TimeMS[ type ] == 0 ) )
+        {
+            continue;
+        }
+        FormatChangeMS( (int64_t)after.m_TimeMS[ type ] - (int64_t)before.m_TimeMS[ type ], buffer );
+        outReport.AppendFormat( " - %-10s : %-10.3f%-10.3f%s\n",
+                                Node::GetTypeName( Node::Type( type ) ),
+                                (double)before.m_TimeMS[ type ] / 1000.0,
+                                (double)after.m_TimeMS[ type ] / 1000.0,
+                                buffer.Get() );
+    }
+
+    // Largest regressions
+    if ( regressions.IsEmpty() == false )
+    {
+        outReport += "--- Largest Regressions -----------------------------------------\n";
+        outReport += "Change (s) Before (s) After (s)  Name:\n";
+        for ( const Regression & regression : regressions )
+        {
+            FormatChangeMS( regression.GetChange(), buffer );
+            outReport.AppendFormat( "%-10s %-10.3f %-10.3f %s", buffer.Get(), (double)regression.m_BeforeMS / 1000.0, (double)regression.m_AfterMS / 1000.0, regression.m_Node->GetPrettyName().Get() );
+            DescribeFlags( regression.m_AfterFlags, buffer );
+            if ( regression.m_InPrevious == false )
+            {
+                outReport.AppendFormat( " (%s, previously up-to-date)\n", buffer.Get() );
+            }
+            else
+            {
+                DescribeFlags( regression.m_BeforeFlags, buffer2 );
+                outReport.AppendFormat( ( buffer == buffer2 ) ? " (%s)\n" : " (%s, previously %s)\n", buffer.Get(), buffer2.Get() );
+            }
+        }
+    }
+
+    // Changed headers
+    if ( changedHeaders.IsEmpty() == false )
+    {
+        changedHeaders.Sort();
+        outReport.AppendFormat( "--- Changed Headers (%u) -----------------------------------------\n", (uint32_t)changedHeaders.GetSize() );
+        outReport += "Time (s)   Objects    Name:\n";
+        const size_t numToDisplay = Math::Min( changedHeaders.GetSize(), (size_t)NUM_HEADERS_TO_DISPLAY );
+        for ( size_t i = 0; i < numToDisplay; ++i )
+        {
+            const HeaderImpact & impact = changedHeaders[ i ];
+            outReport.AppendFormat( "%-10.3f %-10u %s\n", (double)impact.m_TimeMS / 1000.0, impact.m_NumObjects, impact.m_Header->GetName().Get() );
+        }
+    }
+    if ( numRebuiltWithoutHeaderChange > 0 )
+    {
+        outReport.AppendFormat( "Objects slower without a header change: %u\n", numRebuiltWithoutHeaderChange );
+    }
+    outReport += "-----------------------------------------------------------------\n";
+}
+
+// ShouldRecord
+//------------------------------------------------------------------------------
+/*static*/ bool BuildHistory::ShouldRecord( const Node * node )
+{
+    // Nodes which did work in this build (file nodes are too numerous)
+    return ( node->GetStatFlag( Node::STATS_PROCESSED ) &&
+             ( node->GetType() != Node::FILE_NODE ) &&
+             ( node->GetType() != Node::PROXY_NODE ) &&
+             ( ( node->GetProcessingTime() > 0 ) || node->GetStatFlag( Node::STATS_BUILT ) ) );
+}
+
+// GetFlags
+//------------------------------------------------------------------------------
+/*static*/ uint16_t BuildHistory::GetFlags( const Node * node )
+{
+    uint16_t flags = 0;
+    for ( const Node::StatsFlag flag : kRecordedFlags )
+    {
+        flags |= ( node->GetStatFlag( flag ) ? (uint16_t)flag : 0 );
+    }
+    return flags;
+}
+
+// FindRecord
+//------------------------------------------------------------------------------
+template < class T >
+/*static*/ const T * BuildHistory::FindRecord( const Array< T > & records, uint64_t nameHash )
+{
+    // Binary search of sorted records
+    size_t low = 0;
+    size_t high = records.GetSize();
+    while ( low < high )
+    {
+        const size_t mid = ( low + ( ( high - low ) / 2 ) );
+        if ( records[ mid ].m_NameHash < nameHash )
+        {
+            low = ( mid + 1 );
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    if ( ( low < records.GetSize() ) && ( records[ low ].m_NameHash == nameHash ) )
+    {
+        return &records[ low ];
+    }
+    return nullptr;
+}
+
+//------------------------------------------------------------------------------
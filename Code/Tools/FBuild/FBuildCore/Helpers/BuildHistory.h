@@ -0,0 +1,85 @@
+// BuildHistory - Compact record of recent builds, for build-over-build comparison
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+// Core
+#include "Core/Containers/Array.h"
+#include "Core/Env/Types.h"
+
+// Forward Declarations
+//------------------------------------------------------------------------------
+class AString;
+class Node;
+class NodeGraph;
+
+// BuildHistory
+//  - Stored alongside the dependency database (<db>.history)
+//  - Nodes are identified by a hash of their name, so history survives
+//    changes to the dependency graph
+//  - Only nodes which performed work are recorded, so incremental builds are
+//    cheap to record
+//------------------------------------------------------------------------------
+class BuildHistory
+{
+public:
+    enum : uint32_t { MAX_BUILDS = 8 }; // Older builds are discarded
+
+    BuildHistory();
+    ~BuildHistory();
+
+    // A missing file is treated as an empty history
+    bool Load( const AString & fileName );
+    bool Save( const AString & fileName ) const;
+
+    // Record the build which just completed
+    void AddBuild( const NodeGraph & nodeGraph, float totalBuildTime );
+
+    // Compare the build which just completed with the most recent build in
+    // the history, ranking the nodes and changed headers contributing most
+    // to any regression
+    void Compare( const NodeGraph & nodeGraph, float totalBuildTime, AString & outReport ) const;
+
+    [[nodiscard]] size_t GetNumBuilds() const { return m_Builds.GetSize(); }
+
+private:
+    // A node which performed work during a build
+    struct NodeRecord
+    {
+        uint64_t    m_NameHash;
+        uint32_t    m_TimeMS;
+        uint16_t    m_Flags;    // Subset of Node::StatsFlag
+        uint8_t     m_Type;     // Node::Type
+        uint8_t     m_Padding;
+
+        bool operator < ( const NodeRecord & other ) const { return ( m_NameHash < other.m_NameHash ); }
+    };
+
+    // A header used by objects processed during a build
+    struct HeaderRecord
+    {
+        uint64_t    m_NameHash;
+        uint64_t    m_Stamp;
+
+        bool operator < ( const HeaderRecord & other ) const { return ( m_NameHash < other.m_NameHash ); }
+    };
+
+    class Build
+    {
+    public:
+        uint64_t                m_Time          = 0; // Seconds since epoch
+        uint32_t                m_TotalTimeMS   = 0;
+        Array< NodeRecord >     m_Nodes;            // Sorted by m_NameHash
+        Array< HeaderRecord >   m_Headers;          // Sorted by m_NameHash
+    };
+
+    static bool ShouldRecord( const Node * node );
+    static uint16_t GetFlags( const Node * node );
+    template < class T >
+    static const T * FindRecord( const Array< T > & records, uint64_t nameHash );
+
+    Array< Build >  m_Builds; // Oldest to newest
+};
+
+//------------------------------------------------------------------------------
@@ -9,6 +9,7 @@
 #include "Tools/FBuild/FBuildCore/FBuild.h"
 #include "Tools/FBuild/FBuildCore/FBuildOptions.h"
 #include "Tools/FBuild/FBuildCore/Graph/Node.h"
+#include "Tools/FBuild/FBuildCore/Helpers/BuildTrace.h"
 #include "Tools/FBuild/FBuildCore/Helpers/JSON.h"
 #include "Tools/FBuild/FBuildCore/WorkerPool/Job.h"
 
@@ -23,6 +24,10 @@
     #include "Core/Env/WindowsHeader.h"
     #include "Psapi.h"
 #endif
+#if defined( __LINUX__ )
+    #include <stdlib.h>
+    #include <unistd.h>
+#endif
 
 // CONSTRUCTOR (BuildProfiler)
 //------------------------------------------------------------------------------
@@ -57,12 +62,17 @@ void BuildProfiler::RecordLocal( uint32_t threadId,
                       int64_t startTime,
                       int64_t endTime,
                       const char * stepName,
-                      const char * targetName )
+                      const char * targetName,
+                      const Process::ResourceUsage * processUsage )
 {
     const int32_t machineId = Event::LOCAL_MACHINE_ID;
 
     MutexHolder mh( m_Mutex );
-    m_Events.EmplaceBack( machineId, threadId, startTime, endTime, stepName, targetName );
+    Event & event = m_Events.EmplaceBack( machineId, threadId, startTime, endTime, stepName, targetName );
+    if ( processUsage )
+    {
+        event.m_ProcessUsage = *processUsage;
+    }
 }
 
 // RecordRemote
@@ -102,6 +112,31 @@ void BuildProfiler::RecordRemote( uint32_t workerId,
     m_Events.EmplaceBack( static_cast<int32_t>(workerId), remoteThreadId, startTime, endTime, stepName, targetName );
 }
 
+// RecordRemoteJob
+//------------------------------------------------------------------------------
+void BuildProfiler::RecordRemoteJob( uint32_t workerId,
+                                     uint32_t jobId,
+                                     const char * const * phaseNames,
+                                     const int64_t * phaseTimes,
+                                     uint32_t numPhases,
+                                     const char * targetName )
+{
+    ASSERT( numPhases <= RemoteJobEvent::MAX_PHASES );
+
+    MutexHolder mh( m_Mutex );
+
+    RemoteJobEvent & event = m_RemoteJobEvents.EmplaceBack();
+    event.m_MachineId = static_cast<int32_t>( workerId );
+    event.m_JobId = jobId;
+    event.m_NumPhases = numPhases;
+    event.m_PhaseNames = phaseNames;
+    for ( uint32_t i = 0; i <= numPhases; ++i )
+    {
+        event.m_PhaseTimes[ i ] = phaseTimes[ i ];
+    }
+    event.m_TargetName = targetName;
+}
+
 // SaveJSON
 //------------------------------------------------------------------------------
 bool BuildProfiler::SaveJSON( const FBuildOptions & options,  const char * fileName )
@@ -122,6 +157,7 @@ bool BuildProfiler::SaveJSON( const FBuildOptions & options,  const char * fileN
     // - Global metrics
     buffer += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":-2,\"tid\":0,\"args\":{\"name\":\"Memory Usage\"}},";
     buffer += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":-3,\"tid\":0,\"args\":{\"name\":\"Network Usage\"}},";
+    buffer += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":-4,\"tid\":0,\"args\":{\"name\":\"CPU Usage\"}},";
 
     // - Local Processing
     AStackString<> args( options.GetArgs() );
@@ -161,17 +197,69 @@ bool BuildProfiler::SaveJSON( const FBuildOptions & options,  const char * fileN
                                 event.m_ThreadId );
 
         // Optional additional "target name"
-        if ( event.m_TargetName )
+        const Process::ResourceUsage & usage = event.m_ProcessUsage;
+        if ( event.m_TargetName || usage.m_NumProcesses )
         {
-            nameBuffer = event.m_TargetName;
-            JSON::Escape( nameBuffer );
-            buffer.AppendFormat( ",\"args\":{\"name\":\"%s\"}", nameBuffer.Get());
+            buffer += ",\"args\":{";
+            if ( event.m_TargetName )
+            {
+                nameBuffer = event.m_TargetName;
+                JSON::Escape( nameBuffer );
+                buffer.AppendFormat( "\"name\":\"%s\"%s", nameBuffer.Get(), usage.m_NumProcesses ? "," : "" );
+            }
+
+            // Resources used by spawned processes
+            if ( usage.m_NumProcesses )
+            {
+                buffer.AppendFormat( "\"Processes\":%u,\"Peak Memory (MiB)\":%u,\"User CPU (ms)\":%u,\"System CPU (ms)\":%u,\"Read (KiB)\":%" PRIu64 ",\"Write (KiB)\":%" PRIu64,
+                                     usage.m_NumProcesses,
+                                     usage.m_PeakMemoryMiB,
+                                     usage.m_UserTimeMS,
+                                     usage.m_SystemTimeMS,
+                                     ( usage.m_ReadBytes / 1024 ),
+                                     ( usage.m_WriteBytes / 1024 ) );
+            }
+            buffer += '}';
         }
 
         buffer += ( "}," );
     }
 
+    // Serialize remote job phases
+    // - Nestable async events, with the phases inside an event for the whole job
+    for ( const RemoteJobEvent & event : m_RemoteJobEvents )
+    {
+        nameBuffer = event.m_TargetName;
+        JSON::Escape( nameBuffer );
+        const int64_t start = event.m_PhaseTimes[ 0 ];
+        const int64_t end = event.m_PhaseTimes[ event.m_NumPhases ];
+        buffer.AppendFormat( "{\"name\":\"Remote Job\",\"cat\":\"Remote\",\"ph\":\"b\",\"id\":%u,\"ts\":%" PRIu64 ",\"pid\":%i,\"tid\":0,\"args\":{\"name\":\"%s\"}},",
+                             event.m_JobId,
+                             (uint64_t)( (double)start * freqMul ),
+                             event.m_MachineId,
+                             nameBuffer.Get() );
+        for ( uint32_t i = 0; i < event.m_NumPhases; ++i )
+        {
+            const char * phaseName = event.m_PhaseNames[ i ];
+            buffer.AppendFormat( "{\"name\":\"%s\",\"cat\":\"Remote\",\"ph\":\"b\",\"id\":%u,\"ts\":%" PRIu64 ",\"pid\":%i,\"tid\":0},",
+                                 phaseName,
+                                 event.m_JobId,
+                                 (uint64_t)( (double)event.m_PhaseTimes[ i ] * freqMul ),
+                                 event.m_MachineId );
+            buffer.AppendFormat( "{\"name\":\"%s\",\"cat\":\"Remote\",\"ph\":\"e\",\"id\":%u,\"ts\":%" PRIu64 ",\"pid\":%i,\"tid\":0},",
+                                 phaseName,
+                                 event.m_JobId,
+                                 (uint64_t)( (double)event.m_PhaseTimes[ i + 1 ] * freqMul ),
+                                 event.m_MachineId );
+        }
+        buffer.AppendFormat( "{\"name\":\"Remote Job\",\"cat\":\"Remote\",\"ph\":\"e\",\"id\":%u,\"ts\":%" PRIu64 ",\"pid\":%i,\"tid\":0},",
+                             event.m_JobId,
+                             (uint64_t)( (double)end * freqMul ),
+                             event.m_MachineId );
+    }
+
     // Serialize metrics
+    const Metrics * previousMetrics = nullptr;
     for ( const Metrics & metrics : m_Metrics )
     {
         // Total Memory
@@ -193,6 +281,17 @@ bool BuildProfiler::SaveJSON( const FBuildOptions & options,  const char * fileN
                                     (uint64_t)( (double)metrics.m_Time * freqMul ),
                                     metrics.m_NumConnections );
         }
+
+        // CPU usage since the last update (100% per fully used core)
+        if ( previousMetrics && ( metrics.m_Time > previousMetrics->m_Time ) )
+        {
+            const double elapsedMS = ( (double)( metrics.m_Time - previousMetrics->m_Time ) * (double)Timer::GetFrequencyInvFloatMS() );
+            const double cpuTimeMS = (double)( metrics.m_CPUTimeMS - previousMetrics->m_CPUTimeMS );
+            buffer.AppendFormat( "{\"name\":\"CPU (%%)\",\"ph\":\"C\",\"ts\":%" PRIu64 ",\"pid\":-4,\"args\":{\"Percent\":%u}},",
+                                 (uint64_t)( (double)metrics.m_Time * freqMul ),
+                                 (uint32_t)( ( cpuTimeMS * 100.0 ) / elapsedMS ) );
+        }
+        previousMetrics = &metrics;
     }
 
     // Open output file and write the majority of the profiling info
@@ -235,16 +334,8 @@ void BuildProfiler::MetricsUpdate()
         Metrics & metrics = m_Metrics.EmplaceBack();
         metrics.m_Time = Timer::GetNow();
 
-        // FASTBuild memory usage (this process)
-#if defined( __WINDOWS__ )
-        PROCESS_MEMORY_COUNTERS_EX counters;
-        VERIFY( GetProcessMemoryInfo( GetCurrentProcess(),
-                                      (PROCESS_MEMORY_COUNTERS*)&counters,
-                                      sizeof(PROCESS_MEMORY_COUNTERS_EX) ) );
-        metrics.m_TotalMemoryMiB = (uint32_t)( counters.WorkingSetSize / ( 1024 * 1024 ) );
-#else
-        metrics.m_TotalMemoryMiB = 0; // TODO:LINUX TODO:OSX Implement total memory usage stat
-#endif
+        // FASTBuild memory and CPU usage (this process)
+        GetProcessMetrics( metrics.m_TotalMemoryMiB, metrics.m_CPUTimeMS );
 
         // Memory used by distributed jobs
         metrics.m_JobMemoryMiB = (uint32_t)( Job::GetTotalLocalDataMemoryUsage() / ( 1024 * 1024 ) );
@@ -264,13 +355,76 @@ void BuildProfiler::MetricsUpdate()
     }
 }
 
+// GetProcessMetrics
+//------------------------------------------------------------------------------
+/*static*/ void BuildProfiler::GetProcessMetrics( uint32_t & outMemoryMiB, uint64_t & outCPUTimeMS )
+{
+    outMemoryMiB = 0;
+    outCPUTimeMS = 0;
+
+#if defined( __WINDOWS__ )
+    PROCESS_MEMORY_COUNTERS_EX counters;
+    VERIFY( GetProcessMemoryInfo( GetCurrentProcess(),
+                                  (PROCESS_MEMORY_COUNTERS*)&counters,
+                                  sizeof(PROCESS_MEMORY_COUNTERS_EX) ) );
+    outMemoryMiB = (uint32_t)( counters.WorkingSetSize / ( 1024 * 1024 ) );
+
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if ( GetProcessTimes( GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime ) )
+    {
+        // FILETIME is in 100ns units
+        const uint64_t kernel100ns = ( ( (uint64_t)kernelTime.dwHighDateTime << 32 ) | kernelTime.dwLowDateTime );
+        const uint64_t user100ns = ( ( (uint64_t)userTime.dwHighDateTime << 32 ) | userTime.dwLowDateTime );
+        outCPUTimeMS = ( ( kernel100ns + user100ns ) / 10000 );
+    }
+#elif defined( __LINUX__ )
+    // Read /proc/self/stat (a single line)
+    FileStream f;
+    if ( f.Open( "/proc/self/stat", FileStream::READ_ONLY ) == false )
+    {
+        return;
+    }
+    AStackString< 1024 > stat;
+    stat.SetLength( 1024 );
+    const uint64_t len = f.ReadBuffer( stat.Get(), stat.GetLength() );
+    if ( ( len == 0 ) || ( len > stat.GetLength() ) ) // A failed read is returned as -1
+    {
+        return;
+    }
+    stat.SetLength( (uint32_t)len );
+
+    // Fields follow the executable name, which is in parenthesis and can
+    // contain spaces
+    const char * fields = stat.FindLast( ')' );
+    if ( fields == nullptr )
+    {
+        return;
+    }
+    Array< AString > tokens( 64 );
+    AStackString<>( fields + 1 ).Tokenize( tokens, ' ' );
+
+    // Item index 11 and 12 (0-based, from the state) are the utime and stime
+    // in clock ticks, and index 21 is the resident set size in pages
+    if ( tokens.GetSize() > 21 )
+    {
+        const uint64_t ticksPerSecond = (uint64_t)sysconf( _SC_CLK_TCK );
+        const uint64_t cpuTicks = ( strtoull( tokens[ 11 ].Get(), nullptr, 10 ) + strtoull( tokens[ 12 ].Get(), nullptr, 10 ) );
+        outCPUTimeMS = ( ( cpuTicks * 1000 ) / ticksPerSecond );
+        const uint64_t rssBytes = ( strtoull( tokens[ 21 ].Get(), nullptr, 10 ) * (uint64_t)sysconf( _SC_PAGESIZE ) );
+        outMemoryMiB = (uint32_t)( rssBytes / ( 1024 * 1024 ) );
+    }
+#else
+    // TODO:OSX Implement memory and CPU usage stats
+#endif
+}
+
 // CONSTRUCTOR (BuildProfilerScope)
 //------------------------------------------------------------------------------
 BuildProfilerScope::BuildProfilerScope( const char * stepName )
 {
-    m_Active = BuildProfiler::IsValid();
+    m_Active = ( BuildProfiler::IsValid() || BuildTrace::IsValid() );
 
-    // Only record info if the BuildProfiler is active
+    // Only record info if the BuildProfiler or BuildTrace is active
     if ( m_Active )
     {
         m_ThreadId = 0;
@@ -287,10 +441,10 @@ BuildProfilerScope::BuildProfilerScope( const char * stepName )
 //------------------------------------------------------------------------------
 BuildProfilerScope::BuildProfilerScope( Job & job, uint32_t threadId, const char * stepName )
 {
-    m_Active = ( BuildProfiler::IsValid() &&
+    m_Active = ( ( BuildProfiler::IsValid() || BuildTrace::IsValid() ) &&
                  job.IsLocal() ); // When testing, remote jobs can occur in the same process
 
-    // Only record info if the BuildProfiler is active
+    // Only record info if the BuildProfiler or BuildTrace is active
     if ( m_Active )
     {
         m_ThreadId = threadId;
@@ -311,7 +465,20 @@ BuildProfilerScope::~BuildProfilerScope()
     // Commit profiling info
     if ( m_Active )
     {
-        BuildProfiler::Get().RecordLocal( m_ThreadId, m_StartTime, Timer::GetNow(), m_StepName, m_TargetName );
+        const int64_t endTime = Timer::GetNow();
+        if ( BuildProfiler::IsValid() )
+        {
+            BuildProfiler::Get().RecordLocal( m_ThreadId,
+                                              m_StartTime,
+                                              endTime,
+                                              m_StepName,
+                                              m_TargetName,
+                                              m_ProcessUsage.m_NumProcesses ? &m_ProcessUsage : nullptr );
+        }
+        if ( BuildTrace::IsValid() )
+        {
+            BuildTrace::Get().RecordLocal( m_ThreadId, m_StartTime, endTime, m_StepName, m_TargetName );
+        }
     }
 
     // Unhook from associated Job
@@ -10,6 +10,7 @@
 #include "Core/Env/Types.h"
 #include "Core/Process/Atomic.h"
 #include "Core/Process/Mutex.h"
+#include "Core/Process/Process.h"
 #include "Core/Process/Semaphore.h"
 #include "Core/Process/Thread.h"
 #include "Core/Strings/AString.h"
@@ -37,7 +38,8 @@ public:
                       int64_t startTime,
                       int64_t endTime,
                       const char * stepName,
-                      const char * targetName );
+                      const char * targetName,
+                      const Process::ResourceUsage * processUsage = nullptr );
 
     // Record duration of a remote step
     void RecordRemote( uint32_t workedId,
@@ -48,12 +50,22 @@ public:
                        const char * stepName,
                        const char * targetName );
 
+    // Record the end-to-end phases of a remote job, in local time. Phases are
+    // consecutive, with phase N from phaseTimes[ N ] to phaseTimes[ N + 1 ]
+    void RecordRemoteJob( uint32_t workerId,
+                          uint32_t jobId,
+                          const char * const * phaseNames,
+                          const int64_t * phaseTimes,
+                          uint32_t numPhases,
+                          const char * targetName );
+
     // Write the profiling info in Chrome tracing format
     bool SaveJSON( const FBuildOptions & options, const char * fileName );
 
 protected:
     static uint32_t MetricsThreadWrapper( void * userData );
     void MetricsUpdate();
+    static void GetProcessMetrics( uint32_t & outMemoryMiB, uint64_t & outCPUTimeMS );
 
     // Items processed during the build
     class Event
@@ -76,6 +88,21 @@ protected:
         int64_t             m_EndTime;
         const char *        m_StepName;
         const char *        m_TargetName;
+        Process::ResourceUsage m_ProcessUsage; // Processes spawned during the step
+    };
+
+    // Phases of a remote job, shown as nested async events
+    class RemoteJobEvent
+    {
+    public:
+        enum : uint32_t { MAX_PHASES = 8 };
+
+        int32_t             m_MachineId;
+        uint32_t            m_JobId;
+        uint32_t            m_NumPhases;
+        const char * const * m_PhaseNames;
+        int64_t             m_PhaseTimes[ MAX_PHASES + 1 ];
+        const char *        m_TargetName;
     };
 
     // System wide metrics, gathered periodically
@@ -88,6 +115,9 @@ protected:
         uint32_t            m_TotalMemoryMiB = 0;
         uint32_t            m_JobMemoryMiB = 0;
 
+        // CPU time used by this process (not including spawned processes)
+        uint64_t            m_CPUTimeMS = 0;
+
         // Network
         uint16_t            m_NumConnections = 0;
     };
@@ -105,6 +135,7 @@ protected:
     Semaphore               m_ThreadSignalSemaphore;
     Thread                  m_Thread;
     Array<Event>            m_Events;
+    Array<RemoteJobEvent>   m_RemoteJobEvents;
     Array<Metrics>          m_Metrics;
     Array<WorkerInfo>       m_WorkerInfo;
 };
@@ -123,6 +154,9 @@ public:
 
     void SetStepName( const char * stepName ) { m_StepName = stepName; }
 
+    // Resources used by processes spawned during this step
+    void OnProcessExited( const Process::ResourceUsage & usage ) { m_ProcessUsage.Accumulate( usage ); }
+
 protected:
     BuildProfilerScope& operator = ( BuildProfilerScope & other ) = delete;
 
@@ -132,6 +166,7 @@ protected:
     const char *    m_TargetName;
     int64_t         m_StartTime;
     Job *           m_Job;
+    Process::ResourceUsage m_ProcessUsage;
 };
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,618 @@
+// BuildTrace - Compact binary trace of build activity
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "BuildTrace.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/FBuildOptions.h"
+#include "Tools/FBuild/FBuildCore/FLog.h"
+#include "Tools/FBuild/FBuildCore/Helpers/JSON.h"
+
+// Core
+#include "Core/Containers/UniquePtr.h"
+#include "Core/FileIO/FileStream.h"
+#include "Core/Math/Conversions.h"
+#include "Core/Mem/Mem.h"
+#include "Core/Profile/Profile.h"
+#include "Core/Strings/AStackString.h"
+#include "Core/Strings/AString.h"
+#include "Core/Time/Timer.h"
+
+// system
+#include <string.h> // for memcpy, strlen
+
+// Defines
+//------------------------------------------------------------------------------
+#define BUILD_TRACE_MAGIC       ( 'F' | ( 'B' << 8 ) | ( 'T' << 16 ) | ( 'R' << 24 ) )
+#define BUILD_TRACE_VERSION     ( 1 )
+
+// Record Encoding
+//  - All integers are unsigned LEB128 varints
+//  - RECORD_STRING : <id> <length> <bytes>
+//                    Ids start at 1 in each block and increase by 1
+//  - RECORD_SPAN   : <start> <duration> <machine> <thread> <step> <target>
+//                    <start> is zig-zag encoded relative to the previous span
+//                    in the block (the first is relative to 0). <machine>,
+//                    <step> and <target> are string ids, with 0 meaning none.
+//                    A <machine> of 0 is the local machine.
+//------------------------------------------------------------------------------
+namespace
+{
+    enum RecordType : uint8_t
+    {
+        RECORD_STRING   = 1,
+        RECORD_SPAN     = 2,
+    };
+
+    enum : uint32_t
+    {
+        MAX_VARINT_SIZE         = 10,
+        MAX_SPAN_RECORD_SIZE    = ( 1 + ( 6 * MAX_VARINT_SIZE ) ),
+        MAX_STRING_RECORD_SIZE  = ( 1 + ( 2 * MAX_VARINT_SIZE ) ), // Excluding string itself
+        INTERN_TABLE_SIZE       = 512, // Must be a power of 2
+        INVALID_STRING_ID       = 0xFFFFFFFF,
+    };
+    static_assert( BuildTrace::BLOCK_SIZE >= ( MAX_SPAN_RECORD_SIZE + ( 3 * ( MAX_STRING_RECORD_SIZE + BuildTrace::MAX_STRING_LENGTH ) ) ), "Largest record must fit in a block" );
+
+    inline uint8_t * WriteVarInt( uint8_t * pos, uint64_t value )
+    {
+        while ( value >= 0x80 )
+        {
+            *pos++ = (uint8_t)( value | 0x80 );
+            value >>= 7;
+        }
+        *pos++ = (uint8_t)value;
+        return pos;
+    }
+
+    inline bool ReadVarInt( const uint8_t *& pos, const uint8_t * end, uint64_t & outValue )
+    {
+        outValue = 0;
+        for ( uint32_t shift = 0; shift < ( MAX_VARINT_SIZE * 7 ); shift += 7 )
+        {
+            if ( pos >= end )
+            {
+                return false;
+            }
+            const uint8_t byte = *pos++;
+            outValue |= ( (uint64_t)( byte & 0x7F ) << shift );
+            if ( ( byte & 0x80 ) == 0 )
+            {
+                return true;
+            }
+        }
+        return false; // Too long
+    }
+
+    inline uint64_t ZigZagEncode( int64_t value )   { return ( ( (uint64_t)value << 1 ) ^ (uint64_t)( value >> 63 ) ); }
+    inline int64_t ZigZagDecode( uint64_t value )   { return (int64_t)( ( value >> 1 ) ^ ( ~( value & 1 ) + 1 ) ); }
+
+    // Each thread caches the buffer for the active BuildTrace
+    THREAD_LOCAL void *     tls_BuildTraceBuffer = nullptr;
+    THREAD_LOCAL uint32_t   tls_BuildTraceId = 0;
+    uint32_t                g_BuildTraceNextId = 1;
+}
+
+// ThreadBuffer
+//  - Only the owning thread records into a ThreadBuffer
+//------------------------------------------------------------------------------
+class BuildTrace::ThreadBuffer
+{
+public:
+    explicit ThreadBuffer( uint32_t numBlocks );
+    ~ThreadBuffer();
+
+    void RecordSpan( int64_t startTime,
+                     int64_t endTime,
+                     const char * machineName,
+                     uint32_t threadId,
+                     const char * stepName,
+                     const char * targetName );
+
+    uint32_t GetNumBlocks() const;
+    bool WriteBlocks( IOStream & stream ) const;
+
+private:
+    void NextBlock();
+    uint32_t FindString( const char * string ) const;
+    uint32_t WriteString( const char * string, uint32_t length );
+    static uint32_t GetInternSlot( const char * string );
+
+    struct InternEntry
+    {
+        const char *    m_String;
+        uint64_t        m_Block;    // Entries are only valid for the block they were written to
+        uint32_t        m_Id;
+    };
+
+    uint8_t *       m_Memory;
+    uint32_t *      m_BlockSizes;
+    uint32_t        m_NumBlocks;
+    uint64_t        m_BlockCount    = 0; // Blocks started, including overwritten ones
+    uint8_t *       m_Pos           = nullptr;
+    uint8_t *       m_End           = nullptr;
+    int64_t         m_LastTime      = 0;
+    uint32_t        m_NextStringId  = 1;
+    InternEntry     m_InternTable[ INTERN_TABLE_SIZE ];
+};
+
+// CONSTRUCTOR (ThreadBuffer)
+//------------------------------------------------------------------------------
+BuildTrace::ThreadBuffer::ThreadBuffer( uint32_t numBlocks )
+    : m_Memory( (uint8_t *)ALLOC( (size_t)numBlocks * BLOCK_SIZE ) )
+    , m_BlockSizes( (uint32_t *)ALLOC( numBlocks * sizeof( uint32_t ) ) )
+    , m_NumBlocks( numBlocks )
+{
+    ASSERT( numBlocks > 0 );
+    memset( m_BlockSizes, 0, numBlocks * sizeof( uint32_t ) );
+    memset( m_InternTable, 0, sizeof( m_InternTable ) );
+    NextBlock();
+}
+
+// DESTRUCTOR (ThreadBuffer)
+//------------------------------------------------------------------------------
+BuildTrace::ThreadBuffer::~ThreadBuffer()
+{
+    FREE( m_BlockSizes );
+    FREE( m_Memory );
+}
+
+// RecordSpan
+//------------------------------------------------------------------------------
+void BuildTrace::ThreadBuffer::RecordSpan( int64_t startTime,
+                                           int64_t endTime,
+                                           const char * machineName,
+                                           uint32_t threadId,
+                                           const char * stepName,
+                                           const char * targetName )
+{
+    const char * const strings[ 3 ] = { machineName, stepName, targetName };
+    uint32_t ids[ 3 ];
+    uint32_t lengths[ 3 ] = { 0, 0, 0 };
+
+    // Determine space needed for strings not yet written to this block
+    size_t required = MAX_SPAN_RECORD_SIZE;
+    for ( uint32_t i = 0; i < 3; ++i )
+    {
+        ids[ i ] = FindString( strings[ i ] );
+        if ( ids[ i ] == INVALID_STRING_ID )
+        {
+            lengths[ i ] = Math::Min( (uint32_t)strlen( strings[ i ] ), (uint32_t)MAX_STRING_LENGTH );
+            required += ( MAX_STRING_RECORD_SIZE + lengths[ i ] );
+        }
+    }
+
+    // Move to the next block if needed. Strings must be written again
+    // since each block is decoded independently.
+    if ( (size_t)( m_End - m_Pos ) < required )
+    {
+        NextBlock();
+        for ( uint32_t i = 0; i < 3; ++i )
+        {
+            if ( strings[ i ] && ( ids[ i ] != INVALID_STRING_ID ) )
+            {
+                ids[ i ] = INVALID_STRING_ID;
+                lengths[ i ] = Math::Min( (uint32_t)strlen( strings[ i ] ), (uint32_t)MAX_STRING_LENGTH );
+            }
+        }
+    }
+
+    for ( uint32_t i = 0; i < 3; ++i )
+    {
+        if ( ids[ i ] == INVALID_STRING_ID )
+        {
+            ids[ i ] = WriteString( strings[ i ], lengths[ i ] );
+        }
+    }
+
+    // Write span
+    uint8_t * pos = m_Pos;
+    *pos++ = RECORD_SPAN;
+    pos = WriteVarInt( pos, ZigZagEncode( startTime - m_LastTime ) );
+    pos = WriteVarInt( pos, (uint64_t)Math::Max( endTime - startTime, (int64_t)0 ) );
+    pos = WriteVarInt( pos, ids[ 0 ] );
+    pos = WriteVarInt( pos, threadId );
+    pos = WriteVarInt( pos, ids[ 1 ] );
+    pos = WriteVarInt( pos, ids[ 2 ] );
+    m_Pos = pos;
+    m_LastTime = startTime;
+}
+
+// GetNumBlocks
+//------------------------------------------------------------------------------
+uint32_t BuildTrace::ThreadBuffer::GetNumBlocks() const
+{
+    return (uint32_t)Math::Min( m_BlockCount, (uint64_t)m_NumBlocks );
+}
+
+// WriteBlocks
+//------------------------------------------------------------------------------
+bool BuildTrace::ThreadBuffer::WriteBlocks( IOStream & stream ) const
+{
+    // Write oldest to newest
+    const uint64_t currentIndex = ( ( m_BlockCount - 1 ) % m_NumBlocks );
+    const uint64_t numBlocks = GetNumBlocks();
+    const uint64_t firstIndex = ( m_BlockCount > m_NumBlocks ) ? ( m_BlockCount % m_NumBlocks ) : 0;
+    for ( uint64_t i = 0; i < numBlocks; ++i )
+    {
+        const uint64_t index = ( ( firstIndex + i ) % m_NumBlocks );
+        const uint8_t * block = ( m_Memory + ( index * BLOCK_SIZE ) );
+        const uint32_t size = ( index == currentIndex ) ? (uint32_t)( m_Pos - block ) : m_BlockSizes[ index ];
+        if ( ( stream.Write( size ) == false ) ||
+             ( stream.WriteBuffer( block, size ) != size ) )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// NextBlock
+//------------------------------------------------------------------------------
+void BuildTrace::ThreadBuffer::NextBlock()
+{
+    // Note the size of the block being finished
+    if ( m_BlockCount > 0 )
+    {
+        const uint64_t index = ( ( m_BlockCount - 1 ) % m_NumBlocks );
+        m_BlockSizes[ index ] = (uint32_t)( m_Pos - ( m_Memory + ( index * BLOCK_SIZE ) ) );
+    }
+
+    // Start the next block, overwriting the oldest if the ring is full
+    const uint64_t index = ( m_BlockCount % m_NumBlocks );
+    ++m_BlockCount;
+    m_Pos = ( m_Memory + ( index * BLOCK_SIZE ) );
+    m_End = ( m_Pos + BLOCK_SIZE );
+    m_LastTime = 0;
+    m_NextStringId = 1;
+}
+
+// FindString
+//------------------------------------------------------------------------------
+uint32_t BuildTrace::ThreadBuffer::FindString( const char * string ) const
+{
+    if ( string == nullptr )
+    {
+        return 0;
+    }
+    const InternEntry & entry = m_InternTable[ GetInternSlot( string ) ];
+    if ( ( entry.m_String == string ) && ( entry.m_Block == m_BlockCount ) )
+    {
+        return entry.m_Id;
+    }
+    return INVALID_STRING_ID;
+}
+
+// WriteString
+//------------------------------------------------------------------------------
+uint32_t BuildTrace::ThreadBuffer::WriteString( const char * string, uint32_t length )
+{
+    ASSERT( (size_t)( m_End - m_Pos ) >= ( MAX_STRING_RECORD_SIZE + length ) );
+
+    const uint32_t id = m_NextStringId++;
+
+    uint8_t * pos = m_Pos;
+    *pos++ = RECORD_STRING;
+    pos = WriteVarInt( pos, id );
+    pos = WriteVarInt( pos, length );
+    memcpy( pos, string, length );
+    m_Pos = ( pos + length );
+
+    // Replace any previous string in this slot
+    InternEntry & entry = m_InternTable[ GetInternSlot( string ) ];
+    entry.m_String = string;
+    entry.m_Block = m_BlockCount;
+    entry.m_Id = id;
+
+    return id;
+}
+
+// GetInternSlot
+//------------------------------------------------------------------------------
+/*static*/ uint32_t BuildTrace::ThreadBuffer::GetInternSlot( const char * string )
+{
+    // Fibonacci hash of the pointer
+    const uint64_t hash = ( (uint64_t)(size_t)string * 0x9E3779B97F4A7C15ULL );
+    return (uint32_t)( hash >> 32 ) & ( INTERN_TABLE_SIZE - 1 );
+}
+
+// CONSTRUCTOR (BuildTrace)
+//------------------------------------------------------------------------------
+BuildTrace::BuildTrace( uint32_t numBlocksPerThread )
+    : m_Id( g_BuildTraceNextId++ )
+    , m_NumBlocksPerThread( numBlocksPerThread )
+{
+}
+
+// DESTRUCTOR (BuildTrace)
+//------------------------------------------------------------------------------
+BuildTrace::~BuildTrace()
+{
+    for ( ThreadBuffer * buffer : m_ThreadBuffers )
+    {
+        FDELETE buffer;
+    }
+}
+
+// RecordLocal
+//------------------------------------------------------------------------------
+void BuildTrace::RecordLocal( uint32_t threadId,
+                              int64_t startTime,
+                              int64_t endTime,
+                              const char * stepName,
+                              const char * targetName )
+{
+    GetThreadBuffer()->RecordSpan( startTime, endTime, nullptr, threadId, stepName, targetName );
+}
+
+// RecordRemote
+//------------------------------------------------------------------------------
+void BuildTrace::RecordRemote( const AString & workerName,
+                               uint32_t remoteThreadId,
+                               int64_t startTime,
+                               int64_t endTime,
+                               const char * stepName,
+                               const char * targetName )
+{
+    GetThreadBuffer()->RecordSpan( startTime, endTime, workerName.Get(), remoteThreadId, stepName, targetName );
+}
+
+// Save
+//------------------------------------------------------------------------------
+bool BuildTrace::Save( const FBuildOptions & options, const char * fileName ) const
+{
+    PROFILE_FUNCTION;
+
+    FileStream f;
+    if ( f.Open( fileName, FileStream::WRITE_ONLY ) == false )
+    {
+        return false;
+    }
+
+    MutexHolder mh( m_Mutex );
+
+    // Header
+    AStackString<> description( options.m_ProgramName );
+    description += ' ';
+    description += options.GetArgs();
+    uint32_t numBlocks = 0;
+    for ( const ThreadBuffer * buffer : m_ThreadBuffers )
+    {
+        numBlocks += buffer->GetNumBlocks();
+    }
+    bool ok = f.Write( (uint32_t)BUILD_TRACE_MAGIC );
+    ok &= f.Write( (uint32_t)BUILD_TRACE_VERSION );
+    ok &= f.Write( Timer::GetFrequency() );
+    ok &= f.Write( description );
+    ok &= f.Write( numBlocks );
+
+    // Blocks
+    for ( const ThreadBuffer * buffer : m_ThreadBuffers )
+    {
+        ok &= buffer->WriteBlocks( f );
+    }
+    return ok;
+}
+
+// ConvertToJSON
+//------------------------------------------------------------------------------
+/*static*/ bool BuildTrace::ConvertToJSON( const char * traceFileName, const char * jsonFileName )
+{
+    PROFILE_FUNCTION;
+
+    FileStream f;
+    if ( f.Open( traceFileName, FileStream::READ_ONLY ) == false )
+    {
+        FLOG_ERROR( "Failed to open trace '%s'", traceFileName );
+        return false;
+    }
+
+    // Header
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    int64_t frequency = 0;
+    AString description;
+    uint32_t numBlocks = 0;
+    if ( ( f.Read( magic ) == false ) ||
+         ( magic != BUILD_TRACE_MAGIC ) ||
+         ( f.Read( version ) == false ) ||
+         ( version != BUILD_TRACE_VERSION ) ||
+         ( f.Read( frequency ) == false ) ||
+         ( frequency <= 0 ) ||
+         ( f.Read( description ) == false ) ||
+         ( f.Read( numBlocks ) == false ) )
+    {
+        FLOG_ERROR( "Invalid or unsupported trace '%s'", traceFileName );
+        return false;
+    }
+
+    // Track local and remote threads, for naming
+    struct WorkerInfo
+    {
+        AString     m_WorkerName;
+        uint32_t    m_MaxThreadId;
+    };
+    Array< WorkerInfo > workers;
+    uint32_t maxLocalThreadId = 0;
+
+    AString events;
+    events.SetReserved( 1024 * 1024 );
+    AStackString<> nameBuffer;
+    const double freqMul = ( 1000000.0 / (double)frequency );
+
+    // Blocks
+    UniquePtr< uint8_t, FreeDeletor > block( (uint8_t *)ALLOC( BLOCK_SIZE ) );
+    Array< AString > strings;
+    for ( uint32_t blockIndex = 0; blockIndex < numBlocks; ++blockIndex )
+    {
+        uint32_t blockSize = 0;
+        if ( ( f.Read( blockSize ) == false ) ||
+             ( blockSize > BLOCK_SIZE ) ||
+             ( f.ReadBuffer( block.Get(), blockSize ) != blockSize ) )
+        {
+            FLOG_ERROR( "Truncated trace '%s'", traceFileName );
+            return false;
+        }
+
+        // String ids are local to each block
+        strings.Clear();
+
+        const uint8_t * pos = block.Get();
+        const uint8_t * const end = ( pos + blockSize );
+        int64_t lastTime = 0;
+        while ( pos < end )
+        {
+            const uint8_t recordType = *pos++;
+            if ( recordType == RECORD_STRING )
+            {
+                uint64_t id;
+                uint64_t length;
+                if ( ( ReadVarInt( pos, end, id ) == false ) ||
+                     ( id != ( strings.GetSize() + 1 ) ) ||
+                     ( ReadVarInt( pos, end, length ) == false ) ||
+                     ( length > (uint64_t)( end - pos ) ) )
+                {
+                    break; // Corrupt
+                }
+                strings.EmplaceBack( (const char *)pos, (const char *)pos + length );
+                pos += length;
+                continue;
+            }
+            if ( recordType != RECORD_SPAN )
+            {
+                break; // Corrupt
+            }
+
+            uint64_t start;
+            uint64_t duration;
+            uint64_t machine;
+            uint64_t threadId;
+            uint64_t step;
+            uint64_t target;
+            if ( ( ReadVarInt( pos, end, start ) == false ) ||
+                 ( ReadVarInt( pos, end, duration ) == false ) ||
+                 ( ReadVarInt( pos, end, machine ) == false ) ||
+                 ( ReadVarInt( pos, end, threadId ) == false ) ||
+                 ( ReadVarInt( pos, end, step ) == false ) ||
+                 ( ReadVarInt( pos, end, target ) == false ) ||
+                 ( machine > strings.GetSize() ) ||
+                 ( step > strings.GetSize() ) ||
+                 ( target > strings.GetSize() ) )
+            {
+                break; // Corrupt
+            }
+            const int64_t startTime = ( lastTime + ZigZagDecode( start ) );
+            lastTime = startTime;
+
+            // Local machine is -1, with remote workers numbered in order of appearance
+            int32_t pid = -1;
+            if ( machine )
+            {
+                const AString & workerName = strings[ machine - 1 ];
+                WorkerInfo * worker = nullptr;
+                for ( WorkerInfo & info : workers )
+                {
+                    if ( info.m_WorkerName == workerName )
+                    {
+                        worker = &info;
+                        break;
+                    }
+                }
+                if ( worker == nullptr )
+                {
+                    worker = &workers.EmplaceBack();
+                    worker->m_WorkerName = workerName;
+                    worker->m_MaxThreadId = 0;
+                }
+                worker->m_MaxThreadId = Math::Max( worker->m_MaxThreadId, (uint32_t)threadId );
+                pid = (int32_t)workers.GetIndexOf( worker );
+            }
+            else
+            {
+                maxLocalThreadId = Math::Max( maxLocalThreadId, (uint32_t)threadId );
+            }
+
+            // Emit event with duration
+            nameBuffer = step ? strings[ step - 1 ].Get() : "Unknown";
+            JSON::Escape( nameBuffer );
+            events.AppendFormat( ",{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%" PRIu64 ",\"dur\":%" PRIu64 ",\"pid\":%i,\"tid\":%u",
+                                 nameBuffer.Get(),
+                                 (uint64_t)( (double)startTime * freqMul ),
+                                 (uint64_t)( (double)duration * freqMul ),
+                                 pid,
+                                 (uint32_t)threadId );
+
+            // Optional additional "target name"
+            if ( target )
+            {
+                nameBuffer = strings[ target - 1 ];
+                JSON::Escape( nameBuffer );
+                events.AppendFormat( ",\"args\":{\"name\":\"%s\"}", nameBuffer.Get() );
+            }
+            events += '}';
+        }
+        if ( pos != end )
+        {
+            FLOG_ERROR( "Corrupt block %u in trace '%s'", blockIndex, traceFileName );
+            return false;
+        }
+    }
+
+    // Section headings
+    AString buffer;
+    buffer.SetReserved( events.GetLength() + 4096 );
+    JSON::Escape( description );
+    buffer.AppendFormat( "[{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":-1,\"tid\":0,\"args\":{\"name\":\"%s\"}}", description.Get() );
+    buffer += ",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":-1,\"tid\":0,\"args\":{\"name\":\"Phase\"}}";
+    for ( uint32_t i = 1; i <= maxLocalThreadId; ++i )
+    {
+        buffer.AppendFormat( ",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":-1,\"tid\":%u,\"args\":{\"name\":\"Thread %02u\"}}", i, i );
+    }
+    for ( const WorkerInfo & worker : workers )
+    {
+        const uint32_t workerPid = (uint32_t)workers.GetIndexOf( &worker );
+        nameBuffer = worker.m_WorkerName;
+        JSON::Escape( nameBuffer );
+        buffer.AppendFormat( ",{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":0,\"args\":{\"name\":\"Worker: %s\"}}", workerPid, nameBuffer.Get() );
+        for ( uint32_t i = 1000; i <= worker.m_MaxThreadId; ++i )
+        {
+            buffer.AppendFormat( ",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"Thread %02u\"}}", workerPid, i, i - 1000 );
+        }
+    }
+    buffer += events;
+    buffer += ']';
+
+    FileStream out;
+    if ( ( out.Open( jsonFileName, FileStream::WRITE_ONLY ) == false ) ||
+         ( out.WriteBuffer( buffer.Get(), buffer.GetLength() ) != buffer.GetLength() ) )
+    {
+        FLOG_ERROR( "Failed to write '%s'", jsonFileName );
+        return false;
+    }
+    return true;
+}
+
+// GetThreadBuffer
+//------------------------------------------------------------------------------
+BuildTrace::ThreadBuffer * BuildTrace::GetThreadBuffer()
+{
+    // Fast path: this thread has already recorded to this trace
+    if ( tls_BuildTraceId == m_Id )
+    {
+        return static_cast< ThreadBuffer * >( tls_BuildTraceBuffer );
+    }
+
+    // First use on this thread
+    ThreadBuffer * buffer = FNEW( ThreadBuffer( m_NumBlocksPerThread ) );
+    {
+        MutexHolder mh( m_Mutex );
+        m_ThreadBuffers.Append( buffer );
+    }
+    tls_BuildTraceBuffer = buffer;
+    tls_BuildTraceId = m_Id;
+    return buffer;
+}
+
+//------------------------------------------------------------------------------
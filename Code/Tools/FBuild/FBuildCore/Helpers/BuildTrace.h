@@ -0,0 +1,74 @@
+// BuildTrace - Compact binary trace of build activity
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+// Core
+#include "Core/Containers/Array.h"
+#include "Core/Containers/Singleton.h"
+#include "Core/Env/Types.h"
+#include "Core/Process/Mutex.h"
+
+// Forward Declarations
+//------------------------------------------------------------------------------
+class AString;
+class FBuildOptions;
+
+// BuildTrace
+//  - A low-overhead alternative to BuildProfiler, cheap enough to leave enabled
+//  - Each thread records into its own ring of fixed size blocks, so recording
+//    never takes a lock and memory use is bounded. When the ring is full, the
+//    oldest block is overwritten.
+//  - Records are variable length encoded, with timestamps delta encoded and
+//    strings interned by pointer. Each block is self contained so blocks can
+//    be decoded even when older blocks have been overwritten.
+//  - Recorded strings are copied into the trace, so need only be valid while
+//    being recorded. As they are interned by pointer, the memory of a recorded
+//    string should not be reused for a different string during the build
+//------------------------------------------------------------------------------
+class BuildTrace : public Singleton<BuildTrace>
+{
+public:
+    enum : uint32_t
+    {
+        BLOCK_SIZE          = ( 32 * 1024 ),
+        DEFAULT_NUM_BLOCKS  = 32,           // Per thread (1 MiB)
+        MAX_STRING_LENGTH   = ( 4 * 1024 ), // Longer strings are truncated
+    };
+
+    explicit BuildTrace( uint32_t numBlocksPerThread = DEFAULT_NUM_BLOCKS );
+    ~BuildTrace();
+
+    // Record duration of a local step (BuildProfilerScope calls this)
+    void RecordLocal( uint32_t threadId,
+                      int64_t startTime,
+                      int64_t endTime,
+                      const char * stepName,
+                      const char * targetName );
+
+    // Record duration of a remote step
+    void RecordRemote( const AString & workerName,
+                       uint32_t remoteThreadId,
+                       int64_t startTime,
+                       int64_t endTime,
+                       const char * stepName,
+                       const char * targetName );
+
+    // Write the trace. Threads must not be recording while saving.
+    bool Save( const FBuildOptions & options, const char * fileName ) const;
+
+    // Convert a saved trace to Chrome tracing format (as used by -profile)
+    static bool ConvertToJSON( const char * traceFileName, const char * jsonFileName );
+
+private:
+    class ThreadBuffer;
+    ThreadBuffer * GetThreadBuffer();
+
+    uint32_t                m_Id;                   // Distinguishes thread-local state between instances
+    uint32_t                m_NumBlocksPerThread;
+    mutable Mutex           m_Mutex;                // Protects m_ThreadBuffers
+    Array< ThreadBuffer * > m_ThreadBuffers;
+};
+
+//------------------------------------------------------------------------------
@@ -31,6 +31,17 @@ public:
     }
 };
 
+// NodePeakMemorySorter
+//------------------------------------------------------------------------------
+class NodePeakMemorySorter
+{
+public:
+    inline bool operator () ( const Node * a, const Node * b ) const
+    {
+        return ( a->GetLastPeakMemoryMiB() > b->GetLastPeakMemoryMiB() );
+    }
+};
+
 // CONSTRUCTOR - FBuildStats
 //------------------------------------------------------------------------------
 FBuildStats::FBuildStats()
@@ -51,6 +62,7 @@ FBuildStats::Stats::Stats()
     , m_NumCacheHits( 0 )
     , m_NumCacheMisses( 0 )
     , m_NumCacheStores( 0 )
+    , m_NumCacheCorrupt( 0 )
     , m_NumLightCache( 0 )
     , m_ProcessingTimeMS( 0 )
     , m_NumFailed( 0 )
@@ -89,6 +101,13 @@ void FBuildStats::OnBuildStop( const NodeGraph & nodeGraph, Node * node )
     }
 }
 
+// RecordProcessUsage
+//------------------------------------------------------------------------------
+void FBuildStats::RecordProcessUsage( Node::Type nodeType, const Process::ResourceUsage & usage )
+{
+    m_PerTypeStats[ nodeType ].m_ProcessUsage.Accumulate( usage );
+}
+
 // GatherPostBuildStatistics
 //------------------------------------------------------------------------------
 void FBuildStats::GatherPostBuildStatistics( const NodeGraph & nodeGraph, Node * node )
@@ -103,6 +122,8 @@ void FBuildStats::GatherPostBuildStatistics( const NodeGraph & nodeGraph, Node *
 
     NodeCostSorter ncs;
     m_NodesByTime.Sort( ncs );
+    NodePeakMemorySorter npms;
+    m_NodesByPeakMemory.Sort( npms );
 
     // Total the stats
     for ( uint32_t i=0; i< Node::NUM_NODE_TYPES; ++i )
@@ -112,8 +133,10 @@ void FBuildStats::GatherPostBuildStatistics( const NodeGraph & nodeGraph, Node *
         m_Totals.m_NumCacheHits     += m_PerTypeStats[ i ].m_NumCacheHits;
         m_Totals.m_NumCacheMisses   += m_PerTypeStats[ i ].m_NumCacheMisses;
         m_Totals.m_NumCacheStores   += m_PerTypeStats[ i ].m_NumCacheStores;
+        m_Totals.m_NumCacheCorrupt  += m_PerTypeStats[ i ].m_NumCacheCorrupt;
         m_Totals.m_NumLightCache    += m_PerTypeStats[ i ].m_NumLightCache;
         m_Totals.m_CachingTimeMS    += m_PerTypeStats[ i ].m_CachingTimeMS;
+        m_Totals.m_ProcessUsage.Accumulate( m_PerTypeStats[ i ].m_ProcessUsage );
     }
 }
 
@@ -139,6 +162,20 @@ void FBuildStats::OutputSummary() const
         output += "\n";
     }
 
+    // Top 10 memory items
+    if ( m_NodesByPeakMemory.IsEmpty() == false )
+    {
+        output += "--- Most Memory -------------------------------------------------\n";
+        output += "Peak (MiB) Name:\n";
+        const size_t itemsToDisplay = Math::Min( m_NodesByPeakMemory.GetSize(), (size_t)10 );
+        for ( size_t i=0; i<itemsToDisplay; ++i )
+        {
+            const Node * n = m_NodesByPeakMemory[ i ];
+            output.AppendFormat( "%-10u %s\n", n->GetLastPeakMemoryMiB(), n->GetPrettyName().Get() );
+        }
+        output += "\n";
+    }
+
     output += "--- Summary -----------------------------------------------------\n";
 
     // Per-Node type stats
@@ -191,9 +228,27 @@ void FBuildStats::OutputSummary() const
         output.AppendFormat( " - Hits       : %u (%2.1f %%)\n", hits, (double)hitPerc );
         output.AppendFormat( " - Misses     : %u\n", misses );
         output.AppendFormat( " - Stores     : %u\n", stores );
+        if ( m_Totals.m_NumCacheCorrupt > 0 )
+        {
+            output.AppendFormat( " - Corrupt    : %u (quarantined)\n", m_Totals.m_NumCacheCorrupt );
+        }
     }
 
     AStackString<> buffer;
+    const Process::ResourceUsage & processUsage = m_Totals.m_ProcessUsage;
+    if ( processUsage.m_NumProcesses > 0 )
+    {
+        output += "Processes:\n";
+        output.AppendFormat( " - Count      : %u\n", processUsage.m_NumProcesses );
+        output.AppendFormat( " - Peak Memory: %u MiB\n", processUsage.m_PeakMemoryMiB );
+        FormatTime( (float)( (double)processUsage.m_UserTimeMS / (double)1000 ), buffer );
+        output.AppendFormat( " - User CPU   : %s\n", buffer.Get() );
+        FormatTime( (float)( (double)processUsage.m_SystemTimeMS / (double)1000 ), buffer );
+        output.AppendFormat( " - System CPU : %s\n", buffer.Get() );
+        output.AppendFormat( " - Read       : %2.1f MiB\n", (double)processUsage.m_ReadBytes / (double)MEGABYTE );
+        output.AppendFormat( " - Written    : %2.1f MiB\n", (double)processUsage.m_WriteBytes / (double)MEGABYTE );
+    }
+
     FormatTime( m_TotalBuildTime, buffer );
     output += "Time:\n";
     output.AppendFormat( " - Real       : %s\n", buffer.Get() );
@@ -245,6 +300,12 @@ void FBuildStats::GatherPostBuildStatisticsRecurse( Node * node )
             }
         }
 
+        // Track memory used by processes for nodes built in this build
+        if ( node->GetStatFlag( Node::STATS_BUILT ) && ( node->GetLastPeakMemoryMiB() > 0 ) )
+        {
+            m_NodesByPeakMemory.Append( node );
+        }
+
         if ( node->GetStatFlag( Node::STATS_BUILT ) )
         {
             stats.m_NumBuilt++;
@@ -266,6 +327,10 @@ void FBuildStats::GatherPostBuildStatisticsRecurse( Node * node )
             stats.m_NumCacheStores++;
             stats.m_CachingTimeMS += node->GetCachingTime();
         }
+        if ( node->GetStatFlag( Node::STATS_CACHE_CORRUPT ) )
+        {
+            stats.m_NumCacheCorrupt++;
+        }
         if ( node->GetStatFlag( Node::STATS_LIGHT_CACHE ) )
         {
             stats.m_NumLightCache++;
@@ -5,6 +5,7 @@
 // Includes
 //------------------------------------------------------------------------------
 #include "Core/Env/Types.h"
+#include "Core/Process/Process.h"
 #include "Tools/FBuild/FBuildCore/Graph/Node.h"
 
 // Forward Declarations
@@ -33,6 +34,9 @@ public:
     uint32_t    m_TotalLocalCPUTimeMS;  // Total CPU time on local host
     uint32_t    m_TotalRemoteCPUTimeMS; // Total CPU time on remote workers
 
+    // resources used by processes spawned to build a node
+    void RecordProcessUsage( Node::Type nodeType, const Process::ResourceUsage & usage );
+
     // after the build it complete, accumulate all the stats
     void GatherPostBuildStatistics( const NodeGraph & nodeGraph, Node * node );
 
@@ -44,7 +48,9 @@ public:
     uint32_t GetCacheHits() const       { return m_Totals.m_NumCacheHits; }
     uint32_t GetCacheMisses() const     { return m_Totals.m_NumCacheMisses; }
     uint32_t GetCacheStores() const     { return m_Totals.m_NumCacheStores; }
+    uint32_t GetCacheCorrupt() const    { return m_Totals.m_NumCacheCorrupt; }
     uint32_t GetLightCacheCount() const { return m_Totals.m_NumLightCache; }
+    const Process::ResourceUsage & GetProcessUsage() const { return m_Totals.m_ProcessUsage; }
 
     // get stats per node type
     struct Stats;
@@ -60,17 +66,21 @@ public:
         uint32_t m_NumCacheHits;
         uint32_t m_NumCacheMisses;
         uint32_t m_NumCacheStores;
+        uint32_t m_NumCacheCorrupt;
         uint32_t m_NumLightCache;
 
         uint32_t m_ProcessingTimeMS;
         uint32_t m_NumFailed;
         uint32_t m_CachingTimeMS;
+
+        Process::ResourceUsage m_ProcessUsage; // Local processes only
     };
 
     static void FormatTime( float timeInSeconds, AString & outBuffer );
 
     const Node * GetRootNode() const { return m_RootNode; }
     const Array< const Node * > & GetNodesByTime() const { return m_NodesByTime; }
+    const Array< const Node * > & GetNodesByPeakMemory() const { return m_NodesByPeakMemory; }
 
     static inline void SetIgnoreCompilerNodeDeps( bool b ) { s_IgnoreCompilerNodeDeps = b; }
 private:
@@ -85,6 +95,7 @@ private:
 
     Node * m_RootNode;
     Array< const Node * > m_NodesByTime;
+    Array< const Node * > m_NodesByPeakMemory;  // Nodes built in this build, by memory of spawned processes
 
     Stats m_PerTypeStats[ Node::NUM_NODE_TYPES ];
     Stats m_Totals;
@@ -0,0 +1,100 @@
+// FileTimeCache - Retain file timestamps between builds
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "FileTimeCache.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/FLog.h"
+
+// Core
+#include "Core/FileIO/PathUtils.h"
+#include "Core/Profile/Profile.h"
+#include "Core/Strings/AStackString.h"
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+FileTimeCache::FileTimeCache() = default;
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+FileTimeCache::~FileTimeCache() = default;
+
+// Update
+//------------------------------------------------------------------------------
+void FileTimeCache::Update()
+{
+    PROFILE_FUNCTION;
+
+    Array< AString > changedFiles;
+    if ( m_Watcher.GetChanges( changedFiles ) == false )
+    {
+        // Changes may have been missed, so nothing can be trusted
+        FLOG_VERBOSE( "File change notifications were lost - all files will be checked" );
+        m_FileTimes.Destruct();
+        return;
+    }
+
+    for ( const AString & changedFile : changedFiles )
+    {
+        UnorderedMap< AString, Entry >::KeyValue * keyValue = m_FileTimes.Find( changedFile );
+        if ( keyValue )
+        {
+            keyValue->m_Value.m_Valid = false;
+        }
+    }
+}
+
+// GetFileTime
+//------------------------------------------------------------------------------
+bool FileTimeCache::GetFileTime( const AString & fileName, uint64_t & outFileTime )
+{
+    const UnorderedMap< AString, Entry >::KeyValue * keyValue = m_FileTimes.Find( fileName );
+    if ( ( keyValue == nullptr ) || ( keyValue->m_Value.m_Valid == false ) )
+    {
+        return false;
+    }
+    outFileTime = keyValue->m_Value.m_FileTime;
+    return true;
+}
+
+// WatchDirectoryOf
+//------------------------------------------------------------------------------
+bool FileTimeCache::WatchDirectoryOf( const AString & fileName )
+{
+    const char * lastSlash = fileName.FindLast( NATIVE_SLASH );
+    if ( ( lastSlash == nullptr ) || ( lastSlash == fileName.Get() ) )
+    {
+        return false; // Relative paths and files in the root are not cached
+    }
+    const AStackString<> dir( fileName.Get(), lastSlash );
+    return m_Watcher.WatchDirectory( dir );
+}
+
+// StoreFileTime
+//------------------------------------------------------------------------------
+void FileTimeCache::StoreFileTime( const AString & fileName, uint64_t fileTime )
+{
+    const char * lastSlash = fileName.FindLast( NATIVE_SLASH );
+    if ( ( lastSlash == nullptr ) || ( lastSlash == fileName.Get() ) )
+    {
+        return;
+    }
+    const AStackString<> dir( fileName.Get(), lastSlash );
+    if ( m_Watcher.IsWatched( dir ) == false )
+    {
+        return; // Changes would not be detected
+    }
+
+    UnorderedMap< AString, Entry >::KeyValue * keyValue = m_FileTimes.Find( fileName );
+    if ( keyValue )
+    {
+        keyValue->m_Value.m_FileTime = fileTime;
+        keyValue->m_Value.m_Valid = true;
+        return;
+    }
+    m_FileTimes.Insert( fileName, Entry{ fileTime, true } );
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,50 @@
+// FileTimeCache - Retain file timestamps between builds
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Core/Containers/UnorderedMap.h"
+#include "Core/Env/Types.h"
+#include "Core/FileIO/FileWatcher.h"
+
+// FileTimeCache
+//  - Used by long-lived processes (see BuildDaemon) to avoid re-checking files
+//    which haven't changed between builds.
+//  - Only files in watched directories are cached. When watching is not
+//    possible, files are always checked.
+//  - Times are stored as obtained by PrefetchFileStamps, so are content hashes
+//    for input files when using -contenthash
+//------------------------------------------------------------------------------
+class FileTimeCache
+{
+public:
+    FileTimeCache();
+    ~FileTimeCache();
+
+    // Discard times of files changed since the previous update
+    void Update();
+
+    // Discard all times (i.e. if the meaning of stored times changes)
+    void Clear() { m_FileTimes.Destruct(); }
+
+    // Retrieve a cached time
+    bool GetFileTime( const AString & fileName, uint64_t & outFileTime );
+
+    // A time can only be cached if the directory containing the file was being
+    // watched before the time was obtained
+    bool WatchDirectoryOf( const AString & fileName );
+    void StoreFileTime( const AString & fileName, uint64_t fileTime );
+
+private:
+    struct Entry
+    {
+        uint64_t    m_FileTime;
+        bool        m_Valid;
+    };
+
+    FileWatcher                     m_Watcher;
+    UnorderedMap< AString, Entry >  m_FileTimes;
+};
+
+//------------------------------------------------------------------------------
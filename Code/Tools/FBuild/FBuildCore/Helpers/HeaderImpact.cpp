@@ -0,0 +1,228 @@
+// HeaderImpact - Rank headers by the cost of rebuilding everything which depends on them
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "HeaderImpact.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/Graph/Dependencies.h"
+#include "Tools/FBuild/FBuildCore/Graph/Node.h"
+#include "Tools/FBuild/FBuildCore/Graph/NodeGraph.h"
+
+// Core
+#include "Core/Math/Conversions.h"
+#include "Core/Process/Atomic.h"
+#include "Core/Process/Semaphore.h"
+#include "Core/Process/ThreadPool.h"
+#include "Core/Profile/Profile.h"
+
+// system
+#include <string.h> // for memset
+
+// HeaderImpact::Analyzer
+//  - Shared state for threads analyzing headers
+//  - The graph is flattened into arrays indexed by node, with the reverse
+//    edges (the nodes which depend on each node) stored contiguously
+//------------------------------------------------------------------------------
+class HeaderImpact::Analyzer
+{
+public:
+    explicit Analyzer( Array< HeaderStats > & headers )
+        : m_Headers( headers )
+    {
+    }
+
+    void Prepare( const NodeGraph & nodeGraph )
+    {
+        PROFILE_FUNCTION;
+
+        const uint32_t numNodes = static_cast< uint32_t >( nodeGraph.GetNodeCount() );
+
+        // Number the nodes so dependencies can be found by index
+        m_BuildTimeMS.SetSize( numNodes );
+        m_IsObject.SetSize( numNodes );
+        for ( uint32_t i = 0; i < numNodes; ++i )
+        {
+            const Node * node = nodeGraph.GetNodeByIndex( i );
+            node->SetBuildPassTag( i );
+            m_BuildTimeMS[ i ] = node->GetLastBuildTime();
+            m_IsObject[ i ] = ( node->GetType() == Node::OBJECT_NODE );
+        }
+
+        // Count dependents of each node and find the headers. Only static and
+        // dynamic dependencies cause a node to be rebuilt.
+        Array< uint32_t > headerIndices; // Per node, or INVALID_INDEX if not a header
+        headerIndices.SetSize( numNodes );
+        memset( headerIndices.Begin(), 0xFF, numNodes * sizeof( uint32_t ) );
+        m_FirstDependent.SetSize( numNodes + 1 );
+        memset( m_FirstDependent.Begin(), 0, ( numNodes + 1 ) * sizeof( uint32_t ) );
+        for ( uint32_t i = 0; i < numNodes; ++i )
+        {
+            const Node * node = nodeGraph.GetNodeByIndex( i );
+            for ( const Dependency & dep : node->GetStaticDependencies() )
+            {
+                m_FirstDependent[ dep.GetNode()->GetBuildPassTag() ]++;
+            }
+            for ( const Dependency & dep : node->GetDynamicDependencies() )
+            {
+                const Node * depNode = dep.GetNode();
+                const uint32_t depIndex = depNode->GetBuildPassTag();
+                m_FirstDependent[ depIndex ]++;
+                if ( m_IsObject[ i ] &&
+                     ( depNode->GetType() == Node::FILE_NODE ) &&
+                     ( headerIndices[ depIndex ] == INVALID_INDEX ) )
+                {
+                    headerIndices[ depIndex ] = static_cast< uint32_t >( m_HeaderNodes.GetSize() );
+                    m_HeaderNodes.Append( depIndex );
+                    m_Headers.EmplaceBack().m_Header = depNode;
+                }
+            }
+        }
+
+        // Convert counts to offsets (offsets are decremented as dependents
+        // are stored, leaving each at the first dependent)
+        uint32_t total = 0;
+        for ( uint32_t i = 0; i <= numNodes; ++i )
+        {
+            total += m_FirstDependent[ i ];
+            m_FirstDependent[ i ] = total;
+        }
+        m_Dependents.SetSize( total );
+        for ( uint32_t i = 0; i < numNodes; ++i )
+        {
+            const Node * node = nodeGraph.GetNodeByIndex( i );
+            for ( const Dependency & dep : node->GetStaticDependencies() )
+            {
+                m_Dependents[ --m_FirstDependent[ dep.GetNode()->GetBuildPassTag() ] ] = i;
+            }
+            for ( const Dependency & dep : node->GetDynamicDependencies() )
+            {
+                m_Dependents[ --m_FirstDependent[ dep.GetNode()->GetBuildPassTag() ] ] = i;
+            }
+        }
+    }
+
+    static void ThreadFunc( void * userData )
+    {
+        Analyzer * self = static_cast< Analyzer * >( userData );
+        self->Process();
+        self->m_ThreadsCompleted.Signal();
+    }
+
+    void Process()
+    {
+        PROFILE_FUNCTION;
+
+        // Nodes visited for the current header are marked with the header's
+        // index (+1), so marks never need clearing
+        const uint32_t numNodes = static_cast< uint32_t >( m_BuildTimeMS.GetSize() );
+        Array< uint32_t > visited;
+        visited.SetSize( numNodes );
+        memset( visited.Begin(), 0, numNodes * sizeof( uint32_t ) );
+        Array< uint32_t > toVisit( 1024 );
+
+        // Each thread takes the next header until none remain
+        const uint32_t numHeaders = static_cast< uint32_t >( m_HeaderNodes.GetSize() );
+        for ( ;; )
+        {
+            const uint32_t index = ( AtomicInc( &m_NextHeader ) - 1 );
+            if ( index >= numHeaders )
+            {
+                return;
+            }
+            const uint32_t mark = ( index + 1 );
+            HeaderStats & stats = m_Headers[ index ];
+
+            // Visit everything which depends on the header
+            visited[ m_HeaderNodes[ index ] ] = mark;
+            toVisit.Append( m_HeaderNodes[ index ] );
+            while ( toVisit.IsEmpty() == false )
+            {
+                const uint32_t nodeIndex = toVisit.Top();
+                toVisit.Pop();
+                const uint32_t * const end = ( m_Dependents.Begin() + m_FirstDependent[ nodeIndex + 1 ] );
+                for ( const uint32_t * it = ( m_Dependents.Begin() + m_FirstDependent[ nodeIndex ] ); it != end; ++it )
+                {
+                    const uint32_t dependent = *it;
+                    if ( visited[ dependent ] == mark )
+                    {
+                        continue;
+                    }
+                    visited[ dependent ] = mark;
+                    toVisit.Append( dependent );
+
+                    const uint32_t buildTimeMS = m_BuildTimeMS[ dependent ];
+                    stats.m_NumDependents++;
+                    stats.m_RebuildTimeMS += buildTimeMS;
+                    if ( m_IsObject[ dependent ] )
+                    {
+                        stats.m_NumObjects++;
+                        stats.m_CompileTimeMS += buildTimeMS;
+                    }
+                }
+            }
+        }
+    }
+
+    enum : uint32_t { INVALID_INDEX = 0xFFFFFFFF };
+
+    Array< HeaderStats > &  m_Headers;
+    Array< uint32_t >       m_HeaderNodes;      // Node index of each header
+    Array< uint32_t >       m_BuildTimeMS;      // Per node
+    Array< bool >           m_IsObject;         // Per node
+    Array< uint32_t >       m_FirstDependent;   // Per node (+1), indexing m_Dependents
+    Array< uint32_t >       m_Dependents;
+    uint32_t                m_NextHeader = 0;
+    Semaphore               m_ThreadsCompleted;
+};
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+HeaderImpact::HeaderImpact() = default;
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+HeaderImpact::~HeaderImpact() = default;
+
+// Analyze
+//------------------------------------------------------------------------------
+void HeaderImpact::Analyze( const NodeGraph & nodeGraph, ThreadPool * threadPool )
+{
+    PROFILE_FUNCTION;
+
+    m_Headers.Clear();
+    m_NumObjects = 0;
+    m_TotalCompileTimeMS = 0;
+
+    Analyzer analyzer( m_Headers );
+    analyzer.Prepare( nodeGraph );
+    for ( size_t i = 0; i < analyzer.m_IsObject.GetSize(); ++i )
+    {
+        if ( analyzer.m_IsObject[ i ] )
+        {
+            m_NumObjects++;
+            m_TotalCompileTimeMS += analyzer.m_BuildTimeMS[ i ];
+        }
+    }
+
+    // Use the thread pool (if there are enough headers to be worthwhile), with
+    // the main thread helping out
+    const uint32_t kMinHeadersPerThread = 64;
+    const uint32_t numThreads = threadPool ? Math::Min( threadPool->GetNumThreads(),
+                                                        static_cast< uint32_t >( m_Headers.GetSize() / kMinHeadersPerThread ) )
+                                           : 0;
+    for ( uint32_t i = 0; i < numThreads; ++i )
+    {
+        threadPool->EnqueueJob( Analyzer::ThreadFunc, &analyzer );
+    }
+    analyzer.Process();
+    for ( uint32_t i = 0; i < numThreads; ++i )
+    {
+        analyzer.m_ThreadsCompleted.Wait();
+    }
+
+    m_Headers.Sort();
+}
+
+//------------------------------------------------------------------------------
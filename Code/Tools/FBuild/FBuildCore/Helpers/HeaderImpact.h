@@ -0,0 +1,56 @@
+// HeaderImpact - Rank headers by the cost of rebuilding everything which depends on them
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+// Core
+#include "Core/Containers/Array.h"
+#include "Core/Env/Types.h"
+
+// Forward Declarations
+//------------------------------------------------------------------------------
+class Node;
+class NodeGraph;
+class ThreadPool;
+
+// HeaderImpact
+//  - A header is any file included by an object in the dependency database
+//  - Costs are the last recorded build time of each dependent node, so the
+//    analysis requires no build
+//------------------------------------------------------------------------------
+class HeaderImpact
+{
+public:
+    HeaderImpact();
+    ~HeaderImpact();
+
+    class HeaderStats
+    {
+    public:
+        const Node *    m_Header            = nullptr;
+        uint32_t        m_NumObjects        = 0;    // Objects including this header (directly or indirectly)
+        uint32_t        m_NumDependents     = 0;    // All nodes which would rebuild, including objects
+        uint64_t        m_CompileTimeMS     = 0;    // Summed build time of objects
+        uint64_t        m_RebuildTimeMS     = 0;    // Summed build time of all dependents
+
+        bool operator < ( const HeaderStats & other ) const { return ( m_RebuildTimeMS > other.m_RebuildTimeMS ); }
+    };
+
+    // Analyze all headers in the graph, using the thread pool (if provided)
+    void Analyze( const NodeGraph & nodeGraph, ThreadPool * threadPool );
+
+    // Sorted by rebuild time, most expensive first
+    const Array< HeaderStats > &    GetHeaders() const              { return m_Headers; }
+    uint32_t                        GetNumObjects() const           { return m_NumObjects; }
+    uint64_t                        GetTotalCompileTimeMS() const   { return m_TotalCompileTimeMS; }
+
+private:
+    class Analyzer;
+
+    Array< HeaderStats >    m_Headers;
+    uint32_t                m_NumObjects            = 0;
+    uint64_t                m_TotalCompileTimeMS    = 0;
+};
+
+//------------------------------------------------------------------------------
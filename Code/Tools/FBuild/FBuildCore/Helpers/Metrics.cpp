@@ -0,0 +1,184 @@
+// Metrics - Process-wide counters and histograms for live monitoring
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Metrics.h"
+
+// Core
+#include "Core/Strings/AString.h"
+
+// Static Data
+//------------------------------------------------------------------------------
+// Local job processing (JobQueue)
+/*static*/ MetricCounter    Metrics::s_JobsQueued( "fastbuild_jobs_queued_total", "Jobs queued for local processing." );
+/*static*/ MetricCounter    Metrics::s_JobsQueuedDistributable( "fastbuild_jobs_queued_distributable_total", "Jobs made available for distribution." );
+/*static*/ MetricGauge      Metrics::s_JobsActive( "fastbuild_jobs_active", "Jobs currently being processed locally." );
+/*static*/ MetricCounter    Metrics::s_JobsSucceeded( "fastbuild_jobs_succeeded_total", "Jobs completed successfully." );
+/*static*/ MetricCounter    Metrics::s_JobsFailed( "fastbuild_jobs_failed_total", "Jobs which failed." );
+/*static*/ MetricHistogram  Metrics::s_JobDuration( "fastbuild_job_duration_seconds", "Time taken to process jobs locally." );
+
+// Distribution to remote workers (Client)
+/*static*/ MetricGauge      Metrics::s_ClientConnections( "fastbuild_client_connections", "Connected remote workers." );
+/*static*/ MetricCounter    Metrics::s_ClientJobsSent( "fastbuild_client_jobs_sent_total", "Jobs sent to remote workers." );
+/*static*/ MetricCounter    Metrics::s_ClientJobResults( "fastbuild_client_job_results_total", "Job results received from remote workers." );
+/*static*/ MetricCounter    Metrics::s_ClientBytesSent( "fastbuild_client_sent_bytes_total", "Job data sent to remote workers." );
+/*static*/ MetricCounter    Metrics::s_ClientBytesReceived( "fastbuild_client_received_bytes_total", "Job result data received from remote workers." );
+
+// Builds for remote clients (Server)
+/*static*/ MetricGauge      Metrics::s_ServerConnections( "fastbuild_server_connections", "Connected remote clients." );
+/*static*/ MetricCounter    Metrics::s_ServerJobsReceived( "fastbuild_server_jobs_received_total", "Jobs received from remote clients." );
+/*static*/ MetricCounter    Metrics::s_ServerJobResults( "fastbuild_server_job_results_total", "Job results sent to remote clients." );
+/*static*/ MetricCounter    Metrics::s_ServerBytesSent( "fastbuild_server_sent_bytes_total", "Job result data sent to remote clients." );
+/*static*/ MetricCounter    Metrics::s_ServerBytesReceived( "fastbuild_server_received_bytes_total", "Job data received from remote clients." );
+/*static*/ MetricHistogram  Metrics::s_ServerJobDuration( "fastbuild_server_job_duration_seconds", "Time taken to process jobs for remote clients." );
+
+// Cache
+/*static*/ MetricCounter    Metrics::s_CacheHits( "fastbuild_cache_hits_total", "Successful cache retrievals." );
+/*static*/ MetricCounter    Metrics::s_CacheMisses( "fastbuild_cache_misses_total", "Unsuccessful cache retrievals." );
+/*static*/ MetricCounter    Metrics::s_CacheStores( "fastbuild_cache_stores_total", "Items stored in the cache." );
+/*static*/ MetricCounter    Metrics::s_CacheBytesRead( "fastbuild_cache_read_bytes_total", "Data retrieved from the cache." );
+/*static*/ MetricCounter    Metrics::s_CacheBytesWritten( "fastbuild_cache_written_bytes_total", "Data stored in the cache." );
+/*static*/ MetricCounter    Metrics::s_CacheCorrupt( "fastbuild_cache_corrupt_total", "Corrupt cache entries retrieved (and quarantined)." );
+/*static*/ MetricCounter    Metrics::s_CacheLocalHits( "fastbuild_cache_local_hits_total", "Cache retrievals served by the local cache tier." );
+
+// Coordinator
+/*static*/ MetricGauge      Metrics::s_CoordinatorWorkers( "fastbuild_coordinator_workers", "Workers registered with the coordinator." );
+/*static*/ MetricCounter    Metrics::s_CoordinatorWorkerListRequests( "fastbuild_coordinator_worker_list_requests_total", "Worker lists requested from the coordinator." );
+
+// Histogram buckets (upper bounds, inclusive)
+/*static*/ const uint32_t MetricHistogram::s_BucketBoundsMS[ NUM_BUCKETS ] =
+{
+    5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 30000, 60000
+};
+
+// Metric (CONSTRUCTOR)
+//------------------------------------------------------------------------------
+Metric::Metric( const char * name, const char * help )
+    : m_Name( name )
+    , m_Help( help )
+{
+}
+
+// FormatHeader
+//------------------------------------------------------------------------------
+void Metric::FormatHeader( AString & outText, const char * type ) const
+{
+    outText.AppendFormat( "# HELP %s %s\n", m_Name, m_Help );
+    outText.AppendFormat( "# TYPE %s %s\n", m_Name, type );
+}
+
+// MetricCounter (CONSTRUCTOR)
+//------------------------------------------------------------------------------
+MetricCounter::MetricCounter( const char * name, const char * help )
+    : Metric( name, help )
+{
+}
+
+// Format
+//------------------------------------------------------------------------------
+/*virtual*/ void MetricCounter::Format( AString & outText ) const
+{
+    FormatHeader( outText, "counter" );
+    outText.AppendFormat( "%s %" PRIu64 "\n", m_Name, Get() );
+}
+
+// MetricGauge (CONSTRUCTOR)
+//------------------------------------------------------------------------------
+MetricGauge::MetricGauge( const char * name, const char * help )
+    : Metric( name, help )
+{
+}
+
+// Format
+//------------------------------------------------------------------------------
+/*virtual*/ void MetricGauge::Format( AString & outText ) const
+{
+    FormatHeader( outText, "gauge" );
+    outText.AppendFormat( "%s %" PRIi64 "\n", m_Name, Get() );
+}
+
+// MetricHistogram (CONSTRUCTOR)
+//------------------------------------------------------------------------------
+MetricHistogram::MetricHistogram( const char * name, const char * help )
+    : Metric( name, help )
+{
+}
+
+// Observe
+//------------------------------------------------------------------------------
+void MetricHistogram::Observe( uint32_t timeMS )
+{
+    uint32_t bucket = 0;
+    while ( ( bucket < NUM_BUCKETS ) && ( timeMS > s_BucketBoundsMS[ bucket ] ) )
+    {
+        ++bucket;
+    }
+    m_Buckets[ bucket ].Increment();
+    m_SumMS.Add( timeMS );
+    m_Count.Increment();
+}
+
+// Format
+//------------------------------------------------------------------------------
+/*virtual*/ void MetricHistogram::Format( AString & outText ) const
+{
+    FormatHeader( outText, "histogram" );
+
+    // Buckets are stored individually and reported cumulatively
+    uint64_t cumulative = 0;
+    for ( uint32_t i = 0; i < NUM_BUCKETS; ++i )
+    {
+        cumulative += m_Buckets[ i ].Load();
+        outText.AppendFormat( "%s_bucket{le=\"%u.%03u\"} %" PRIu64 "\n", m_Name, s_BucketBoundsMS[ i ] / 1000, s_BucketBoundsMS[ i ] % 1000, cumulative );
+    }
+    cumulative += m_Buckets[ NUM_BUCKETS ].Load();
+    outText.AppendFormat( "%s_bucket{le=\"+Inf\"} %" PRIu64 "\n", m_Name, cumulative );
+
+    // Count is derived from the buckets so they are consistent, even if
+    // updated concurrently
+    const uint64_t sumMS = m_SumMS.Load();
+    outText.AppendFormat( "%s_sum %" PRIu64 ".%03u\n", m_Name, sumMS / 1000, (uint32_t)( sumMS % 1000 ) );
+    outText.AppendFormat( "%s_count %" PRIu64 "\n", m_Name, cumulative );
+}
+
+// Format
+//------------------------------------------------------------------------------
+/*static*/ void Metrics::Format( AString & outText )
+{
+    const Metric * const metrics[] =
+    {
+        &s_JobsQueued,
+        &s_JobsQueuedDistributable,
+        &s_JobsActive,
+        &s_JobsSucceeded,
+        &s_JobsFailed,
+        &s_JobDuration,
+        &s_ClientConnections,
+        &s_ClientJobsSent,
+        &s_ClientJobResults,
+        &s_ClientBytesSent,
+        &s_ClientBytesReceived,
+        &s_ServerConnections,
+        &s_ServerJobsReceived,
+        &s_ServerJobResults,
+        &s_ServerBytesSent,
+        &s_ServerBytesReceived,
+        &s_ServerJobDuration,
+        &s_CacheHits,
+        &s_CacheMisses,
+        &s_CacheStores,
+        &s_CacheBytesRead,
+        &s_CacheBytesWritten,
+        &s_CacheCorrupt,
+        &s_CacheLocalHits,
+        &s_CoordinatorWorkers,
+        &s_CoordinatorWorkerListRequests,
+    };
+    for ( const Metric * metric : metrics )
+    {
+        metric->Format( outText );
+    }
+}
+
+//------------------------------------------------------------------------------
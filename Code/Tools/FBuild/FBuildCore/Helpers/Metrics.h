@@ -0,0 +1,134 @@
+// Metrics - Process-wide counters and histograms for live monitoring
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Core/Env/Types.h"
+#include "Core/Process/Atomic.h"
+
+// Forward Declarations
+//------------------------------------------------------------------------------
+class AString;
+
+// Metric
+//  - Metrics are updated lock-free and can be updated from any thread
+//  - Values accumulate for the lifetime of the process
+//------------------------------------------------------------------------------
+class Metric
+{
+public:
+    Metric( const char * name, const char * help );
+    virtual ~Metric() = default;
+
+    // Append metric in the Prometheus text exposition format
+    virtual void Format( AString & outText ) const = 0;
+
+protected:
+    void FormatHeader( AString & outText, const char * type ) const;
+
+    const char * m_Name;
+    const char * m_Help;
+};
+
+// MetricCounter - a monotonically increasing value
+//------------------------------------------------------------------------------
+class MetricCounter : public Metric
+{
+public:
+    MetricCounter( const char * name, const char * help );
+
+    void                    Add( uint64_t value = 1 )   { m_Value.Add( value ); }
+    [[nodiscard]] uint64_t  Get() const                 { return m_Value.Load(); }
+
+    virtual void Format( AString & outText ) const override;
+
+private:
+    Atomic< uint64_t > m_Value;
+};
+
+// MetricGauge - a value which can go up and down
+//------------------------------------------------------------------------------
+class MetricGauge : public Metric
+{
+public:
+    MetricGauge( const char * name, const char * help );
+
+    void                    Increment()                 { m_Value.Increment(); }
+    void                    Decrement()                 { m_Value.Decrement(); }
+    void                    Set( int64_t value )        { m_Value.Store( value ); }
+    [[nodiscard]] int64_t   Get() const                 { return m_Value.Load(); }
+
+    virtual void Format( AString & outText ) const override;
+
+private:
+    Atomic< int64_t > m_Value;
+};
+
+// MetricHistogram - a distribution of durations
+//------------------------------------------------------------------------------
+class MetricHistogram : public Metric
+{
+public:
+    MetricHistogram( const char * name, const char * help );
+
+    void                    Observe( uint32_t timeMS );
+    [[nodiscard]] uint64_t  GetCount() const            { return m_Count.Load(); }
+
+    virtual void Format( AString & outText ) const override;
+
+private:
+    enum : uint32_t { NUM_BUCKETS = 13 };
+    static const uint32_t   s_BucketBoundsMS[ NUM_BUCKETS ];
+
+    Atomic< uint64_t >      m_Buckets[ NUM_BUCKETS + 1 ]; // Last is overflow (+Inf)
+    Atomic< uint64_t >      m_Count;
+    Atomic< uint64_t >      m_SumMS;
+};
+
+// Metrics
+//------------------------------------------------------------------------------
+class Metrics
+{
+public:
+    // Local job processing (JobQueue)
+    static MetricCounter    s_JobsQueued;
+    static MetricCounter    s_JobsQueuedDistributable;
+    static MetricGauge      s_JobsActive;
+    static MetricCounter    s_JobsSucceeded;
+    static MetricCounter    s_JobsFailed;
+    static MetricHistogram  s_JobDuration;
+
+    // Distribution to remote workers (Client)
+    static MetricGauge      s_ClientConnections;
+    static MetricCounter    s_ClientJobsSent;
+    static MetricCounter    s_ClientJobResults;
+    static MetricCounter    s_ClientBytesSent;
+    static MetricCounter    s_ClientBytesReceived;
+
+    // Builds for remote clients (Server)
+    static MetricGauge      s_ServerConnections;
+    static MetricCounter    s_ServerJobsReceived;
+    static MetricCounter    s_ServerJobResults;
+    static MetricCounter    s_ServerBytesSent;
+    static MetricCounter    s_ServerBytesReceived;
+    static MetricHistogram  s_ServerJobDuration;
+
+    // Cache
+    static MetricCounter    s_CacheHits;
+    static MetricCounter    s_CacheMisses;
+    static MetricCounter    s_CacheStores;
+    static MetricCounter    s_CacheBytesRead;
+    static MetricCounter    s_CacheBytesWritten;
+    static MetricCounter    s_CacheCorrupt;
+    static MetricCounter    s_CacheLocalHits;
+
+    // Coordinator
+    static MetricGauge      s_CoordinatorWorkers;
+    static MetricCounter    s_CoordinatorWorkerListRequests;
+
+    // Append all metrics in the Prometheus text exposition format
+    static void Format( AString & outText );
+};
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,138 @@
+// MetricsServer - Serve Metrics over HTTP for live monitoring
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "MetricsServer.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/Helpers/Metrics.h"
+
+// Core
+#include "Core/Strings/AStackString.h"
+#include "Core/Strings/AString.h"
+#include "Core/Tracing/Tracing.h"
+
+// Defines
+//------------------------------------------------------------------------------
+#define MAX_REQUEST_SIZE ( 8 * KILOBYTE ) // Requests are just a few headers
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+MetricsServer::MetricsServer()
+    : TCPConnectionPool()
+{
+    SetRawMode( true );
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+MetricsServer::~MetricsServer()
+{
+    ShutdownAllConnections();
+}
+
+// Start
+//------------------------------------------------------------------------------
+bool MetricsServer::Start( uint16_t port )
+{
+    if ( Listen( port, true ) == false )
+    {
+        OUTPUT( "FBuild: Warning: Failed to listen for metrics requests on port %u\n", (uint32_t)port );
+        return false;
+    }
+    return true;
+}
+
+// OnReceive
+//------------------------------------------------------------------------------
+/*virtual*/ void MetricsServer::OnReceive( const ConnectionInfo * connection, void * data, uint32_t size, bool & /*keepMemory*/ )
+{
+    // Accumulate until the request headers are complete
+    AString * request = static_cast< AString * >( connection->GetUserData() );
+    if ( request == nullptr )
+    {
+        return; // Response already sent
+    }
+    request->Append( static_cast< const char * >( data ), size );
+    const char * headersEnd = request->Find( "\r\n\r\n" );
+    if ( headersEnd == nullptr )
+    {
+        headersEnd = request->Find( "\n\n" );
+    }
+    if ( headersEnd == nullptr )
+    {
+        if ( request->GetLength() > MAX_REQUEST_SIZE )
+        {
+            SendResponse( connection, "400 Bad Request", AStackString<>( "Bad Request\n" ) );
+        }
+        return;
+    }
+
+    // Request line: <method> <path> <version>
+    const char * pathStart = request->Find( ' ' );
+    const char * pathEnd = pathStart ? request->Find( ' ', pathStart + 1 ) : nullptr;
+    if ( ( pathEnd == nullptr ) || ( pathEnd > headersEnd ) )
+    {
+        SendResponse( connection, "400 Bad Request", AStackString<>( "Bad Request\n" ) );
+        return;
+    }
+    const AStackString<> method( request->Get(), pathStart );
+    const AStackString<> path( pathStart + 1, pathEnd );
+    if ( method != "GET" )
+    {
+        SendResponse( connection, "405 Method Not Allowed", AStackString<>( "Method Not Allowed\n" ) );
+        return;
+    }
+    if ( ( path != "/metrics" ) && ( path.BeginsWith( "/metrics?" ) == false ) )
+    {
+        SendResponse( connection, "404 Not Found", AStackString<>( "Not Found\n" ) );
+        return;
+    }
+
+    AString body( 16 * KILOBYTE );
+    Metrics::Format( body );
+    SendResponse( connection, "200 OK", body );
+}
+
+// OnConnected
+//------------------------------------------------------------------------------
+/*virtual*/ void MetricsServer::OnConnected( const ConnectionInfo * connection )
+{
+    connection->SetUserData( FNEW( AString ) );
+}
+
+// OnDisconnected
+//------------------------------------------------------------------------------
+/*virtual*/ void MetricsServer::OnDisconnected( const ConnectionInfo * connection )
+{
+    AString * request = static_cast< AString * >( connection->GetUserData() );
+    connection->SetUserData( nullptr );
+    FDELETE request;
+}
+
+// SendResponse
+//------------------------------------------------------------------------------
+void MetricsServer::SendResponse( const ConnectionInfo * connection, const char * status, const AString & body )
+{
+    // Only one request is handled per connection
+    AString * request = static_cast< AString * >( connection->GetUserData() );
+    connection->SetUserData( nullptr );
+    FDELETE request;
+
+    AStackString<> header;
+    header.Format( "HTTP/1.0 %s\r\n"
+                   "Content-Type: text/plain; version=0.0.4\r\n"
+                   "Content-Length: %u\r\n"
+                   "Connection: close\r\n"
+                   "\r\n",
+                   status,
+                   body.GetLength() );
+    if ( SendRaw( connection, header.Get(), header.GetLength() ) )
+    {
+        SendRaw( connection, body.Get(), body.GetLength() );
+    }
+    Disconnect( connection );
+}
+
+//------------------------------------------------------------------------------
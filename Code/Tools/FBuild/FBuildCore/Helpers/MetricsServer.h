@@ -0,0 +1,32 @@
+// MetricsServer - Serve Metrics over HTTP for live monitoring
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Core/Network/TCPConnectionPool.h"
+
+// MetricsServer
+//  - Enabled with -metricsport, serves the Metrics on "/metrics" in the
+//    Prometheus text exposition format
+//  - Only accepts connections from this machine
+//  - Minimal HTTP/1.0 implementation: one GET request per connection
+//------------------------------------------------------------------------------
+class MetricsServer : public TCPConnectionPool
+{
+public:
+    MetricsServer();
+    virtual ~MetricsServer() override;
+
+    bool Start( uint16_t port );
+
+protected:
+    // TCPConnectionPool interface
+    virtual void OnReceive( const ConnectionInfo * connection, void * data, uint32_t size, bool & keepMemory ) override;
+    virtual void OnConnected( const ConnectionInfo * connection ) override;
+    virtual void OnDisconnected( const ConnectionInfo * connection ) override;
+
+    void SendResponse( const ConnectionInfo * connection, const char * status, const AString & body );
+};
+
+//------------------------------------------------------------------------------
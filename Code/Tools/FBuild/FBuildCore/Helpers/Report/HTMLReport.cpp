@@ -8,6 +8,7 @@
 // FBuild
 #include "Tools/FBuild/FBuildCore/FBuild.h"
 #include "Tools/FBuild/FBuildCore/FBuildVersion.h"
+#include "Tools/FBuild/FBuildCore/Helpers/HeaderImpact.h"
 
 // Core
 #include "Core/Env/Env.h"
@@ -83,15 +84,79 @@ void HTMLReport::Generate( const NodeGraph & nodeGraph, const FBuildStats & stat
     FixupTimeTakenPlaceholder();
 }
 
-// Save
+// GenerateHeaderImpact
 //------------------------------------------------------------------------------
-void HTMLReport::Save() const
+void HTMLReport::GenerateHeaderImpact( const HeaderImpact & headerImpact )
 {
-    FileStream f;
-    if ( f.Open( "report.html", FileStream::WRITE_ONLY ) )
+    CreateHeader();
+
+    Write( "<h1>FASTBuild Header Impact Report</h1>\n" );
+
+    // Overview
+    const Array< HeaderImpact::HeaderStats > & headers = headerImpact.GetHeaders();
+    DoSectionTitle( "Overview", "overview" );
+    DoTableStart();
+    Write( "<tr><th width=150>Item</th><th>Details</th></tr>\n" );
+    Write( "<tr><td>Headers</td><td>%u</td></tr>\n", (uint32_t)headers.GetSize() );
+    Write( "<tr><td>Objects</td><td>%u</td></tr>\n", headerImpact.GetNumObjects() );
+    AStackString<> buffer;
+    FBuildStats::FormatTime( (float)( (double)headerImpact.GetTotalCompileTimeMS() / 1000.0 ), buffer );
+    Write( "<tr><td>Compile Time</td><td>%s</td></tr>\n", buffer.Get() );
+    Write( "<tr><td>Version</td><td>%s %s</td></tr>\n", FBUILD_VERSION_STRING, FBUILD_VERSION_PLATFORM );
+    AStackString<> reportDateTime;
+    GetReportDateTime( reportDateTime );
+    Write( "<tr><td>Report Generated</td><td>%s - %s</td></tr>\n", GetTimeTakenPlaceholder(), reportDateTime.Get() );
+    DoTableStop();
+
+    // Headers, most expensive first
+    DoSectionTitle( "Header Impact", "headerImpact" );
+    if ( headers.IsEmpty() )
     {
-        f.Write( m_Output.Get(), m_Output.GetLength() );
+        Write( "No headers.\n" );
     }
+    else
+    {
+        DoTableStart();
+        Write( "<tr><th style=\"width:100px;\">Rebuild Time</th><th style=\"width:100px;\">Compile Time</th><th style=\"width:80px;\">Objects</th><th style=\"width:80px;\">Dependents</th><th>Name</th></tr>\n" );
+        size_t numOutput = 0;
+        for ( const HeaderImpact::HeaderStats & stats : headers )
+        {
+            // start collapsible section
+            if ( numOutput == 10 )
+            {
+                DoToggleSection( headers.GetSize() - 10 );
+            }
+
+            Write( ( numOutput == 10 ) ? "<tr></tr><tr><td style=\"width:100px;\">%2.3fs</td><td style=\"width:100px;\">%2.3fs</td><td style=\"width:80px;\">%u</td><td style=\"width:80px;\">%u</td><td>%s</td></tr>\n"
+                                       : "<tr><td>%2.3fs</td><td>%2.3fs</td><td>%u</td><td>%u</td><td>%s</td></tr>\n",
+                   (double)stats.m_RebuildTimeMS / 1000.0,
+                   (double)stats.m_CompileTimeMS / 1000.0,
+                   stats.m_NumObjects,
+                   stats.m_NumDependents,
+                   stats.m_Header->GetName().Get() );
+            numOutput++;
+        }
+        DoTableStop();
+
+        if ( numOutput > 10 )
+        {
+            Write( "</details>\n" );
+        }
+    }
+
+    CreateFooter();
+
+    // patch in time take
+    FixupTimeTakenPlaceholder();
+}
+
+// Save
+//------------------------------------------------------------------------------
+bool HTMLReport::Save( const char * fileName ) const
+{
+    FileStream f;
+    return ( f.Open( fileName, FileStream::WRITE_ONLY ) &&
+             ( f.WriteBuffer( m_Output.Get(), m_Output.GetLength() ) == m_Output.GetLength() ) );
 }
 
 // CreateHeader
@@ -19,7 +19,8 @@ public:
     virtual ~HTMLReport() override;
 
     virtual void Generate(const NodeGraph & nodeGraph, const FBuildStats & stats) override;
-    virtual void Save() const override;
+    virtual void GenerateHeaderImpact( const HeaderImpact & headerImpact ) override;
+    virtual bool Save( const char * fileName ) const override;
 
 private:
     // HtmlReport sections
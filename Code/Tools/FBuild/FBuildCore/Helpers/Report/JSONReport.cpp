@@ -10,6 +10,7 @@
 #include "Tools/FBuild/FBuildCore/FBuildVersion.h"
 #include "Tools/FBuild/FBuildCore/Graph/ObjectNode.h"
 #include "Tools/FBuild/FBuildCore/Helpers/FBuildStats.h"
+#include "Tools/FBuild/FBuildCore/Helpers/HeaderImpact.h"
 #include "Tools/FBuild/FBuildCore/Helpers/JSON.h"
 
 // Core
@@ -56,15 +57,55 @@ void JSONReport::Generate( const NodeGraph & nodeGraph, const FBuildStats & stat
     FixupTimeTakenPlaceholder();
 }
 
-// Save
+// GenerateHeaderImpact
 //------------------------------------------------------------------------------
-void JSONReport::Save() const
+void JSONReport::GenerateHeaderImpact( const HeaderImpact & headerImpact )
 {
-    FileStream f;
-    if ( f.Open( "report.json", FileStream::WRITE_ONLY ) )
+    Write( "{\n\t" );
+
+    // Overview
+    const Array< HeaderImpact::HeaderStats > & headers = headerImpact.GetHeaders();
+    Write( "\"Overview\": {\n\t\t" );
+    Write( "\"Headers\": %u,\n\t\t", (uint32_t)headers.GetSize() );
+    Write( "\"Objects\": %u,\n\t\t", headerImpact.GetNumObjects() );
+    Write( "\"Compile Time (s)\": %2.3f,\n\t\t", (double)headerImpact.GetTotalCompileTimeMS() / 1000.0 );
+    Write( "\"Version\": \"%s %s\",\n\t\t", FBUILD_VERSION_STRING, FBUILD_VERSION_PLATFORM );
+    AStackString<> reportDateTime;
+    GetReportDateTime( reportDateTime );
+    Write( "\"Report Generated\": \"%s - %s\"\n\t", GetTimeTakenPlaceholder(), reportDateTime.Get() );
+    Write( "},\n\t" );
+
+    // Headers, most expensive first
+    Write( "\"Header Impact\": [" );
+    for ( size_t i = 0; i < headers.GetSize(); ++i )
     {
-        f.Write( m_Output.Get(), m_Output.GetLength() );
+        const HeaderImpact::HeaderStats & stats = headers[ i ];
+        Write( ( i == 0 ) ? "\n\t\t{\n\t\t\t" : ",\n\t\t{\n\t\t\t" );
+
+        Write( "\"Rebuild Time (s)\": %2.3f,\n\t\t\t", (double)stats.m_RebuildTimeMS / 1000.0 );
+        Write( "\"Compile Time (s)\": %2.3f,\n\t\t\t", (double)stats.m_CompileTimeMS / 1000.0 );
+        Write( "\"Objects\": %u,\n\t\t\t", stats.m_NumObjects );
+        Write( "\"Dependents\": %u,\n\t\t\t", stats.m_NumDependents );
+
+        AStackString<> headerName( stats.m_Header->GetName() );
+        JSON::Escape( headerName );
+        Write( "\"Name\": \"%s\"\n\t\t", headerName.Get() );
+
+        Write( "}" );
     }
+    Write( headers.IsEmpty() ? "]\n}" : "\n\t]\n}" );
+
+    // patch in time take
+    FixupTimeTakenPlaceholder();
+}
+
+// Save
+//------------------------------------------------------------------------------
+bool JSONReport::Save( const char * fileName ) const
+{
+    FileStream f;
+    return ( f.Open( fileName, FileStream::WRITE_ONLY ) &&
+             ( f.WriteBuffer( m_Output.Get(), m_Output.GetLength() ) == m_Output.GetLength() ) );
 }
 
 // CreateOverview
@@ -30,17 +30,34 @@
     {
         JSONReport report;
         report.Generate( nodeGraph, stats );
-        report.Save();
+        report.Save( "report.json" );
     }
     else
     {
         ASSERT( reportType == "html" );
         HTMLReport report;
         report.Generate( nodeGraph, stats );
-        report.Save();
+        report.Save( "report.html" );
     }
 }
 
+//------------------------------------------------------------------------------
+/*static*/ bool Report::GenerateHeaderImpact( const AString & reportType,
+                                              const HeaderImpact & headerImpact )
+{
+    if ( reportType == "json" )
+    {
+        JSONReport report;
+        report.GenerateHeaderImpact( headerImpact );
+        return report.Save( "headerimpact.json" );
+    }
+
+    ASSERT( reportType == "html" );
+    HTMLReport report;
+    report.GenerateHeaderImpact( headerImpact );
+    return report.Save( "headerimpact.html" );
+}
+
 // CONSTRUCTOR
 //------------------------------------------------------------------------------
 Report::Report()
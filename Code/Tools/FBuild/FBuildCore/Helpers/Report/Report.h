@@ -15,6 +15,7 @@
 //------------------------------------------------------------------------------
 struct FBuildStats;
 class Dependencies;
+class HeaderImpact;
 class Node;
 class NodeGraph;
 
@@ -26,13 +27,16 @@ public:
     static void Generate( const AString & reportType,
                           const NodeGraph & nodeGraph,
                           const FBuildStats & stats );
+    static bool GenerateHeaderImpact( const AString & reportType,
+                                      const HeaderImpact & headerImpact );
 
 protected:
     Report();
     virtual ~Report();
 
     virtual void Generate( const NodeGraph & nodeGraph, const FBuildStats & stats ) = 0;
-    virtual void Save() const = 0;
+    virtual void GenerateHeaderImpact( const HeaderImpact & headerImpact ) = 0;
+    virtual bool Save( const char * fileName ) const = 0;
 
     enum : uint32_t
     {
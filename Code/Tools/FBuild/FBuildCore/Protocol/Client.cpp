@@ -9,10 +9,13 @@
 #include "Tools/FBuild/FBuildCore/FBuild.h"
 #include "Tools/FBuild/FBuildCore/FLog.h"
 #include "Tools/FBuild/FBuildCore/Graph/CompilerNode.h"
+#include "Tools/FBuild/FBuildCore/Graph/ExecNode.h"
 #include "Tools/FBuild/FBuildCore/Graph/FileNode.h"
 #include "Tools/FBuild/FBuildCore/Graph/Node.h"
 #include "Tools/FBuild/FBuildCore/Graph/ObjectNode.h"
 #include "Tools/FBuild/FBuildCore/Helpers/BuildProfiler.h"
+#include "Tools/FBuild/FBuildCore/Helpers/BuildTrace.h"
+#include "Tools/FBuild/FBuildCore/Helpers/Metrics.h"
 #include <Tools/FBuild/FBuildCore/Helpers/MultiBuffer.h>
 #include "Tools/FBuild/FBuildCore/WorkerPool/Job.h"
 #include "Tools/FBuild/FBuildCore/WorkerPool/JobQueue.h"
@@ -73,6 +76,7 @@ Client::~Client()
 
     MutexHolder mh( ss->m_Mutex );
     DIST_INFO( "Disconnected: %s\n", ss->m_RemoteName.Get() );
+    Metrics::s_ClientConnections.Decrement();
     if ( ss->m_Jobs.IsEmpty() == false )
     {
         for ( Job * job : ss->m_Jobs )
@@ -87,6 +91,10 @@ Client::~Client()
     // we had the connection drop between message and payload
     FREE( (void *)( ss->m_CurrentMessage ) );
 
+    // The worker may have restarted (or be a different machine) when this
+    // slot reconnects, so its clock must be measured again
+    ss->ResetClockOffset();
+
     ss->m_RemoteName.Clear();
     AtomicStoreRelaxed( &ss->m_Connection, static_cast< const ConnectionInfo * >( nullptr ) );
     ss->m_CurrentMessage = nullptr;
@@ -214,6 +222,7 @@ void Client::LookForWorkers()
             ss.m_RemoteName = m_WorkerList[ i ];
             AtomicStoreRelaxed( &ss.m_Connection, ci ); // success!
             ss.m_NumJobsAvailable = numJobsAvailable;
+            Metrics::s_ClientConnections.Increment();
 
             // send connection msg
             const Protocol::MsgConnection msg( numJobsAvailable );
@@ -438,7 +447,21 @@ void Client::Process( const ConnectionInfo * connection, const Protocol::MsgRequ
         return;
     }
 
-    Job * job = JobQueue::Get().GetDistributableJobToProcess( true );
+    // Take note of how quickly this worker completes jobs, so we can
+    // anticipate which jobs are worth racing
+    float buildTimeFactor;
+    {
+        MutexHolder mh( ss->m_Mutex );
+        buildTimeFactor = ss->m_BuildTimeFactor;
+    }
+
+    // Don't send jobs to workers without enough memory to build them
+    const uint32_t maxJobMemoryMiB = ss->m_MaxJobMemoryMiB.Load();
+
+    // Older workers can't run Exec() jobs
+    const bool supportsExec = ( ss->m_ProtocolVersionMinor.Load() >= Protocol::PROTOCOL_VERSION_MINOR_EXEC_JOBS );
+
+    Job * job = JobQueue::Get().GetDistributableJobToProcess( true, buildTimeFactor, maxJobMemoryMiB, supportsExec );
     if ( job == nullptr )
     {
         PROFILE_SECTION( "NoJob" );
@@ -466,15 +489,15 @@ void Client::Process( const ConnectionInfo * connection, const Protocol::MsgRequ
     ss->m_NumJobsAvailable = 0;
 
     // if tool is explicitly specified, get the id of the tool manifest
-    const Node * n = job->GetNode()->CastTo< ObjectNode >()->GetCompiler();
-    const ToolManifest & manifest = n->CastTo< CompilerNode >()->GetManifest();
+    const ToolManifest & manifest = GetCompiler( job )->GetManifest();
     const uint64_t toolId = manifest.GetToolId();
     ASSERT( toolId );
 
     // output to signify remote start
     if ( FBuild::Get().GetOptions().m_ShowCommandSummary )
     {
-        FLOG_OUTPUT( "-> Obj: %s <REMOTE: %s>\n", job->GetNode()->GetName().Get(), ss->m_RemoteName.Get() );
+        const char * prefix = ( job->GetNode()->GetType() == Node::EXEC_NODE ) ? "Run" : "Obj";
+        FLOG_OUTPUT( "-> %s: %s <REMOTE: %s>\n", prefix, job->GetNode()->GetName().Get(), ss->m_RemoteName.Get() );
     }
     FLOG_MONITOR( "START_JOB %s \"%s\" \n", ss->m_RemoteName.Get(), job->GetNode()->GetName().Get() );
 
@@ -487,6 +510,7 @@ void Client::Process( const ConnectionInfo * connection, const Protocol::MsgRequ
         const int16_t cacheCompressionLevel = FBuild::Get().GetOptions().m_CacheCompressionLevel;
         if ( ( cacheCompressionLevel != 0 ) &&
              ( FBuild::Get().GetOptions().m_UseCacheWrite ) &&
+             ( job->GetNode()->GetType() == Node::OBJECT_NODE ) && // Exec() outputs are compressed when written to the cache
              ( job->GetNode()->CastTo< ObjectNode >()->ShouldUseCache() ) )
         {
             resultCompressionLevel = Math::Max( resultCompressionLevel, cacheCompressionLevel );
@@ -500,8 +524,11 @@ void Client::Process( const ConnectionInfo * connection, const Protocol::MsgRequ
 
     {
         PROFILE_SECTION( "SendJob" );
+        job->RecordPhaseTime( Job::PHASE_SENT );
         const Protocol::MsgJob msg( toolId, resultCompressionLevel );
         SendMessageInternal( connection, msg, stream );
+        Metrics::s_ClientJobsSent.Add();
+        Metrics::s_ClientBytesSent.Add( stream.GetSize() );
     }
 }
 
@@ -539,6 +566,7 @@ void Client::Process( const ConnectionInfo * connection, const Protocol::MsgConn
     // Take note of additional server info
     ss->m_WorkerVersion.Store( msg->GetWorkerVersion() );
     ss->m_ProtocolVersionMinor.Store( msg->GetProtocolVersionMinor() );
+    ss->m_MaxJobMemoryMiB.Store( msg->GetMaxJobMemoryMiB() );
     DIST_INFO( " - Worker %s is v%u.%u (protocol v%u.%u)\n", ss->m_RemoteName.Get(),
                                                              (ss->m_WorkerVersion.Load() / 100U),
                                                              (ss->m_WorkerVersion.Load() % 100U),
@@ -554,6 +582,8 @@ void Client::ProcessJobResultCommon( const ConnectionInfo * connection, bool isC
     // Doing it as soon as possible makes it more accurate, as work below can take a non-trivial
     // amount of time. (For example OnReturnRemoteJob when cancelling the local job in a race)
     const int64_t receivedResultEndTime = Timer::GetNow();
+    Metrics::s_ClientJobResults.Add();
+    Metrics::s_ClientBytesReceived.Add( payloadSize );
 
     // find server
     ServerState * ss = (ServerState *)connection->GetUserData();
@@ -587,9 +617,46 @@ void Client::ProcessJobResultCommon( const ConnectionInfo * connection, bool isC
     ms.Read( dataSize );
     const void * data = (const char *)ms.GetData() + ms.Tell();
 
+    // Timing of each phase on the worker (not provided by older workers)
+    int64_t workerPhaseTimesUS[ Job::NUM_REMOTE_PHASES ] = {};
+    if ( ms.Seek( ms.Tell() + dataSize ) && ( ms.Tell() < payloadSize ) )
+    {
+        uint8_t numPhases = 0;
+        ms.Read( numPhases );
+        for ( uint32_t i = 0; i < numPhases; ++i )
+        {
+            int64_t timeUS = 0;
+            ms.Read( timeUS );
+            const uint32_t phase = ( Job::FIRST_WORKER_PHASE + i );
+            if ( phase < Job::NUM_REMOTE_PHASES ) // Ignore phases added by newer workers
+            {
+                workerPhaseTimesUS[ phase ] = timeUS;
+            }
+        }
+    }
+    int64_t phaseTimes[ Job::NUM_REMOTE_PHASES ] = {};
+    bool hasPhaseTimes = false;
+
     {
         MutexHolder mh( ss->m_Mutex );
-        VERIFY( ss->m_Jobs.FindDerefAndErase( jobId ) );
+        Job ** jobIt = ss->m_Jobs.FindDeref( jobId );
+        ASSERT( jobIt );
+        if ( jobIt )
+        {
+            // Convert the worker phase timings to local time
+            const Job * sentJob = *jobIt;
+            hasPhaseTimes = GetRemotePhaseTimes( *ss, *sentJob, workerPhaseTimesUS, receivedResultEndTime, phaseTimes );
+
+            // Update observed throughput of this worker (including transfer time)
+            if ( ( systemError == false ) && ( sentJob->GetExpectedTimeMS() > 0 ) )
+            {
+                const float observedTimeMS = (float)( receivedResultEndTime - sentJob->GetRemoteStartTime() ) * Timer::GetFrequencyInvFloatMS();
+                const float factor = ( observedTimeMS / (float)sentJob->GetExpectedTimeMS() );
+                ss->m_BuildTimeFactor = ( ss->m_BuildTimeFactor > 0.0f ) ? ( ( ss->m_BuildTimeFactor * 0.75f ) + ( factor * 0.25f ) )
+                                                                         : factor;
+            }
+            ss->m_Jobs.Erase( jobIt );
+        }
     }
 
     // Has the job been cancelled in the interim?
@@ -644,7 +711,7 @@ void Client::ProcessJobResultCommon( const ConnectionInfo * connection, bool isC
     }
 
     // Handle build profiling output
-    if ( BuildProfiler::IsValid() )
+    if ( BuildProfiler::IsValid() || BuildTrace::IsValid() )
     {
         // Chose description.
         // NOTE:
@@ -665,15 +732,83 @@ void Client::ProcessJobResultCommon( const ConnectionInfo * connection, bool isC
         }
 
         // Record information about worker
+        // - Older workers only provide the build time, so the start is estimated
         const uint32_t workerId = static_cast<uint32_t>( m_ServerList.GetIndexOf( ss ) );
-        const int64_t start = receivedResultEndTime - (int64_t)( ( (double)buildTime / 1000 ) * (double)Timer::GetFrequency() );
-        BuildProfiler::Get().RecordRemote( workerId,
-                                           ss->m_RemoteName,
-                                           remoteThreadId,
-                                           start,
-                                           receivedResultEndTime,
-                                           resultStr,
-                                           node->GetName().Get());
+        const int64_t start = hasPhaseTimes ? phaseTimes[ Job::PHASE_WORKER_STARTED ]
+                                            : receivedResultEndTime - (int64_t)( ( (double)buildTime / 1000 ) * (double)Timer::GetFrequency() );
+        const int64_t end = hasPhaseTimes ? phaseTimes[ Job::PHASE_WORKER_RESULT_READY ]
+                                          : receivedResultEndTime;
+        if ( BuildTrace::IsValid() )
+        {
+            BuildTrace::Get().RecordRemote( ss->m_RemoteName,
+                                            remoteThreadId,
+                                            start,
+                                            end,
+                                            resultStr,
+                                            node->GetName().Get() );
+        }
+        if ( BuildProfiler::IsValid() )
+        {
+            BuildProfiler::Get().RecordRemote( workerId,
+                                               ss->m_RemoteName,
+                                               remoteThreadId,
+                                               start,
+                                               end,
+                                               resultStr,
+                                               node->GetName().Get());
+
+            if ( hasPhaseTimes )
+            {
+                // Steps within the build on the worker
+                if ( phaseTimes[ Job::PHASE_WORKER_DECOMPRESS_BEGIN ] )
+                {
+                    BuildProfiler::Get().RecordRemote( workerId,
+                                                       ss->m_RemoteName,
+                                                       remoteThreadId,
+                                                       phaseTimes[ Job::PHASE_WORKER_DECOMPRESS_BEGIN ],
+                                                       phaseTimes[ Job::PHASE_WORKER_DECOMPRESS_END ],
+                                                       "Decompress",
+                                                       node->GetName().Get() );
+                }
+                BuildProfiler::Get().RecordRemote( workerId,
+                                                   ss->m_RemoteName,
+                                                   remoteThreadId,
+                                                   phaseTimes[ Job::PHASE_WORKER_BUILT ],
+                                                   phaseTimes[ Job::PHASE_WORKER_RESULT_READY ],
+                                                   "Compress Result",
+                                                   node->GetName().Get() );
+
+                // End-to-end breakdown of the job
+                static const char * const phaseNames[] =
+                {
+                    "Compress",
+                    "Client Queue",
+                    "Send Job",
+                    "Tool Sync",
+                    "Worker Queue",
+                    "Build",
+                    "Send Result",
+                };
+                const int64_t phaseBoundaries[] =
+                {
+                    phaseTimes[ Job::PHASE_COMPRESS_BEGIN ],
+                    phaseTimes[ Job::PHASE_COMPRESS_END ],
+                    phaseTimes[ Job::PHASE_SENT ],
+                    phaseTimes[ Job::PHASE_WORKER_RECEIVED ],
+                    phaseTimes[ Job::PHASE_WORKER_TOOLS_READY ],
+                    phaseTimes[ Job::PHASE_WORKER_STARTED ],
+                    phaseTimes[ Job::PHASE_WORKER_RESULT_READY ],
+                    receivedResultEndTime,
+                };
+                static_assert( ARRAY_SIZE( phaseNames ) + 1 == ARRAY_SIZE( phaseBoundaries ), "Mismatched phases" );
+                BuildProfiler::Get().RecordRemoteJob( workerId,
+                                                      jobId,
+                                                      phaseNames,
+                                                      phaseBoundaries,
+                                                      (uint32_t)ARRAY_SIZE( phaseNames ),
+                                                      node->GetName().Get() );
+            }
+        }
     }
 
     // Handle verbose logging
@@ -721,7 +856,57 @@ void Client::ProcessJobResultCommon( const ConnectionInfo * connection, bool isC
 
     job->SetMessages( messages );
 
-    if ( result == true )
+    if ( ( result == true ) && ( node->GetType() == Node::EXEC_NODE ) )
+    {
+        // built ok - serialize to disc
+
+        ExecNode * execNode = node->CastTo< ExecNode >();
+
+        // Decompress if needed
+        MultiBuffer mb( data, dataSize );
+        if ( isCompressed )
+        {
+            mb.Decompress();
+        }
+
+        const AString & nodeName = execNode->GetName();
+        if ( Node::EnsurePathExistsForFile( nodeName ) == false )
+        {
+            FLOG_ERROR( "Failed to create path for '%s'", nodeName.Get() );
+            result = false;
+        }
+        else
+        {
+            result = WriteFileToDisk( nodeName, mb, 0 );
+        }
+
+        if ( result )
+        {
+            // record new file time
+            execNode->RecordStampFromBuiltFile();
+
+            // record time taken to build
+            execNode->SetLastBuildTime( buildTime );
+            execNode->SetStatFlag( Node::STATS_BUILT );
+            execNode->SetStatFlag( Node::STATS_BUILT_REMOTE );
+
+            // Store to cache if needed (cache name is set when the job is queued)
+            if ( job->GetCacheName().IsEmpty() == false )
+            {
+                execNode->WriteToCache( job->GetCacheName() );
+            }
+        }
+        else
+        {
+            execNode->SetStatFlag( Node::STATS_FAILED );
+        }
+
+        // Output from remote work (if .ExecAlwaysShowOutput is set)
+        AStackString<> msgBuffer;
+        job->GetMessagesForLog( msgBuffer );
+        Node::DumpOutput( nullptr, msgBuffer );
+    }
+    else if ( result == true )
     {
         // built ok - serialize to disc
 
@@ -859,6 +1044,68 @@ void Client::ProcessJobResultCommon( const ConnectionInfo * connection, bool isC
                                            true ); // remote job
 }
 
+// GetRemotePhaseTimes
+//------------------------------------------------------------------------------
+/*static*/ bool Client::GetRemotePhaseTimes( ServerState & ss,
+                                             const Job & sentJob,
+                                             const int64_t * workerTimesUS,
+                                             int64_t receivedTime,
+                                             int64_t * outPhaseTimes )
+{
+    const int64_t sentTime = sentJob.GetPhaseTime( Job::PHASE_SENT );
+    const int64_t workerReceivedUS = workerTimesUS[ Job::PHASE_WORKER_RECEIVED ];
+    const int64_t workerSentUS = workerTimesUS[ Job::PHASE_WORKER_SENT ];
+    if ( ( sentTime == 0 ) || ( workerReceivedUS == 0 ) || ( workerSentUS == 0 ) )
+    {
+        return false; // Older worker
+    }
+
+    // Estimate the offset between the clocks from the round trip, assuming
+    // transfer takes the same time in each direction. Estimates from the
+    // fastest round trips are the most accurate, so the best is kept.
+    const double toMicroseconds = ( 1000000.0 / (double)Timer::GetFrequency() );
+    const int64_t sentUS = (int64_t)( (double)sentTime * toMicroseconds );
+    const int64_t receivedUS = (int64_t)( (double)receivedTime * toMicroseconds );
+    const int64_t delayUS = Math::Max< int64_t >( ( receivedUS - sentUS ) - ( workerSentUS - workerReceivedUS ), 0 );
+    if ( ( ss.m_ClockOffsetDelayUS < 0 ) || ( delayUS <= ss.m_ClockOffsetDelayUS ) )
+    {
+        ss.m_ClockOffsetUS = ( ( workerReceivedUS - sentUS ) + ( workerSentUS - receivedUS ) ) / 2;
+        ss.m_ClockOffsetDelayUS = delayUS;
+    }
+
+    // Client phases
+    for ( uint32_t i = 0; i < Job::FIRST_WORKER_PHASE; ++i )
+    {
+        outPhaseTimes[ i ] = sentJob.GetPhaseTime( (Job::RemotePhase)i );
+    }
+
+    // Worker phases, in local time. Phases are kept in order and within the
+    // round trip, so inaccuracies in the estimate can't produce overlaps.
+    int64_t previousTime = sentTime;
+    for ( uint32_t i = Job::FIRST_WORKER_PHASE; i < Job::NUM_REMOTE_PHASES; ++i )
+    {
+        if ( workerTimesUS[ i ] == 0 )
+        {
+            outPhaseTimes[ i ] = 0; // Phase not reached (i.e. no decompression)
+            continue;
+        }
+        const int64_t localTime = (int64_t)( (double)( workerTimesUS[ i ] - ss.m_ClockOffsetUS ) / toMicroseconds );
+        outPhaseTimes[ i ] = Math::Clamp( localTime, previousTime, receivedTime );
+        previousTime = outPhaseTimes[ i ];
+    }
+
+    // Phases which were not recorded locally start when the next one does
+    if ( outPhaseTimes[ Job::PHASE_COMPRESS_END ] == 0 )
+    {
+        outPhaseTimes[ Job::PHASE_COMPRESS_END ] = sentTime;
+    }
+    if ( outPhaseTimes[ Job::PHASE_COMPRESS_BEGIN ] == 0 )
+    {
+        outPhaseTimes[ Job::PHASE_COMPRESS_BEGIN ] = outPhaseTimes[ Job::PHASE_COMPRESS_END ];
+    }
+    return true;
+}
+
 // Process( MsgRequestManifest )
 //------------------------------------------------------------------------------
 void Client::Process( const ConnectionInfo * connection, const Protocol::MsgRequestManifest * msg )
@@ -924,6 +1171,18 @@ void Client::Process( const ConnectionInfo * connection, const Protocol::MsgRequ
     SendMessageInternal( connection, resultMsg, ms );
 }
 
+// GetCompiler
+//------------------------------------------------------------------------------
+/*static*/ const CompilerNode * Client::GetCompiler( const Job * job )
+{
+    const Node * node = job->GetNode();
+    if ( node->GetType() == Node::EXEC_NODE )
+    {
+        return node->CastTo< ExecNode >()->GetCompiler();
+    }
+    return node->CastTo< ObjectNode >()->GetCompiler();
+}
+
 // FindManifest
 //------------------------------------------------------------------------------
 const ToolManifest * Client::FindManifest( const ConnectionInfo * connection, uint64_t toolId ) const
@@ -935,8 +1194,7 @@ const ToolManifest * Client::FindManifest( const ConnectionInfo * connection, ui
 
     for ( const Job * job : ss->m_Jobs )
     {
-        const Node * n = job->GetNode()->CastTo< ObjectNode >()->GetCompiler();
-        const ToolManifest & m = n->CastTo< CompilerNode >()->GetManifest();
+        const ToolManifest & m = GetCompiler( job )->GetManifest();
         if ( m.GetToolId() == toolId )
         {
             // found a job with the same toolid
@@ -966,9 +1224,20 @@ Client::ServerState::ServerState()
     , m_CurrentMessage( nullptr )
     , m_NumJobsAvailable( 0 )
     , m_Jobs( 16 )
+    , m_BuildTimeFactor( 0.0f )
+    , m_ClockOffsetUS( 0 )
+    , m_ClockOffsetDelayUS( -1 )
     , m_Denylisted( false )
 {
     m_DelayTimer.Start( 999.0f );
 }
 
+// ResetClockOffset
+//------------------------------------------------------------------------------
+void Client::ServerState::ResetClockOffset()
+{
+    m_ClockOffsetUS = 0;
+    m_ClockOffsetDelayUS = -1;
+}
+
 //------------------------------------------------------------------------------
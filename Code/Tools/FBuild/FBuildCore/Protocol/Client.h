@@ -13,6 +13,7 @@
 
 // Forward Declarations
 //------------------------------------------------------------------------------
+class CompilerNode;
 class ConstMemoryStream;
 class Job;
 class MemoryStream;
@@ -54,6 +55,11 @@ private:
 
     void ProcessJobResultCommon( const ConnectionInfo * connection, bool isCompressed, const void * payload, size_t payloadSize );
 
+    friend class TestDistributed; // For GetRemotePhaseTimes
+    struct ServerState;
+    static bool     GetRemotePhaseTimes( ServerState & ss, const Job & sentJob, const int64_t * workerTimesUS, int64_t receivedTime, int64_t * outPhaseTimes );
+
+    static const CompilerNode * GetCompiler( const Job * job );
     const ToolManifest * FindManifest( const ConnectionInfo * connection, uint64_t toolId ) const;
     bool WriteFileToDisk( const AString& fileName, const MultiBuffer & multiBuffer, size_t index ) const;
 
@@ -80,16 +86,22 @@ private:
     {
         explicit ServerState();
 
+        void                    ResetClockOffset();
+
         const ConnectionInfo *  m_Connection;
         AString                 m_RemoteName;
         Atomic<uint16_t>        m_WorkerVersion;
         Atomic<uint8_t>         m_ProtocolVersionMinor;
+        Atomic<uint32_t>        m_MaxJobMemoryMiB;      // largest job (by memory) the worker accepts (0 if unknown)
 
         Mutex                   m_Mutex;
         const Protocol::IMessage * m_CurrentMessage;
         Timer                   m_DelayTimer;
         uint32_t                m_NumJobsAvailable;     // num jobs we've told this server we have available
         Array< Job * >          m_Jobs;                 // jobs we've sent to this server
+        float                   m_BuildTimeFactor;      // observed job time relative to last known build time (0 until known)
+        int64_t                 m_ClockOffsetUS;        // estimated worker clock minus local clock (for profiling)
+        int64_t                 m_ClockOffsetDelayUS;   // round trip delay of the offset estimate (-1 if none, lower is more accurate)
 
         bool                    m_Denylisted;
     };
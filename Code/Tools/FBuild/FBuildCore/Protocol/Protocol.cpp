@@ -125,11 +125,12 @@ Protocol::MsgConnection::MsgConnection( uint32_t numJobsAvailable )
 
 // MsgConnectionAck
 //------------------------------------------------------------------------------
-Protocol::MsgConnectionAck::MsgConnectionAck()
+Protocol::MsgConnectionAck::MsgConnectionAck( uint32_t maxJobMemoryMiB )
     : Protocol::IMessage( Protocol::MSG_CONNECTION_ACK, sizeof( MsgConnectionAck ), false )
     , m_WorkerVersion( static_cast<uint16_t>( FBUILD_VERSION ) )
     , m_ProtocolVersionMajor( PROTOCOL_VERSION_MAJOR )
     , m_ProtocolVersionMinor( PROTOCOL_VERSION_MINOR )
+    , m_MaxJobMemoryMiB( maxJobMemoryMiB )
 {
 }
 
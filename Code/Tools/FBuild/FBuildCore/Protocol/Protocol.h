@@ -32,12 +32,18 @@ namespace Protocol
 
     // Protocol Version
     enum : uint32_t { PROTOCOL_VERSION_MAJOR = 22 };    // Changes here make workers incompatible
-    enum : uint8_t  { PROTOCOL_VERSION_MINOR = 4 };     // Changes must be forwards and backwards compatible
+    enum : uint8_t  { PROTOCOL_VERSION_MINOR = 7 };     // Changes must be forwards and backwards compatible
+
+    // Minimum minor versions for optional features
+    enum : uint8_t  { PROTOCOL_VERSION_MINOR_EXEC_JOBS = 7 }; // Worker can run distributable Exec() jobs
 
     enum { PROTOCOL_TEST_PORT = PROTOCOL_PORT + 1 }; // Different port for use by tests
 
     enum { COORDINATOR_PORT = PROTOCOL_PORT + 128 }; // Different port for use by tests
 
+    enum : uint16_t { DAEMON_PORT = PROTOCOL_PORT + 256 };  // First port used by -daemon (offset by working dir)
+    enum : uint16_t { DAEMON_PORT_RANGE = 1024 };
+
     // Identifiers for all unique messages
     //------------------------------------------------------------------------------
     enum MessageType : uint8_t
@@ -128,15 +134,17 @@ namespace Protocol
     class MsgConnectionAck : public IMessage
     {
     public:
-        MsgConnectionAck();
+        explicit MsgConnectionAck( uint32_t maxJobMemoryMiB );
 
         uint16_t        GetWorkerVersion() const        { return m_WorkerVersion; }
         uint8_t         GetProtocolVersionMajor() const { return m_ProtocolVersionMajor; }
         uint8_t         GetProtocolVersionMinor() const { return m_ProtocolVersionMinor; }
+        uint32_t        GetMaxJobMemoryMiB() const      { return ( GetSize() >= sizeof( MsgConnectionAck ) ) ? m_MaxJobMemoryMiB : 0; } // v22.5 or later
     private:
         uint16_t        m_WorkerVersion;
         uint8_t         m_ProtocolVersionMajor;
         uint8_t         m_ProtocolVersionMinor;
+        uint32_t        m_MaxJobMemoryMiB; // Largest memory requirement of a job the worker can accept (v22.5 or later)
     };
 
     // MsgStatus
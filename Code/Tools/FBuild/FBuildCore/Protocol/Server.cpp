@@ -7,6 +7,7 @@
 #include "Protocol.h"
 
 #include "Tools/FBuild/FBuildCore/FLog.h"
+#include "Tools/FBuild/FBuildCore/Helpers/Metrics.h"
 #include "Tools/FBuild/FBuildCore/Helpers/ToolManifest.h"
 #include "Tools/FBuild/FBuildCore/WorkerPool/Job.h"
 #include "Tools/FBuild/FBuildCore/WorkerPool/JobQueueRemote.h"
@@ -105,6 +106,7 @@ bool Server::IsSynchingTool( AString & statusStr ) const
 
     MutexHolder mh( m_ClientListMutex );
     m_ClientList.Append( cs );
+    Metrics::s_ServerConnections.Increment();
 }
 
 //------------------------------------------------------------------------------
@@ -113,6 +115,7 @@ bool Server::IsSynchingTool( AString & statusStr ) const
     ASSERT( connection );
     ClientState * cs = (ClientState *)connection->GetUserData();
     ASSERT( cs );
+    Metrics::s_ServerConnections.Decrement();
 
     // Unhook any jobs which are queued or in progress for this client
     // - deletes the queued jobs
@@ -298,7 +301,7 @@ void Server::Process( const ConnectionInfo * connection, const Protocol::MsgConn
     if ( msg->GetProtocolVersionMinor() >= 3 )
     {
         // Send Ack to client
-        const Protocol::MsgConnectionAck ack;
+        const Protocol::MsgConnectionAck ack( JobQueueRemote::Get().GetMemoryBudgetMiB() );
         ack.Send( connection );
     }
 }
@@ -329,6 +332,10 @@ void Server::Process( const ConnectionInfo * connection, const Protocol::MsgNoJo
 //------------------------------------------------------------------------------
 void Server::Process( const ConnectionInfo * connection, const Protocol::MsgJob * msg, const void * payload, size_t payloadSize )
 {
+    const int64_t receivedTime = Timer::GetNow();
+    Metrics::s_ServerJobsReceived.Add();
+    Metrics::s_ServerBytesReceived.Add( payloadSize );
+
     ClientState * cs = (ClientState *)connection->GetUserData();
     {
         ASSERT( cs->m_NumJobsRequested.Load() > 0 );
@@ -342,6 +349,7 @@ void Server::Process( const ConnectionInfo * connection, const Protocol::MsgJob
 
         Job * job = FNEW( Job( ms ) );
         job->SetUserData( cs );
+        job->SetPhaseTime( Job::PHASE_WORKER_RECEIVED, receivedTime );
 
         // Take not of client support requirements
         // - Zstd suport can become unconditional if protocol compatibility is broken
@@ -744,6 +752,13 @@ void Server::FinalizeCompletedJobs()
                 ms.Write( (uint32_t)job->GetDataSize() );
                 ms.WriteBuffer( job->GetData(), job->GetDataSize() );
 
+                // Timing of each phase on this worker, for profiling by the client
+                if ( cs->m_ProtocolVersionMinor >= 6 )
+                {
+                    job->RecordPhaseTime( Job::PHASE_WORKER_SENT );
+                    WritePhaseTimes( ms, *job );
+                }
+
                 {
                     ASSERT( cs->m_NumJobsActive.Load() > 0 );
                     cs->m_NumJobsActive.Decrement();
@@ -762,6 +777,8 @@ void Server::FinalizeCompletedJobs()
                         const Protocol::MsgJobResultCompressed msg;
                         msg.Send( cs->m_Connection, ms );
                     }
+                    Metrics::s_ServerJobResults.Add();
+                    Metrics::s_ServerBytesSent.Add( ms.GetSize() );
                 }
             }
             else
@@ -775,6 +792,22 @@ void Server::FinalizeCompletedJobs()
     }
 }
 
+// WritePhaseTimes
+//------------------------------------------------------------------------------
+/*static*/ void Server::WritePhaseTimes( IOStream & stream, const Job & job )
+{
+    // Times are sent in microseconds as the Timer frequency may differ between
+    // machines. The client estimates the offset between the clocks.
+    const uint8_t numPhases = ( Job::NUM_REMOTE_PHASES - Job::FIRST_WORKER_PHASE );
+    stream.Write( numPhases );
+    const double toMicroseconds = ( 1000000.0 / (double)Timer::GetFrequency() );
+    for ( uint8_t i = Job::FIRST_WORKER_PHASE; i < Job::NUM_REMOTE_PHASES; ++i )
+    {
+        const int64_t time = job.GetPhaseTime( (Job::RemotePhase)i );
+        stream.Write( (int64_t)( (double)time * toMicroseconds ) );
+    }
+}
+
 // TouchToolchains
 //------------------------------------------------------------------------------
 void Server::TouchToolchains()
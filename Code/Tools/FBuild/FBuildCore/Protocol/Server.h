@@ -10,6 +10,7 @@
 
 // Forward Declarations
 //------------------------------------------------------------------------------
+class IOStream;
 class Job;
 class JobQueueRemote;
 namespace Protocol
@@ -55,6 +56,7 @@ private:
 
     void            FindNeedyClients();
     void            FinalizeCompletedJobs();
+    static void     WritePhaseTimes( IOStream & stream, const Job & job );
     void            TouchToolchains();
     void            CheckWaitingJobs( const ToolManifest * manifest );
 
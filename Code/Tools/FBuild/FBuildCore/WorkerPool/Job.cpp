@@ -6,14 +6,18 @@
 #include "Job.h"
 
 #include "Tools/FBuild/FBuildCore/Graph/Node.h"
+#include "Tools/FBuild/FBuildCore/Helpers/BuildProfiler.h"
 #include "Tools/FBuild/FBuildCore/FLog.h"
 
 #include "Core/Env/Assert.h"
 #include "Core/FileIO/FileIO.h"
 #include "Core/FileIO/IOStream.h"
+#include "Core/Math/Conversions.h"
 #include "Core/Process/Atomic.h"
+#include "Core/Process/Process.h"
 #include "Core/Profile/Profile.h"
 #include "Core/Strings/AStackString.h"
+#include "Core/Time/Timer.h"
 
 #include <stdarg.h>
 
@@ -73,6 +77,28 @@ void Job::CancelDueToRemoteRaceWin()
     AtomicStoreRelaxed( &m_Abort, true );
 }
 
+// OnProcessExited
+//------------------------------------------------------------------------------
+void Job::OnProcessExited( const Process & process )
+{
+    // Track the largest of the processes spawned to build the node, and the
+    // total of other resources
+    m_ProcessUsage.Accumulate( process.GetResourceUsage() );
+
+    // Attribute to the current profiling step
+    if ( m_BuildProfilerScope )
+    {
+        m_BuildProfilerScope->OnProcessExited( process.GetResourceUsage() );
+    }
+}
+
+// RecordPhaseTime
+//------------------------------------------------------------------------------
+void Job::RecordPhaseTime( RemotePhase phase )
+{
+    m_PhaseTimes[ phase ] = Timer::GetNow();
+}
+
 // OwnData
 //------------------------------------------------------------------------------
 void Job::OwnData( void * data, size_t size, bool compressed )
@@ -176,6 +202,9 @@ void Job::Serialize( IOStream & stream )
 
     stream.Write( m_DataSize );
     stream.Write( m_Data, m_DataSize );
+
+    // v22.5 or later (ignored by older workers)
+    stream.Write( m_MemoryRequiredMiB );
 }
 
 // Deserialize
@@ -200,6 +229,12 @@ void Job::Deserialize( IOStream & stream )
     stream.Read( data, dataSize );
 
     OwnData( data, dataSize, compressed );
+
+    // v22.5 or later (not sent by older clients)
+    if ( stream.Tell() < stream.GetFileSize() )
+    {
+        stream.Read( m_MemoryRequiredMiB );
+    }
 }
 
 // GetMessagesForLog
@@ -7,6 +7,7 @@
 #include "Core/Env/MSVCStaticAnalysis.h"
 #include "Core/Env/Types.h"
 #include "Core/Process/Atomic.h"
+#include "Core/Process/Process.h"
 #include "Core/Strings/AString.h"
 
 // Forward Declarations
@@ -103,6 +104,53 @@ public:
     inline void                 SetDistributionState( DistributionState state ) { m_DistributionState = state; }
     inline DistributionState    GetDistributionState() const                    { return m_DistributionState; }
 
+    // Timing info for jobs built remotely (used to decide which jobs to race)
+    void                        SetRemoteBuildEstimate( int64_t startTime, uint32_t expectedTimeMS, uint32_t expectedRemoteTimeMS )
+    {
+        m_RemoteStartTime = startTime;
+        m_ExpectedTimeMS = expectedTimeMS;
+        m_ExpectedRemoteTimeMS = expectedRemoteTimeMS;
+    }
+    inline int64_t              GetRemoteStartTime() const      { return m_RemoteStartTime; }
+    inline uint32_t             GetExpectedTimeMS() const       { return m_ExpectedTimeMS; }
+    inline uint32_t             GetExpectedRemoteTimeMS() const { return m_ExpectedRemoteTimeMS; }
+
+    // Timestamps of the stages of a distributed job, for profiling (0 if not reached)
+    enum RemotePhase : uint8_t
+    {
+        // Client
+        PHASE_COMPRESS_BEGIN,
+        PHASE_COMPRESS_END,
+        PHASE_SENT,
+
+        // Worker (returned to the Client with the result)
+        PHASE_WORKER_RECEIVED,
+        PHASE_WORKER_TOOLS_READY,
+        PHASE_WORKER_STARTED,
+        PHASE_WORKER_DECOMPRESS_BEGIN,
+        PHASE_WORKER_DECOMPRESS_END,
+        PHASE_WORKER_BUILT,
+        PHASE_WORKER_RESULT_READY,
+        PHASE_WORKER_SENT,
+
+        NUM_REMOTE_PHASES,
+        FIRST_WORKER_PHASE = PHASE_WORKER_RECEIVED
+    };
+    void                        RecordPhaseTime( RemotePhase phase );
+    inline void                 SetPhaseTime( RemotePhase phase, int64_t time ) { m_PhaseTimes[ phase ] = time; }
+    inline int64_t              GetPhaseTime( RemotePhase phase ) const         { return m_PhaseTimes[ phase ]; }
+
+    // Memory needed to build (from ConcurrencyGroup and history), to avoid over-subscription
+    inline void                 SetMemoryRequiredMiB( uint32_t memoryMiB )  { m_MemoryRequiredMiB = memoryMiB; }
+    inline uint32_t             GetMemoryRequiredMiB() const                { return m_MemoryRequiredMiB; }
+    inline void                 SetLocalMemoryReservedMiB( uint32_t memoryMiB ) { m_LocalMemoryReservedMiB = memoryMiB; }
+    inline uint32_t             GetLocalMemoryReservedMiB() const               { return m_LocalMemoryReservedMiB; }
+
+    // Resources used by processes spawned while building
+    void                        OnProcessExited( const Process & process );
+    inline uint32_t             GetPeakMemoryMiB() const    { return m_ProcessUsage.m_PeakMemoryMiB; }
+    inline const Process::ResourceUsage & GetProcessUsage() const { return m_ProcessUsage; }
+
     // Access total memory usage by job data
     static uint64_t             GetTotalLocalDataMemoryUsage();
 
@@ -128,6 +176,13 @@ private:
     ToolManifest *      m_ToolManifest      = nullptr;
     int16_t             m_ResultCompressionLevel = 0; // Compression level of returned results
     bool                m_AllowZstdUse = false; // Can client accept Zstd results?
+    int64_t             m_RemoteStartTime = 0;      // When the job was sent to a worker
+    uint32_t            m_ExpectedTimeMS = 0;       // Last known build time when sent to a worker (0 if unknown)
+    uint32_t            m_ExpectedRemoteTimeMS = 0; // Expected time on the worker it was sent to (0 if unknown)
+    uint32_t            m_MemoryRequiredMiB = 0;    // Memory needed to build (0 if unknown)
+    uint32_t            m_LocalMemoryReservedMiB = 0; // Memory accounted for while building locally
+    Process::ResourceUsage m_ProcessUsage;          // Resources used by spawned processes
+    int64_t             m_PhaseTimes[ NUM_REMOTE_PHASES ] = {}; // See RemotePhase
 
     Array< AString >    m_Messages;
 
@@ -13,14 +13,19 @@
 #include "Tools/FBuild/FBuildCore/Graph/ObjectNode.h"
 #include "Tools/FBuild/FBuildCore/Graph/SettingsNode.h"
 #include "Tools/FBuild/FBuildCore/Helpers/BuildProfiler.h"
+#include "Tools/FBuild/FBuildCore/Helpers/Metrics.h"
 
 #include "Core/Time/Timer.h"
 #include "Core/FileIO/FileIO.h"
+#include "Core/Math/Conversions.h"
+#include "Core/Mem/MemInfo.h"
 #include "Core/Process/Atomic.h"
 #include "Core/Process/ThreadPool.h"
 #include "Core/Profile/Profile.h"
 
 // JobCostSorter
+//  - Sorts by the length of the critical path through each node (see
+//    NodeGraph::ComputeCriticalPathCosts) so the most critical jobs are last
 //------------------------------------------------------------------------------
 class JobCostSorter
 {
@@ -64,6 +69,7 @@ void JobSubQueue::QueueJobs( Array< Node * > & nodes )
     for ( Node * node : nodes )
     {
         Job * job = FNEW( Job( node ) );
+        job->SetMemoryRequiredMiB( node->GetLastPeakMemoryMiB() );
         jobs.Append( job );
     }
 
@@ -116,7 +122,7 @@ void JobSubQueue::QueueJobs( Array< Node * > & nodes )
 
 // RemoveJob
 //------------------------------------------------------------------------------
-Job * JobSubQueue::RemoveJob()
+Job * JobSubQueue::RemoveJob( uint32_t memoryAvailableMiB )
 {
     // lock-free early out if there are no jobs
     if ( AtomicLoadRelaxed( &m_Count ) == 0 )
@@ -133,10 +139,26 @@ Job * JobSubQueue::RemoveJob()
         return nullptr;
     }
 
+    // Jobs are sorted from least to most expensive, so we consume from the end
+    // of the list, skipping any expected to need more memory than is available
+    Job ** jobIt = m_Jobs.End();
+    for ( ;; )
+    {
+        if ( jobIt == m_Jobs.Begin() )
+        {
+            return nullptr;
+        }
+        --jobIt;
+        if ( ( *jobIt )->GetMemoryRequiredMiB() <= memoryAvailableMiB )
+        {
+            break;
+        }
+    }
+
     VERIFY( AtomicDec( &m_Count ) != static_cast< uint32_t >( -1 ) );
 
-    Job * job = m_Jobs.Top();
-    m_Jobs.Pop();
+    Job * job = *jobIt;
+    m_Jobs.Erase( jobIt );
 
     return job;
 }
@@ -162,6 +184,11 @@ JobQueue::JobQueue( uint32_t numWorkerThreads, ThreadPool * threadPool ) :
 {
     PROFILE_FUNCTION;
 
+    // Jobs with known memory requirements are limited to what is available now
+    SystemMemInfo memInfo;
+    MemInfo::GetSystemInfo( memInfo );
+    m_LocalMemoryBudgetMiB = memInfo.mAvailPhysMiB;
+
     WorkerThread::InitTmpDir();
 
     if ( numWorkerThreads > 0 )
@@ -189,7 +216,7 @@ JobQueue::~JobQueue()
     SignalStopWorkers();
 
     // delete incomplete jobs
-    while ( Job * job = m_LocalJobs_Available.RemoveJob() )
+    while ( Job * job = m_LocalJobs_Available.RemoveJob( MEMORY_UNLIMITED ) )
     {
         FDELETE job;
     }
@@ -369,6 +396,7 @@ void JobQueue::FlushJobBatch( const SettingsNode & settings )
             const uint32_t numJobs = static_cast<uint32_t>( groupState.m_LocalJobs_Staging.GetSize() );
             m_LocalJobs_Available.QueueJobs( groupState.m_LocalJobs_Staging );
             m_WorkerThreadSemaphore.Signal( numJobs );
+            Metrics::s_JobsQueued.Add( numJobs );
             groupState.m_LocalJobs_Staging.Clear();
             groupState.m_ActiveJobs += numJobs;
         }
@@ -381,6 +409,7 @@ void JobQueue::FlushJobBatch( const SettingsNode & settings )
                          groupState.m_LocalJobs_Staging.End() );
             m_LocalJobs_Available.QueueJobs( jobs );
             m_WorkerThreadSemaphore.Signal( maxJobsToQueue );
+            Metrics::s_JobsQueued.Add( maxJobsToQueue );
             groupState.m_LocalJobs_Staging.SetSize( groupState.m_LocalJobs_Staging.GetSize() - maxJobsToQueue );
             groupState.m_ActiveJobs += maxJobsToQueue;
         }
@@ -407,6 +436,18 @@ void JobQueue::QueueDistributableJob( Job * job )
     ASSERT( job->GetNode()->GetState() == Node::BUILDING );
     ASSERT( job->GetDistributionState() == Job::DIST_NONE );
 
+    // First pass is complete
+    ReleaseLocalMemory( job );
+
+    // Workers use the memory requirements of the ConcurrencyGroup (or the
+    // recorded peak memory, if larger) to avoid over-subscription
+    const uint8_t groupIndex = job->GetNode()->GetConcurrencyGroupIndex();
+    if ( groupIndex > 0 )
+    {
+        const uint32_t groupMemoryMiB = FBuild::Get().GetSettings()->GetConcurrencyGroup( groupIndex ).GetMemoryPerJobMiB();
+        job->SetMemoryRequiredMiB( Math::Max( job->GetMemoryRequiredMiB(), groupMemoryMiB ) );
+    }
+
     {
         MutexHolder m( m_DistributedJobsMutex );
 
@@ -425,31 +466,71 @@ void JobQueue::QueueDistributableJob( Job * job )
 
     ASSERT( m_NumLocalJobsActive > 0 );
     AtomicDec( &m_NumLocalJobsActive ); // job converts from active to pending remote
+    Metrics::s_JobsActive.Decrement();
+    Metrics::s_JobsQueuedDistributable.Add();
 
     m_WorkerThreadSemaphore.Signal();
 }
 
 // GetDistributableJobToProcess
 //------------------------------------------------------------------------------
-Job * JobQueue::GetDistributableJobToProcess( bool remote )
+Job * JobQueue::GetDistributableJobToProcess( bool remote, float remoteBuildTimeFactor, uint32_t maxJobMemoryMiB, bool remoteSupportsExec )
 {
     MutexHolder m( m_DistributedJobsMutex );
-
     if ( m_DistributableJobs_Available.IsEmpty() )
     {
         return nullptr;
     }
 
+    // Local jobs are limited by the memory currently available, remote jobs
+    // by the capacity of the worker (0 if the worker didn't specify)
+    MutexHolder mh( m_LocalMemoryMutex );
+    uint32_t memoryAvailableMiB = remote ? maxJobMemoryMiB : GetLocalMemoryAvailableMiB();
+    if ( remote && ( memoryAvailableMiB == 0 ) )
+    {
+        memoryAvailableMiB = MEMORY_UNLIMITED;
+    }
+
     // Jobs are sorted from least to most expensive, so we consume
-    // from the end of the list.
-    Job * job = m_DistributableJobs_Available.Top();
-    m_DistributableJobs_Available.Pop();
+    // from the end of the list, skipping any which don't fit (or which
+    // older workers can't build)
+    Job ** jobIt = m_DistributableJobs_Available.End();
+    for ( ;; )
+    {
+        if ( jobIt == m_DistributableJobs_Available.Begin() )
+        {
+            return nullptr;
+        }
+        --jobIt;
+        if ( ( remoteSupportsExec == false ) && ( ( *jobIt )->GetNode()->GetType() == Node::EXEC_NODE ) )
+        {
+            continue;
+        }
+        if ( ( *jobIt )->GetMemoryRequiredMiB() <= memoryAvailableMiB )
+        {
+            break;
+        }
+    }
+    Job * job = *jobIt;
+    m_DistributableJobs_Available.Erase( jobIt );
+    if ( remote == false )
+    {
+        ReserveLocalMemory( job );
+    }
 
     ASSERT( job->GetDistributionState() == Job::DIST_AVAILABLE );
 
     // Tag job as in-use
     job->SetDistributionState( remote ? Job::DIST_BUILDING_REMOTELY : Job::DIST_BUILDING_LOCALLY );
     m_DistributableJobs_InProgress.Append( job );
+
+    // Take note of when we expect remote jobs to complete, so we can decide which to race
+    if ( remote )
+    {
+        const uint32_t expectedTimeMS = job->GetNode()->GetLastBuildTime();
+        const uint32_t expectedRemoteTimeMS = (uint32_t)( (float)expectedTimeMS * remoteBuildTimeFactor );
+        job->SetRemoteBuildEstimate( Timer::GetNow(), expectedTimeMS, expectedRemoteTimeMS );
+    }
     return job;
 }
 
@@ -463,8 +544,16 @@ Job * JobQueue::GetDistributableJobToRace()
         return nullptr;
     }
 
-    // take newest job, which is least likely to finish first
-    // compared to older distributed jobs
+    // Don't race jobs which would need more memory than is available
+    MutexHolder mh( m_LocalMemoryMutex );
+    const uint32_t memoryAvailableMiB = GetLocalMemoryAvailableMiB();
+
+    // Race the job we expect to gain the most from racing. This prefers
+    // stragglers on slow workers and avoids racing jobs about to complete.
+    const int64_t now = Timer::GetNow();
+    Job * bestJob = nullptr;
+    uint32_t bestGainMS = 0;
+    Job * unknownJob = nullptr;
     const int32_t numJobs = (int32_t)m_DistributableJobs_InProgress.GetSize();
     for ( int32_t i = ( numJobs - 1 ); i >= 0; --i )
     {
@@ -472,16 +561,126 @@ Job * JobQueue::GetDistributableJobToRace()
 
         // Don't Race jobs already building locally
         const Job::DistributionState distState = job->GetDistributionState();
-        if ( distState == Job::DIST_BUILDING_REMOTELY )
+        if ( distState != Job::DIST_BUILDING_REMOTELY )
         {
-            job->SetDistributionState( Job::DIST_RACING );
-            return job;
+            continue;
+        }
+        if ( job->GetMemoryRequiredMiB() > memoryAvailableMiB )
+        {
+            continue;
+        }
+
+        // Without history for the job or worker we can't know when it will
+        // complete. Fall back to the newest job, which is least likely to
+        // finish first compared to older distributed jobs
+        const uint32_t expectedRemoteTimeMS = job->GetExpectedRemoteTimeMS();
+        if ( expectedRemoteTimeMS == 0 )
+        {
+            if ( unknownJob == nullptr )
+            {
+                unknownJob = job;
+            }
+            continue;
+        }
+
+        const uint32_t elapsedMS = (uint32_t)( (float)( now - job->GetRemoteStartTime() ) * Timer::GetFrequencyInvFloatMS() );
+        const uint32_t gainMS = EstimateRaceGainMS( elapsedMS, expectedRemoteTimeMS, job->GetExpectedTimeMS() );
+        if ( gainMS > bestGainMS )
+        {
+            bestJob = job;
+            bestGainMS = gainMS;
         }
     }
 
+    Job * job = bestJob ? bestJob : unknownJob;
+    if ( job )
+    {
+        job->SetDistributionState( Job::DIST_RACING );
+        ReserveLocalMemory( job );
+        return job;
+    }
+
     return nullptr; // No job found to race (all were local or races already)
 }
 
+// EstimateRaceGainMS
+//------------------------------------------------------------------------------
+/*static*/ uint32_t JobQueue::EstimateRaceGainMS( uint32_t elapsedMS, uint32_t expectedRemoteTimeMS, uint32_t expectedLocalTimeMS )
+{
+    // Estimate the time remaining for the remote job. Once a job is overdue
+    // we have no idea when it will complete, so assume it will take at least
+    // as long again as it is already overdue (i.e. the worker is stalled).
+    const uint32_t remainingMS = ( elapsedMS < expectedRemoteTimeMS ) ? ( expectedRemoteTimeMS - elapsedMS )
+                                                                       : ( elapsedMS - expectedRemoteTimeMS );
+
+    // Only worth racing if we expect to finish first
+    return ( remainingMS > expectedLocalTimeMS ) ? ( remainingMS - expectedLocalTimeMS ) : 0;
+}
+
+// CalcLocalMemoryAvailableMiB
+//------------------------------------------------------------------------------
+/*static*/ uint32_t JobQueue::CalcLocalMemoryAvailableMiB( uint32_t budgetMiB, uint32_t inUseMiB, uint32_t availPhysMiB )
+{
+    // Always allow a job to start if nothing we know to be memory hungry is in
+    // progress to ensure forward progress (jobs without history are unrestricted)
+    if ( inUseMiB == 0 )
+    {
+        return MEMORY_UNLIMITED;
+    }
+
+    // Jobs in progress may not have reached their peak yet, so the remaining
+    // budget ensures we don't over-commit when starting several at once. The
+    // memory available now accounts for other processes on the machine.
+    const uint32_t budgetRemainingMiB = ( budgetMiB > inUseMiB ) ? ( budgetMiB - inUseMiB ) : 0;
+    return Math::Min( budgetRemainingMiB, availPhysMiB );
+}
+
+// GetLocalMemoryAvailableMiB
+//------------------------------------------------------------------------------
+uint32_t JobQueue::GetLocalMemoryAvailableMiB() const
+{
+    // Avoid querying the system when nothing with a known cost is in progress
+    if ( m_LocalMemoryInUseMiB == 0 )
+    {
+        return MEMORY_UNLIMITED;
+    }
+
+    SystemMemInfo memInfo;
+    MemInfo::GetSystemInfo( memInfo );
+    return CalcLocalMemoryAvailableMiB( m_LocalMemoryBudgetMiB, m_LocalMemoryInUseMiB, memInfo.mAvailPhysMiB );
+}
+
+// ReserveLocalMemory
+//------------------------------------------------------------------------------
+void JobQueue::ReserveLocalMemory( Job * job )
+{
+    ASSERT( job->GetLocalMemoryReservedMiB() == 0 );
+    const uint32_t memoryMiB = job->GetMemoryRequiredMiB();
+    job->SetLocalMemoryReservedMiB( memoryMiB );
+    m_LocalMemoryInUseMiB += memoryMiB;
+}
+
+// ReleaseLocalMemory
+//------------------------------------------------------------------------------
+void JobQueue::ReleaseLocalMemory( Job * job )
+{
+    const uint32_t memoryMiB = job->GetLocalMemoryReservedMiB();
+    if ( memoryMiB == 0 )
+    {
+        return;
+    }
+
+    {
+        MutexHolder mh( m_LocalMemoryMutex );
+        ASSERT( m_LocalMemoryInUseMiB >= memoryMiB );
+        m_LocalMemoryInUseMiB -= memoryMiB;
+    }
+    job->SetLocalMemoryReservedMiB( 0 );
+
+    // Jobs may have been held back waiting for memory
+    m_WorkerThreadSemaphore.Signal();
+}
+
 // OnReturnRemoteJob
 //------------------------------------------------------------------------------
 Job * JobQueue::OnReturnRemoteJob( uint32_t jobId,
@@ -640,6 +839,15 @@ void JobQueue::FinalizeCompletedJobs( NodeGraph & nodeGraph )
         m_CompletedJobsFailed2.Swap( m_CompletedJobsFailed );
     }
 
+    // Completed jobs may have modified files, so timestamps obtained before the
+    // build can no longer be relied upon
+    if ( ( m_CompletedJobs2.IsEmpty() == false ) ||
+         ( m_CompletedJobsAborted2.IsEmpty() == false ) ||
+         ( m_CompletedJobsFailed2.IsEmpty() == false ) )
+    {
+        Node::DiscardPrefetchedFileTimes();
+    }
+
     // Process results
     Array< Job * > * jobArrays[] = { &m_CompletedJobs2,
                                      &m_CompletedJobsAborted2,
@@ -657,6 +865,12 @@ void JobQueue::FinalizeCompletedJobs( NodeGraph & nodeGraph )
             const uint8_t groupIndex = n->GetConcurrencyGroupIndex();
             m_ConcurrencyGroupsState[ groupIndex ].m_ActiveJobs -= 1;
 
+            // Resources used by processes spawned locally
+            if ( job->GetProcessUsage().m_NumProcesses > 0 )
+            {
+                FBuild::Get().GetStatsMutable().RecordProcessUsage( n->GetType(), job->GetProcessUsage() );
+            }
+
             if ( completedJob )
             {
                 // Finalize completed jobs
@@ -747,10 +961,19 @@ void JobQueue::WorkerThreadWait( uint32_t maxWaitMS )
 //------------------------------------------------------------------------------
 Job * JobQueue::GetJobToProcess()
 {
-    Job * job = m_LocalJobs_Available.RemoveJob();
+    // lock-free early out if there are no jobs
+    if ( m_LocalJobs_Available.GetCount() == 0 )
+    {
+        return nullptr;
+    }
+
+    MutexHolder mh( m_LocalMemoryMutex );
+    Job * job = m_LocalJobs_Available.RemoveJob( GetLocalMemoryAvailableMiB() );
     if ( job )
     {
+        ReserveLocalMemory( job );
         AtomicInc( &m_NumLocalJobsActive );
+        Metrics::s_JobsActive.Increment();
         return job;
     }
 
@@ -768,6 +991,8 @@ void JobQueue::FinishedProcessingJob( Job * job, Node::BuildResult result, bool
             ( result == Node::BuildResult::eAborted ) ||
             ( result == Node::BuildResult::eFailed ) );
 
+    ReleaseLocalMemory( job );
+
     if ( wasARemoteJob )
     {
         MutexHolder mh( m_DistributedJobsMutex );
@@ -824,6 +1049,16 @@ void JobQueue::FinishedProcessingJob( Job * job, Node::BuildResult result, bool
     {
         ASSERT( m_NumLocalJobsActive > 0 );
         AtomicDec( &m_NumLocalJobsActive );
+        Metrics::s_JobsActive.Decrement();
+    }
+
+    if ( result == Node::BuildResult::eOk )
+    {
+        Metrics::s_JobsSucceeded.Add();
+    }
+    else if ( result == Node::BuildResult::eFailed )
+    {
+        Metrics::s_JobsFailed.Add();
     }
 
     {
@@ -925,6 +1160,10 @@ void JobQueue::FinishedProcessingJob( Job * job, Node::BuildResult result, bool
                 // record new build time only if built (i.e. if cached or failed, the time
                 // does not represent how long it takes to create this resource)
                 node->SetLastBuildTime( timeTakenMS );
+                if ( job->GetPeakMemoryMiB() > 0 )
+                {
+                    node->SetLastPeakMemoryMiB( job->GetPeakMemoryMiB() );
+                }
                 node->SetStatFlag( Node::STATS_BUILT );
                 FLOG_VERBOSE( "-Build: %u ms\t%s", timeTakenMS, node->GetName().Get() );
             }
@@ -949,6 +1188,7 @@ void JobQueue::FinishedProcessingJob( Job * job, Node::BuildResult result, bool
 
     // log processing time
     node->AddProcessingTime( timeTakenMS );
+    Metrics::s_JobDuration.Observe( timeTakenMS );
 
     if ( nodeRelevantToMonitorLog && FLog::IsMonitorEnabled() )
     {
@@ -33,8 +33,8 @@ public:
     // jobs pushed by the main thread
     void QueueJobs( Array< Node * > & nodes );
 
-    // jobs consumed by workers
-    Job * RemoveJob();
+    // jobs consumed by workers (most expensive job which fits in the given memory)
+    Job * RemoveJob( uint32_t memoryAvailableMiB );
 private:
     uint32_t    m_Count;    // access the current count
     Mutex       m_Mutex;    // lock to add/remove jobs
@@ -70,6 +70,15 @@ public:
                       uint32_t & numJobsDist, uint32_t & numJobsDistActive ) const;
     bool HasPendingCompletedJobs() const;
 
+    // Estimate how much sooner a remote job would complete if raced locally (0 if not worth racing)
+    static uint32_t EstimateRaceGainMS( uint32_t elapsedMS, uint32_t expectedRemoteTimeMS, uint32_t expectedLocalTimeMS );
+
+    enum : uint32_t { MEMORY_UNLIMITED = 0xFFFFFFFF };
+
+    // Memory which can be used by additional local jobs given the memory available when the
+    // build started, the expected peak memory of jobs in progress and the memory available now
+    static uint32_t CalcLocalMemoryAvailableMiB( uint32_t budgetMiB, uint32_t inUseMiB, uint32_t availPhysMiB );
+
 private:
     // worker threads call these
     friend class WorkerThread;
@@ -81,9 +90,14 @@ private:
 
     void        QueueDistributableJob( Job * job );
 
+    // local memory accounting (m_LocalMemoryMutex must be held when selecting jobs)
+    uint32_t    GetLocalMemoryAvailableMiB() const;
+    void        ReserveLocalMemory( Job * job );
+    void        ReleaseLocalMemory( Job * job );
+
     // client side of protocol consumes jobs via this interface
     friend class Client;
-    Job *       GetDistributableJobToProcess( bool remote );
+    Job *       GetDistributableJobToProcess( bool remote, float remoteBuildTimeFactor = 0.0f, uint32_t maxJobMemoryMiB = 0, bool remoteSupportsExec = true );
     Job *       OnReturnRemoteJob( uint32_t jobId,
                                    bool systemError,
                                    bool & outRaceLost,
@@ -108,6 +122,11 @@ private:
     // Jobs in progress locally
     uint32_t            m_NumLocalJobsActive;
 
+    // Memory accounting for jobs in progress locally
+    Mutex               m_LocalMemoryMutex;
+    uint32_t            m_LocalMemoryBudgetMiB = 0; // Memory available when the build started
+    uint32_t            m_LocalMemoryInUseMiB = 0;  // Expected peak memory of jobs in progress
+
     // Jobs available for distributed processing (can also be done locally)
     mutable Mutex       m_DistributedJobsMutex;
     Array< Job * >      m_DistributableJobs_Available;  // Available, not in progress anywhere
@@ -10,15 +10,22 @@
 #include "Tools/FBuild/FBuildCore/FBuild.h"
 #include "Tools/FBuild/FBuildCore/FLog.h"
 #include "Tools/FBuild/FBuildCore/Graph/Node.h"
+#include "Tools/FBuild/FBuildCore/Cache/ICache.h"
 #include "Tools/FBuild/FBuildCore/Graph/ObjectNode.h"
 #include "Tools/FBuild/FBuildCore/Helpers/BuildProfiler.h"
+#include "Tools/FBuild/FBuildCore/Helpers/Compressor.h"
+#include "Tools/FBuild/FBuildCore/Helpers/Metrics.h"
 #include "Tools/FBuild/FBuildCore/Helpers/MultiBuffer.h"
+#include "Tools/FBuild/FBuildCore/Helpers/ToolManifest.h"
 
 // Core
 #include "Core/Env/ErrorFormat.h"
 #include "Core/FileIO/FileIO.h"
 #include "Core/FileIO/FileStream.h"
 #include "Core/FileIO/PathUtils.h"
+#include "Core/Math/xxHash.h"
+#include "Core/Mem/Mem.h"
+#include "Core/Mem/MemInfo.h"
 #include "Core/Process/ThreadPool.h"
 #include "Core/Profile/Profile.h"
 #include "Core/Time/Timer.h"
@@ -35,6 +42,11 @@ JobQueueRemote::JobQueueRemote( uint32_t numWorkerThreads ) :
 {
     WorkerThread::InitTmpDir( true ); // remote == true
 
+    // Jobs with known memory requirements are limited by physical memory
+    SystemMemInfo sysMemInfo;
+    MemInfo::GetSystemInfo( sysMemInfo );
+    m_MemoryBudgetMiB = sysMemInfo.mTotalPhysMiB;
+
     // Create thread pool
     m_ThreadPool = FNEW( ThreadPool( numWorkerThreads ) );
 
@@ -107,6 +119,14 @@ void JobQueueRemote::GetWorkerStatus( size_t index, AString & hostName, AString
     ( (WorkerThreadRemote *)m_Workers[ index ] )->GetStatus( hostName, status, isIdle );
 }
 
+// SetMemoryBudgetMiB
+//------------------------------------------------------------------------------
+void JobQueueRemote::SetMemoryBudgetMiB( uint32_t memoryMiB )
+{
+    MutexHolder m( m_PendingJobsMutex );
+    m_MemoryBudgetMiB = memoryMiB;
+}
+
 // MainThreadWait
 //------------------------------------------------------------------------------
 void JobQueueRemote::MainThreadWait( uint32_t timeoutMS )
@@ -142,6 +162,8 @@ void JobQueueRemote::WorkerThreadSleep()
 //------------------------------------------------------------------------------
 void JobQueueRemote::QueueJob( Job * job )
 {
+    job->RecordPhaseTime( Job::PHASE_WORKER_TOOLS_READY );
+
     {
         MutexHolder m( m_PendingJobsMutex );
         m_PendingJobs.Append( job );
@@ -245,14 +267,27 @@ Job * JobQueueRemote::GetJobToProcess()
     WorkerThreadWait();
 
     MutexHolder m( m_PendingJobsMutex );
-    if ( m_PendingJobs.IsEmpty() )
+
+    // building jobs in the order they are queued, skipping any which would
+    // exceed available memory (we always allow one job to be in flight)
+    Job ** jobIt = m_PendingJobs.Begin();
+    for ( ; jobIt != m_PendingJobs.End(); ++jobIt )
+    {
+        const uint32_t memoryRequiredMiB = ( *jobIt )->GetMemoryRequiredMiB();
+        if ( ( memoryRequiredMiB == 0 ) ||
+             ( m_MemoryInUseMiB == 0 ) ||
+             ( ( m_MemoryInUseMiB + memoryRequiredMiB ) <= m_MemoryBudgetMiB ) )
+        {
+            break;
+        }
+    }
+    if ( jobIt == m_PendingJobs.End() )
     {
         return nullptr;
     }
-
-    // building jobs in the order they are queued
-    Job * job = m_PendingJobs[ 0 ];
-    m_PendingJobs.PopFront();
+    Job * job = *jobIt;
+    m_PendingJobs.Erase( jobIt );
+    m_MemoryInUseMiB += job->GetMemoryRequiredMiB();
 
     MutexHolder mh( m_InFlightJobsMutex );
     m_InFlightJobs.Append( job );
@@ -272,6 +307,17 @@ void JobQueueRemote::FinishedProcessingJob( Job * job, Node::BuildResult result
         m_InFlightJobs.Erase( it );
     }
 
+    // release memory, which might allow a waiting job to start
+    if ( job->GetMemoryRequiredMiB() > 0 )
+    {
+        {
+            MutexHolder m( m_PendingJobsMutex );
+            ASSERT( m_MemoryInUseMiB >= job->GetMemoryRequiredMiB() );
+            m_MemoryInUseMiB -= job->GetMemoryRequiredMiB();
+        }
+        m_WorkerThreadSemaphore.Signal( 1 );
+    }
+
     // handle jobs which were cancelled while in flight
     if ( job->GetUserData() == nullptr )
     {
@@ -302,12 +348,19 @@ void JobQueueRemote::FinishedProcessingJob( Job * job, Node::BuildResult result
 
     const Timer timer; // track how long the item takes
 
-    ObjectNode * node = job->GetNode()->CastTo< ObjectNode >();
+    Node * node = job->GetNode();
+
+    // Object files can have additional outputs and be shared between clients
+    ObjectNode * objectNode = ( node->GetType() == Node::OBJECT_NODE ) ? node->CastTo< ObjectNode >() : nullptr;
 
     if ( job->IsLocal() )
     {
         FLOG_MONITOR( "START_JOB local \"%s\" \n", job->GetNode()->GetName().Get() );
     }
+    else
+    {
+        job->RecordPhaseTime( Job::PHASE_WORKER_STARTED );
+    }
 
     // remote tasks must output to a tmp file
     if ( job->IsLocal() == false )
@@ -332,17 +385,29 @@ void JobQueueRemote::FinishedProcessingJob( Job * job, Node::BuildResult result
     }
 
     // Delete any left over PDB from a previous run (to be sure we have a clean pdb)
-    if ( node->IsUsingPDB() && ( job->IsLocal() == false ) )
+    if ( objectNode && objectNode->IsUsingPDB() && ( job->IsLocal() == false ) )
     {
         AStackString<> pdbName;
-        node->GetPDBName( pdbName );
+        objectNode->GetPDBName( pdbName );
         FileIO::FileDelete( pdbName.Get() );
     }
 
     Node::BuildResult result;
+    uint32_t cachedBuildTimeMS = 0;
+    const bool retrievedFromResultCache = ( objectNode && ( job->IsLocal() == false ) && RetrieveFromResultCache( job, cachedBuildTimeMS ) );
+    if ( retrievedFromResultCache )
+    {
+        // Identical job was previously built for another client
+        result = Node::BuildResult::eOk;
+    }
+    else
     {
         PROFILE_SECTION( racingRemoteJob ? "RACE" : "LOCAL" );
-        result = ((Node *)node )->DoBuild2( job, racingRemoteJob );
+        result = node->DoBuild2( job, racingRemoteJob );
+    }
+    if ( job->IsLocal() == false )
+    {
+        job->RecordPhaseTime( Job::PHASE_WORKER_BUILT );
     }
 
     // Ignore result if job was cancelled
@@ -356,6 +421,10 @@ void JobQueueRemote::FinishedProcessingJob( Job * job, Node::BuildResult result
 
     const uint32_t timeTakenMS = uint32_t( timer.GetElapsedMS() );
 
+    // Results from the cache report the time taken to originally build them,
+    // so the client's build time history is unaffected
+    const uint32_t buildTimeMS = retrievedFromResultCache ? cachedBuildTimeMS : timeTakenMS;
+
     switch ( result )
     {
         case Node::BuildResult::eFailed:
@@ -383,7 +452,11 @@ void JobQueueRemote::FinishedProcessingJob( Job * job, Node::BuildResult result
         case Node::BuildResult::eOk:
         {
             // record new build time
-            node->SetLastBuildTime( timeTakenMS );
+            node->SetLastBuildTime( buildTimeMS );
+            if ( job->GetPeakMemoryMiB() > 0 )
+            {
+                node->SetLastPeakMemoryMiB( job->GetPeakMemoryMiB() );
+            }
             node->SetStatFlag( Node::STATS_BUILT );
 
             #ifdef DEBUG
@@ -396,7 +469,7 @@ void JobQueueRemote::FinishedProcessingJob( Job * job, Node::BuildResult result
 
 
             // TODO:A Also read into job if cache is being used
-            if ( job->IsLocal() == false )
+            if ( ( job->IsLocal() == false ) && ( retrievedFromResultCache == false ) )
             {
                 // read results into memory to send back to client
                 if ( ReadResults( job ) == false )
@@ -415,16 +488,22 @@ void JobQueueRemote::FinishedProcessingJob( Job * job, Node::BuildResult result
         FileIO::FileDelete( node->GetName().Get() );
 
         // Cleanup PDB file
-        if ( node->IsUsingPDB() )
+        if ( objectNode && objectNode->IsUsingPDB() )
         {
             AStackString<> pdbName;
-            node->GetPDBName( pdbName );
+            objectNode->GetPDBName( pdbName );
             FileIO::FileDelete( pdbName.Get() );
         }
     }
 
     // log processing time
     node->AddProcessingTime( timeTakenMS );
+    Metrics::s_ServerJobDuration.Observe( timeTakenMS );
+
+    if ( job->IsLocal() == false )
+    {
+        job->RecordPhaseTime( Job::PHASE_WORKER_RESULT_READY );
+    }
 
     if ( job->IsLocal() && FLog::IsMonitorEnabled() )
     {
@@ -444,14 +523,15 @@ void JobQueueRemote::FinishedProcessingJob( Job * job, Node::BuildResult result
 //------------------------------------------------------------------------------
 /*static*/ bool JobQueueRemote::ReadResults( Job * job )
 {
-    const ObjectNode * node = job->GetNode()->CastTo< ObjectNode >();
-    const bool includePDB = node->IsUsingPDB();
-    const bool usingStaticAnalysis = node->IsUsingStaticAnalysisMSVC();
+    const Node * node = job->GetNode();
+    const ObjectNode * objectNode = ( node->GetType() == Node::OBJECT_NODE ) ? node->CastTo< ObjectNode >() : nullptr;
+    const bool includePDB = objectNode && objectNode->IsUsingPDB();
+    const bool usingStaticAnalysis = objectNode && objectNode->IsUsingStaticAnalysisMSVC();
 
     // Determine list of files to send
 
-    // 1. Object file
-    //---------------
+    // 1. Object file (or other output)
+    //---------------------------------
     StackArray< AString > fileNames;
     fileNames.Append( node->GetName() );
 
@@ -460,7 +540,7 @@ void JobQueueRemote::FinishedProcessingJob( Job * job, Node::BuildResult result
     if ( includePDB )
     {
         AStackString<> pdbFileName;
-        node->GetPDBName( pdbFileName );
+        objectNode->GetPDBName( pdbFileName );
         fileNames.Append( pdbFileName );
     }
 
@@ -469,18 +549,25 @@ void JobQueueRemote::FinishedProcessingJob( Job * job, Node::BuildResult result
     if ( usingStaticAnalysis )
     {
         AStackString<> xmlFileName;
-        node->GetNativeAnalysisXMLPath( xmlFileName );
+        objectNode->GetNativeAnalysisXMLPath( xmlFileName );
         fileNames.Append( xmlFileName );
     }
 
     MultiBuffer mb;
     size_t problemFileIndex = 0;
-    if ( !mb.CreateFromFiles( fileNames, &problemFileIndex ) )
+    const bool readFiles = mb.CreateFromFiles( fileNames, &problemFileIndex );
+    if ( !readFiles )
     {
         job->Error( "Error reading file: '%s'", fileNames[ problemFileIndex ].Get() );
         FLOG_ERROR( "Error reading file: '%s'", fileNames[ problemFileIndex ].Get() );
     }
 
+    // Keep a copy of the (uncompressed) results for identical jobs
+    if ( readFiles && ( job->GetCacheName().IsEmpty() == false ) )
+    {
+        JobQueueRemote::Get().m_ResultCache.Publish( job->GetCacheName(), mb.GetData(), (size_t)mb.GetDataSize(), job->GetMessages(), node->GetLastBuildTime() );
+    }
+
     // Compress result
     const int32_t compressionLevel = job->GetResultCompressionLevel();
     if ( compressionLevel != 0 )
@@ -496,4 +583,92 @@ void JobQueueRemote::FinishedProcessingJob( Job * job, Node::BuildResult result
     return true;
 }
 
+// GetResultCacheId
+//------------------------------------------------------------------------------
+/*static*/ bool JobQueueRemote::GetResultCacheId( const Job * job, AString & outCacheId )
+{
+    PROFILE_FUNCTION;
+
+    const ObjectNode * node = job->GetNode()->CastTo< ObjectNode >();
+
+    // hash the pre-processed input data
+    const void * data = job->GetData();
+    size_t dataSize = job->GetDataSize();
+    Compressor c; // scoped here so we can access decompression buffer
+    if ( job->IsDataCompressed() )
+    {
+        if ( c.Decompress( data ) == false )
+        {
+            return false; // Job will report the failure when it tries to build
+        }
+        data = c.GetResult();
+        dataSize = c.GetResultSize();
+    }
+    const uint64_t preprocessedSourceKey = xxHash3::Calc64( data, dataSize );
+
+    // hash the args sent by the client and the output file name (which can
+    // be embedded in the output)
+    const char * fileName = ( job->GetRemoteName().FindLast( NATIVE_SLASH ) + 1 );
+    AStackString<> args( node->GetCompilerOptions() );
+    args.AppendFormat( " %08X %s", node->GetCompilerFlags().m_Flags, fileName );
+    const uint32_t commandLineKey = xxHash::Calc32( args );
+
+    // ToolChain hash
+    const uint64_t toolChainKey = job->GetToolManifest()->GetToolId();
+
+    ICache::GetCacheId( preprocessedSourceKey, commandLineKey, toolChainKey, 0, outCacheId );
+    return true;
+}
+
+// RetrieveFromResultCache
+//------------------------------------------------------------------------------
+/*static*/ bool JobQueueRemote::RetrieveFromResultCache( Job * job, uint32_t & outBuildTimeMS )
+{
+    WorkerResultCache & resultCache = JobQueueRemote::Get().m_ResultCache;
+    if ( resultCache.IsEnabled() == false )
+    {
+        return false;
+    }
+
+    AStackString<> cacheId;
+    if ( GetResultCacheId( job, cacheId ) == false )
+    {
+        return false;
+    }
+
+    // Take note of the id so results can be stored if not found
+    job->SetCacheName( cacheId );
+
+    void * data;
+    size_t dataSize;
+    Array< AString > messages;
+    if ( resultCache.Retrieve( cacheId, data, dataSize, messages, outBuildTimeMS ) == false )
+    {
+        return false;
+    }
+
+    // Compress result as requested by this client
+    const int32_t compressionLevel = job->GetResultCompressionLevel();
+    if ( compressionLevel != 0 )
+    {
+        Compressor c;
+        if ( job->GetAllowZstdUse() )
+        {
+            c.CompressZstd( data, dataSize, compressionLevel );
+        }
+        else
+        {
+            c.Compress( data, dataSize, compressionLevel );
+        }
+        FREE( data );
+        dataSize = c.GetResultSize();
+        data = c.ReleaseResult();
+    }
+
+    // transfer data to job
+    job->SetMessages( messages );
+    job->OwnData( data, dataSize );
+    return true;
+}
+
 //------------------------------------------------------------------------------
@@ -8,6 +8,7 @@
 #include "Core/Containers/Singleton.h"
 
 #include "Tools/FBuild/FBuildCore/Graph/Node.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/WorkerResultCache.h"
 #include "Core/Process/Mutex.h"
 #include "Core/Process/Semaphore.h"
 
@@ -38,6 +39,15 @@ public:
     inline size_t GetNumWorkers() const { return m_Workers.GetSize(); }
     void          GetWorkerStatus( size_t index, AString & hostName, AString & status, bool & isIdle ) const;
 
+    // Memory available for jobs, used to avoid over-subscription by jobs with
+    // known memory requirements (from their ConcurrencyGroup)
+    inline uint32_t GetMemoryBudgetMiB() const { return m_MemoryBudgetMiB; }
+    void SetMemoryBudgetMiB( uint32_t memoryMiB );
+
+    // Optional cache of results to avoid rebuilding identical jobs (0 to disable)
+    void SetResultCacheSize( uint64_t maxSize ) { m_ResultCache.SetMaxSize( maxSize ); }
+    const WorkerResultCache & GetResultCache() const { return m_ResultCache; }
+
     void MainThreadWait( uint32_t timeoutMS );
     void WakeMainThread();
 
@@ -55,9 +65,13 @@ private:
 
     // internal helpers
     static bool ReadResults( Job * job );
+    static bool GetResultCacheId( const Job * job, AString & outCacheId );
+    static bool RetrieveFromResultCache( Job * job, uint32_t & outBuildTimeMS );
 
     mutable Mutex       m_PendingJobsMutex;
     Array< Job * >      m_PendingJobs;
+    uint32_t            m_MemoryBudgetMiB = 0;  // Total memory for jobs
+    uint32_t            m_MemoryInUseMiB = 0;   // Memory required by in-flight jobs (protected by m_PendingJobsMutex)
     mutable Mutex       m_InFlightJobsMutex;
     Array< Job * >      m_InFlightJobs;
     Mutex               m_CompletedJobsMutex;
@@ -69,6 +83,8 @@ private:
     Semaphore           m_WorkerThreadSemaphore;
     Semaphore           m_WorkerThreadSleepSemaphore;
 
+    WorkerResultCache   m_ResultCache;
+
     ThreadPool *        m_ThreadPool;
     Array< WorkerThread * > m_Workers;
 };
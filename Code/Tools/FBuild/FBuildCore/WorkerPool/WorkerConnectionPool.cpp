@@ -7,6 +7,7 @@
 #include "WorkerBrokerage.h"
 
 // FBuild
+#include "Tools/FBuild/FBuildCore/Helpers/Metrics.h"
 #include "Tools/FBuild/FBuildCore/Protocol/Protocol.h"
 
 // Core
@@ -156,6 +157,7 @@ void WorkerConnectionPool::Process( const ConnectionInfo * connection, const Pro
 {
     MutexHolder mh( m_Mutex );
     ClearTimeoutWorkerWithoutMutex();
+    Metrics::s_CoordinatorWorkerListRequests.Add();
 
     MemoryStream ms;
     const size_t numWorkers( m_Workers.GetSize() );
@@ -275,6 +277,7 @@ bool WorkerConnectionPool::ClearTimeoutWorkerWithoutMutex()
     }
 
     m_Workers.Swap(newWorkers);
+    Metrics::s_CoordinatorWorkers.Set( (int64_t)m_Workers.GetSize() );
 
     if ( hasTimeout ) OutputCurrentWorkers();
     return hasTimeout;
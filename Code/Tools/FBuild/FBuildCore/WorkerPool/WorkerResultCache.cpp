@@ -0,0 +1,197 @@
+// WorkerResultCache - Cache of job results on a worker
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "WorkerResultCache.h"
+
+// Core
+#include "Core/Env/Assert.h"
+#include "Core/Mem/Mem.h"
+#include "Core/Profile/Profile.h"
+
+// system
+#include <string.h> // for memcpy
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+WorkerResultCache::WorkerResultCache() = default;
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+WorkerResultCache::~WorkerResultCache()
+{
+    EvictAll();
+}
+
+// SetMaxSize
+//------------------------------------------------------------------------------
+void WorkerResultCache::SetMaxSize( uint64_t maxSize )
+{
+    MutexHolder mh( m_Mutex );
+    m_MaxSize = maxSize;
+    if ( maxSize == 0 )
+    {
+        EvictAll(); // Including empty results, which don't count towards the size
+        return;
+    }
+    EvictEntries( maxSize );
+}
+
+// Retrieve
+//------------------------------------------------------------------------------
+bool WorkerResultCache::Retrieve( const AString & cacheId, void * & outData, size_t & outDataSize, Array< AString > & outMessages, uint32_t & outBuildTimeMS )
+{
+    PROFILE_FUNCTION;
+
+    MutexHolder mh( m_Mutex );
+    const UnorderedMap< AString, Entry * >::KeyValue * keyValue = m_Entries.Find( cacheId );
+    if ( keyValue == nullptr )
+    {
+        ++m_NumMisses;
+        return false;
+    }
+
+    Entry * entry = keyValue->m_Value;
+    Unlink( entry );
+    LinkMostRecent( entry );
+    ++m_NumHits;
+
+    outData = ALLOC( entry->m_DataSize );
+    memcpy( outData, entry->m_Data, entry->m_DataSize );
+    outDataSize = entry->m_DataSize;
+    outMessages = entry->m_Messages;
+    outBuildTimeMS = entry->m_BuildTimeMS;
+    return true;
+}
+
+// Publish
+//------------------------------------------------------------------------------
+void WorkerResultCache::Publish( const AString & cacheId, const void * data, size_t dataSize, const Array< AString > & messages, uint32_t buildTimeMS )
+{
+    PROFILE_FUNCTION;
+
+    MutexHolder mh( m_Mutex );
+
+    if ( IsEnabled() == false )
+    {
+        return;
+    }
+
+    // Ignore results which would evict everything else
+    if ( dataSize > ( m_MaxSize / 4 ) )
+    {
+        return;
+    }
+
+    // Identical job may have been in flight concurrently
+    if ( m_Entries.Find( cacheId ) )
+    {
+        return;
+    }
+
+    // Make room
+    EvictEntries( m_MaxSize - dataSize );
+
+    Entry * entry = FNEW( Entry );
+    entry->m_CacheId = cacheId;
+    entry->m_Data = ALLOC( dataSize );
+    memcpy( entry->m_Data, data, dataSize );
+    entry->m_DataSize = dataSize;
+    entry->m_Messages = messages;
+    entry->m_BuildTimeMS = buildTimeMS;
+    m_Entries.Insert( cacheId, entry );
+    LinkMostRecent( entry );
+    m_Size += dataSize;
+}
+
+// GetStats
+//------------------------------------------------------------------------------
+void WorkerResultCache::GetStats( uint32_t & outNumHits, uint32_t & outNumMisses, uint64_t & outSize ) const
+{
+    MutexHolder mh( m_Mutex );
+    outNumHits = m_NumHits;
+    outNumMisses = m_NumMisses;
+    outSize = m_Size;
+}
+
+// EvictEntries
+//------------------------------------------------------------------------------
+void WorkerResultCache::EvictEntries( uint64_t maxSize )
+{
+    // Remove least recently used entries until we're within the limit
+    while ( m_Size > maxSize )
+    {
+        ASSERT( m_LeastRecent );
+        Evict( m_LeastRecent );
+    }
+}
+
+// EvictAll
+//------------------------------------------------------------------------------
+void WorkerResultCache::EvictAll()
+{
+    // Walk the list rather than relying on the size, as empty results
+    // don't contribute to it
+    while ( m_LeastRecent )
+    {
+        Evict( m_LeastRecent );
+    }
+    ASSERT( m_MostRecent == nullptr );
+    ASSERT( m_Entries.IsEmpty() );
+    ASSERT( m_Size == 0 );
+}
+
+// Evict
+//------------------------------------------------------------------------------
+void WorkerResultCache::Evict( Entry * entry )
+{
+    Unlink( entry );
+    VERIFY( m_Entries.Erase( entry->m_CacheId ) );
+    m_Size -= entry->m_DataSize;
+    FREE( entry->m_Data );
+    FDELETE entry;
+}
+
+// LinkMostRecent
+//------------------------------------------------------------------------------
+void WorkerResultCache::LinkMostRecent( Entry * entry )
+{
+    entry->m_MoreRecent = nullptr;
+    entry->m_LessRecent = m_MostRecent;
+    if ( m_MostRecent )
+    {
+        m_MostRecent->m_MoreRecent = entry;
+    }
+    else
+    {
+        m_LeastRecent = entry;
+    }
+    m_MostRecent = entry;
+}
+
+// Unlink
+//------------------------------------------------------------------------------
+void WorkerResultCache::Unlink( Entry * entry )
+{
+    if ( entry->m_MoreRecent )
+    {
+        entry->m_MoreRecent->m_LessRecent = entry->m_LessRecent;
+    }
+    else
+    {
+        m_MostRecent = entry->m_LessRecent;
+    }
+    if ( entry->m_LessRecent )
+    {
+        entry->m_LessRecent->m_MoreRecent = entry->m_MoreRecent;
+    }
+    else
+    {
+        m_LeastRecent = entry->m_MoreRecent;
+    }
+    entry->m_MoreRecent = nullptr;
+    entry->m_LessRecent = nullptr;
+}
+
+//------------------------------------------------------------------------------
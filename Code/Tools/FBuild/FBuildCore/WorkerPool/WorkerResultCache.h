@@ -0,0 +1,66 @@
+// WorkerResultCache - Cache of job results on a worker
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Core/Containers/Array.h"
+#include "Core/Containers/UnorderedMap.h"
+#include "Core/Env/Types.h"
+#include "Core/Process/Mutex.h"
+#include "Core/Strings/AString.h"
+
+// WorkerResultCache
+//------------------------------------------------------------------------------
+// Identical jobs sent by different clients (for example when many people build
+// the same changelist) are only compiled once. Results are held in memory
+// (uncompressed) up to the configured size, evicting least recently used first.
+class WorkerResultCache
+{
+public:
+    WorkerResultCache();
+    ~WorkerResultCache();
+
+    // Size limit (0 disables the cache)
+    void SetMaxSize( uint64_t maxSize );
+    inline bool IsEnabled() const { return ( m_MaxSize > 0 ); }
+
+    // Retrieve a copy of cached results, which the caller must FREE, along with
+    // the time taken to originally build them
+    bool Retrieve( const AString & cacheId, void * & outData, size_t & outDataSize, Array< AString > & outMessages, uint32_t & outBuildTimeMS );
+    void Publish( const AString & cacheId, const void * data, size_t dataSize, const Array< AString > & messages, uint32_t buildTimeMS );
+
+    // Stats
+    void GetStats( uint32_t & outNumHits, uint32_t & outNumMisses, uint64_t & outSize ) const;
+
+private:
+    struct Entry
+    {
+        AString             m_CacheId;
+        void *              m_Data = nullptr;
+        size_t              m_DataSize = 0;
+        Array< AString >    m_Messages;
+        uint32_t            m_BuildTimeMS = 0;
+
+        // Position in list ordered by use
+        Entry *             m_MoreRecent = nullptr;
+        Entry *             m_LessRecent = nullptr;
+    };
+
+    void EvictEntries( uint64_t maxSize );
+    void EvictAll();
+    void Evict( Entry * entry );
+    void LinkMostRecent( Entry * entry );
+    void Unlink( Entry * entry );
+
+    mutable Mutex       m_Mutex;
+    UnorderedMap< AString, Entry * > m_Entries;
+    Entry *             m_MostRecent = nullptr;
+    Entry *             m_LeastRecent = nullptr;
+    uint64_t            m_MaxSize = 0;
+    uint64_t            m_Size = 0;
+    uint32_t            m_NumHits = 0;
+    uint32_t            m_NumMisses = 0;
+};
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,50 @@
+//
+// Allocate and use 64 MiB of memory
+//
+// On Linux/OSX this is done in a child process, as a compiler driver runs
+// the compiler proper
+//
+#include <stdlib.h>
+#if defined( _WIN32 )
+    #include <windows.h>
+#else
+    #include <sys/wait.h>
+    #include <unistd.h>
+#endif
+
+static void Allocate()
+{
+    // Write to every page so the memory is resident
+    const size_t size = ( 64 * 1024 * 1024 );
+    volatile char * mem = static_cast< volatile char * >( malloc( size ) );
+    for ( size_t i = 0; i < size; i += 4096 )
+    {
+        mem[ i ] = 1;
+    }
+
+    // Stay alive long enough to be observed
+    #if defined( _WIN32 )
+        Sleep( 250 );
+    #else
+        usleep( 250 * 1000 );
+    #endif
+    free( const_cast< char * >( mem ) );
+}
+
+int main( int, char *[] )
+{
+    #if defined( _WIN32 )
+        Allocate();
+        return 0;
+    #else
+        const pid_t pid = fork();
+        if ( pid == 0 )
+        {
+            Allocate();
+            return 0;
+        }
+        int status = -1;
+        waitpid( pid, &status, 0 );
+        return ( WIFEXITED( status ) ? WEXITSTATUS( status ) : 1 );
+    #endif
+}
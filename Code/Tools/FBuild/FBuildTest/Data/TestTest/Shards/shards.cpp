@@ -0,0 +1,17 @@
+//
+// An executable to run as a sharded test, reporting the shard it was asked to run
+//
+#include <stdio.h>
+#include <stdlib.h>
+
+int main( int argc, char ** argv )
+{
+    const char * index = getenv( "GTEST_SHARD_INDEX" );
+    const char * total = getenv( "GTEST_TOTAL_SHARDS" );
+    printf( "Env %s/%s\n", index ? index : "-", total ? total : "-" );
+    for ( int i = 1; i < argc; ++i )
+    {
+        printf( "Arg %s\n", argv[ i ] );
+    }
+    return 0;
+}
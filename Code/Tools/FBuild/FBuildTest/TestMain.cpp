@@ -14,7 +14,10 @@ int main( int, char *[] )
     REGISTER_TESTGROUP( TestArgs )
     REGISTER_TESTGROUP( TestBFFParsing )
     REGISTER_TESTGROUP( TestBuildAndLinkLibrary )
+    REGISTER_TESTGROUP( TestBuildDaemon )
     REGISTER_TESTGROUP( TestBuildFBuild )
+    REGISTER_TESTGROUP( TestBuildHistory )
+    REGISTER_TESTGROUP( TestBuildTrace )
     REGISTER_TESTGROUP( TestCache )
     REGISTER_TESTGROUP( TestCachePlugin )
     REGISTER_TESTGROUP( TestCompilationDatabase )
@@ -22,6 +25,7 @@ int main( int, char *[] )
     REGISTER_TESTGROUP( TestCompressor )
     REGISTER_TESTGROUP( TestConcurrencyGroups )
     REGISTER_TESTGROUP( TestCopy )
+    REGISTER_TESTGROUP( TestCriticalPath )
     REGISTER_TESTGROUP( TestDependencies )
     REGISTER_TESTGROUP( TestDirectoryList )
     REGISTER_TESTGROUP( TestDistributed )
@@ -31,11 +35,13 @@ int main( int, char *[] )
     REGISTER_TESTGROUP( TestExec )
     REGISTER_TESTGROUP( TestFastCancel )
     REGISTER_TESTGROUP( TestGraph )
+    REGISTER_TESTGROUP( TestHeaderImpact )
     REGISTER_TESTGROUP( TestIf )
     REGISTER_TESTGROUP( TestIncludeParser )
     REGISTER_TESTGROUP( TestLibrary )
     REGISTER_TESTGROUP( TestLinker )
     REGISTER_TESTGROUP( TestListDependencies )
+    REGISTER_TESTGROUP( TestMetrics )
     REGISTER_TESTGROUP( TestNodeReflection )
     REGISTER_TESTGROUP( TestObject )
     REGISTER_TESTGROUP( TestObjectList )
@@ -95,6 +95,7 @@ public:
     void SerializeDepGraphToText( const char * nodeName, AString & outBuffer ) const;
 
     const AString & GetDependencyGraphFile() const { return m_DependencyGraphFile; }
+    const NodeGraph & GetDependencyGraph() const { return *m_DependencyGraph; }
 
     using FBuild::Build;
     virtual bool Build( Node * nodeToBuild ) override;
@@ -6,6 +6,7 @@
 #include "FBuildTest.h"
 
 #include "Tools/FBuild/FBuildCore/FBuild.h"
+#include "Tools/FBuild/FBuildCore/Graph/LibraryNode.h"
 
 #include "Core/FileIO/FileIO.h"
 #include "Core/Strings/AStackString.h"
@@ -25,6 +26,7 @@ private:
     void TestLibMerge_NoRebuild() const;
     void TestLibMerge_NoRebuild_BFFChange() const;
     void DeleteFile() const;
+    void BuiltInArchiver() const;
 
     const char * GetBuildLibDBFileName() const { return "../tmp/Test/BuildAndLinkLibrary/buildlib.fdb"; }
     const char * GetMergeLibDBFileName() const { return "../tmp/Test/BuildAndLinkLibrary/mergelib.fdb"; }
@@ -41,6 +43,9 @@ REGISTER_TESTS_BEGIN( TestBuildAndLinkLibrary )
     REGISTER_TEST( TestLibMerge_NoRebuild )
     REGISTER_TEST( TestLibMerge_NoRebuild_BFFChange )
     REGISTER_TEST( DeleteFile )
+    #if defined( __LINUX__ )
+        REGISTER_TEST( BuiltInArchiver ) // ELF only
+    #endif
 REGISTER_TESTS_END
 
 // TestStackFramesEmpty
@@ -304,4 +309,77 @@ void TestBuildAndLinkLibrary::DeleteFile() const
     }
 }
 
+// BuiltInArchiver
+//------------------------------------------------------------------------------
+void TestBuildAndLinkLibrary::BuiltInArchiver() const
+{
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestBuildAndLinkLibrary/BuiltInArchiver/fbuild.bff";
+    options.m_ForceCleanBuild = true;
+    const char * const dbFile = "../tmp/Test/BuildAndLinkLibrary/BuiltInArchiver/fbuild.fdb";
+    const char * const fileA = "../tmp/Test/BuildAndLinkLibrary/BuiltInArchiver/Input/a.cpp";
+    const char * const fileB = "../tmp/Test/BuildAndLinkLibrary/BuiltInArchiver/Input/b_with_a_long_file_name.cpp";
+    const char * const fileMain = "../tmp/Test/BuildAndLinkLibrary/BuiltInArchiver/Main/main.cpp";
+
+    TEST_ASSERT( FileIO::EnsurePathExistsForFile( AStackString<>( fileA ) ) );
+    TEST_ASSERT( FileIO::EnsurePathExistsForFile( AStackString<>( fileMain ) ) );
+    MakeFile( fileA, "int A() { return 1; }\n" );
+    MakeFile( fileB, "int FunctionWithALongFileName() { return 2; }\n" );
+    MakeFile( fileMain, "int A();\n"
+                        "int FunctionWithALongFileName();\n"
+                        "int main() { return A() + FunctionWithALongFileName() - 3; }\n" );
+
+    // Libraries can be linked, which requires a valid symbol table
+    {
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "Exe" ) );
+        TEST_ASSERT( fBuild.Build( "ExeThin" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( dbFile ) );
+
+        EnsureFileExists( "../tmp/Test/BuildAndLinkLibrary/BuiltInArchiver/exe" );
+        EnsureFileExists( "../tmp/Test/BuildAndLinkLibrary/BuiltInArchiver/exethin" );
+
+        // Thin archive doesn't contain the objects
+        FileIO::FileInfo lib;
+        FileIO::FileInfo libThin;
+        TEST_ASSERT( FileIO::GetFileInfo( AStackString<>( "../tmp/Test/BuildAndLinkLibrary/BuiltInArchiver/lib.a" ), lib ) );
+        TEST_ASSERT( FileIO::GetFileInfo( AStackString<>( "../tmp/Test/BuildAndLinkLibrary/BuiltInArchiver/libthin.a" ), libThin ) );
+        TEST_ASSERT( libThin.m_Size < lib.m_Size );
+
+        Array< const Node * > libraries;
+        fBuild.GetNodesOfType( Node::LIBRARY_NODE, libraries );
+        TEST_ASSERT( libraries.GetSize() == 2 );
+        for ( const Node * library : libraries )
+        {
+            TEST_ASSERT( library->CastTo< LibraryNode >()->GetNumArchiveMembersScanned() == 2 );
+        }
+    }
+    options.m_ForceCleanBuild = false;
+
+    // Only modified members are scanned for symbols
+    MakeFile( fileA, "int A() { return 3; }\n" );
+    MakeFile( fileMain, "int A();\n"
+                        "int FunctionWithALongFileName();\n"
+                        "int main() { return A() + FunctionWithALongFileName() - 5; }\n" );
+    {
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( dbFile ) );
+        TEST_ASSERT( fBuild.Build( "Exe" ) );
+        TEST_ASSERT( fBuild.Build( "ExeThin" ) );
+
+        // Check stats
+        //               Seen,  Built,  Type
+        CheckStatsNode ( 2,     2,      Node::LIBRARY_NODE );
+        CheckStatsNode ( 2,     2,      Node::EXE_NODE );
+
+        Array< const Node * > libraries;
+        fBuild.GetNodesOfType( Node::LIBRARY_NODE, libraries );
+        for ( const Node * library : libraries )
+        {
+            TEST_ASSERT( library->CastTo< LibraryNode >()->GetNumArchiveMembersScanned() == 1 );
+        }
+    }
+}
+
 //------------------------------------------------------------------------------
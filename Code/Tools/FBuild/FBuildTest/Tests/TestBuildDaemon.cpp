@@ -0,0 +1,320 @@
+// TestBuildDaemon.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "FBuildTest.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/FBuild.h"
+#include "Tools/FBuild/FBuildCore/Helpers/BuildDaemon.h"
+
+// Core
+#include "Core/FileIO/FileIO.h"
+#include "Core/FileIO/FileStream.h"
+#include "Core/FileIO/PathUtils.h"
+#include "Core/Process/Thread.h"
+#include "Core/Strings/AStackString.h"
+
+// TestBuildDaemon
+//------------------------------------------------------------------------------
+class TestBuildDaemon : public FBuildTest
+{
+private:
+    DECLARE_TESTS
+
+    void RepeatedBuilds() const;
+    void WrongWorkingDir() const;
+    void ClientServer() const;
+    void WrongToken() const;
+    void OptionsCompatibility() const;
+
+    // Helpers
+    void PrepareSource( const char * contents ) const;
+    static void GetArgs( Array< AString > & outArgs );
+};
+
+// Register Tests
+//------------------------------------------------------------------------------
+REGISTER_TESTS_BEGIN( TestBuildDaemon )
+    REGISTER_TEST( RepeatedBuilds )
+    REGISTER_TEST( WrongWorkingDir )
+    REGISTER_TEST( ClientServer )
+    REGISTER_TEST( WrongToken )
+    REGISTER_TEST( OptionsCompatibility )
+REGISTER_TESTS_END
+
+// Constants
+//------------------------------------------------------------------------------
+namespace
+{
+    const char * const kConfigFile  = "Tools/FBuild/FBuildTest/Data/TestBuildDaemon/fbuild.bff";
+    const char * const kSourceFile  = "../tmp/Test/BuildDaemon/source.txt";
+    const char * const kDestFile    = "../tmp/Test/BuildDaemon/dest.txt";
+    const char * const kDBFile      = "../tmp/Test/BuildDaemon/fbuild.fdb";
+
+    // In-process client must not print forwarded output, as it would be
+    // forwarded by the daemon again
+    class TestClient : public BuildDaemonClient
+    {
+    public:
+        virtual void OnOutput( const char * /*message*/ ) override {}
+    };
+
+    // Expose internals for testing
+    class TestDaemon : public BuildDaemon
+    {
+    public:
+        using BuildDaemon::AreOptionsCompatible;
+    };
+}
+
+// RepeatedBuilds
+//------------------------------------------------------------------------------
+void TestBuildDaemon::RepeatedBuilds() const
+{
+    PrepareSource( "a" );
+
+    FBuildTestOptions options;
+    options.m_ConfigFile = kConfigFile;
+    BuildDaemon daemon( options );
+
+    Array< AString > args;
+    GetArgs( args );
+
+    // Initial build
+    TEST_ASSERT( daemon.ProcessRequest( options.GetWorkingDir(), args ) == BuildDaemon::RESULT_OK );
+    CheckStatsNode( 1, 1, Node::COPY_FILE_NODE );
+    AString contents;
+    LoadFileContentsAsString( kDestFile, contents );
+    TEST_ASSERT( contents == "a" );
+
+    // Nothing has changed, so the resident graph is re-used and nothing is built
+    const FBuild * fBuild = &FBuild::Get();
+    TEST_ASSERT( daemon.ProcessRequest( options.GetWorkingDir(), args ) == BuildDaemon::RESULT_OK );
+    TEST_ASSERT( &FBuild::Get() == fBuild );
+    CheckStatsNode( 1, 0, Node::COPY_FILE_NODE );
+
+    // Modified source is detected
+    PrepareSource( "b" );
+    TEST_ASSERT( daemon.ProcessRequest( options.GetWorkingDir(), args ) == BuildDaemon::RESULT_OK );
+    TEST_ASSERT( &FBuild::Get() == fBuild );
+    CheckStatsNode( 1, 1, Node::COPY_FILE_NODE );
+    LoadFileContentsAsString( kDestFile, contents );
+    TEST_ASSERT( contents == "b" );
+
+    // Deleted output is detected
+    EnsureFileDoesNotExist( kDestFile );
+    TEST_ASSERT( daemon.ProcessRequest( options.GetWorkingDir(), args ) == BuildDaemon::RESULT_OK );
+    CheckStatsNode( 1, 1, Node::COPY_FILE_NODE );
+    EnsureFileExists( kDestFile );
+
+    // Bad args are reported
+    args.EmplaceBack( "-badarg" );
+    TEST_ASSERT( daemon.ProcessRequest( options.GetWorkingDir(), args ) == BuildDaemon::RESULT_BAD_ARGS );
+}
+
+// WrongWorkingDir
+//------------------------------------------------------------------------------
+void TestBuildDaemon::WrongWorkingDir() const
+{
+    FBuildTestOptions options;
+    options.m_ConfigFile = kConfigFile;
+    BuildDaemon daemon( options );
+
+    Array< AString > args;
+    GetArgs( args );
+
+    // A daemon only serves builds in its own working dir
+    AStackString<> otherDir( options.GetWorkingDir() );
+    otherDir += NATIVE_SLASH;
+    otherDir += "Other";
+    TEST_ASSERT( daemon.ProcessRequest( otherDir, args ) == BuildDaemon::RESULT_WRONG_WORKING_DIR );
+}
+
+// ClientServer
+//------------------------------------------------------------------------------
+void TestBuildDaemon::ClientServer() const
+{
+    PrepareSource( "a" );
+
+    FBuildTestOptions options;
+    options.m_ConfigFile = kConfigFile;
+    options.m_DBFile = kDBFile;
+    options.m_Profile = false;
+    BuildDaemon daemon( options );
+
+    // Client must be on another thread as the daemon builds on the main thread
+    struct ClientData
+    {
+        BuildDaemon *       m_Daemon;
+        FBuildOptions *     m_Options;
+        bool                m_Connected;
+        BuildDaemon::Result m_Result;
+    };
+    ClientData data{ &daemon, &options, false, BuildDaemon::RESULT_BUILD_FAILED };
+
+    Thread thread;
+    thread.Start( []( void * userData ) -> uint32_t
+    {
+        ClientData & clientData = *static_cast< ClientData * >( userData );
+        Array< AString > args;
+        GetArgs( args );
+
+        // Wait for the daemon to start listening
+        for ( uint32_t attempt = 0; attempt < 100; ++attempt )
+        {
+            TestClient client;
+            if ( client.Build( *clientData.m_Options, args, clientData.m_Result ) )
+            {
+                clientData.m_Connected = true;
+                break;
+            }
+            Thread::Sleep( 50 );
+        }
+
+        clientData.m_Daemon->Stop();
+        return 0;
+    }, "TestBuildDaemon", &data );
+
+    TEST_ASSERT( daemon.Run() );
+    thread.Join();
+
+    // Build was performed by the daemon
+    TEST_ASSERT( data.m_Connected );
+    TEST_ASSERT( data.m_Result == BuildDaemon::RESULT_OK );
+    TEST_ASSERT( GetRecordedOutput().Find( "FBuild: OK: Copy" ) );
+    EnsureFileExists( kDestFile );
+
+    // Token is removed when the daemon stops
+    AStackString<> tokenFile;
+    BuildDaemon::GetTokenFileName( options, tokenFile );
+    EnsureFileDoesNotExist( tokenFile );
+}
+
+// WrongToken
+//------------------------------------------------------------------------------
+void TestBuildDaemon::WrongToken() const
+{
+    PrepareSource( "a" );
+
+    FBuildTestOptions options;
+    options.m_ConfigFile = kConfigFile;
+    options.m_DBFile = kDBFile;
+    options.m_Profile = false;
+    BuildDaemon daemon( options );
+
+    // Client must be on another thread as the daemon builds on the main thread
+    struct ClientData
+    {
+        BuildDaemon *       m_Daemon;
+        FBuildOptions *     m_Options;
+        bool                m_Connected;
+        bool                m_ConnectedWithWrongToken;
+    };
+    ClientData data{ &daemon, &options, false, true };
+
+    Thread thread;
+    thread.Start( []( void * userData ) -> uint32_t
+    {
+        ClientData & clientData = *static_cast< ClientData * >( userData );
+        Array< AString > args;
+        GetArgs( args );
+
+        // Wait for the daemon to start listening
+        BuildDaemon::Result result;
+        for ( uint32_t attempt = 0; attempt < 100; ++attempt )
+        {
+            TestClient client;
+            if ( client.Build( *clientData.m_Options, args, result ) )
+            {
+                clientData.m_Connected = true;
+                break;
+            }
+            Thread::Sleep( 50 );
+        }
+
+        // Replace the token, as if written by another user
+        FileIO::FileDelete( kDestFile );
+        AStackString<> tokenFile;
+        BuildDaemon::GetTokenFileName( *clientData.m_Options, tokenFile );
+        {
+            FileStream f;
+            if ( f.Open( tokenFile.Get(), FileStream::WRITE_ONLY ) )
+            {
+                f.WriteBuffer( "0123456789abcdef0123456789abcdef", 32 );
+            }
+        }
+
+        // Request is rejected
+        {
+            TestClient client;
+            clientData.m_ConnectedWithWrongToken = client.Build( *clientData.m_Options, args, result );
+        }
+
+        clientData.m_Daemon->Stop();
+        return 0;
+    }, "TestBuildDaemon", &data );
+
+    TEST_ASSERT( daemon.Run() );
+    thread.Join();
+
+    // Only the request with the correct token was built
+    TEST_ASSERT( data.m_Connected );
+    TEST_ASSERT( data.m_ConnectedWithWrongToken == false );
+    EnsureFileDoesNotExist( kDestFile );
+}
+
+// OptionsCompatibility
+//------------------------------------------------------------------------------
+void TestBuildDaemon::OptionsCompatibility() const
+{
+    const FBuildTestOptions a;
+
+    // Targets don't affect the FBuild
+    {
+        FBuildTestOptions b;
+        b.m_Targets.EmplaceBack( "Copy" );
+        TEST_ASSERT( TestDaemon::AreOptionsCompatible( a, b ) );
+    }
+
+    // Options captured by the FBuild require a new one
+    {
+        FBuildTestOptions b;
+        b.m_MetricsPort = 1234;
+        TEST_ASSERT( TestDaemon::AreOptionsCompatible( a, b ) == false );
+    }
+    {
+        FBuildTestOptions b;
+        b.m_ShowTotalTimeTaken = !a.m_ShowTotalTimeTaken;
+        TEST_ASSERT( TestDaemon::AreOptionsCompatible( a, b ) == false );
+    }
+    {
+        FBuildTestOptions b;
+        b.m_ConfigFile = "other.bff";
+        TEST_ASSERT( TestDaemon::AreOptionsCompatible( a, b ) == false );
+    }
+}
+
+// PrepareSource
+//------------------------------------------------------------------------------
+void TestBuildDaemon::PrepareSource( const char * contents ) const
+{
+    TEST_ASSERT( FileIO::EnsurePathExistsForFile( AStackString<>( kSourceFile ) ) );
+    MakeFile( kSourceFile, contents );
+}
+
+// GetArgs
+//------------------------------------------------------------------------------
+/*static*/ void TestBuildDaemon::GetArgs( Array< AString > & outArgs )
+{
+    outArgs.EmplaceBack( "FBuildTest" );
+    outArgs.EmplaceBack( "-config" );
+    outArgs.EmplaceBack( kConfigFile );
+    outArgs.EmplaceBack( "-dbfile" ); // Daemon saves the DB after each build
+    outArgs.EmplaceBack( kDBFile );
+    outArgs.EmplaceBack( "-summary" ); // Required for stats checks
+    outArgs.EmplaceBack( "Copy" );
+}
+
+//------------------------------------------------------------------------------
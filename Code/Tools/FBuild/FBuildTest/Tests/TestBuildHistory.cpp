@@ -0,0 +1,200 @@
+// TestBuildHistory.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "FBuildTest.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/FBuild.h"
+#include "Tools/FBuild/FBuildCore/Helpers/BuildHistory.h"
+
+// Core
+#include "Core/FileIO/FileIO.h"
+#include "Core/Math/Conversions.h"
+#include "Core/Strings/AStackString.h"
+
+// TestBuildHistory
+//------------------------------------------------------------------------------
+class TestBuildHistory : public FBuildTest
+{
+private:
+    DECLARE_TESTS
+
+    void NoPreviousBuild() const;
+    void Compare() const;
+    void Retention() const;
+    void InvalidHistory() const;
+};
+
+// Register Tests
+//------------------------------------------------------------------------------
+REGISTER_TESTS_BEGIN( TestBuildHistory )
+    REGISTER_TEST( NoPreviousBuild )
+    REGISTER_TEST( Compare )
+    REGISTER_TEST( Retention )
+    REGISTER_TEST( InvalidHistory )
+REGISTER_TESTS_END
+
+// Constants
+//------------------------------------------------------------------------------
+namespace
+{
+    const char * const kConfigFile  = "Tools/FBuild/FBuildTest/Data/TestBuildHistory/fbuild.bff";
+    const char * const kInputPath   = "../tmp/Test/BuildHistory/GeneratedInput/";
+    const char * const kDBFile      = "../tmp/Test/BuildHistory/fbuild.fdb";
+    const char * const kHistoryFile = "../tmp/Test/BuildHistory/fbuild.fdb.history";
+}
+
+// NoPreviousBuild
+//------------------------------------------------------------------------------
+void TestBuildHistory::NoPreviousBuild() const
+{
+    EnsureFileDoesNotExist( kHistoryFile );
+
+    FBuildTestOptions options;
+    options.m_ConfigFile = kConfigFile;
+    options.m_DBFile = kDBFile;
+    options.m_Compare = true;
+    options.m_History = true;
+    options.m_ForceCleanBuild = true;
+    FBuild fBuild( options );
+    TEST_ASSERT( fBuild.Initialize() );
+    TEST_ASSERT( fBuild.Build( "Copy" ) );
+
+    // Nothing to compare with, but the build is recorded
+    TEST_ASSERT( GetRecordedOutput().Find( "No previous build recorded" ) );
+    BuildHistory history;
+    TEST_ASSERT( history.Load( AStackString<>( kHistoryFile ) ) );
+    TEST_ASSERT( history.GetNumBuilds() == 1 );
+}
+
+// Compare
+//------------------------------------------------------------------------------
+void TestBuildHistory::Compare() const
+{
+    EnsureFileDoesNotExist( kHistoryFile );
+
+    // Objects a and b use the header which will change
+    TEST_ASSERT( FileIO::EnsurePathExists( AStackString<>( kInputPath ) ) );
+    const AStackString<> commonHeader( "../tmp/Test/BuildHistory/GeneratedInput/common.h" );
+    const AStackString<> changedHeader( "../tmp/Test/BuildHistory/GeneratedInput/changed.h" );
+    MakeFile( commonHeader.Get(), "#define COMMON 1\n" );
+    MakeFile( changedHeader.Get(), "#define CHANGED 1\n" );
+    MakeFile( "../tmp/Test/BuildHistory/GeneratedInput/a.cpp", "#include \"common.h\"\n#include \"changed.h\"\nint A() { return COMMON + CHANGED; }\n" );
+    MakeFile( "../tmp/Test/BuildHistory/GeneratedInput/b.cpp", "#include \"changed.h\"\nint B() { return CHANGED; }\n" );
+    MakeFile( "../tmp/Test/BuildHistory/GeneratedInput/c.cpp", "#include \"common.h\"\nint C() { return COMMON; }\n" );
+
+    FBuildTestOptions options;
+    options.m_ConfigFile = kConfigFile;
+    options.m_DBFile = kDBFile;
+    options.m_History = true;
+
+    // Clean build
+    {
+        options.m_ForceCleanBuild = true;
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "Objects" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( kDBFile ) );
+        CheckStatsNode( 3, 3, Node::OBJECT_NODE );
+    }
+    options.m_ForceCleanBuild = false;
+
+    // No-op build
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( kDBFile ) );
+        TEST_ASSERT( fBuild.Build( "Objects" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( kDBFile ) );
+        CheckStatsNode( 3, 0, Node::OBJECT_NODE );
+    }
+
+    // Modify a header and compare with the no-op build
+    MakeFile( changedHeader.Get(), "#define CHANGED 2\n" );
+    {
+        options.m_Compare = true;
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( kDBFile ) );
+        TEST_ASSERT( fBuild.Build( "Objects" ) );
+        CheckStatsNode( 3, 2, Node::OBJECT_NODE );
+    }
+
+    // Rebuilt objects are regressions
+    const AString & output = GetRecordedOutput();
+    const char * report = output.Find( "--- Comparison With Previous Build" );
+    TEST_ASSERT( report );
+    TEST_ASSERT( output.Find( "--- Largest Regressions", report ) );
+    TEST_ASSERT( output.Find( "Output/a.o (local, previously up-to-date)", report ) );
+    TEST_ASSERT( output.Find( "Output/b.o (local, previously up-to-date)", report ) );
+    TEST_ASSERT( output.Find( "Output/c.o", report ) == nullptr );
+
+    // The changed header is attributed with both objects, and the unchanged
+    // header is not listed
+    const char * headers = output.Find( "--- Changed Headers (1)", report );
+    TEST_ASSERT( headers );
+    TEST_ASSERT( output.Find( "2          ", headers ) );
+    TEST_ASSERT( output.Find( "changed.h", headers ) );
+    TEST_ASSERT( output.Find( "common.h", headers ) == nullptr );
+
+    // All three builds are retained
+    BuildHistory history;
+    TEST_ASSERT( history.Load( AStackString<>( kHistoryFile ) ) );
+    TEST_ASSERT( history.GetNumBuilds() == 3 );
+}
+
+// Retention
+//------------------------------------------------------------------------------
+void TestBuildHistory::Retention() const
+{
+    EnsureFileDoesNotExist( kHistoryFile );
+
+    FBuildTestOptions options;
+    options.m_ConfigFile = kConfigFile;
+    options.m_DBFile = kDBFile;
+    options.m_History = true;
+    options.m_ForceCleanBuild = true;
+
+    // Only the most recent builds are kept
+    for ( uint32_t i = 0; i < ( BuildHistory::MAX_BUILDS + 2 ); ++i )
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "Copy" ) );
+
+        BuildHistory history;
+        TEST_ASSERT( history.Load( AStackString<>( kHistoryFile ) ) );
+        TEST_ASSERT( history.GetNumBuilds() == Math::Min( i + 1, (uint32_t)BuildHistory::MAX_BUILDS ) );
+    }
+}
+
+// InvalidHistory
+//------------------------------------------------------------------------------
+void TestBuildHistory::InvalidHistory() const
+{
+    // Not a history file
+    TEST_ASSERT( FileIO::EnsurePathExistsForFile( AStackString<>( kHistoryFile ) ) );
+    MakeFile( kHistoryFile, "Not a history file" );
+    {
+        BuildHistory history;
+        TEST_ASSERT( history.Load( AStackString<>( kHistoryFile ) ) == false );
+        TEST_ASSERT( history.GetNumBuilds() == 0 );
+    }
+
+    // Build succeeds, replacing the invalid history
+    FBuildTestOptions options;
+    options.m_ConfigFile = kConfigFile;
+    options.m_DBFile = kDBFile;
+    options.m_History = true;
+    options.m_ForceCleanBuild = true;
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "Copy" ) );
+    }
+    BuildHistory history;
+    TEST_ASSERT( history.Load( AStackString<>( kHistoryFile ) ) );
+    TEST_ASSERT( history.GetNumBuilds() == 1 );
+}
+
+//------------------------------------------------------------------------------
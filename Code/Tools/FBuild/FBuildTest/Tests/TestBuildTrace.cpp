@@ -0,0 +1,234 @@
+// TestBuildTrace.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "FBuildTest.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/FBuild.h"
+#include "Tools/FBuild/FBuildCore/Helpers/BuildProfiler.h"
+#include "Tools/FBuild/FBuildCore/Helpers/BuildTrace.h"
+
+// Core
+#include "Core/FileIO/FileIO.h"
+#include "Core/FileIO/FileStream.h"
+#include "Core/Process/Thread.h"
+#include "Core/Strings/AStackString.h"
+#include "Core/Time/Timer.h"
+#include "Core/Tracing/Tracing.h"
+
+// TestBuildTrace
+//------------------------------------------------------------------------------
+class TestBuildTrace : public FBuildTest
+{
+private:
+    DECLARE_TESTS
+
+    void RoundTrip() const;
+    void RingWrap() const;
+    void Build() const;
+    void InvalidTrace() const;
+    void RecordCost() const;
+};
+
+// Register Tests
+//------------------------------------------------------------------------------
+REGISTER_TESTS_BEGIN( TestBuildTrace )
+    REGISTER_TEST( RoundTrip )
+    REGISTER_TEST( RingWrap )
+    REGISTER_TEST( Build )
+    REGISTER_TEST( InvalidTrace )
+    REGISTER_TEST( RecordCost )
+REGISTER_TESTS_END
+
+// Constants
+//------------------------------------------------------------------------------
+namespace
+{
+    const char * const kConfigFile  = "Tools/FBuild/FBuildTest/Data/TestBuildTrace/fbuild.bff";
+    const char * const kOutputPath  = "../tmp/Test/BuildTrace";
+    const char * const kDestFile    = "../tmp/Test/BuildTrace/copy.bff";
+    const char * const kTraceFile   = "../tmp/Test/BuildTrace/fbuild.trace";
+    const char * const kJSONFile    = "../tmp/Test/BuildTrace/fbuild.trace.json";
+}
+
+// RoundTrip
+//------------------------------------------------------------------------------
+void TestBuildTrace::RoundTrip() const
+{
+    TEST_ASSERT( FileIO::EnsurePathExists( AStackString<>( kOutputPath ) ) );
+
+    FBuildTestOptions options;
+    BuildTrace trace;
+
+    // Times are in Timer ticks
+    const int64_t second = Timer::GetFrequency();
+    const int64_t millisecond = ( second / 1000 );
+
+    // Events from the main thread, including a string requiring escaping
+    trace.RecordLocal( 0, second, ( second + millisecond ), "Build", nullptr );
+    trace.RecordLocal( 1, ( 2 * second ), ( 3 * second ), "Compile", "C:\\Dir\\File.cpp" );
+
+    // Events from another thread use a separate buffer
+    Thread thread;
+    thread.Start( []( void * userData ) -> uint32_t
+                  {
+                      const int64_t freq = Timer::GetFrequency();
+                      static_cast< BuildTrace * >( userData )->RecordLocal( 2, freq, ( 4 * freq ), "Link", "app.exe" );
+                      return 0;
+                  }, "TraceThread", &trace );
+    thread.Join();
+
+    // A remote event
+    const AStackString<> workerName( "Worker1" );
+    trace.RecordRemote( workerName, 1003, second, ( 2 * second ), "Compile", "remote.cpp" );
+
+    TEST_ASSERT( trace.Save( options, kTraceFile ) );
+    TEST_ASSERT( BuildTrace::ConvertToJSON( kTraceFile, kJSONFile ) );
+
+    AString json;
+    LoadFileContentsAsString( kJSONFile, json );
+    TEST_ASSERT( json.BeginsWith( '[' ) && json.EndsWith( ']' ) );
+
+    // Events are decoded with the original times (in microseconds)
+    TEST_ASSERT( json.Find( "{\"name\":\"Build\",\"ph\":\"X\",\"ts\":1000000,\"dur\":1000,\"pid\":-1,\"tid\":0}" ) );
+    TEST_ASSERT( json.Find( "{\"name\":\"Compile\",\"ph\":\"X\",\"ts\":2000000,\"dur\":1000000,\"pid\":-1,\"tid\":1,\"args\":{\"name\":\"C:\\\\Dir\\\\File.cpp\"}}" ) );
+    TEST_ASSERT( json.Find( "{\"name\":\"Link\",\"ph\":\"X\",\"ts\":1000000,\"dur\":3000000,\"pid\":-1,\"tid\":2,\"args\":{\"name\":\"app.exe\"}}" ) );
+    TEST_ASSERT( json.Find( "{\"name\":\"Compile\",\"ph\":\"X\",\"ts\":1000000,\"dur\":1000000,\"pid\":0,\"tid\":1003,\"args\":{\"name\":\"remote.cpp\"}}" ) );
+
+    // Local and remote threads are named
+    TEST_ASSERT( json.Find( "\"pid\":-1,\"tid\":2,\"args\":{\"name\":\"Thread 02\"}" ) );
+    TEST_ASSERT( json.Find( "\"pid\":0,\"tid\":0,\"args\":{\"name\":\"Worker: Worker1\"}" ) );
+    TEST_ASSERT( json.Find( "\"pid\":0,\"tid\":1003,\"args\":{\"name\":\"Thread 03\"}" ) );
+}
+
+// RingWrap
+//------------------------------------------------------------------------------
+void TestBuildTrace::RingWrap() const
+{
+    TEST_ASSERT( FileIO::EnsurePathExists( AStackString<>( kOutputPath ) ) );
+
+    // Many unique target names (which must outlive the trace)
+    const uint32_t numEvents = 4000;
+    Array< AString > targets( numEvents );
+    for ( uint32_t i = 0; i < numEvents; ++i )
+    {
+        AString & target = targets.EmplaceBack();
+        target.Format( "Some/Long/Path/To/Source/Files/For/Testing/The/Trace/Ring/Buffer/File%05u.cpp", i );
+    }
+
+    FBuildTestOptions options;
+    uint32_t fileSize = 0;
+    {
+        // Record much more data than fits in 2 blocks
+        BuildTrace trace( 2 );
+        for ( uint32_t i = 0; i < numEvents; ++i )
+        {
+            const int64_t start = Timer::GetNow();
+            trace.RecordLocal( 1, start, start + 1, "Compile", targets[ i ].Get() );
+        }
+        TEST_ASSERT( trace.Save( options, kTraceFile ) );
+
+        // Size is bounded by the ring
+        FileStream f;
+        TEST_ASSERT( f.Open( kTraceFile ) );
+        fileSize = (uint32_t)f.GetFileSize();
+    }
+    TEST_ASSERT( fileSize <= ( 1024 + ( 2 * BuildTrace::BLOCK_SIZE ) ) );
+
+    // Newest events are retained and the oldest are discarded
+    TEST_ASSERT( BuildTrace::ConvertToJSON( kTraceFile, kJSONFile ) );
+    AString json;
+    LoadFileContentsAsString( kJSONFile, json );
+    TEST_ASSERT( json.EndsWith( "File03999.cpp\"}}]" ) );
+    TEST_ASSERT( json.Find( "File00000.cpp" ) == nullptr );
+}
+
+// Build
+//------------------------------------------------------------------------------
+void TestBuildTrace::Build() const
+{
+    EnsureFileDoesNotExist( kDestFile );
+
+    FBuildTestOptions options;
+    options.m_ConfigFile = kConfigFile;
+    options.m_Trace = true;
+    options.m_ForceCleanBuild = true;
+    FBuild fBuild( options );
+    TEST_ASSERT( fBuild.Initialize() );
+    TEST_ASSERT( BuildTrace::IsValid() );
+    TEST_ASSERT( fBuild.Build( "Copy" ) );
+    EnsureFileExists( kDestFile );
+
+    TEST_ASSERT( BuildTrace::Get().Save( options, kTraceFile ) );
+    TEST_ASSERT( BuildTrace::ConvertToJSON( kTraceFile, kJSONFile ) );
+
+    // Main thread phases and jobs are recorded
+    AString json;
+    LoadFileContentsAsString( kJSONFile, json );
+    TEST_ASSERT( json.Find( "{\"name\":\"Initialize\",\"ph\":\"X\"" ) );
+    TEST_ASSERT( json.Find( "{\"name\":\"Build\",\"ph\":\"X\"" ) );
+    TEST_ASSERT( json.Find( "{\"name\":\"CopyFile\",\"ph\":\"X\"" ) );
+    TEST_ASSERT( json.Find( "copy.bff\"}}" ) );
+}
+
+// InvalidTrace
+//------------------------------------------------------------------------------
+void TestBuildTrace::InvalidTrace() const
+{
+    // Missing file
+    TEST_ASSERT( BuildTrace::ConvertToJSON( "../tmp/Test/BuildTrace/missing.trace", kJSONFile ) == false );
+
+    // Not a trace
+    TEST_ASSERT( BuildTrace::ConvertToJSON( kConfigFile, kJSONFile ) == false );
+}
+
+// RecordCost
+//------------------------------------------------------------------------------
+void TestBuildTrace::RecordCost() const
+{
+    // Targets are recorded many times, as when jobs have several steps
+    const uint32_t numTargets = 1000;
+    Array< AString > targets( numTargets );
+    for ( uint32_t i = 0; i < numTargets; ++i )
+    {
+        AString & target = targets.EmplaceBack();
+        target.Format( "Code/Module/SubDir/SourceFile%04u.cpp", i );
+    }
+    const char * const steps[] = { "Preprocess", "Compile", "Cache Hit" };
+
+    #if defined( DEBUG )
+        const uint32_t numEvents = ( 200 * 1000 );
+    #else
+        const uint32_t numEvents = ( 2 * 1000 * 1000 );
+    #endif
+
+    // BuildTrace
+    {
+        BuildTrace trace;
+        const Timer t;
+        for ( uint32_t i = 0; i < numEvents; ++i )
+        {
+            const int64_t start = Timer::GetNow();
+            trace.RecordLocal( 1, start, start + 100, steps[ i % 3 ], targets[ ( i / 3 ) % numTargets ].Get() );
+        }
+        const float time = t.GetElapsed();
+        OUTPUT( "BuildTrace      : %2.3fs @ %6.1f ns/event (%u events)\n", (double)time, (double)( time * 1e9f / (float)numEvents ), numEvents );
+    }
+
+    // BuildProfiler, for comparison
+    {
+        BuildProfiler profiler;
+        const Timer t;
+        for ( uint32_t i = 0; i < numEvents; ++i )
+        {
+            const int64_t start = Timer::GetNow();
+            profiler.RecordLocal( 1, start, start + 100, steps[ i % 3 ], targets[ ( i / 3 ) % numTargets ].Get() );
+        }
+        const float time = t.GetElapsed();
+        OUTPUT( "BuildProfiler   : %2.3fs @ %6.1f ns/event (%u events)\n", (double)time, (double)( time * 1e9f / (float)numEvents ), numEvents );
+    }
+}
+
+//------------------------------------------------------------------------------
@@ -6,15 +6,23 @@
 #include "FBuildTest.h"
 
 // FBuild
+#include "Tools/FBuild/FBuildCore/Cache/CacheEntry.h"
 #include "Tools/FBuild/FBuildCore/FBuild.h"
 #include "Tools/FBuild/FBuildCore/Graph/ObjectNode.h"
 #include "Tools/FBuild/FBuildCore/Graph/SettingsNode.h"
+#include "Tools/FBuild/FBuildCore/Helpers/Compressor.h"
+#include "Tools/FBuild/FBuildCore/Helpers/Metrics.h"
 #include "Tools/FBuild/FBuildCore/Protocol/Server.h"
 
 // Core
+#include "Core/Env/Env.h"
 #include "Core/FileIO/FileIO.h"
+#include "Core/FileIO/FileStream.h"
 #include "Core/Profile/Profile.h"
 #include "Core/Strings/AStackString.h"
+#include "Core/Time/Time.h"
+#include "Core/Time/Timer.h"
+#include "Core/Tracing/Tracing.h"
 
 // TestCache
 //------------------------------------------------------------------------------
@@ -27,6 +35,10 @@ private:
     void Read() const;
     void ReadWrite() const;
     void ConsistentCacheKeysWithDist() const;
+    void ExplainMiss() const;
+    void EntryIntegrity() const;
+    void EntryIntegrityPerformance() const;
+    void TieredCache() const;
 
     void LightCache_IncludeUsingMacro() const;
     void LightCache_IncludeUsingMacro2() const;
@@ -55,6 +67,10 @@ private:
     void ExtraFiles_GCNO() const;
 
     // Helpers
+    void PrepareUniqueSource( const char * configFile, const char * sourceFile, FBuildTestOptions & options ) const;
+    void CorruptCacheEntry( const char * cachePath, bool truncate ) const;
+    void DeleteCacheEntries( const char * cachePath ) const;
+    uint32_t CountCacheEntries( const char * cachePath, const char * wildcard = "*.H" ) const;
     void CheckForDependencies( const FBuildForTest & fBuild, const char * const files[], size_t numFiles ) const;
     void LightCache_IncludeUsingUndefinedMacros( const char * consfigFile,
                                                  bool expectedBuildResult,
@@ -71,6 +87,10 @@ REGISTER_TESTS_BEGIN( TestCache )
     REGISTER_TEST( Read )
     REGISTER_TEST( ReadWrite )
     REGISTER_TEST( ConsistentCacheKeysWithDist )
+    REGISTER_TEST( ExplainMiss )
+    REGISTER_TEST( EntryIntegrity )
+    REGISTER_TEST( EntryIntegrityPerformance )
+    REGISTER_TEST( TieredCache )
     REGISTER_TEST( ExtraFiles_GCNO )
     #if defined( __WINDOWS__ )
         REGISTER_TEST( ExtraFiles_NativeCodeAnalysisXML )
@@ -1070,6 +1090,388 @@ void TestCache::Analyze_MSVC_WarningsOnly_ReadFromDist() const
     TEST_ASSERT( xml.Find( "<DEFECTCODE>6387</DEFECTCODE>" ) );
 }
 
+// ExplainMiss
+//------------------------------------------------------------------------------
+void TestCache::ExplainMiss() const
+{
+    const char * const sourceFile = "../tmp/Test/Cache/ExplainMiss/file.cpp";
+    FBuildTestOptions options;
+    PrepareUniqueSource( "Tools/FBuild/FBuildTest/Data/TestCache/ExplainMiss/fbuild.bff", sourceFile, options );
+    options.m_CacheExplain = true;
+    options.m_CacheKeys = true; // Implied by -cacheexplain
+
+    // Store with the key components recorded
+    Env::SetEnvVariable( "FBUILD_TEST_EXPLAIN_MISS_VALUE", AString( "1" ) );
+    {
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+        TEST_ASSERT( fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE ).m_NumCacheStores == 1 );
+    }
+
+    // Change the args, which is explained as an arg difference
+    Env::SetEnvVariable( "FBUILD_TEST_EXPLAIN_MISS_VALUE", AString( "2" ) );
+    {
+        const size_t outputStart = GetRecordedOutput().GetLength();
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+        TEST_ASSERT( fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE ).m_NumCacheMisses == 1 );
+
+        const AString & output = GetRecordedOutput();
+        const char * explained = output.Find( " - Cache Miss Explained:", output.Get() + outputStart );
+        TEST_ASSERT( explained );
+        TEST_ASSERT( output.Find( "   - Args differ\n", explained ) );
+        TEST_ASSERT( output.Find( "     + -DEXPLAIN_MISS_VALUE=2\n", explained ) );
+        TEST_ASSERT( output.Find( "     - -DEXPLAIN_MISS_VALUE=1\n", explained ) );
+        TEST_ASSERT( output.Find( "   - Source differs", explained ) == nullptr );
+        TEST_ASSERT( output.Find( "   - Toolchain differs", explained ) == nullptr );
+    }
+
+    // Change the source, which is explained as a source difference
+    AString source;
+    LoadFileContentsAsString( sourceFile, source );
+    TEST_ASSERT( source.Replace( "return 1;", "return 2;" ) == 1 );
+    MakeFile( sourceFile, source.Get() );
+    {
+        const size_t outputStart = GetRecordedOutput().GetLength();
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+        TEST_ASSERT( fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE ).m_NumCacheMisses == 1 );
+
+        const AString & output = GetRecordedOutput();
+        const char * explained = output.Find( " - Cache Miss Explained:", output.Get() + outputStart );
+        TEST_ASSERT( explained );
+        TEST_ASSERT( output.Find( "   - Source differs", explained ) );
+        TEST_ASSERT( output.Find( "     Same files were used, so their contents differ\n", explained ) );
+        TEST_ASSERT( output.Find( "   - Args differ", explained ) == nullptr );
+    }
+    Env::SetEnvVariable( "FBUILD_TEST_EXPLAIN_MISS_VALUE", AString::GetEmpty() );
+
+    // Build the same source in another workspace, so args differ only by the
+    // working dir, which is explained as absolute paths
+    const char * const srcConfigFile = "Tools/FBuild/FBuildTest/Data/TestCache/ExplainMiss/WorkingDir/fbuild.bff";
+    const char * const workspaces[] = { "A", "B" };
+    for ( const char * workspace : workspaces )
+    {
+        AStackString<> dst;
+        dst.Format( "../tmp/Test/Cache/ExplainMiss/WorkingDir/%s/Code/fbuild.bff", workspace );
+        TEST_ASSERT( FileIO::EnsurePathExistsForFile( dst ) );
+        TEST_ASSERT( FileIO::FileCopy( srcConfigFile, dst.Get() ) );
+    }
+    FBuildTestOptions workspaceOptions;
+    PrepareUniqueSource( "fbuild.bff", "../tmp/Test/Cache/ExplainMiss/WorkingDir/A/Code/file.cpp", workspaceOptions );
+    TEST_ASSERT( FileIO::FileCopy( "../tmp/Test/Cache/ExplainMiss/WorkingDir/A/Code/file.cpp",
+                                   "../tmp/Test/Cache/ExplainMiss/WorkingDir/B/Code/file.cpp" ) );
+    workspaceOptions.m_CacheExplain = true;
+    workspaceOptions.m_CacheKeys = true; // Implied by -cacheexplain
+    AStackString<> codeDir;
+    GetCodeDir( codeDir );
+    codeDir.Trim( 0, 5 ); // Remove Code/
+
+    // Store from the first workspace
+    {
+        AStackString<> workingDir( codeDir );
+        workingDir += "tmp/Test/Cache/ExplainMiss/WorkingDir/A/Code/";
+        workspaceOptions.SetWorkingDir( workingDir );
+        FBuildForTest fBuild( workspaceOptions );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+        TEST_ASSERT( fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE ).m_NumCacheStores == 1 );
+    }
+
+    // Miss from the second workspace
+    {
+        AStackString<> workingDir( codeDir );
+        workingDir += "tmp/Test/Cache/ExplainMiss/WorkingDir/B/Code/";
+        workspaceOptions.SetWorkingDir( workingDir );
+        const size_t outputStart = GetRecordedOutput().GetLength();
+        FBuildForTest fBuild( workspaceOptions );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+        TEST_ASSERT( fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE ).m_NumCacheMisses == 1 );
+
+        const AString & output = GetRecordedOutput();
+        const char * explained = output.Find( " - Cache Miss Explained:", output.Get() + outputStart );
+        TEST_ASSERT( explained );
+        TEST_ASSERT( output.Find( "   - Working dir differs", explained ) );
+        TEST_ASSERT( output.Find( "   - Toolchain differs", explained ) == nullptr );
+
+        // Each differing arg contains the working dir
+        const char * argsDiffer = output.Find( "   - Args differ\n", explained );
+        TEST_ASSERT( argsDiffer );
+        uint32_t numArgsDiffer = 0;
+        const char * line = ( argsDiffer + AString::StrLen( "   - Args differ\n" ) );
+        while ( AString::StrNCmp( line, "     ", 5 ) == 0 )
+        {
+            const char * lineEnd = output.Find( '\n', line );
+            TEST_ASSERT( lineEnd );
+            TEST_ASSERT( AString( line, lineEnd ).EndsWith( " (absolute path)" ) );
+            ++numArgsDiffer;
+            line = ( lineEnd + 1 );
+        }
+        TEST_ASSERT( numArgsDiffer > 0 );
+    }
+}
+
+// EntryIntegrity
+//------------------------------------------------------------------------------
+void TestCache::EntryIntegrity() const
+{
+    // Empty the private cache (see fbuild.bff), so it only holds the entries stored below
+    const char * const cachePath = "../tmp/Test/Cache/EntryIntegrity/Cache";
+    DeleteCacheEntries( cachePath );
+
+    // Raw compressed data (as stored by older versions) is not a valid entry
+    {
+        const char data[] = "Data which is larger than the header of an entry";
+        Compressor c;
+        c.Compress( data, sizeof( data ), 0 ); // 0 = Disable compression
+        AStackString<> problem;
+        TEST_ASSERT( CacheEntry::Verify( c.GetResult(), c.GetResultSize(), problem ) == false );
+        TEST_ASSERT( problem == "Missing header" );
+
+        CacheEntry entry;
+        entry.Create( c.GetResult(), c.GetResultSize() );
+        TEST_ASSERT( CacheEntry::Verify( entry.GetData(), entry.GetDataSize(), problem ) );
+        TEST_ASSERT( CacheEntry::GetPayloadSize( entry.GetData() ) == c.GetResultSize() );
+    }
+
+    FBuildTestOptions options;
+    PrepareUniqueSource( "Tools/FBuild/FBuildTest/Data/TestCache/EntryIntegrity/fbuild.bff",
+                         "../tmp/Test/Cache/EntryIntegrity/file.cpp",
+                         options );
+
+    // Store
+    {
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+        TEST_ASSERT( fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE ).m_NumCacheStores == 1 );
+    }
+
+    // Corrupt the entry in two ways: truncation and a modified byte
+    const bool truncations[] = { true, false };
+    for ( const bool truncate : truncations )
+    {
+        CorruptCacheEntry( cachePath, truncate );
+
+        // Corrupt entry is detected, quarantined and treated as a miss
+        {
+            const size_t outputStart = GetRecordedOutput().GetLength();
+            FBuildForTest fBuild( options );
+            TEST_ASSERT( fBuild.Initialize() );
+            TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+            TEST_ASSERT( fBuild.GetStats().GetCacheHits() == 0 );
+            TEST_ASSERT( fBuild.GetStats().GetCacheMisses() == 1 );
+            TEST_ASSERT( fBuild.GetStats().GetCacheCorrupt() == 1 );
+
+            const AString & output = GetRecordedOutput();
+            const char * warning = output.Find( "Cache returned corrupt data (quarantined)", output.Get() + outputStart );
+            TEST_ASSERT( warning );
+            TEST_ASSERT( output.Find( truncate ? " - Problem: Truncated data" : " - Problem: Hash mismatch", warning ) );
+            TEST_ASSERT( output.Find( " - Corrupt    : 1 (quarantined)", warning ) );
+
+            TEST_ASSERT( CountCacheEntries( cachePath, "*.corrupt" ) == 1 );
+        }
+
+        // Replacement entry was stored by the previous build
+        {
+            FBuildForTest fBuild( options );
+            TEST_ASSERT( fBuild.Initialize() );
+            TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+            TEST_ASSERT( fBuild.GetStats().GetCacheHits() == 1 );
+            TEST_ASSERT( fBuild.GetStats().GetCacheCorrupt() == 0 );
+        }
+    }
+}
+
+// PrepareUniqueSource
+//------------------------------------------------------------------------------
+void TestCache::PrepareUniqueSource( const char * configFile, const char * sourceFile, FBuildTestOptions & options ) const
+{
+    // The source is unique to each run, so entries from previous runs are not hit
+    TEST_ASSERT( FileIO::EnsurePathExistsForFile( AStackString<>( sourceFile ) ) );
+    AStackString<> source;
+    source.Format( "const char * Unique() { return \"%" PRIu64 "\"; }\nint Function() { return 1; }\n", Time::GetCurrentFileTime() );
+    MakeFile( sourceFile, source.Get() );
+
+    // Build it, reading and writing the cache
+    options.m_ForceCleanBuild = true;
+    options.m_ConfigFile = configFile;
+    options.m_UseCacheRead = true;
+    options.m_UseCacheWrite = true;
+}
+
+// CorruptCacheEntry
+//------------------------------------------------------------------------------
+void TestCache::CorruptCacheEntry( const char * cachePath, bool truncate ) const
+{
+    // Find the only (non-quarantined) entry
+    Array< AString > entries;
+    FileIO::GetFiles( AStackString<>( cachePath ), AStackString<>( "*.H" ), true, &entries );
+    TEST_ASSERT( entries.GetSize() == 1 );
+
+    // Read it
+    AString data;
+    {
+        FileStream f;
+        TEST_ASSERT( f.Open( entries[ 0 ].Get() ) );
+        data.SetLength( (uint32_t)f.GetFileSize() );
+        TEST_ASSERT( f.ReadBuffer( data.Get(), f.GetFileSize() ) == f.GetFileSize() );
+    }
+    AStackString<> problem;
+    TEST_ASSERT( CacheEntry::Verify( data.Get(), data.GetLength(), problem ) );
+
+    // Damage it
+    if ( truncate )
+    {
+        data.SetLength( data.GetLength() / 2 );
+    }
+    else
+    {
+        data[ data.GetLength() - 1 ] = (char)( data[ data.GetLength() - 1 ] ^ 0x01 );
+    }
+    FileStream f;
+    TEST_ASSERT( f.Open( entries[ 0 ].Get(), FileStream::WRITE_ONLY ) );
+    TEST_ASSERT( f.WriteBuffer( data.Get(), data.GetLength() ) == data.GetLength() );
+}
+
+// DeleteCacheEntries
+//------------------------------------------------------------------------------
+void TestCache::DeleteCacheEntries( const char * cachePath ) const
+{
+    Array< AString > entries;
+    FileIO::GetFiles( AStackString<>( cachePath ), AStackString<>( "*" ), true, &entries );
+    for ( const AString & entry : entries )
+    {
+        TEST_ASSERT( FileIO::FileDelete( entry.Get() ) );
+    }
+}
+
+// CountCacheEntries
+//------------------------------------------------------------------------------
+uint32_t TestCache::CountCacheEntries( const char * cachePath, const char * wildcard ) const
+{
+    Array< AString > entries;
+    FileIO::GetFiles( AStackString<>( cachePath ), AStackString<>( wildcard ), true, &entries );
+    return (uint32_t)entries.GetSize();
+}
+
+// EntryIntegrityPerformance
+//------------------------------------------------------------------------------
+void TestCache::EntryIntegrityPerformance() const
+{
+    // Representative data, compressed as it would be when stored
+    AString data;
+    {
+        FileStream f;
+        TEST_ASSERT( f.Open( "Tools/FBuild/FBuildTest/Data/TestCompressor/TestPreprocessedFile.ii" ) );
+        data.SetLength( (uint32_t)f.GetFileSize() );
+        TEST_ASSERT( f.ReadBuffer( data.Get(), f.GetFileSize() ) == f.GetFileSize() );
+    }
+    Compressor c;
+    c.Compress( data.Get(), data.GetLength() );
+    CacheEntry entry;
+    entry.Create( c.GetResult(), c.GetResultSize() );
+
+    // Verify and decompress repeatedly, to get more stable timings
+    #if defined( __ASAN__ ) || defined( __TSAN__ ) || defined( __MSAN__ )
+        const uint32_t numRepeats = 4; // Slow sanitizer configs do fewer passes
+    #else
+        const uint32_t numRepeats = 16; // Increase to get more consistent numbers
+    #endif
+    double verifyTimeTaken = 0.0;
+    double decompressTimeTaken = 0.0;
+    for ( uint32_t i = 0; i < numRepeats; ++i )
+    {
+        const Timer t;
+        AStackString<> problem;
+        TEST_ASSERT( CacheEntry::Verify( entry.GetData(), entry.GetDataSize(), problem ) );
+        verifyTimeTaken += (double)t.GetElapsedMS();
+
+        const Timer t2;
+        Compressor d;
+        TEST_ASSERT( d.Decompress( CacheEntry::GetPayload( entry.GetData() ) ) );
+        decompressTimeTaken += (double)t2.GetElapsedMS();
+    }
+
+    // Cost is reported per GiB of entries read from the cache
+    const double numGiB = ( ( (double)entry.GetDataSize() * (double)numRepeats ) / (double)( MEGABYTE * 1024 ) );
+    OUTPUT( "Entry size     : %zu (Uncompressed: %u)\n", entry.GetDataSize(), data.GetLength() );
+    OUTPUT( "Verify         : %8.1f ms per GiB\n", verifyTimeTaken / numGiB );
+    OUTPUT( "Decompress     : %8.1f ms per GiB\n", decompressTimeTaken / numGiB );
+}
+
+// TieredCache
+//------------------------------------------------------------------------------
+void TestCache::TieredCache() const
+{
+    // Empty the private caches (see fbuild.bff)
+    const char * const localCachePath = "../tmp/Test/Cache/TieredCache/Local";
+    const char * const sharedCachePath = "../tmp/Test/Cache/TieredCache/Shared";
+    DeleteCacheEntries( localCachePath );
+    DeleteCacheEntries( sharedCachePath );
+
+    FBuildTestOptions options;
+    PrepareUniqueSource( "Tools/FBuild/FBuildTest/Data/TestCache/TieredCache/fbuild.bff",
+                         "../tmp/Test/Cache/TieredCache/file.cpp",
+                         options );
+
+    // Store - written to both caches (shared cache write completes at shutdown)
+    {
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+        TEST_ASSERT( fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE ).m_NumCacheStores == 1 );
+    }
+    TEST_ASSERT( CountCacheEntries( localCachePath ) == 1 );
+    TEST_ASSERT( CountCacheEntries( sharedCachePath ) == 1 );
+
+    options.m_UseCacheWrite = false;
+
+    // Hit in shared cache fills local cache
+    DeleteCacheEntries( localCachePath );
+    {
+        const uint64_t localHits = Metrics::s_CacheLocalHits.Get();
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+        TEST_ASSERT( fBuild.GetStats().GetCacheHits() == 1 );
+        TEST_ASSERT( Metrics::s_CacheLocalHits.Get() == localHits );
+    }
+    TEST_ASSERT( CountCacheEntries( localCachePath ) == 1 );
+
+    // Corrupt local entry is quarantined and the shared entry is used instead,
+    // refilling the local cache
+    CorruptCacheEntry( localCachePath, false );
+    {
+        const uint64_t localHits = Metrics::s_CacheLocalHits.Get();
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+        TEST_ASSERT( fBuild.GetStats().GetCacheHits() == 1 );
+        TEST_ASSERT( fBuild.GetStats().GetCacheCorrupt() == 0 );
+        TEST_ASSERT( Metrics::s_CacheLocalHits.Get() == localHits );
+    }
+    TEST_ASSERT( CountCacheEntries( localCachePath, "*.corrupt" ) == 1 );
+    TEST_ASSERT( CountCacheEntries( sharedCachePath ) == 1 );
+    TEST_ASSERT( CountCacheEntries( sharedCachePath, "*.corrupt" ) == 0 );
+    TEST_ASSERT( CountCacheEntries( localCachePath ) == 1 );
+
+    // Hit in local cache doesn't need the shared cache
+    DeleteCacheEntries( sharedCachePath );
+    {
+        const uint64_t localHits = Metrics::s_CacheLocalHits.Get();
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+        TEST_ASSERT( fBuild.GetStats().GetCacheHits() == 1 );
+        TEST_ASSERT( Metrics::s_CacheLocalHits.Get() == ( localHits + 1 ) );
+    }
+}
+
 // ExtraFiles
 //------------------------------------------------------------------------------
 void TestCache::ExtraFiles( const char * bffPath, const char * extraFilePath ) const
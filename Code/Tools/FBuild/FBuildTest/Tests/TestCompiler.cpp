@@ -28,6 +28,7 @@ private:
     void CompilerExecutableAsDependency() const;
     void CompilerExecutableAsDependency_NoRebuild() const;
     void MultipleImplicitCompilers() const;
+    void NormalizeCachePathsIncompatibleWithCompiler() const;
 
     uint64_t GetToolId( const FBuildForTest & fBuild ) const;
 };
@@ -44,6 +45,7 @@ REGISTER_TESTS_BEGIN( TestCompiler )
     REGISTER_TEST( CompilerExecutableAsDependency )
     REGISTER_TEST( CompilerExecutableAsDependency_NoRebuild )
     REGISTER_TEST( MultipleImplicitCompilers )
+    REGISTER_TEST( NormalizeCachePathsIncompatibleWithCompiler )
 REGISTER_TESTS_END
 
 // BuildCompiler_Explicit
@@ -306,6 +308,14 @@ void TestCompiler::MultipleImplicitCompilers() const
     Parse( "Tools/FBuild/FBuildTest/Data/TestCompiler/multipleimplicitcompilers.bff" );
 }
 
+// NormalizeCachePathsIncompatibleWithCompiler
+//------------------------------------------------------------------------------
+void TestCompiler::NormalizeCachePathsIncompatibleWithCompiler() const
+{
+    Parse( "Tools/FBuild/FBuildTest/Data/TestCompiler/normalizecachepaths.bff", true ); // Expect failure
+    TEST_ASSERT( GetRecordedOutput().Find( "Error #1505" ) );
+}
+
 // GetToolId
 //------------------------------------------------------------------------------
 uint64_t TestCompiler::GetToolId( const FBuildForTest & fBuild ) const
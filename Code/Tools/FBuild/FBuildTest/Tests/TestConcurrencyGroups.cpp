@@ -7,10 +7,16 @@
 
 // FBuildCore
 #include "Tools/FBuild/FBuildCore/Graph/SettingsNode.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/JobQueue.h"
 
 // Core
+#include "Core/Containers/UniquePtr.h"
+#include "Core/Process/Process.h"
 #include "Core/Strings/AStackString.h"
 
+// system
+#include <string.h> // for memset
+
 // TestConcurrencyGroups
 //------------------------------------------------------------------------------
 class TestConcurrencyGroups : public FBuildTest
@@ -23,6 +29,8 @@ private:
     void NoLimitsSet() const;
     void UndefinedGroup() const;
     void EnforceLimit() const;
+    void PeakMemoryHistory() const;
+    void LocalMemoryAvailable() const;
 };
 
 // Register Tests
@@ -33,6 +41,8 @@ REGISTER_TESTS_BEGIN( TestConcurrencyGroups )
     REGISTER_TEST( NoLimitsSet )
     REGISTER_TEST( UndefinedGroup )
     REGISTER_TEST( EnforceLimit )
+    REGISTER_TEST( PeakMemoryHistory )
+    REGISTER_TEST( LocalMemoryAvailable )
 REGISTER_TESTS_END
 
 // TooManyGroups
@@ -135,4 +145,99 @@ void TestConcurrencyGroups::EnforceLimit() const
     TEST_ASSERT( fBuild.Build( "EnforceLimit" ) );
 }
 
+// PeakMemoryHistory
+//------------------------------------------------------------------------------
+void TestConcurrencyGroups::PeakMemoryHistory() const
+{
+    // The peak memory of each task is recorded and persisted so that future
+    // builds can avoid starting more tasks than will fit in memory
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestConcurrencyGroups/PeakMemory/peakmemory.bff";
+    options.m_ForceCleanBuild = true;
+    const char * dbFile = "../tmp/Test/ConcurrencyGroups/PeakMemoryHistory/fbuild.fdb";
+
+    // The task uses 64 MiB (in a grandchild process on Linux/OSX)
+    const uint32_t taskMemoryMiB = 64;
+
+    #if defined( __LINUX__ )
+        // Use more memory than the task, so memory inherited from this
+        // process before exec would hide the task's peak if it were counted
+        const size_t parentExtraMemory = ( 2 * taskMemoryMiB * 1024 * 1024 );
+        UniquePtr< void, FreeDeletor > parentMemory( ALLOC( parentExtraMemory ) );
+        memset( parentMemory.Get(), 1, parentExtraMemory );
+        const uint64_t parentMemoryKiB = Process::ReadMemoryStatusKiB( "/proc/self/status", "VmRSS:" );
+        TEST_ASSERT( parentMemoryKiB > ( (uint64_t)parentExtraMemory / 1024 ) );
+    #endif
+
+    {
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "PeakMemory" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( dbFile ) );
+
+        // Resources used by the processes are aggregated in the stats...
+        const Process::ResourceUsage & usage = fBuild.GetStats().GetStatsFor( Node::EXEC_NODE ).m_ProcessUsage;
+        TEST_ASSERT( usage.m_NumProcesses == 1 );
+        TEST_ASSERT( fBuild.GetStats().GetProcessUsage().m_NumProcesses > 1 ); // Includes compiling the helper
+        #if !defined( __OSX__ ) // Not supported on OSX
+            TEST_ASSERT( usage.m_PeakMemoryMiB >= taskMemoryMiB );
+            #if defined( __LINUX__ )
+                // Memory inherited from this process before exec is not counted
+                TEST_ASSERT( usage.m_PeakMemoryMiB < ( 2 * taskMemoryMiB ) );
+            #endif
+
+            Array< const Node * > nodes;
+            fBuild.GetNodesOfType( Node::EXEC_NODE, nodes );
+            TEST_ASSERT( nodes.GetSize() == 1 );
+            TEST_ASSERT( fBuild.GetStats().GetNodesByPeakMemory().Find( nodes[ 0 ] ) );
+
+            // Compiling the helper reads the source (likely from the OS file cache) and writes the object
+            const Process::ResourceUsage & objectUsage = fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE ).m_ProcessUsage;
+            TEST_ASSERT( objectUsage.m_ReadBytes > 0 );
+            TEST_ASSERT( objectUsage.m_WriteBytes > 0 );
+        #endif
+
+        // ... and attached to the steps in the profile
+        AString profile;
+        LoadFileContentsAsString( "fbuild_profile.json", profile );
+        TEST_ASSERT( profile.Find( "\"Peak Memory (MiB)\"" ) );
+        TEST_ASSERT( profile.Find( "\"User CPU (ms)\"" ) );
+    }
+
+    // Check history was loaded from the DB
+    options.m_ForceCleanBuild = false;
+    FBuildForTest fBuild( options );
+    TEST_ASSERT( fBuild.Initialize( dbFile ) );
+    Array< const Node * > nodes;
+    fBuild.GetNodesOfType( Node::EXEC_NODE, nodes );
+    TEST_ASSERT( nodes.GetSize() == 1 );
+    #if defined( __OSX__ )
+        (void)taskMemoryMiB; // Not supported on OSX
+    #else
+        TEST_ASSERT( nodes[ 0 ]->GetLastPeakMemoryMiB() >= taskMemoryMiB );
+    #endif
+}
+
+// LocalMemoryAvailable
+//------------------------------------------------------------------------------
+void TestConcurrencyGroups::LocalMemoryAvailable() const
+{
+    // Nothing with known memory requirements in progress - anything can start
+    TEST_ASSERT( JobQueue::CalcLocalMemoryAvailableMiB( 8192, 0, 0 ) == JobQueue::MEMORY_UNLIMITED );
+
+    // 64 GiB machine with jobs which peak at 6 GiB
+    const uint32_t budgetMiB = ( 60 * 1024 );
+    const uint32_t jobMiB = ( 6 * 1024 );
+
+    // Jobs have just started and not yet consumed their memory: the budget limits us
+    TEST_ASSERT( JobQueue::CalcLocalMemoryAvailableMiB( budgetMiB, jobMiB * 4, budgetMiB ) == ( jobMiB * 6 ) );
+
+    // The budget is exhausted, even if the memory is not yet in use
+    TEST_ASSERT( JobQueue::CalcLocalMemoryAvailableMiB( budgetMiB, jobMiB * 10, budgetMiB ) == 0 );
+    TEST_ASSERT( JobQueue::CalcLocalMemoryAvailableMiB( budgetMiB, jobMiB * 11, budgetMiB ) == 0 );
+
+    // Something else is consuming memory: what is available now limits us
+    TEST_ASSERT( JobQueue::CalcLocalMemoryAvailableMiB( budgetMiB, jobMiB, 1024 ) == 1024 );
+}
+
 //------------------------------------------------------------------------------
@@ -0,0 +1,285 @@
+// TestCriticalPath.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "FBuildTest.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/Graph/NodeGraph.h"
+
+// Core
+#include "Core/Containers/Array.h"
+#include "Core/Strings/AStackString.h"
+#include "Core/Tracing/Tracing.h"
+
+// TestCriticalPath
+//------------------------------------------------------------------------------
+class TestCriticalPath : public FBuildTest
+{
+private:
+    DECLARE_TESTS
+
+    void CriticalPathCosts() const;
+    void SharedDependency() const;
+    void SimulateSyntheticProfile() const;
+};
+
+// Register Tests
+//------------------------------------------------------------------------------
+REGISTER_TESTS_BEGIN( TestCriticalPath )
+    REGISTER_TEST( CriticalPathCosts )
+    REGISTER_TEST( SharedDependency )
+    REGISTER_TEST( SimulateSyntheticProfile )
+REGISTER_TESTS_END
+
+// SimNode
+//------------------------------------------------------------------------------
+// Fake node representing a build step (name, build time, dependencies)
+class SimNode : public Node
+{
+public:
+    SimNode( const char * name, uint32_t buildTimeMS )
+        : Node( Node::PROXY_NODE )
+    {
+        SetName( AStackString<>( name ) );
+        SetLastBuildTime( buildTimeMS );
+    }
+    virtual bool Initialize( NodeGraph & /*nodeGraph*/, const BFFToken * /*funcStartIter*/, const Function * /*function*/ ) override
+    {
+        ASSERT( false );
+        return false;
+    }
+    virtual bool IsAFile() const override { return false; }
+
+    void AddDependency( SimNode * node )
+    {
+        m_StaticDependencies.Add( node );
+        node->m_Dependents.Append( this );
+    }
+
+    // Simulation state
+    Array< SimNode * >  m_Dependents;
+    uint32_t            m_Priority = 0;
+    uint32_t            m_NumPendingDependencies = 0;
+    uint32_t            m_FinishTime = 0;
+    bool                m_Visited = false;
+};
+
+// SimProfile
+//------------------------------------------------------------------------------
+class SimProfile
+{
+public:
+    ~SimProfile()
+    {
+        for ( SimNode * node : m_Nodes )
+        {
+            FDELETE node;
+        }
+    }
+
+    SimNode * Add( const char * name, uint32_t buildTimeMS )
+    {
+        SimNode * node = FNEW( SimNode( name, buildTimeMS ) );
+        m_Nodes.Append( node );
+        return node;
+    }
+
+    // Priorities as assigned by the JobQueue prior to the critical path pass:
+    // the cost accumulated along the first path from the root to reach each node
+    void AssignLegacyPriorities( SimNode * root )
+    {
+        for ( SimNode * node : m_Nodes )
+        {
+            node->m_Visited = false;
+        }
+        AssignLegacyPrioritiesRecurse( root, 0 );
+    }
+
+    // Priorities as assigned by the JobQueue now
+    void AssignCriticalPathPriorities( SimNode * root )
+    {
+        NodeGraph::ComputeCriticalPathCosts( root );
+        for ( SimNode * node : m_Nodes )
+        {
+            node->m_Priority = node->GetRecursiveCost();
+        }
+    }
+
+    // Replay the build on the given number of workers, always starting the
+    // highest priority available job, and return the total time taken
+    uint32_t Simulate( uint32_t numWorkers )
+    {
+        Array< SimNode * > available( m_Nodes.GetSize() );
+        for ( SimNode * node : m_Nodes )
+        {
+            node->m_NumPendingDependencies = (uint32_t)node->GetStaticDependencies().GetSize();
+            if ( node->m_NumPendingDependencies == 0 )
+            {
+                available.Append( node );
+            }
+        }
+
+        Array< SimNode * > active( numWorkers );
+        uint32_t time = 0;
+        uint32_t numCompleted = 0;
+        while ( numCompleted < m_Nodes.GetSize() )
+        {
+            // Start as many jobs as possible
+            while ( ( active.GetSize() < numWorkers ) && ( available.IsEmpty() == false ) )
+            {
+                SimNode ** best = available.Begin();
+                for ( SimNode ** it = available.Begin(); it != available.End(); ++it )
+                {
+                    if ( ( *it )->m_Priority > ( *best )->m_Priority )
+                    {
+                        best = it;
+                    }
+                }
+                SimNode * node = *best;
+                available.Erase( best );
+                node->m_FinishTime = ( time + node->GetLastBuildTime() );
+                active.Append( node );
+            }
+
+            // Advance to the next job completion
+            SimNode ** next = active.Begin();
+            for ( SimNode ** it = active.Begin(); it != active.End(); ++it )
+            {
+                if ( ( *it )->m_FinishTime < ( *next )->m_FinishTime )
+                {
+                    next = it;
+                }
+            }
+            SimNode * completed = *next;
+            active.Erase( next );
+            time = completed->m_FinishTime;
+            ++numCompleted;
+
+            // Release dependents
+            for ( SimNode * dependent : completed->m_Dependents )
+            {
+                if ( --dependent->m_NumPendingDependencies == 0 )
+                {
+                    available.Append( dependent );
+                }
+            }
+        }
+        return time;
+    }
+
+private:
+    void AssignLegacyPrioritiesRecurse( SimNode * node, uint32_t cost )
+    {
+        cost += node->GetLastBuildTime();
+        node->m_Priority = cost;
+        for ( const Dependency & dep : node->GetStaticDependencies() )
+        {
+            SimNode * depNode = static_cast< SimNode * >( dep.GetNode() );
+            if ( depNode->m_Visited == false )
+            {
+                depNode->m_Visited = true;
+                AssignLegacyPrioritiesRecurse( depNode, cost );
+            }
+        }
+    }
+
+    Array< SimNode * > m_Nodes;
+};
+
+// CriticalPathCosts
+//------------------------------------------------------------------------------
+void TestCriticalPath::CriticalPathCosts() const
+{
+    // Exe <- Lib <- Obj
+    SimProfile profile;
+    SimNode * exe = profile.Add( "exe", 20000 );
+    SimNode * lib = profile.Add( "lib", 1000 );
+    SimNode * obj = profile.Add( "obj", 5000 );
+    exe->AddDependency( lib );
+    lib->AddDependency( obj );
+
+    NodeGraph::ComputeCriticalPathCosts( exe );
+
+    // Each node's cost includes its own time and that of everything which must follow it
+    TEST_ASSERT( exe->GetRecursiveCost() == 20000 );
+    TEST_ASSERT( lib->GetRecursiveCost() == 21000 );
+    TEST_ASSERT( obj->GetRecursiveCost() == 26000 );
+
+    // Re-computing must not accumulate costs from the previous pass
+    NodeGraph::ComputeCriticalPathCosts( exe );
+    TEST_ASSERT( obj->GetRecursiveCost() == 26000 );
+}
+
+// SharedDependency
+//------------------------------------------------------------------------------
+void TestCriticalPath::SharedDependency() const
+{
+    // A library shared by a cheap and an expensive link must take the cost of
+    // the longest path, regardless of which link is visited first
+    SimProfile profile;
+    SimNode * all = profile.Add( "all", 1 );
+    SimNode * tool = profile.Add( "tool", 500 );
+    SimNode * game = profile.Add( "game", 30000 );
+    SimNode * lib = profile.Add( "lib", 1000 );
+    all->AddDependency( tool );
+    all->AddDependency( game );
+    tool->AddDependency( lib );
+    game->AddDependency( lib );
+
+    NodeGraph::ComputeCriticalPathCosts( all );
+
+    TEST_ASSERT( tool->GetRecursiveCost() == 501 );
+    TEST_ASSERT( game->GetRecursiveCost() == 30001 );
+    TEST_ASSERT( lib->GetRecursiveCost() == 31001 );
+}
+
+// SimulateSyntheticProfile
+//------------------------------------------------------------------------------
+void TestCriticalPath::SimulateSyntheticProfile() const
+{
+    // Synthetic build times modelled on a typical project (not recorded from a
+    // real build): a few huge unity files in a core library shared with a small
+    // tool, many small files in the game library and a long final link
+    SimProfile profile;
+    SimNode * all = profile.Add( "all", 1 );
+    SimNode * tool = profile.Add( "Tool.exe", 500 );
+    SimNode * game = profile.Add( "Game.exe", 30000 );
+    SimNode * coreLib = profile.Add( "Core.lib", 1000 );
+    SimNode * gameLib = profile.Add( "Game.lib", 1000 );
+    all->AddDependency( tool );
+    all->AddDependency( game );
+    tool->AddDependency( coreLib );
+    game->AddDependency( coreLib );
+    game->AddDependency( gameLib );
+    for ( uint32_t i = 0; i < 4; ++i )
+    {
+        AStackString<> name;
+        name.Format( "CoreUnity%u.obj", i );
+        coreLib->AddDependency( profile.Add( name.Get(), 20000 ) );
+    }
+    for ( uint32_t i = 0; i < 64; ++i )
+    {
+        AStackString<> name;
+        name.Format( "Game%u.obj", i );
+        gameLib->AddDependency( profile.Add( name.Get(), 2000 ) );
+    }
+
+    const uint32_t numWorkers = 8;
+
+    profile.AssignLegacyPriorities( all );
+    const uint32_t legacyTime = profile.Simulate( numWorkers );
+
+    profile.AssignCriticalPathPriorities( all );
+    const uint32_t criticalPathTime = profile.Simulate( numWorkers );
+
+    OUTPUT( "Workers            : %u\n", numWorkers );
+    OUTPUT( "Makespan (legacy)  : %2.3fs\n", (double)legacyTime / 1000.0 );
+    OUTPUT( "Makespan (critical): %2.3fs\n", (double)criticalPathTime / 1000.0 );
+
+    // Huge unity files must start first so they don't delay the final link
+    TEST_ASSERT( criticalPathTime < legacyTime );
+}
+
+//------------------------------------------------------------------------------
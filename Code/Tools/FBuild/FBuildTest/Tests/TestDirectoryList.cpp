@@ -11,9 +11,17 @@
 
 // Core
 #include "Core/Containers/Array.h"
+#include "Core/FileIO/ConstMemoryStream.h"
+#include "Core/FileIO/FileIO.h"
+#include "Core/FileIO/MemoryStream.h"
 #include "Core/FileIO/PathUtils.h"
 #include "Core/Strings/AStackString.h"
 
+// system
+#if defined( __APPLE__ ) || defined( __LINUX__ )
+    #include <unistd.h>
+#endif
+
 // TestGraph
 //------------------------------------------------------------------------------
 class TestDirectoryList : public FBuildTest
@@ -23,6 +31,13 @@ private:
 
     void Build() const;
     void Names() const;
+    void Incremental() const;
+    #if defined( __APPLE__ ) || defined( __LINUX__ )
+        void SymlinkRoot() const;
+    #endif
+
+    // Helpers
+    void AgeDirectory( const AString & path ) const;
 };
 
 // Register Tests
@@ -30,6 +45,10 @@ private:
 REGISTER_TESTS_BEGIN( TestDirectoryList )
     REGISTER_TEST( Build )
     REGISTER_TEST( Names )
+    REGISTER_TEST( Incremental )
+    #if defined( __APPLE__ ) || defined( __LINUX__ )
+        REGISTER_TEST( SymlinkRoot )
+    #endif
 REGISTER_TESTS_END
 
 // Build
@@ -217,4 +236,192 @@ void TestDirectoryList::Names() const
     }
 }
 
+// Incremental
+//------------------------------------------------------------------------------
+void TestDirectoryList::Incremental() const
+{
+    // Full paths are needed to modify directory times
+    AStackString<> root;
+    TEST_ASSERT( FileIO::GetCurrentDir( root ) );
+    PathUtils::EnsureTrailingSlash( root );
+    root += "../tmp/Test/DirectoryList/Incremental/";
+    PathUtils::FixupFolderPath( root );
+    AStackString<> subDir( root );
+    subDir += "Sub";
+    subDir += NATIVE_SLASH;
+    AStackString<> fileA( root );
+    fileA += "a.cpp";
+    AStackString<> fileB( subDir );
+    fileB += "b.cpp";
+    AStackString<> fileC( subDir );
+    fileC += "c.cpp";
+    AStackString<> fileH( root );
+    fileH += "h.h";
+
+    // Create a tree of files
+    EnsureFileDoesNotExist( fileC );
+    TEST_ASSERT( FileIO::EnsurePathExists( subDir ) );
+    MakeFile( fileA.Get(), "" );
+    MakeFile( fileB.Get(), "" );
+    MakeFile( fileH.Get(), "" ); // Excluded by pattern
+
+    // Create the node
+    NodeGraph ng;
+    Array< AString > patterns;
+    patterns.EmplaceBack( "*.cpp" );
+    AStackString<> name;
+    DirectoryListNode::FormatName( root,
+                                   &patterns,
+                                   true, // recursive
+                                   false, // Don't include read-only status in hash
+                                   false, // Don't include directories
+                                   Array< AString >(), // excludePaths,
+                                   Array< AString >(), // excludeFiles,
+                                   Array< AString >(), // excludePatterns,
+                                   name );
+    DirectoryListNode * node = ng.CreateNode<DirectoryListNode>( name );
+    node->m_Path = root;
+    node->m_Patterns = patterns;
+    TEST_ASSERT( node->Initialize( ng, nullptr, nullptr ) );
+
+    // Initial build reads everything
+    Job j( node );
+    TEST_ASSERT( node->DoBuild( &j ) == Node::BuildResult::eOk );
+    TEST_ASSERT( node->GetFiles().GetSize() == 2 );
+    TEST_ASSERT( node->m_NumDirectoriesRead == 2 );
+    const uint64_t stamp = node->GetStamp();
+
+    // Recently modified directories are read again, as a change in the same
+    // time interval would not be detected
+    TEST_ASSERT( node->DoBuild( &j ) == Node::BuildResult::eOk );
+    TEST_ASSERT( node->m_NumDirectoriesRead == 2 );
+
+    // Unchanged directories are not read again
+    AgeDirectory( root );
+    AgeDirectory( subDir );
+    TEST_ASSERT( node->DoBuild( &j ) == Node::BuildResult::eOk );
+    TEST_ASSERT( node->DoBuild( &j ) == Node::BuildResult::eOk );
+    TEST_ASSERT( node->m_NumDirectoriesRead == 0 );
+    TEST_ASSERT( node->GetFiles().GetSize() == 2 );
+    TEST_ASSERT( node->GetStamp() == stamp );
+
+    // Snapshots are preserved in the DB
+    {
+        MemoryStream ms;
+        Node::Save( ms, node );
+        ConstMemoryStream cms( ms.GetData(), ms.GetSize() );
+        NodeGraph ng2;
+        DirectoryListNode * loadedNode = Node::Load( ng2, cms )->CastTo< DirectoryListNode >();
+        Job j2( loadedNode );
+        TEST_ASSERT( loadedNode->DoBuild( &j2 ) == Node::BuildResult::eOk );
+        TEST_ASSERT( loadedNode->m_NumDirectoriesRead == 0 );
+        TEST_ASSERT( loadedNode->GetFiles().GetSize() == 2 );
+        TEST_ASSERT( loadedNode->GetStamp() == stamp );
+    }
+
+    // Added file is detected, reading only the modified directory
+    MakeFile( fileC.Get(), "" );
+    TEST_ASSERT( node->DoBuild( &j ) == Node::BuildResult::eOk );
+    TEST_ASSERT( node->m_NumDirectoriesRead == 1 );
+    TEST_ASSERT( node->GetFiles().GetSize() == 3 );
+    TEST_ASSERT( node->GetStamp() != stamp );
+
+    // Removed file is detected
+    EnsureFileDoesNotExist( fileA );
+    TEST_ASSERT( node->DoBuild( &j ) == Node::BuildResult::eOk );
+    TEST_ASSERT( node->GetFiles().GetSize() == 2 );
+    for ( const FileIO::FileInfo & file : node->GetFiles() )
+    {
+        TEST_ASSERT( file.m_Name.BeginsWith( subDir ) );
+    }
+
+    // Removed directory is detected
+    EnsureFileDoesNotExist( fileB );
+    EnsureFileDoesNotExist( fileC );
+    TEST_ASSERT( FileIO::DirectoryDelete( subDir ) );
+    TEST_ASSERT( node->DoBuild( &j ) == Node::BuildResult::eOk );
+    TEST_ASSERT( node->GetFiles().IsEmpty() );
+}
+
+// SymlinkRoot
+//------------------------------------------------------------------------------
+#if defined( __APPLE__ ) || defined( __LINUX__ )
+    void TestDirectoryList::SymlinkRoot() const
+    {
+        AStackString<> base;
+        TEST_ASSERT( FileIO::GetCurrentDir( base ) );
+        PathUtils::EnsureTrailingSlash( base );
+        base += "../tmp/Test/DirectoryList/SymlinkRoot/";
+        PathUtils::FixupFolderPath( base );
+        AStackString<> real( base );
+        real += "Real/";
+        AStackString<> subDir( real );
+        subDir += "Sub/";
+        AStackString<> subDirLink( real );
+        subDirLink += "SubLink";
+        AStackString<> rootLink( base );
+        rootLink += "Link";
+        AStackString<> fileA( real );
+        fileA += "a.cpp";
+        AStackString<> fileB( subDir );
+        fileB += "b.cpp";
+
+        // Create a tree of files, with a symlink to a sub-directory
+        TEST_ASSERT( FileIO::EnsurePathExists( subDir ) );
+        MakeFile( fileA.Get(), "" );
+        MakeFile( fileB.Get(), "" );
+        unlink( subDirLink.Get() );
+        TEST_ASSERT( symlink( subDir.Get(), subDirLink.Get() ) == 0 );
+
+        // List via a symlink to the tree
+        unlink( rootLink.Get() );
+        TEST_ASSERT( symlink( real.Get(), rootLink.Get() ) == 0 );
+        rootLink += NATIVE_SLASH;
+
+        // Create the node
+        NodeGraph ng;
+        Array< AString > patterns;
+        patterns.EmplaceBack( "*.cpp" );
+        AStackString<> name;
+        DirectoryListNode::FormatName( rootLink,
+                                       &patterns,
+                                       true, // recursive
+                                       false, // Don't include read-only status in hash
+                                       false, // Don't include directories
+                                       Array< AString >(), // excludePaths,
+                                       Array< AString >(), // excludeFiles,
+                                       Array< AString >(), // excludePatterns,
+                                       name );
+        DirectoryListNode * node = ng.CreateNode<DirectoryListNode>( name );
+        node->m_Path = rootLink;
+        node->m_Patterns = patterns;
+        TEST_ASSERT( node->Initialize( ng, nullptr, nullptr ) );
+
+        // The symlinked root is followed, but the symlinked sub-directory is not
+        Job j( node );
+        TEST_ASSERT( node->DoBuild( &j ) == Node::BuildResult::eOk );
+        TEST_ASSERT( node->GetFiles().GetSize() == 2 );
+        for ( const FileIO::FileInfo & file : node->GetFiles() )
+        {
+            TEST_ASSERT( file.m_Name.BeginsWith( rootLink ) );
+            TEST_ASSERT( file.m_Name.Find( "SubLink" ) == nullptr );
+        }
+    }
+#endif
+
+// AgeDirectory
+//------------------------------------------------------------------------------
+void TestDirectoryList::AgeDirectory( const AString & path ) const
+{
+    // Move time of directory an hour into the past
+    #if defined( __WINDOWS__ )
+        const uint64_t oneHour = ( 60ULL * 60ULL * 10000000ULL ); // 100ns units
+    #else
+        const uint64_t oneHour = ( 60ULL * 60ULL * 1000000000ULL ); // ns
+    #endif
+    const uint64_t time = FileIO::GetFileLastWriteTime( path );
+    TEST_ASSERT( time != 0 );
+    TEST_ASSERT( FileIO::SetFileLastWriteTime( path, time - oneHour ) );
+}
+
 //------------------------------------------------------------------------------
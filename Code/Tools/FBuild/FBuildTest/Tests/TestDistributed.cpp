@@ -7,13 +7,18 @@
 
 #include "Tools/FBuild/FBuildCore/FBuild.h"
 #include "Tools/FBuild/FBuildCore/Graph/ObjectNode.h"
+#include "Tools/FBuild/FBuildCore/Protocol/Client.h"
 #include "Tools/FBuild/FBuildCore/Protocol/Protocol.h"
 #include "Tools/FBuild/FBuildCore/Protocol/Server.h"
 #include "Tools/FBuild/FBuildCore/WorkerPool/Job.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/JobQueue.h"
 #include "Tools/FBuild/FBuildCore/WorkerPool/JobQueueRemote.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/WorkerResultCache.h"
 
 #include "Core/FileIO/FileIO.h"
+#include "Core/Math/Conversions.h"
 #include "Core/Strings/AStackString.h"
+#include "Core/Time/Timer.h"
 
 // Defines
 //------------------------------------------------------------------------------
@@ -34,6 +39,13 @@ private:
     void RegressionTest_RemoteCrashOnErrorFormatting();
     void TestLocalRace();
     void RemoteRaceWinRemote();
+    void RacePolicy() const;
+    void WorkerResultCache() const;
+    void WorkerResultCacheEmptyResults() const;
+    void HeavyJobs() const;
+    void RemoteJobProfiling() const;
+    void RemotePhaseTimesClockSkew() const;
+    void ExecDistributable() const;
     #if defined( DEBUG )
         void RemoteRaceSystemFailure();
     #endif
@@ -64,6 +76,13 @@ REGISTER_TESTS_BEGIN( TestDistributed )
     REGISTER_TEST( RegressionTest_RemoteCrashOnErrorFormatting )
     REGISTER_TEST( TestLocalRace )
     REGISTER_TEST( RemoteRaceWinRemote )
+    REGISTER_TEST( RacePolicy )
+    REGISTER_TEST( WorkerResultCache )
+    REGISTER_TEST( WorkerResultCacheEmptyResults )
+    REGISTER_TEST( HeavyJobs )
+    REGISTER_TEST( RemoteJobProfiling )
+    REGISTER_TEST( RemotePhaseTimesClockSkew )
+    REGISTER_TEST( ExecDistributable )
     #if defined( DEBUG )
         REGISTER_TEST( RemoteRaceSystemFailure )
     #endif
@@ -198,6 +217,362 @@ void TestDistributed::RemoteRaceWinRemote()
     TEST_ASSERT( fBuild.Build( "RemoteRaceWinRemote" ) );
 }
 
+// WorkerResultCache
+//------------------------------------------------------------------------------
+void TestDistributed::WorkerResultCache() const
+{
+    const char * target( "../tmp/Test/Distributed/dist.lib" );
+
+    // start a worker with a result cache
+    Server s( 1 );
+    s.Listen( Protocol::PROTOCOL_TEST_PORT );
+    JobQueueRemote::Get().SetResultCacheSize( 64 * MEGABYTE );
+
+    uint32_t numHits = 0;
+    uint32_t numMisses = 0;
+    uint64_t size = 0;
+    Array< uint32_t > buildTimes;
+
+    // Build twice, emulating two clients building the same code
+    for ( uint32_t i = 0; i < 2; ++i )
+    {
+        FBuildTestOptions options;
+        options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestDistributed/fbuild.bff";
+        options.m_AllowDistributed = true;
+        options.m_NumWorkerThreads = 1;
+        options.m_ForceCleanBuild = true;
+        options.m_NoLocalConsumptionOfRemoteJobs = true; // ensure all jobs happen on the remote worker
+        options.m_AllowLocalRace = false;
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+
+        TEST_ASSERT( fBuild.Build( target ) );
+        TEST_ASSERT( FileIO::FileExists( target ) );
+
+        Array< const Node * > nodes;
+        fBuild.GetNodesOfType( Node::OBJECT_NODE, nodes );
+
+        JobQueueRemote::Get().GetResultCache().GetStats( numHits, numMisses, size );
+        if ( i == 0 )
+        {
+            // First build populates the cache
+            TEST_ASSERT( numHits == 0 );
+            TEST_ASSERT( numMisses > 0 );
+            TEST_ASSERT( size > 0 );
+
+            for ( const Node * node : nodes )
+            {
+                buildTimes.Append( node->GetLastBuildTime() );
+            }
+        }
+        else
+        {
+            // Cache hits report the original build time, not the retrieval time
+            TEST_ASSERT( nodes.GetSize() == buildTimes.GetSize() );
+            for ( size_t j = 0; j < nodes.GetSize(); ++j )
+            {
+                TEST_ASSERT( nodes[ j ]->GetLastBuildTime() == buildTimes[ j ] );
+            }
+        }
+    }
+
+    // Second build is entirely serviced from the cache
+    TEST_ASSERT( numHits == numMisses );
+}
+
+// WorkerResultCacheEmptyResults
+//------------------------------------------------------------------------------
+void TestDistributed::WorkerResultCacheEmptyResults() const
+{
+    // Results with no data don't contribute to the size of the cache, but must
+    // still be freed (leaks are detected when the test ends)
+    const Array< AString > messages;
+    uint32_t numHits = 0;
+    uint32_t numMisses = 0;
+    uint64_t size = 0;
+
+    // Freed on destruction
+    {
+        ::WorkerResultCache cache;
+        cache.SetMaxSize( MEGABYTE );
+        cache.Publish( AString( "Empty1" ), "", 0, messages, 10 );
+        cache.Publish( AString( "Empty2" ), "", 0, messages, 20 );
+        cache.Publish( AString( "Data" ), "data", 4, messages, 30 );
+        cache.GetStats( numHits, numMisses, size );
+        TEST_ASSERT( size == 4 );
+    }
+
+    // Freed when the cache is disabled
+    {
+        ::WorkerResultCache cache;
+        cache.SetMaxSize( MEGABYTE );
+        cache.Publish( AString( "Empty" ), "", 0, messages, 10 );
+
+        void * data = nullptr;
+        size_t dataSize = 0;
+        Array< AString > outMessages;
+        uint32_t buildTimeMS = 0;
+        TEST_ASSERT( cache.Retrieve( AString( "Empty" ), data, dataSize, outMessages, buildTimeMS ) );
+        TEST_ASSERT( ( dataSize == 0 ) && ( buildTimeMS == 10 ) );
+        FREE( data );
+
+        cache.SetMaxSize( 0 );
+        TEST_ASSERT( cache.Retrieve( AString( "Empty" ), data, dataSize, outMessages, buildTimeMS ) == false );
+
+        // Nothing is stored while disabled
+        cache.Publish( AString( "Empty" ), "", 0, messages, 10 );
+        TEST_ASSERT( cache.Retrieve( AString( "Empty" ), data, dataSize, outMessages, buildTimeMS ) == false );
+    }
+}
+
+// HeavyJobs
+//------------------------------------------------------------------------------
+void TestDistributed::HeavyJobs() const
+{
+    // Jobs in a ConcurrencyGroup which needs 2 GiB per job
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestDistributed/HeavyJobs/fbuild.bff";
+    options.m_AllowDistributed = true;
+    options.m_NumWorkerThreads = 1;
+    options.m_ForceCleanBuild = true;
+    options.m_AllowLocalRace = false;
+
+    // Worker with enough memory for one job at a time
+    {
+        Server s( 4 );
+        s.Listen( Protocol::PROTOCOL_TEST_PORT );
+        JobQueueRemote::Get().SetMemoryBudgetMiB( 3072 );
+
+        options.m_NoLocalConsumptionOfRemoteJobs = true; // ensure all jobs happen on the remote worker
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "HeavyJobs" ) );
+
+        // All jobs were built remotely
+        Array< const Node * > nodes;
+        fBuild.GetNodesOfType( Node::OBJECT_NODE, nodes );
+        TEST_ASSERT( nodes.GetSize() == 3 );
+        for ( const Node * node : nodes )
+        {
+            TEST_ASSERT( node->GetStatFlag( Node::STATS_BUILT_REMOTE ) );
+        }
+    }
+
+    // Worker with insufficient memory for any job
+    {
+        Server s( 4 );
+        s.Listen( Protocol::PROTOCOL_TEST_PORT );
+        JobQueueRemote::Get().SetMemoryBudgetMiB( 1024 );
+
+        options.m_NoLocalConsumptionOfRemoteJobs = false;
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "HeavyJobs" ) );
+
+        // No jobs were sent to the worker
+        Array< const Node * > nodes;
+        fBuild.GetNodesOfType( Node::OBJECT_NODE, nodes );
+        TEST_ASSERT( nodes.GetSize() == 3 );
+        for ( const Node * node : nodes )
+        {
+            TEST_ASSERT( node->GetStatFlag( Node::STATS_BUILT_REMOTE ) == false );
+        }
+    }
+}
+
+// RemoteJobProfiling
+//------------------------------------------------------------------------------
+void TestDistributed::RemoteJobProfiling() const
+{
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestDistributed/fbuild.bff";
+    options.m_AllowDistributed = true;
+    options.m_NumWorkerThreads = 1;
+    options.m_NoLocalConsumptionOfRemoteJobs = true; // ensure all jobs happen on the remote worker
+    options.m_ForceCleanBuild = true;
+    TEST_ASSERT( options.m_Profile );
+
+    Server s( 1 );
+    s.Listen( Protocol::PROTOCOL_TEST_PORT );
+
+    FBuildForTest fBuild( options );
+    TEST_ASSERT( fBuild.Initialize() );
+    TEST_ASSERT( fBuild.Build( "../tmp/Test/Distributed/dist.lib" ) );
+
+    // Worker reports timing of each phase, shown as a breakdown of each job
+    AString profile;
+    LoadFileContentsAsString( "fbuild_profile.json", profile );
+    const char * const expectedPhases[] =
+    {
+        "\"Remote Job\"", "\"Compress\"", "\"Client Queue\"", "\"Send Job\"", "\"Tool Sync\"",
+        "\"Worker Queue\"", "\"Build\"", "\"Send Result\"", "\"Decompress\"", "\"Compress Result\"",
+    };
+    for ( const char * phase : expectedPhases )
+    {
+        TEST_ASSERT( profile.Find( phase ) );
+    }
+}
+
+// RemotePhaseTimesClockSkew
+//------------------------------------------------------------------------------
+void TestDistributed::RemotePhaseTimesClockSkew() const
+{
+    // Times are specified in microseconds, with the worker clock 5s ahead
+    const int64_t kSkewUS = ( 5 * 1000 * 1000 );
+    const auto toTicks = []( int64_t timeUS ) { return (int64_t)( (double)timeUS * ( (double)Timer::GetFrequency() / 1000000.0 ) ); };
+    const auto checkTime = [ & ]( int64_t time, int64_t expectedUS )
+    {
+        // Allow for rounding in the conversions
+        const int64_t tolerance = Math::Max< int64_t >( toTicks( 2 ), 2 );
+        TEST_ASSERT( ( time >= ( toTicks( expectedUS ) - tolerance ) ) &&
+                     ( time <= ( toTicks( expectedUS ) + tolerance ) ) );
+    };
+    const auto setWorkerTimes = []( int64_t * workerTimesUS, int64_t receivedUS, int64_t builtUS, int64_t sentUS )
+    {
+        for ( uint32_t i = 0; i < Job::NUM_REMOTE_PHASES; ++i )
+        {
+            workerTimesUS[ i ] = 0;
+        }
+        workerTimesUS[ Job::PHASE_WORKER_RECEIVED ] = receivedUS;
+        workerTimesUS[ Job::PHASE_WORKER_TOOLS_READY ] = receivedUS;
+        workerTimesUS[ Job::PHASE_WORKER_STARTED ] = receivedUS;
+        workerTimesUS[ Job::PHASE_WORKER_BUILT ] = builtUS;
+        workerTimesUS[ Job::PHASE_WORKER_RESULT_READY ] = builtUS;
+        workerTimesUS[ Job::PHASE_WORKER_SENT ] = sentUS;
+    };
+
+    Client::ServerState ss;
+    Job job( nullptr );
+    int64_t workerTimesUS[ Job::NUM_REMOTE_PHASES ] = {};
+    int64_t phaseTimes[ Job::NUM_REMOTE_PHASES ] = {};
+
+    // Older workers don't provide timings
+    job.SetPhaseTime( Job::PHASE_SENT, toTicks( 1000000 ) );
+    TEST_ASSERT( Client::GetRemotePhaseTimes( ss, job, workerTimesUS, toTicks( 1010000 ), phaseTimes ) == false );
+    TEST_ASSERT( ss.m_ClockOffsetDelayUS == -1 );
+
+    // Round trip of 10ms, with 2ms transfer each way
+    {
+        setWorkerTimes( workerTimesUS, 1002000 + kSkewUS, 1006000 + kSkewUS, 1008000 + kSkewUS );
+        TEST_ASSERT( Client::GetRemotePhaseTimes( ss, job, workerTimesUS, toTicks( 1010000 ), phaseTimes ) );
+
+        // Offset is estimated from the round trip
+        TEST_ASSERT( ( ss.m_ClockOffsetUS >= ( kSkewUS - 2 ) ) && ( ss.m_ClockOffsetUS <= ( kSkewUS + 2 ) ) );
+        TEST_ASSERT( ( ss.m_ClockOffsetDelayUS >= 3998 ) && ( ss.m_ClockOffsetDelayUS <= 4002 ) );
+
+        // Worker phases are converted to local time
+        checkTime( phaseTimes[ Job::PHASE_WORKER_RECEIVED ], 1002000 );
+        checkTime( phaseTimes[ Job::PHASE_WORKER_BUILT ], 1006000 );
+        checkTime( phaseTimes[ Job::PHASE_WORKER_SENT ], 1008000 );
+        TEST_ASSERT( phaseTimes[ Job::PHASE_WORKER_DECOMPRESS_BEGIN ] == 0 ); // Not reached
+
+        // Unrecorded compression starts when the job was sent
+        TEST_ASSERT( phaseTimes[ Job::PHASE_COMPRESS_BEGIN ] == job.GetPhaseTime( Job::PHASE_SENT ) );
+        TEST_ASSERT( phaseTimes[ Job::PHASE_COMPRESS_END ] == job.GetPhaseTime( Job::PHASE_SENT ) );
+    }
+
+    // A slower, asymmetric round trip doesn't replace the more accurate estimate
+    {
+        const int64_t offsetUS = ss.m_ClockOffsetUS;
+        job.SetPhaseTime( Job::PHASE_SENT, toTicks( 2000000 ) );
+        setWorkerTimes( workerTimesUS, 2090000 + kSkewUS, 2092000 + kSkewUS, 2095000 + kSkewUS );
+        TEST_ASSERT( Client::GetRemotePhaseTimes( ss, job, workerTimesUS, toTicks( 2100000 ), phaseTimes ) );
+        TEST_ASSERT( ss.m_ClockOffsetUS == offsetUS );
+        checkTime( phaseTimes[ Job::PHASE_WORKER_RECEIVED ], 2090000 );
+        checkTime( phaseTimes[ Job::PHASE_WORKER_SENT ], 2095000 );
+    }
+
+    // Worker clock has drifted 20ms ahead of the estimate, so phases would be
+    // after the result was received. They are clamped to the round trip.
+    {
+        job.SetPhaseTime( Job::PHASE_SENT, toTicks( 3000000 ) );
+        setWorkerTimes( workerTimesUS, 3000500 + kSkewUS + 20000, 3002000 + kSkewUS + 20000, 3003000 + kSkewUS + 20000 );
+        TEST_ASSERT( Client::GetRemotePhaseTimes( ss, job, workerTimesUS, toTicks( 3010000 ), phaseTimes ) );
+        for ( uint32_t i = Job::FIRST_WORKER_PHASE; i < Job::NUM_REMOTE_PHASES; ++i )
+        {
+            TEST_ASSERT( ( phaseTimes[ i ] == 0 ) || ( phaseTimes[ i ] == toTicks( 3010000 ) ) );
+        }
+    }
+
+    // Worker clock has drifted 20ms behind the estimate, so phases would be
+    // before the job was sent. They are clamped to the round trip, in order.
+    {
+        job.SetPhaseTime( Job::PHASE_SENT, toTicks( 4000000 ) );
+        setWorkerTimes( workerTimesUS, 4000500 + kSkewUS - 20000, 4002000 + kSkewUS - 20000, 4025000 + kSkewUS - 20000 );
+        TEST_ASSERT( Client::GetRemotePhaseTimes( ss, job, workerTimesUS, toTicks( 4030000 ), phaseTimes ) );
+        TEST_ASSERT( phaseTimes[ Job::PHASE_WORKER_RECEIVED ] == toTicks( 4000000 ) );
+        TEST_ASSERT( phaseTimes[ Job::PHASE_WORKER_BUILT ] == toTicks( 4000000 ) );
+        checkTime( phaseTimes[ Job::PHASE_WORKER_SENT ], 4005000 );
+    }
+
+    // Worker restarts with its clock 1s behind, and reconnects using the same
+    // slot. The estimate from the previous connection must not be kept, even
+    // though the new round trip is slower.
+    {
+        ss.ResetClockOffset(); // As done by OnDisconnected
+        TEST_ASSERT( ss.m_ClockOffsetDelayUS == -1 );
+
+        const int64_t kNewSkewUS = -( 1000 * 1000 );
+        job.SetPhaseTime( Job::PHASE_SENT, toTicks( 5000000 ) );
+        setWorkerTimes( workerTimesUS, 5010000 + kNewSkewUS, 5020000 + kNewSkewUS, 5030000 + kNewSkewUS );
+        TEST_ASSERT( Client::GetRemotePhaseTimes( ss, job, workerTimesUS, toTicks( 5040000 ), phaseTimes ) );
+        TEST_ASSERT( ( ss.m_ClockOffsetUS >= ( kNewSkewUS - 2 ) ) && ( ss.m_ClockOffsetUS <= ( kNewSkewUS + 2 ) ) );
+        checkTime( phaseTimes[ Job::PHASE_WORKER_RECEIVED ], 5010000 );
+        checkTime( phaseTimes[ Job::PHASE_WORKER_BUILT ], 5020000 );
+        checkTime( phaseTimes[ Job::PHASE_WORKER_SENT ], 5030000 );
+    }
+}
+
+// ExecDistributable
+//------------------------------------------------------------------------------
+void TestDistributed::ExecDistributable() const
+{
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestDistributed/Exec/fbuild.bff";
+    options.m_AllowDistributed = true;
+    options.m_NumWorkerThreads = 1;
+    options.m_NoLocalConsumptionOfRemoteJobs = true; // ensure all jobs happen on the remote worker
+    options.m_ForceCleanBuild = true;
+    options.m_UseCacheWrite = true;
+
+    // Inputs
+    const char * const inputs[] = { "../tmp/Test/Distributed/Exec/InputA.txt",
+                                    "../tmp/Test/Distributed/Exec/InputB.txt" };
+    for ( const char * input : inputs )
+    {
+        TEST_ASSERT( FileIO::EnsurePathExistsForFile( AStackString<>( input ) ) );
+        MakeFile( input, "I" );
+    }
+
+    // Files the executable writes alongside its inputs
+    const AStackString<> sideEffectA( "../tmp/Test/Distributed/Exec/InputA.txt.out" );
+    const AStackString<> sideEffectB( "../tmp/Test/Distributed/Exec/InputB.txt.out" );
+    FileIO::FileDelete( sideEffectA.Get() );
+    FileIO::FileDelete( sideEffectB.Get() );
+
+    Server s( 1 );
+    s.Listen( Protocol::PROTOCOL_TEST_PORT );
+
+    FBuildForTest fBuild( options );
+    TEST_ASSERT( fBuild.Initialize() );
+    TEST_ASSERT( fBuild.Build( "Exec" ) );
+
+    // Exec was built remotely, and its output stored in the cache
+    Array< const Node * > nodes;
+    fBuild.GetNodesOfType( Node::EXEC_NODE, nodes );
+    TEST_ASSERT( nodes.GetSize() == 1 );
+    TEST_ASSERT( nodes[ 0 ]->GetStatFlag( Node::STATS_BUILT_REMOTE ) );
+    TEST_ASSERT( nodes[ 0 ]->GetStatFlag( Node::STATS_CACHE_STORE ) );
+
+    // The output was returned, and the executable only saw copies of the inputs
+    AString output;
+    LoadFileContentsAsString( "../tmp/Test/Distributed/Exec/Output.txt", output );
+    TEST_ASSERT( output.Find( "InputA.txt.out" ) );
+    TEST_ASSERT( output.Find( "InputB.txt.out" ) );
+    EnsureFileDoesNotExist( sideEffectA );
+    EnsureFileDoesNotExist( sideEffectB );
+}
+
 // RemoteRaceSystemFailure
 //------------------------------------------------------------------------------
 #if defined( ENABLE_FAKE_SYSTEM_FAILURE )
@@ -563,4 +938,29 @@ void TestDistributed::CleanMessageToPreventMSBuildFailure() const
     }
 }
 
+// RacePolicy
+//------------------------------------------------------------------------------
+void TestDistributed::RacePolicy() const
+{
+    // Job expected to take 10s locally and 10s on the worker
+    const uint32_t expectedTimeMS = 10000;
+
+    // Jobs about to complete remotely are not worth racing
+    TEST_ASSERT( JobQueue::EstimateRaceGainMS( 1000, expectedTimeMS, expectedTimeMS ) == 0 );
+    TEST_ASSERT( JobQueue::EstimateRaceGainMS( 9000, expectedTimeMS, expectedTimeMS ) == 0 );
+
+    // Jobs only slightly overdue are not worth racing
+    TEST_ASSERT( JobQueue::EstimateRaceGainMS( 15000, expectedTimeMS, expectedTimeMS ) == 0 );
+
+    // Stragglers are worth racing, and more so the longer they are overdue
+    const uint32_t gain1 = JobQueue::EstimateRaceGainMS( 25000, expectedTimeMS, expectedTimeMS );
+    const uint32_t gain2 = JobQueue::EstimateRaceGainMS( 40000, expectedTimeMS, expectedTimeMS );
+    TEST_ASSERT( gain1 == 5000 );
+    TEST_ASSERT( gain2 > gain1 );
+
+    // Jobs on a slow worker are worth racing from the start
+    TEST_ASSERT( JobQueue::EstimateRaceGainMS( 0, expectedTimeMS * 4, expectedTimeMS ) == 30000 );
+    TEST_ASSERT( JobQueue::EstimateRaceGainMS( 20000, expectedTimeMS * 4, expectedTimeMS ) == 10000 );
+}
+
 //------------------------------------------------------------------------------
@@ -12,6 +12,7 @@
 #include "Core/Process/Process.h"
 #include "Core/Process/Thread.h"
 #include "Core/Strings/AStackString.h"
+#include "Core/Time/Time.h"
 
 // TestExec
 //------------------------------------------------------------------------------
@@ -30,6 +31,8 @@ private:
     void Build_ExecEnvCommand() const;
     void Exclusions() const;
     void PreBuildDependencies() const;
+    void Cacheable() const;
+    void DistributableRequiresCompiler() const;
 };
 
 // Register Tests
@@ -45,6 +48,8 @@ REGISTER_TESTS_BEGIN( TestExec )
     REGISTER_TEST( Build_ExecEnvCommand )
     REGISTER_TEST( Exclusions )
     REGISTER_TEST( PreBuildDependencies )
+    REGISTER_TEST( Cacheable )
+    REGISTER_TEST( DistributableRequiresCompiler )
 REGISTER_TESTS_END
 
 // Helpers
@@ -384,3 +389,80 @@ void TestExec::PreBuildDependencies() const
 }
 
 //------------------------------------------------------------------------------
+void TestExec::Cacheable() const
+{
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestExec/Cacheable/fbuild.bff";
+    options.m_ForceCleanBuild = true;
+
+    // Unique inputs so results can't be in the cache from previous runs
+    const char * const inputs[] = { "../tmp/Test/Exec/Cacheable/InputA.txt",
+                                    "../tmp/Test/Exec/Cacheable/InputB.txt" };
+    AStackString<> contents;
+    contents.Format( "%" PRIu64, Time::GetCurrentFileTime() );
+    for ( const char * input : inputs )
+    {
+        TEST_ASSERT( FileIO::EnsurePathExistsForFile( AStackString<>( input ) ) );
+        MakeFile( input, contents.Get() );
+    }
+    const AStackString<> outputA( "../tmp/Test/Exec/Cacheable/InputA.txt.out" );
+    const AStackString<> outputB( "../tmp/Test/Exec/Cacheable/InputB.txt.out" );
+
+    // Write to the cache
+    {
+        options.m_UseCacheWrite = true;
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "Cacheable" ) );
+
+        const FBuildStats::Stats & execStats = fBuild.GetStats().GetStatsFor( Node::EXEC_NODE );
+        TEST_ASSERT( execStats.m_NumBuilt == 2 );
+        TEST_ASSERT( execStats.m_NumCacheHits == 0 );
+        TEST_ASSERT( execStats.m_NumCacheStores == 2 );
+        options.m_UseCacheWrite = false;
+    }
+
+    EnsureFileDoesNotExist( outputA );
+    EnsureFileDoesNotExist( outputB );
+
+    // Read from the cache
+    {
+        options.m_UseCacheRead = true;
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "Cacheable" ) );
+
+        const FBuildStats::Stats & execStats = fBuild.GetStats().GetStatsFor( Node::EXEC_NODE );
+        TEST_ASSERT( execStats.m_NumCacheHits == 2 );
+        EnsureFileExists( outputA );
+        EnsureFileExists( outputB );
+    }
+
+    // Changing an input results in a cache miss
+    contents += "-changed";
+    MakeFile( inputs[ 0 ], contents.Get() );
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "Cacheable" ) );
+
+        const FBuildStats::Stats & execStats = fBuild.GetStats().GetStatsFor( Node::EXEC_NODE );
+        TEST_ASSERT( execStats.m_NumCacheHits == 1 );
+        TEST_ASSERT( execStats.m_NumCacheMisses == 1 );
+    }
+}
+
+//------------------------------------------------------------------------------
+void TestExec::DistributableRequiresCompiler() const
+{
+    // Workers receive the executable via a Compiler's manifest
+    TEST_PARSE_FAIL( "Exec( 'Exec' )\n"
+                     "{\n"
+                     "    .ExecExecutable     = 'tool.exe'\n"
+                     "    .ExecOutput         = 'out.txt'\n"
+                     "    .ExecDistributable  = true\n"
+                     "}\n",
+                     "Error #1102" );
+}
+
+//------------------------------------------------------------------------------
@@ -34,6 +34,7 @@
 #include "Core/Math/Conversions.h"
 #include "Core/Math/xxHash.h"
 #include "Core/Process/Thread.h"
+#include "Core/Process/ThreadPool.h"
 #include "Core/Strings/AStackString.h"
 #include "Core/Time/Timer.h"
 
@@ -60,6 +61,13 @@ private:
     void FixupErrorPaths() const;
     void CyclicDependency() const;
     void DBLocation() const;
+    void ContentHashStamps() const;
+    void EarlyCutoff() const;
+    void PrefetchFileStamps() const;
+    void PrefetchFileStampsBuildDecisions() const;
+
+    // Helpers
+    void BuildWithModifiedFiles( bool prefetchFileStamps, Array< AString > & outRebuiltFiles ) const;
 };
 
 // Register Tests
@@ -81,6 +89,10 @@ REGISTER_TESTS_BEGIN( TestGraph )
     REGISTER_TEST( FixupErrorPaths )
     REGISTER_TEST( CyclicDependency )
     REGISTER_TEST( DBLocation )
+    REGISTER_TEST( ContentHashStamps )
+    REGISTER_TEST( EarlyCutoff )
+    REGISTER_TEST( PrefetchFileStamps )
+    REGISTER_TEST( PrefetchFileStampsBuildDecisions )
 REGISTER_TESTS_END
 
 // NodeTestHelper
@@ -102,6 +114,8 @@ public:
     }
     virtual bool IsAFile() const override { return true; }
 
+    void AddStaticDependency( Node * node ) { m_StaticDependencies.Add( node ); }
+
     using Node::FixupPathForVSIntegration;
 };
 REFLECT_BEGIN( NodeTestHelper, Node, MetaNone() )
@@ -113,6 +127,7 @@ class FileNodeTestHelper : public FileNode
 {
 public:
     using FileNode::DoBuild;
+    using FileNode::ConsumePrefetchedFileTime;
 };
 
 // EmptyGraph
@@ -944,4 +959,288 @@ void TestGraph::DBLocation() const
     }
 }
 
+// ContentHashStamps
+//------------------------------------------------------------------------------
+void TestGraph::ContentHashStamps() const
+{
+    const char * const sourceFile   = "../tmp/Test/Graph/ContentHash/source.txt";
+    const char * const dbFile       = "../tmp/Test/Graph/ContentHash/fbuild.fdb";
+
+    TEST_ASSERT( FileIO::EnsurePathExistsForFile( AStackString<>( sourceFile ) ) );
+    EnsureFileDoesNotExist( dbFile );
+    MakeFile( sourceFile, "a" );
+
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestGraph/ContentHash/fbuild.bff";
+    options.m_UseContentHash = true;
+
+    // Initial build
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "Copy" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( dbFile ) );
+        CheckStatsNode( 1, 1, Node::COPY_FILE_NODE );
+    }
+
+    // Change the time of the source without changing the contents
+    AStackString<> source;
+    TEST_ASSERT( FileIO::GetCurrentDir( source ) );
+    PathUtils::EnsureTrailingSlash( source );
+    source += sourceFile; // Full path required by SetFileLastWriteTime
+    const uint64_t originalTime = FileIO::GetFileLastWriteTime( source );
+    TEST_ASSERT( FileIO::SetFileLastWriteTime( source, originalTime - ( 60 * 1000 * 1000 ) ) );
+    TEST_ASSERT( FileIO::GetFileLastWriteTime( source ) != originalTime );
+
+    // Nothing needs building
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( dbFile ) );
+        TEST_ASSERT( fBuild.Build( "Copy" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( dbFile ) );
+        CheckStatsNode( 1, 0, Node::COPY_FILE_NODE );
+    }
+
+    // Change the contents without changing the time or size
+    const uint64_t touchedTime = FileIO::GetFileLastWriteTime( source );
+    MakeFile( sourceFile, "b" );
+    TEST_ASSERT( FileIO::SetFileLastWriteTime( source, touchedTime ) );
+
+    // Hash saved in the DB is re-used as time and size are unchanged, so the
+    // change is not seen (as would also be the case with timestamps)
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( dbFile ) );
+        TEST_ASSERT( fBuild.Build( "Copy" ) );
+        CheckStatsNode( 1, 0, Node::COPY_FILE_NODE );
+    }
+
+    // Change the contents and the time
+    MakeFile( sourceFile, "c" );
+    TEST_ASSERT( FileIO::SetFileLastWriteTime( source, originalTime ) );
+
+    // Change is detected
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( dbFile ) );
+        TEST_ASSERT( fBuild.Build( "Copy" ) );
+        CheckStatsNode( 1, 1, Node::COPY_FILE_NODE );
+    }
+}
+
+// EarlyCutoff
+//------------------------------------------------------------------------------
+void TestGraph::EarlyCutoff() const
+{
+    const char * const textFile = "../tmp/Test/Graph/EarlyCutoff/text.txt";
+    const char * const dbFile   = "../tmp/Test/Graph/EarlyCutoff/fbuild.fdb";
+
+    EnsureFileDoesNotExist( textFile );
+    EnsureFileDoesNotExist( dbFile );
+
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestGraph/EarlyCutoff/fbuild.bff";
+    options.m_EarlyCutoff = true;
+
+    // Initial build
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "Copy" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( dbFile ) );
+        CheckStatsNode( 1, 1, Node::TEXT_FILE_NODE );
+        CheckStatsNode( 1, 1, Node::COPY_FILE_NODE );
+    }
+
+    // Modify the time of the intermediate file, so it is rebuilt
+    AStackString<> text;
+    TEST_ASSERT( FileIO::GetCurrentDir( text ) );
+    PathUtils::EnsureTrailingSlash( text );
+    text += textFile; // Full path required by SetFileLastWriteTime
+    const uint64_t originalTime = FileIO::GetFileLastWriteTime( text );
+    TEST_ASSERT( FileIO::SetFileLastWriteTime( text, originalTime - ( 60 * 1000 * 1000 ) ) );
+
+    // Intermediate file is rebuilt with identical contents, so the copy is not
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( dbFile ) );
+        TEST_ASSERT( fBuild.Build( "Copy" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( dbFile ) );
+        CheckStatsNode( 1, 1, Node::TEXT_FILE_NODE );
+        CheckStatsNode( 1, 0, Node::COPY_FILE_NODE );
+    }
+
+    // Without early cutoff, the copy is rebuilt
+    TEST_ASSERT( FileIO::SetFileLastWriteTime( text, originalTime ) );
+    options.m_EarlyCutoff = false;
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( dbFile ) );
+        TEST_ASSERT( fBuild.Build( "Copy" ) );
+        CheckStatsNode( 1, 1, Node::TEXT_FILE_NODE );
+        CheckStatsNode( 1, 1, Node::COPY_FILE_NODE );
+    }
+}
+
+// PrefetchFileStamps
+//------------------------------------------------------------------------------
+void TestGraph::PrefetchFileStamps() const
+{
+    FBuild fb; // needed for NodeGraph::CreateNode
+
+    // Create enough files that several threads are used
+    const uint32_t kNumFiles = 256;
+    const uint32_t kNumMissingFiles = 8;
+    NodeGraph ng;
+    NodeTestHelper target;
+    Array< FileNode * > fileNodes( kNumFiles + kNumMissingFiles );
+    for ( uint32_t i = 0; i < ( kNumFiles + kNumMissingFiles ); ++i )
+    {
+        AStackString<> fileName;
+        fileName.Format( "../tmp/Test/Graph/PrefetchFileStamps/stamps/file%03u.txt", i );
+        if ( i < kNumFiles )
+        {
+            TEST_ASSERT( FileIO::EnsurePathExistsForFile( fileName ) );
+            AStackString<> contents;
+            contents.Format( "%u", i );
+            MakeFile( fileName.Get(), contents.Get() );
+        }
+        else
+        {
+            EnsureFileDoesNotExist( fileName );
+        }
+
+        // Path must be cleaned so it matches the node name
+        AStackString<> cleanFileName;
+        NodeGraph::CleanPath( fileName, cleanFileName );
+        FileNode * fileNode = ng.CreateNode< FileNode >( cleanFileName );
+        target.AddStaticDependency( fileNode );
+        fileNodes.Append( fileNode );
+    }
+
+    ThreadPool threadPool( 4 );
+    for ( uint32_t pass = 0; pass < 2; ++pass )
+    {
+        const bool useContentHash = ( pass == 1 );
+        NodeGraph::PrefetchFileStamps( &target, threadPool, false, useContentHash ); // forceCleanBuild
+
+        // Prefetched stamps match those obtained individually
+        for ( FileNode * fileNode : fileNodes )
+        {
+            PRAGMA_DISABLE_PUSH_MSVC(4946) // reinterpret_cast used between related classes
+            const FileNodeTestHelper * helper = reinterpret_cast<const FileNodeTestHelper *>( fileNode );
+            PRAGMA_DISABLE_POP_MSVC
+
+            uint64_t prefetchedStamp = 0;
+            TEST_ASSERT( helper->ConsumePrefetchedFileTime( prefetchedStamp ) );
+            TEST_ASSERT( prefetchedStamp == fileNode->ObtainStamp( useContentHash ) );
+            if ( useContentHash == false )
+            {
+                TEST_ASSERT( prefetchedStamp == FileIO::GetFileLastWriteTime( fileNode->GetName() ) );
+            }
+
+            // Only the first check can use the prefetched stamp
+            TEST_ASSERT( helper->ConsumePrefetchedFileTime( prefetchedStamp ) == false );
+        }
+        for ( uint32_t i = kNumFiles; i < fileNodes.GetSize(); ++i )
+        {
+            TEST_ASSERT( fileNodes[ i ]->ObtainStamp( useContentHash ) == 0 ); // Missing
+        }
+    }
+}
+
+// PrefetchFileStampsBuildDecisions
+//------------------------------------------------------------------------------
+void TestGraph::PrefetchFileStampsBuildDecisions() const
+{
+    // The same files are rebuilt whether or not stamps are prefetched
+    Array< AString > rebuiltWithPrefetch;
+    Array< AString > rebuiltWithoutPrefetch;
+    BuildWithModifiedFiles( true, rebuiltWithPrefetch );
+    BuildWithModifiedFiles( false, rebuiltWithoutPrefetch );
+    TEST_ASSERT( rebuiltWithPrefetch.GetSize() == rebuiltWithoutPrefetch.GetSize() );
+    for ( size_t i = 0; i < rebuiltWithPrefetch.GetSize(); ++i )
+    {
+        TEST_ASSERT( rebuiltWithPrefetch[ i ] == rebuiltWithoutPrefetch[ i ] );
+    }
+}
+
+// BuildWithModifiedFiles
+//------------------------------------------------------------------------------
+void TestGraph::BuildWithModifiedFiles( bool prefetchFileStamps, Array< AString > & outRebuiltFiles ) const
+{
+    const char * const dbFile = "../tmp/Test/Graph/PrefetchFileStamps/fbuild.fdb";
+    EnsureFileDoesNotExist( dbFile );
+
+    // Create enough files that several threads are used
+    const uint32_t kNumFiles = 150;
+    AStackString<> workingDir;
+    TEST_ASSERT( FileIO::GetCurrentDir( workingDir ) );
+    PathUtils::EnsureTrailingSlash( workingDir );
+    Array< AString > srcFiles( kNumFiles );
+    Array< AString > dstFiles( kNumFiles );
+    for ( uint32_t i = 0; i < kNumFiles; ++i )
+    {
+        AStackString<> srcFile;
+        AStackString<> dstFile;
+        srcFile.Format( "%s../tmp/Test/Graph/PrefetchFileStamps/src/file%03u.txt", workingDir.Get(), i );
+        dstFile.Format( "%s../tmp/Test/Graph/PrefetchFileStamps/dst/file%03u.txt", workingDir.Get(), i );
+        TEST_ASSERT( FileIO::EnsurePathExistsForFile( srcFile ) );
+        MakeFile( srcFile.Get(), "a" );
+        srcFiles.Append( srcFile ); // Full paths required by SetFileLastWriteTime
+        dstFiles.Append( dstFile );
+    }
+
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestGraph/PrefetchFileStamps/fbuild.bff";
+    options.m_PrefetchFileStamps = prefetchFileStamps;
+
+    // Initial build
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "Copy" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( dbFile ) );
+        CheckStatsNode( kNumFiles, kNumFiles, Node::COPY_FILE_NODE );
+    }
+
+    // Modify some inputs, and delete and modify some outputs
+    for ( uint32_t i = 0; i < 3; ++i )
+    {
+        const uint64_t time = FileIO::GetFileLastWriteTime( srcFiles[ i ] );
+        TEST_ASSERT( FileIO::SetFileLastWriteTime( srcFiles[ i ], time - ( 60 * 1000 * 1000 ) ) );
+    }
+    EnsureFileDoesNotExist( dstFiles[ 3 ] );
+    EnsureFileDoesNotExist( dstFiles[ 4 ] );
+    const uint64_t dstTime = FileIO::GetFileLastWriteTime( dstFiles[ 5 ] );
+    TEST_ASSERT( FileIO::SetFileLastWriteTime( dstFiles[ 5 ], dstTime - ( 60 * 1000 * 1000 ) ) );
+
+    // Only the affected files are rebuilt
+    {
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( dbFile ) );
+        TEST_ASSERT( fBuild.Build( "Copy" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( dbFile ) );
+        CheckStatsNode( kNumFiles, 6, Node::COPY_FILE_NODE );
+
+        Array< const Node * > nodes;
+        fBuild.GetNodesOfType( Node::COPY_FILE_NODE, nodes );
+        for ( const Node * node : nodes )
+        {
+            if ( node->GetStatFlag( Node::STATS_BUILT ) )
+            {
+                outRebuiltFiles.Append( node->GetName() );
+            }
+        }
+    }
+
+    // Nothing needs building
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( dbFile ) );
+        TEST_ASSERT( fBuild.Build( "Copy" ) );
+        CheckStatsNode( kNumFiles, 0, Node::COPY_FILE_NODE );
+    }
+}
+
 //------------------------------------------------------------------------------
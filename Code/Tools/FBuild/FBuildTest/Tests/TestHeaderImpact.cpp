@@ -0,0 +1,165 @@
+// TestHeaderImpact.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "FBuildTest.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/FBuild.h"
+#include "Tools/FBuild/FBuildCore/Helpers/HeaderImpact.h"
+
+// Core
+#include "Core/FileIO/FileIO.h"
+#include "Core/Process/ThreadPool.h"
+#include "Core/Strings/AStackString.h"
+
+// TestHeaderImpact
+//------------------------------------------------------------------------------
+class TestHeaderImpact : public FBuildTest
+{
+private:
+    DECLARE_TESTS
+
+    void Analyze() const;
+    void AnalyzeParallel() const;
+
+    void Build( FBuildForTest & fBuild ) const;
+    static const HeaderImpact::HeaderStats * FindHeader( const HeaderImpact & headerImpact, const char * fileName );
+};
+
+// Register Tests
+//------------------------------------------------------------------------------
+REGISTER_TESTS_BEGIN( TestHeaderImpact )
+    REGISTER_TEST( Analyze )
+    REGISTER_TEST( AnalyzeParallel )
+REGISTER_TESTS_END
+
+// Constants
+//------------------------------------------------------------------------------
+namespace
+{
+    const char * const kConfigFile  = "Tools/FBuild/FBuildTest/Data/TestHeaderImpact/fbuild.bff";
+    const char * const kInputPath   = "../tmp/Test/HeaderImpact/GeneratedInput/";
+    const uint32_t kNumExtraHeaders = 200; // Enough to use several threads
+}
+
+// Analyze
+//------------------------------------------------------------------------------
+void TestHeaderImpact::Analyze() const
+{
+    FBuildTestOptions options;
+    options.m_ConfigFile = kConfigFile;
+    options.m_ForceCleanBuild = true;
+    FBuildForTest fBuild( options );
+    Build( fBuild );
+
+    HeaderImpact headerImpact;
+    headerImpact.Analyze( fBuild.GetDependencyGraph(), nullptr );
+    TEST_ASSERT( headerImpact.GetNumObjects() == 3 );
+    TEST_ASSERT( headerImpact.GetTotalCompileTimeMS() > 0 );
+    TEST_ASSERT( headerImpact.GetHeaders().GetSize() == ( 3 + kNumExtraHeaders ) );
+
+    // Included by all objects, rebuilding the objects and everything using them
+    const HeaderImpact::HeaderStats * common = FindHeader( headerImpact, "common.h" );
+    TEST_ASSERT( common );
+    TEST_ASSERT( common->m_NumObjects == 3 );
+    TEST_ASSERT( common->m_CompileTimeMS == headerImpact.GetTotalCompileTimeMS() );
+    TEST_ASSERT( common->m_RebuildTimeMS >= common->m_CompileTimeMS );
+
+    // Included indirectly by all objects
+    const HeaderImpact::HeaderStats * leaf = FindHeader( headerImpact, "leaf.h" );
+    TEST_ASSERT( leaf );
+    TEST_ASSERT( leaf->m_NumObjects == 3 );
+    TEST_ASSERT( leaf->m_RebuildTimeMS == common->m_RebuildTimeMS );
+
+    // Included by one object
+    const HeaderImpact::HeaderStats * onlyA = FindHeader( headerImpact, "only_a.h" );
+    TEST_ASSERT( onlyA );
+    TEST_ASSERT( onlyA->m_NumObjects == 1 );
+    TEST_ASSERT( onlyA->m_NumDependents == ( common->m_NumDependents - 2 ) );
+    TEST_ASSERT( onlyA->m_CompileTimeMS < common->m_CompileTimeMS );
+
+    // Most expensive first
+    const Array< HeaderImpact::HeaderStats > & headers = headerImpact.GetHeaders();
+    for ( size_t i = 1; i < headers.GetSize(); ++i )
+    {
+        TEST_ASSERT( headers[ i - 1 ].m_RebuildTimeMS >= headers[ i ].m_RebuildTimeMS );
+    }
+}
+
+// AnalyzeParallel
+//------------------------------------------------------------------------------
+void TestHeaderImpact::AnalyzeParallel() const
+{
+    FBuildTestOptions options;
+    options.m_ConfigFile = kConfigFile;
+    options.m_ForceCleanBuild = true;
+    FBuildForTest fBuild( options );
+    Build( fBuild );
+
+    HeaderImpact serial;
+    serial.Analyze( fBuild.GetDependencyGraph(), nullptr );
+
+    // Results are the same when headers are analyzed on several threads
+    ThreadPool threadPool( 4 );
+    HeaderImpact parallel;
+    parallel.Analyze( fBuild.GetDependencyGraph(), &threadPool );
+    TEST_ASSERT( parallel.GetNumObjects() == serial.GetNumObjects() );
+    TEST_ASSERT( parallel.GetHeaders().GetSize() == serial.GetHeaders().GetSize() );
+    for ( const HeaderImpact::HeaderStats & stats : serial.GetHeaders() )
+    {
+        const HeaderImpact::HeaderStats * other = FindHeader( parallel, stats.m_Header->GetName().Get() );
+        TEST_ASSERT( other );
+        TEST_ASSERT( other->m_NumObjects == stats.m_NumObjects );
+        TEST_ASSERT( other->m_NumDependents == stats.m_NumDependents );
+        TEST_ASSERT( other->m_CompileTimeMS == stats.m_CompileTimeMS );
+        TEST_ASSERT( other->m_RebuildTimeMS == stats.m_RebuildTimeMS );
+    }
+}
+
+// Build
+//------------------------------------------------------------------------------
+void TestHeaderImpact::Build( FBuildForTest & fBuild ) const
+{
+    // Generate sources
+    //  - common.h (which includes leaf.h) is used by all objects
+    //  - only_a.h and many extra headers are used by a.cpp only
+    TEST_ASSERT( FileIO::EnsurePathExists( AStackString<>( kInputPath ) ) );
+    AStackString<> fileName;
+    AString aSource( "#include \"common.h\"\n#include \"only_a.h\"\n" );
+    for ( uint32_t i = 0; i < kNumExtraHeaders; ++i )
+    {
+        fileName.Format( "%sextra%03u.h", kInputPath, i );
+        AStackString<> contents;
+        contents.Format( "#pragma once\nint Extra%03u();\n", i );
+        MakeFile( fileName.Get(), contents.Get() );
+        aSource.AppendFormat( "#include \"extra%03u.h\"\n", i );
+    }
+    aSource += "int A() { return COMMON + LEAF; }\n";
+    MakeFile( "../tmp/Test/HeaderImpact/GeneratedInput/leaf.h", "#pragma once\n#define LEAF 1\n" );
+    MakeFile( "../tmp/Test/HeaderImpact/GeneratedInput/common.h", "#pragma once\n#include \"leaf.h\"\n#define COMMON 1\n" );
+    MakeFile( "../tmp/Test/HeaderImpact/GeneratedInput/only_a.h", "#pragma once\nint OnlyA();\n" );
+    MakeFile( "../tmp/Test/HeaderImpact/GeneratedInput/a.cpp", aSource.Get() );
+    MakeFile( "../tmp/Test/HeaderImpact/GeneratedInput/b.cpp", "#include \"common.h\"\nint B() { return COMMON; }\n" );
+    MakeFile( "../tmp/Test/HeaderImpact/GeneratedInput/c.cpp", "#include \"common.h\"\nint C() { return COMMON; }\n" );
+
+    TEST_ASSERT( fBuild.Initialize() );
+    TEST_ASSERT( fBuild.Build( "Lib" ) );
+}
+
+// FindHeader
+//------------------------------------------------------------------------------
+/*static*/ const HeaderImpact::HeaderStats * TestHeaderImpact::FindHeader( const HeaderImpact & headerImpact, const char * fileName )
+{
+    for ( const HeaderImpact::HeaderStats & stats : headerImpact.GetHeaders() )
+    {
+        if ( stats.m_Header->GetName().EndsWith( fileName ) )
+        {
+            return &stats;
+        }
+    }
+    return nullptr;
+}
+
+//------------------------------------------------------------------------------
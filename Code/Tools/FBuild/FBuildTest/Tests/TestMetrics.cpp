@@ -0,0 +1,226 @@
+// TestMetrics.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "FBuildTest.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/FBuild.h"
+#include "Tools/FBuild/FBuildCore/Helpers/Metrics.h"
+#include "Tools/FBuild/FBuildCore/Protocol/Protocol.h"
+
+// FBuildCoordinator
+#include "Tools/FBuild/FBuildCoordinator/Coordinator/Coordinator.h"
+#include "Tools/FBuild/FBuildCoordinator/FBuildCoordinatorOptions.h"
+
+// Core
+#include "Core/Network/TCPConnectionPool.h"
+#include "Core/Process/Mutex.h"
+#include "Core/Process/Semaphore.h"
+#include "Core/Process/Thread.h"
+#include "Core/Strings/AStackString.h"
+#include "Core/Time/Timer.h"
+
+// TestMetrics
+//------------------------------------------------------------------------------
+class TestMetrics : public FBuildTest
+{
+private:
+    DECLARE_TESTS
+
+    void Format() const;
+    void Scrape() const;
+    void NotFound() const;
+    void CoordinatorScrape() const;
+
+    // Helpers
+    static bool HTTPGet( const char * path, AString & outResponse );
+};
+
+// Register Tests
+//------------------------------------------------------------------------------
+REGISTER_TESTS_BEGIN( TestMetrics )
+    REGISTER_TEST( Format )
+    REGISTER_TEST( Scrape )
+    REGISTER_TEST( NotFound )
+    REGISTER_TEST( CoordinatorScrape )
+REGISTER_TESTS_END
+
+// Constants
+//------------------------------------------------------------------------------
+namespace
+{
+    const char * const kConfigFile  = "Tools/FBuild/FBuildTest/Data/TestMetrics/fbuild.bff";
+    const char * const kDestFile    = "../tmp/Test/Metrics/copy.bff";
+    const uint16_t kMetricsPort     = ( Protocol::PROTOCOL_TEST_PORT + 1 ); // Not used by other tests
+}
+
+// Format
+//------------------------------------------------------------------------------
+void TestMetrics::Format() const
+{
+    // Histogram buckets are reported cumulatively
+    MetricHistogram histogram( "test_duration_seconds", "Test durations." );
+    histogram.Observe( 1 );
+    histogram.Observe( 7 );
+    histogram.Observe( 100000 );
+    TEST_ASSERT( histogram.GetCount() == 3 );
+
+    AString text;
+    histogram.Format( text );
+    TEST_ASSERT( text.Find( "# TYPE test_duration_seconds histogram\n" ) );
+    TEST_ASSERT( text.Find( "test_duration_seconds_bucket{le=\"0.005\"} 1\n" ) );
+    TEST_ASSERT( text.Find( "test_duration_seconds_bucket{le=\"0.010\"} 2\n" ) );
+    TEST_ASSERT( text.Find( "test_duration_seconds_bucket{le=\"60.000\"} 2\n" ) );
+    TEST_ASSERT( text.Find( "test_duration_seconds_bucket{le=\"+Inf\"} 3\n" ) );
+    TEST_ASSERT( text.Find( "test_duration_seconds_sum 100.008\n" ) );
+    TEST_ASSERT( text.Find( "test_duration_seconds_count 3\n" ) );
+
+    // Counters
+    MetricCounter counter( "test_total", "Test counter." );
+    counter.Add();
+    counter.Add( 2 );
+    text.Clear();
+    counter.Format( text );
+    TEST_ASSERT( text == "# HELP test_total Test counter.\n"
+                         "# TYPE test_total counter\n"
+                         "test_total 3\n" );
+}
+
+// Scrape
+//------------------------------------------------------------------------------
+void TestMetrics::Scrape() const
+{
+    EnsureFileDoesNotExist( kDestFile );
+
+    FBuildTestOptions options;
+    options.m_ConfigFile = kConfigFile;
+    options.m_MetricsPort = kMetricsPort;
+    options.m_ForceCleanBuild = true;
+    FBuild fBuild( options );
+    TEST_ASSERT( fBuild.Initialize() );
+
+    const uint64_t succeededBefore = Metrics::s_JobsSucceeded.Get();
+    const uint64_t durationsBefore = Metrics::s_JobDuration.GetCount();
+    TEST_ASSERT( fBuild.Build( "Copy" ) );
+    EnsureFileExists( kDestFile );
+
+    // Metrics are maintained for the job
+    const uint64_t succeeded = Metrics::s_JobsSucceeded.Get();
+    TEST_ASSERT( succeeded > succeededBefore );
+    TEST_ASSERT( Metrics::s_JobDuration.GetCount() > durationsBefore );
+    TEST_ASSERT( Metrics::s_JobsActive.Get() == 0 );
+
+    // Metrics can be scraped while FBuild is alive
+    AString response;
+    TEST_ASSERT( HTTPGet( "/metrics", response ) );
+    TEST_ASSERT( response.BeginsWith( "HTTP/1.0 200 OK\r\n" ) );
+    TEST_ASSERT( response.Find( "Content-Type: text/plain; version=0.0.4\r\n" ) );
+    AStackString<> expected;
+    expected.Format( "\nfastbuild_jobs_succeeded_total %" PRIu64 "\n", succeeded );
+    TEST_ASSERT( response.Find( expected ) );
+    TEST_ASSERT( response.Find( "# TYPE fastbuild_job_duration_seconds histogram\n" ) );
+    TEST_ASSERT( response.Find( "# TYPE fastbuild_cache_hits_total counter\n" ) );
+    TEST_ASSERT( response.Find( "# TYPE fastbuild_server_connections gauge\n" ) );
+
+    // Body length matches the header
+    const char * body = response.Find( "\r\n\r\n" );
+    TEST_ASSERT( body );
+    body += 4;
+    expected.Format( "Content-Length: %u\r\n", (uint32_t)( response.GetEnd() - body ) );
+    TEST_ASSERT( response.Find( expected ) );
+}
+
+// NotFound
+//------------------------------------------------------------------------------
+void TestMetrics::NotFound() const
+{
+    FBuildTestOptions options;
+    options.m_ConfigFile = kConfigFile;
+    options.m_MetricsPort = kMetricsPort;
+    const FBuild fBuild( options );
+
+    // Only metrics are served
+    AString response;
+    TEST_ASSERT( HTTPGet( "/other", response ) );
+    TEST_ASSERT( response.BeginsWith( "HTTP/1.0 404 Not Found\r\n" ) );
+}
+
+// CoordinatorScrape
+//------------------------------------------------------------------------------
+void TestMetrics::CoordinatorScrape() const
+{
+    // Port is taken from the command line
+    AStackString<> args;
+    args.Format( "-metricsport=%u", (uint32_t)kMetricsPort );
+    FBuildCoordinatorOptions options;
+    TEST_ASSERT( options.ProcessCommandLine( args ) );
+    TEST_ASSERT( options.m_MetricsPort == kMetricsPort );
+
+    Coordinator coordinator( args );
+    coordinator.StartMetricsServer( options.m_MetricsPort );
+
+    // Coordinator specific metrics are served
+    AString response;
+    TEST_ASSERT( HTTPGet( "/metrics", response ) );
+    TEST_ASSERT( response.BeginsWith( "HTTP/1.0 200 OK\r\n" ) );
+    TEST_ASSERT( response.Find( "# TYPE fastbuild_coordinator_workers gauge\n" ) );
+    TEST_ASSERT( response.Find( "# TYPE fastbuild_coordinator_worker_list_requests_total counter\n" ) );
+}
+
+// HTTPGet
+//------------------------------------------------------------------------------
+/*static*/ bool TestMetrics::HTTPGet( const char * path, AString & outResponse )
+{
+    // Accumulate the response until the server closes the connection
+    class HTTPClient : public TCPConnectionPool
+    {
+    public:
+        HTTPClient() { SetRawMode( true ); }
+        virtual ~HTTPClient() override { ShutdownAllConnections(); }
+
+        virtual void OnReceive( const ConnectionInfo *, void * data, uint32_t size, bool & ) override
+        {
+            MutexHolder mh( m_Mutex );
+            m_Response.Append( static_cast< const char * >( data ), size );
+        }
+        virtual void OnDisconnected( const ConnectionInfo * ) override
+        {
+            m_Completed.Signal();
+        }
+
+        Mutex       m_Mutex;
+        AString     m_Response;
+        Semaphore   m_Completed;
+    };
+
+    HTTPClient client;
+    const ConnectionInfo * connection = nullptr;
+    const Timer t;
+    while ( ( connection = client.Connect( AStackString<>( "127.0.0.1" ), kMetricsPort ) ) == nullptr )
+    {
+        if ( t.GetElapsed() > 5.0f )
+        {
+            return false;
+        }
+        Thread::Sleep( 50 );
+    }
+
+    AStackString<> request;
+    request.Format( "GET %s HTTP/1.0\r\nHost: 127.0.0.1\r\n\r\n", path );
+    if ( client.SendRaw( connection, request.Get(), request.GetLength() ) == false )
+    {
+        return false;
+    }
+    if ( client.m_Completed.Wait( 10 * 1000 ) == false )
+    {
+        return false;
+    }
+
+    MutexHolder mh( client.m_Mutex );
+    outResponse = client.m_Response;
+    return true;
+}
+
+//------------------------------------------------------------------------------
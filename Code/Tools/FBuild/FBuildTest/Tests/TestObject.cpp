@@ -33,6 +33,8 @@ private:
     void TestStaleDynamicDeps() const;
     void ModTimeChangeBackwards() const;
     void CacheUsingRelativePaths() const;
+    void CacheUsingNormalizedPaths() const;
+    void NormalizedPathsExcludeRoot() const;
     void SourceMapping() const;
     void ClangExplicitLanguageType() const;
     void ClangDependencyArgs() const;
@@ -46,6 +48,10 @@ REGISTER_TESTS_BEGIN( TestObject )
     REGISTER_TEST( Preprocessor )
     REGISTER_TEST( TestStaleDynamicDeps )       // Test dynamic deps are cleared when necessary
     REGISTER_TEST( ModTimeChangeBackwards )
+    REGISTER_TEST( CacheUsingNormalizedPaths )
+    #if !defined( __WINDOWS__ ) // TODO:C Check Windows, where __FILE__ separators vary
+        REGISTER_TEST( NormalizedPathsExcludeRoot )
+    #endif
     REGISTER_TEST( CacheUsingRelativePaths )
     REGISTER_TEST( SourceMapping )
     REGISTER_TEST( ClangExplicitLanguageType )
@@ -431,6 +437,167 @@ void TestObject::CacheUsingRelativePaths() const
     }
 }
 
+// CacheUsingNormalizedPaths
+//------------------------------------------------------------------------------
+void TestObject::CacheUsingNormalizedPaths() const
+{
+    // Source files
+    const char * srcPath = "Tools/FBuild/FBuildTest/Data/TestObject/CacheUsingNormalizedPaths/";
+    const char * fileA = "File.cpp";
+    const char * fileB = "Subdir/Header.h";
+    const char * fileC = "fbuild.bff";
+    const char * files[] = { fileA, fileB, fileC };
+
+    // Dest paths
+    const char * dstPathA = "../tmp/Test/Object/CacheUsingNormalizedPaths/A/Code";
+    const char * dstPathB = "../tmp/Test/Object/CacheUsingNormalizedPaths/B/Code";
+    const char * dstPaths[] = { dstPathA, dstPathB };
+
+    #if defined( __WINDOWS__ )
+        const char * objFileA = "../tmp/Test/Object/CacheUsingNormalizedPaths/A/Code/out/File.obj";
+    #else
+        const char * objFileA = "../tmp/Test/Object/CacheUsingNormalizedPaths/A/Code/out/File.o";
+    #endif
+
+    // Copy file structure to both destinations
+    for ( const char * dstPath : dstPaths )
+    {
+        for ( const char * file : files )
+        {
+            AStackString<> src, dst;
+            src.Format( "%s/%s", srcPath, file );
+            dst.Format( "%s/%s", dstPath, file );
+            TEST_ASSERT( FileIO::EnsurePathExistsForFile( dst ) );
+            TEST_ASSERT( FileIO::FileCopy( src.Get(), dst.Get() ) );
+        }
+    }
+
+    // Build in path A, writing to the cache
+    {
+        // Init
+        FBuildTestOptions options;
+        options.m_ConfigFile = "fbuild.bff";
+        options.m_UseCacheWrite = true;
+        AStackString<> codeDir;
+        GetCodeDir( codeDir );
+        codeDir.Trim( 0, 5 ); // Remove Code/
+        codeDir += "tmp/Test/Object/CacheUsingNormalizedPaths/A/Code/";
+        options.SetWorkingDir( codeDir );
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+
+        // Compile
+        TEST_ASSERT( fBuild.Build( AStackString<>( "ObjectList" ) ) );
+
+        TEST_ASSERT( fBuild.GetStats().GetCacheStores() == 1 );
+    }
+
+    // Check __FILE__ paths in the object file don't contain the workspace root
+    #if !defined( __WINDOWS__ ) // TODO:C Check Windows, where __FILE__ separators vary
+    {
+        // Read obj file into memory
+        AString buffer;
+        {
+            FileStream f;
+            TEST_ASSERT( f.Open( objFileA ) );
+            buffer.SetLength( (uint32_t)f.GetFileSize() );
+            TEST_ASSERT( f.ReadBuffer( buffer.Get(), f.GetFileSize() ) == f.GetFileSize() );
+            buffer.Replace( (char)0, ' ' ); // Make string searches simpler
+        }
+
+        TEST_ASSERT( buffer.Find( "FILE_MACRO_START_1(./Subdir/Header.h)FILE_MACRO_END_1" ) );
+        TEST_ASSERT( buffer.Find( "FILE_MACRO_START_2(./File.cpp)FILE_MACRO_END_2" ) );
+    }
+    #else
+        (void)objFileA;
+    #endif
+
+    // Build in path B, reading from the cache
+    {
+        // Init
+        FBuildTestOptions options;
+        options.m_ConfigFile = "fbuild.bff";
+        options.m_UseCacheRead = true;
+        AStackString<> codeDir;
+        GetCodeDir( codeDir );
+        codeDir.Trim( 0, 5 ); // Remove Code/
+        codeDir += "tmp/Test/Object/CacheUsingNormalizedPaths/B/Code/";
+        options.SetWorkingDir( codeDir );
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+
+        // Compile
+        TEST_ASSERT( fBuild.Build( AStackString<>( "ObjectList" ) ) );
+
+        TEST_ASSERT( fBuild.GetStats().GetCacheHits() == 1 );
+    }
+}
+
+// NormalizedPathsExcludeRoot
+//------------------------------------------------------------------------------
+void TestObject::NormalizedPathsExcludeRoot() const
+{
+    // Source files
+    const char * srcPath = "Tools/FBuild/FBuildTest/Data/TestObject/CacheUsingNormalizedPaths/";
+    const char * files[] = { "File.cpp", "Subdir/Header.h", "fbuild.bff" };
+
+    // Build the same source in two workspaces, without the cache, so each
+    // object is compiled in its own workspace
+    const char * workspaces[] = { "A", "B" };
+    Array< AString > roots;
+    for ( const char * workspace : workspaces )
+    {
+        // Copy file structure
+        for ( const char * file : files )
+        {
+            AStackString<> src, dst;
+            src.Format( "%s/%s", srcPath, file );
+            dst.Format( "../tmp/Test/Object/NormalizedPathsExcludeRoot/%s/Code/%s", workspace, file );
+            TEST_ASSERT( FileIO::EnsurePathExistsForFile( dst ) );
+            TEST_ASSERT( FileIO::FileCopy( src.Get(), dst.Get() ) );
+        }
+
+        // Init
+        FBuildTestOptions options;
+        options.m_ConfigFile = "fbuild.bff";
+        options.m_ForceCleanBuild = true;
+        AStackString<> codeDir;
+        GetCodeDir( codeDir );
+        codeDir.Trim( 0, 5 ); // Remove Code/
+        codeDir.AppendFormat( "tmp/Test/Object/NormalizedPathsExcludeRoot/%s/Code", workspace );
+        roots.Append( codeDir );
+        codeDir += '/';
+        options.SetWorkingDir( codeDir );
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+
+        // Compile
+        TEST_ASSERT( fBuild.Build( AStackString<>( "ObjectList" ) ) );
+    }
+
+    // Neither object contains either root (including the compilation dir
+    // in the debug info, which is the root itself)
+    for ( const char * workspace : workspaces )
+    {
+        // Read obj file into memory
+        AString buffer;
+        {
+            AStackString<> objFile;
+            objFile.Format( "../tmp/Test/Object/NormalizedPathsExcludeRoot/%s/Code/out/File.o", workspace );
+            FileStream f;
+            TEST_ASSERT( f.Open( objFile.Get() ) );
+            buffer.SetLength( (uint32_t)f.GetFileSize() );
+            TEST_ASSERT( f.ReadBuffer( buffer.Get(), f.GetFileSize() ) == f.GetFileSize() );
+            buffer.Replace( (char)0, ' ' ); // Make string searches simpler
+        }
+
+        for ( const AString & root : roots )
+        {
+            TEST_ASSERT( buffer.Find( root ) == nullptr );
+        }
+    }
+}
+
 // SourceMapping
 //------------------------------------------------------------------------------
 void TestObject::SourceMapping() const
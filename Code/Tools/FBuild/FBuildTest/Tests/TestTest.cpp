@@ -11,6 +11,7 @@
 #include "Tools/FBuild/FBuildCore/Graph/TestNode.h"
 
 #include "Core/FileIO/FileIO.h"
+#include "Core/FileIO/PathUtils.h"
 #include "Core/Strings/AStackString.h"
 
 // TestTest
@@ -26,6 +27,10 @@ private:
     void Fail_Crash() const;
     void TimeOut() const;
     void Exclusions() const;
+    void Shards() const;
+
+    // Helpers
+    static const TestNode * GetTestNode( const FBuildForTest & fBuild, const char * alias );
 };
 
 // Register Tests
@@ -37,6 +42,7 @@ REGISTER_TESTS_BEGIN( TestTest )
     REGISTER_TEST( Fail_Crash )
     REGISTER_TEST( TimeOut )
     REGISTER_TEST( Exclusions )
+    REGISTER_TEST( Shards )
 REGISTER_TESTS_END
 
 // Build
@@ -185,4 +191,98 @@ void TestTest::Exclusions() const
     }
 }
 
+// Shards
+//------------------------------------------------------------------------------
+void TestTest::Shards() const
+{
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestTest/Shards/fbuild.bff";
+    const char * const dbFile = "../tmp/Test/Test/Shards/fbuild.fdb";
+    const char * const inputFile = "../tmp/Test/Test/Shards/input.txt";
+    TEST_ASSERT( FileIO::EnsurePathExistsForFile( AStackString<>( inputFile ) ) );
+    MakeFile( inputFile, "a" );
+
+    // Initial build
+    {
+        options.m_ForceCleanBuild = true;
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "Test" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( dbFile ) );
+
+        // Shards are passed via the environment, with output merged in order
+        TEST_ASSERT( GetTestNode( fBuild, "ShardsEnv" )->GetNumShardsRun() == 4 );
+        AString output;
+        LoadFileContentsAsString( "../tmp/Test/Test/Shards/env.txt", output );
+        output.Replace( "\r", "" ); // Normalize line endings
+        TEST_ASSERT( output == "[==== Shard 0/4 ====]\nEnv 0/4\n"
+                               "[==== Shard 1/4 ====]\nEnv 1/4\n"
+                               "[==== Shard 2/4 ====]\nEnv 2/4\n"
+                               "[==== Shard 3/4 ====]\nEnv 3/4\n" );
+
+        // Or via arguments
+        TEST_ASSERT( GetTestNode( fBuild, "ShardsArgs" )->GetNumShardsRun() == 3 );
+        LoadFileContentsAsString( "../tmp/Test/Test/Shards/args.txt", output );
+        output.Replace( "\r", "" ); // Normalize line endings
+        TEST_ASSERT( output.Find( "[==== Shard 1/3 ====]\nEnv -/-\nArg -verbose\nArg -shard=1/3\n" ) );
+        TEST_ASSERT( output.Find( "Arg -shard=2/3" ) );
+        TEST_ASSERT( output.Find( "Arg -shard=3/3" ) == nullptr );
+
+        TEST_ASSERT( GetTestNode( fBuild, "Cached" )->GetNumShardsRun() == 2 );
+
+        // Shards don't exceed the ConcurrencyGroup limit
+        TEST_ASSERT( GetTestNode( fBuild, "Limited" )->GetNumShardsRun() == 4 );
+        TEST_ASSERT( GetTestNode( fBuild, "Limited" )->GetMaxShardsRunConcurrently() == 1 );
+    }
+
+    // Shards don't exceed the worker thread count
+    {
+        FBuildTestOptions twoThreadOptions( options );
+        twoThreadOptions.m_NumWorkerThreads = 2;
+        FBuildForTest fBuild( twoThreadOptions );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ShardsEnv" ) );
+        TEST_ASSERT( GetTestNode( fBuild, "ShardsEnv" )->GetNumShardsRun() == 4 );
+        TEST_ASSERT( GetTestNode( fBuild, "ShardsEnv" )->GetMaxShardsRunConcurrently() <= 2 );
+    }
+
+    // Change the time of the input without changing the contents
+    AStackString<> input;
+    TEST_ASSERT( FileIO::GetCurrentDir( input ) );
+    PathUtils::EnsureTrailingSlash( input );
+    input += inputFile; // Full path required by SetFileLastWriteTime
+    const uint64_t originalTime = FileIO::GetFileLastWriteTime( input );
+    TEST_ASSERT( FileIO::SetFileLastWriteTime( input, originalTime - ( 60 * 1000 * 1000 ) ) );
+
+    // Test is not run again
+    options.m_ForceCleanBuild = false;
+    {
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( dbFile ) );
+        TEST_ASSERT( fBuild.Build( "Cached" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( dbFile ) );
+        TEST_ASSERT( GetTestNode( fBuild, "Cached" )->GetNumShardsRun() == 0 );
+    }
+
+    // Modify the input
+    MakeFile( inputFile, "b" );
+
+    // Test is run again
+    {
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( dbFile ) );
+        TEST_ASSERT( fBuild.Build( "Cached" ) );
+        TEST_ASSERT( GetTestNode( fBuild, "Cached" )->GetNumShardsRun() == 2 );
+    }
+}
+
+// GetTestNode
+//------------------------------------------------------------------------------
+/*static*/ const TestNode * TestTest::GetTestNode( const FBuildForTest & fBuild, const char * alias )
+{
+    const Node * aliasNode = fBuild.GetNode( alias );
+    TEST_ASSERT( aliasNode );
+    return aliasNode->GetStaticDependencies()[ 0 ].GetNode()->CastTo< TestNode >();
+}
+
 //------------------------------------------------------------------------------
@@ -13,8 +13,13 @@
 // Core
 #include "Core/FileIO/FileIO.h"
 #include "Core/FileIO/FileStream.h"
+#include "Core/FileIO/PathUtils.h"
+#include "Core/Math/Conversions.h"
+#include "Core/Math/Random.h"
 #include "Core/Process/Thread.h"
 #include "Core/Strings/AStackString.h"
+#include "Core/Time/Timer.h"
+#include "Core/Tracing/Tracing.h"
 
 // TestUnity
 //------------------------------------------------------------------------------
@@ -49,6 +54,12 @@ private:
     void SortFiles() const;
     void CacheUsingRelativePaths() const;
     void NoUnityCommandLineOption() const;
+    void BalanceByCost() const;
+    void BalanceByCost_Makespan() const;
+    void IsolateChangedFiles() const;
+
+    // Helpers
+    static uint64_t GetMakespan( const Array< uint64_t > & costs, const Array< uint32_t > & unityIndices, uint32_t numUnityFiles );
 };
 
 // Register Tests
@@ -73,6 +84,9 @@ REGISTER_TESTS_BEGIN( TestUnity )
     REGISTER_TEST( SortFiles )
     REGISTER_TEST( CacheUsingRelativePaths )
     REGISTER_TEST( NoUnityCommandLineOption )
+    REGISTER_TEST( BalanceByCost )
+    REGISTER_TEST( BalanceByCost_Makespan )
+    REGISTER_TEST( IsolateChangedFiles )
 REGISTER_TESTS_END
 
 // BuildGenerate
@@ -1081,4 +1095,317 @@ void TestUnity::NoUnityCommandLineOption() const
     }
 }
 
+// BalanceByCost
+//------------------------------------------------------------------------------
+void TestUnity::BalanceByCost() const
+{
+    //
+    // Files are distributed by cost and remain in their unity file when other
+    // files are added
+    //
+    const char * const dbFile = "../tmp/Test/Unity/BalanceByCost/fbuild.fdb";
+    const char * const unity1 = "../tmp/Test/Unity/BalanceByCost/Unity1.cpp";
+    const char * const unity2 = "../tmp/Test/Unity/BalanceByCost/Unity2.cpp";
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestUnity/BalanceByCost/fbuild.bff";
+
+    // One large file and several small ones
+    TEST_ASSERT( FileIO::EnsurePathExists( AStackString<>( "../tmp/Test/Unity/BalanceByCost/Input/Sub/" ) ) );
+    EnsureFileDoesNotExist( "../tmp/Test/Unity/BalanceByCost/Input/Sub/e.cpp" );
+    AString bigFile;
+    for ( uint32_t i = 0; i < 1000; ++i )
+    {
+        bigFile.AppendFormat( "int Big%u() { return %u; }\n", i, i );
+    }
+    MakeFile( "../tmp/Test/Unity/BalanceByCost/Input/big.cpp", bigFile.Get() );
+    MakeFile( "../tmp/Test/Unity/BalanceByCost/Input/a.cpp", "int A() { return 0; }\n" );
+    MakeFile( "../tmp/Test/Unity/BalanceByCost/Input/b.cpp", "int B() { return 0; }\n" );
+    MakeFile( "../tmp/Test/Unity/BalanceByCost/Input/c.cpp", "int C() { return 0; }\n" );
+    MakeFile( "../tmp/Test/Unity/BalanceByCost/Input/d.cpp", "int D() { return 0; }\n" );
+
+    // Large file is given a unity file of its own (by count, it would share)
+    AString unity1Contents;
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "Unity" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( dbFile ) );
+
+        LoadFileContentsAsString( unity1, unity1Contents );
+        TEST_ASSERT( unity1Contents.Find( "big.cpp" ) );
+        TEST_ASSERT( unity1Contents.Find( "a.cpp" ) == nullptr );
+
+        AString unity2Contents;
+        LoadFileContentsAsString( unity2, unity2Contents );
+        TEST_ASSERT( unity2Contents.Find( "a.cpp" ) );
+        TEST_ASSERT( unity2Contents.Find( "d.cpp" ) );
+    }
+
+    // Add a file which (by count) would shift other files between unity files
+    MakeFile( "../tmp/Test/Unity/BalanceByCost/Input/aa.cpp", "int AA() { return 0; }\n" );
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( dbFile ) );
+        TEST_ASSERT( fBuild.Build( "Unity" ) );
+
+        // Existing assignments are preserved and the new file is balanced
+        AString contents;
+        LoadFileContentsAsString( unity1, contents );
+        TEST_ASSERT( contents == unity1Contents );
+        LoadFileContentsAsString( unity2, contents );
+        TEST_ASSERT( contents.Find( "aa.cpp" ) );
+    }
+
+    // Modifying a file doesn't change its directory, so the listing from the
+    // previous build is re-used when another directory changes. The new size
+    // of the file must still be used.
+    {
+        // Move time of directory into the past so the listing is trusted
+        // (full path is needed to modify directory times)
+        AStackString<> inputPath;
+        TEST_ASSERT( FileIO::GetCurrentDir( inputPath ) );
+        PathUtils::EnsureTrailingSlash( inputPath );
+        inputPath += "../tmp/Test/Unity/BalanceByCost/Input/";
+        PathUtils::FixupFolderPath( inputPath );
+        #if defined( __WINDOWS__ )
+            const uint64_t oneHour = ( 60ULL * 60ULL * 10000000ULL ); // 100ns units
+        #else
+            const uint64_t oneHour = ( 60ULL * 60ULL * 1000000000ULL ); // ns
+        #endif
+        TEST_ASSERT( FileIO::SetFileLastWriteTime( inputPath, FileIO::GetFileLastWriteTime( inputPath ) - oneHour ) );
+
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( dbFile ) );
+        TEST_ASSERT( fBuild.Build( "Unity" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( dbFile ) );
+    }
+    AString hugeFile;
+    for ( uint32_t i = 0; i < 3000; ++i )
+    {
+        hugeFile.AppendFormat( "int B%u() { return %u; }\n", i, i );
+    }
+    MakeFile( "../tmp/Test/Unity/BalanceByCost/Input/b.cpp", hugeFile.Get() );
+    MakeFile( "../tmp/Test/Unity/BalanceByCost/Input/Sub/e.cpp", "int E() { return 0; }\n" );
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( dbFile ) );
+        TEST_ASSERT( fBuild.Build( "Unity" ) );
+
+        // Unity file containing the now huge file is over-full, so the small
+        // files move to the other one
+        AString contents;
+        LoadFileContentsAsString( unity1, contents );
+        TEST_ASSERT( contents.Find( "big.cpp" ) );
+        TEST_ASSERT( contents.Find( "a.cpp" ) );
+        LoadFileContentsAsString( unity2, contents );
+        TEST_ASSERT( contents.Find( "b.cpp" ) );
+        TEST_ASSERT( contents.Find( "a.cpp" ) == nullptr );
+    }
+}
+
+// BalanceByCost_Makespan
+//------------------------------------------------------------------------------
+void TestUnity::BalanceByCost_Makespan() const
+{
+    //
+    // Compare the makespan (cost of the most expensive unity file) when
+    // distributing by count vs by cost, for a skewed set of file costs
+    //
+    const uint32_t numFiles = 512;
+    const uint32_t numUnityFiles = 16;
+
+    // Most files are cheap, some are very expensive
+    Random r( 12345 ); // Deterministic
+    Array< uint64_t > costs( numFiles );
+    for ( uint32_t i = 0; i < numFiles; ++i )
+    {
+        uint64_t cost = ( 50 + r.GetRandIndex( 200 ) );
+        if ( r.GetRandIndex( 20 ) == 0 )
+        {
+            cost *= 30;
+        }
+        costs.Append( cost );
+    }
+
+    // By count
+    Array< uint32_t > byCount;
+    UnityNode::AssignFilesByCount( numFiles, numUnityFiles, byCount );
+    const uint64_t makespanByCount = GetMakespan( costs, byCount, numUnityFiles );
+
+    // By cost
+    Array< uint32_t > noPrevious( numFiles );
+    for ( uint32_t i = 0; i < numFiles; ++i )
+    {
+        noPrevious.Append( (uint32_t)UnityNode::NO_UNITY_INDEX );
+    }
+    Array< uint32_t > byCost;
+    const Timer t;
+    const uint32_t numRepeats = 100;
+    for ( uint32_t i = 0; i < numRepeats; ++i )
+    {
+        byCost.Clear();
+        UnityNode::AssignFilesByCost( costs, noPrevious, numUnityFiles, byCost );
+    }
+    const float timeMS = ( t.GetElapsedMS() / (float)numRepeats );
+    const uint64_t makespanByCost = GetMakespan( costs, byCost, numUnityFiles );
+
+    uint64_t totalCost = 0;
+    for ( const uint64_t cost : costs )
+    {
+        totalCost += cost;
+    }
+    const uint64_t ideal = ( totalCost / numUnityFiles );
+    OUTPUT( "Files: %u, Unity files: %u, Ideal makespan: %" PRIu64 "\n", numFiles, numUnityFiles, ideal );
+    OUTPUT( "By count  : %" PRIu64 "\n", makespanByCount );
+    OUTPUT( "By cost   : %" PRIu64 " (%2.3fms)\n", makespanByCost, (double)timeMS );
+    TEST_ASSERT( makespanByCost <= makespanByCount );
+
+    // Insert some files near the start, as adding files to a directory often would
+    Array< uint64_t > newCosts( numFiles + 4 );
+    Array< uint32_t > previous( numFiles + 4 );
+    for ( uint32_t i = 0; i < 4; ++i )
+    {
+        newCosts.Append( 100 );
+        previous.Append( (uint32_t)UnityNode::NO_UNITY_INDEX );
+    }
+    for ( uint32_t i = 0; i < numFiles; ++i )
+    {
+        newCosts.Append( costs[ i ] );
+        previous.Append( byCost[ i ] );
+    }
+    Array< uint32_t > newByCount;
+    UnityNode::AssignFilesByCount( numFiles + 4, numUnityFiles, newByCount );
+    Array< uint32_t > newByCost;
+    UnityNode::AssignFilesByCost( newCosts, previous, numUnityFiles, newByCost );
+
+    // Count how many of the original files changed unity file
+    uint32_t movedByCount = 0;
+    uint32_t movedByCost = 0;
+    for ( uint32_t i = 0; i < numFiles; ++i )
+    {
+        movedByCount += ( newByCount[ i + 4 ] != byCount[ i ] ) ? 1u : 0u;
+        movedByCost += ( newByCost[ i + 4 ] != byCost[ i ] ) ? 1u : 0u;
+    }
+    OUTPUT( "Files moved after adding 4 files - By count: %u, By cost: %u\n", movedByCount, movedByCost );
+    TEST_ASSERT( movedByCost <= movedByCount );
+}
+
+// IsolateChangedFiles
+//------------------------------------------------------------------------------
+void TestUnity::IsolateChangedFiles() const
+{
+    //
+    // Modified files are isolated, and return to the unity once other files
+    // have been modified
+    //
+    const char * const dbFile = "../tmp/Test/Unity/IsolateChangedFiles/fbuild.fdb";
+    const char * const fileA = "../tmp/Test/Unity/IsolateChangedFiles/Input/a.cpp";
+    const char * const fileB = "../tmp/Test/Unity/IsolateChangedFiles/Input/b.cpp";
+    const char * const fileC = "../tmp/Test/Unity/IsolateChangedFiles/Input/c.cpp";
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestUnity/IsolateChangedFiles/fbuild.bff";
+    options.m_ForceCleanBuild = true;
+
+    TEST_ASSERT( FileIO::EnsurePathExistsForFile( AStackString<>( fileA ) ) );
+    MakeFile( fileA, "int A() { return 0; }\n" );
+    MakeFile( fileB, "int B() { return 0; }\n" );
+    MakeFile( fileC, "int C() { return 0; }\n" );
+
+    // Initial build has no history, so all files are in the unity
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "Compile" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( dbFile ) );
+
+        // Check stats
+        //               Seen,  Built,  Type
+        CheckStatsNode ( 1,     1,      Node::OBJECT_NODE );
+    }
+    options.m_ForceCleanBuild = false;
+
+    // Modify a file: It is isolated
+    MakeFile( fileA, "int A() { return 1; }\n" );
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( dbFile ) );
+        TEST_ASSERT( fBuild.Build( "Compile" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( dbFile ) );
+
+        // Check stats
+        //               Seen,  Built,  Type
+        CheckStatsNode ( 2,     2,      Node::OBJECT_NODE ); // Unity and a.cpp
+    }
+
+    // Modify it again: Only the isolated file is rebuilt
+    MakeFile( fileA, "int A() { return 2; }\n" );
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( dbFile ) );
+        TEST_ASSERT( fBuild.Build( "Compile" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( dbFile ) );
+
+        // Check stats
+        //               Seen,  Built,  Type
+        CheckStatsNode ( 2,     1,      Node::OBJECT_NODE ); // a.cpp
+    }
+
+    // Nothing modified: Nothing is rebuilt
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( dbFile ) );
+        TEST_ASSERT( fBuild.Build( "Compile" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( dbFile ) );
+
+        // Check stats
+        //               Seen,  Built,  Type
+        CheckStatsNode ( 2,     0,      Node::OBJECT_NODE );
+    }
+
+    // Modify other files: a.cpp returns to the unity after 2 builds
+    MakeFile( fileB, "int B() { return 1; }\n" );
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( dbFile ) );
+        TEST_ASSERT( fBuild.Build( "Compile" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( dbFile ) );
+
+        // Check stats
+        //               Seen,  Built,  Type
+        CheckStatsNode ( 3,     2,      Node::OBJECT_NODE ); // Unity and b.cpp
+    }
+    MakeFile( fileC, "int C() { return 1; }\n" );
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( dbFile ) );
+        TEST_ASSERT( fBuild.Build( "Compile" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( dbFile ) );
+
+        // Check stats
+        //               Seen,  Built,  Type
+        CheckStatsNode ( 3,     2,      Node::OBJECT_NODE ); // Unity and c.cpp (b.cpp is still isolated)
+    }
+}
+
+// GetMakespan
+//------------------------------------------------------------------------------
+/*static*/ uint64_t TestUnity::GetMakespan( const Array< uint64_t > & costs, const Array< uint32_t > & unityIndices, uint32_t numUnityFiles )
+{
+    Array< uint64_t > loads( numUnityFiles );
+    for ( uint32_t i = 0; i < numUnityFiles; ++i )
+    {
+        loads.Append( 0 );
+    }
+    for ( size_t i = 0; i < costs.GetSize(); ++i )
+    {
+        loads[ unityIndices[ i ] ] += costs[ i ];
+    }
+    uint64_t makespan = 0;
+    for ( const uint64_t load : loads )
+    {
+        makespan = Math::Max( makespan, load );
+    }
+    return makespan;
+}
+
 //------------------------------------------------------------------------------
@@ -33,9 +33,11 @@ FBuildWorkerOptions::FBuildWorkerOptions() :
     m_OverrideWorkMode( false ),
     m_WorkMode( WorkerSettings::WHEN_IDLE ),
     m_MinimumFreeMemoryMiB( 0 ),
+    m_ResultCacheSizeMiB( 0 ),
     m_ConsoleMode( false ),
     m_PeriodicRestart( false ),
-    m_PreferHostName( false )
+    m_PreferHostName( false ),
+    m_MetricsPort( 0 )
 {
     #ifdef __LINUX__
         m_ConsoleMode = true; // Only console mode supported on Linux
@@ -147,6 +149,27 @@ bool FBuildWorkerOptions::ProcessCommandLine( const AString & commandLine )
                 continue;
             }
         #endif
+        else if ( token.BeginsWith( "-resultcache=" ) )
+        {
+            uint32_t num( 0 );
+            if ( AString::ScanS( token.Get() + 13, "%u", &num ) == 1 )
+            {
+                m_ResultCacheSizeMiB = num;
+                continue;
+            }
+            // problem... fall through
+        }
+        else if ( token.BeginsWith( "-metricsport=" ) )
+        {
+            uint32_t num( 0 );
+            if ( ( AString::ScanS( token.Get() + 13, "%u", &num ) == 1 ) &&
+                 ( num > 0 ) && ( num <= 65535 ) )
+            {
+                m_MetricsPort = (uint16_t)num;
+                continue;
+            }
+            // problem... fall through
+        }
         else if ( token == "-preferhostname" )
         {
             m_PreferHostName = true;
@@ -193,6 +216,8 @@ void FBuildWorkerOptions::ShowUsageError()
                        "        - idle : Accept work when PC is idle.\n"
                        "        - dedicated : Accept work always.\n"
                        "        - proportional : Accept work proportional to free CPUs.\n"
+                       " -metricsport=<port>\n"
+                       "        Serve live metrics on http://127.0.0.1:<port>/metrics\n"
                        " -minfreememory <MiB>\n"
                        "        Set minimum free memory (MiB) required to accept work.\n"
                        " -nosubprocess\n"
@@ -201,6 +226,8 @@ void FBuildWorkerOptions::ShowUsageError()
                        "        Worker will restart every 4 hours.\n"
                        " -preferhostname\n"
                        "        Broker filename will be the hostname instead of the IP Address.\n"
+                       " -resultcache=<MiB>\n"
+                       "        Cache results of up to <MiB> to avoid rebuilding identical jobs.\n"
                        " -coordinator=<ip address>\n"
                        "        Set FBuildCoordinator ip address.\n"
                        " -brokerage=<path>\n"
@@ -36,6 +36,7 @@ public:
     bool m_OverrideWorkMode;
     WorkerSettings::Mode m_WorkMode;
     uint32_t m_MinimumFreeMemoryMiB; // Minimum OS free memory including virtual memory to let worker do its work
+    uint32_t m_ResultCacheSizeMiB;   // Size of cache of results for identical jobs (0 = disabled)
 
     // Console mode
     bool m_ConsoleMode;
@@ -43,6 +44,7 @@ public:
     // Other
     bool m_PeriodicRestart;
     bool m_PreferHostName;
+    uint16_t m_MetricsPort;         // Serve live metrics on this port (0 = disabled)
 
     // Coordinator ip
     AString m_CoordinatorAddress;
@@ -158,6 +158,14 @@ int Main( const AString & args )
         {
             worker.SetBrokeragePath( options.m_BrokeragePath );
         }
+        if ( options.m_ResultCacheSizeMiB )
+        {
+            worker.SetResultCacheSize( (uint64_t)options.m_ResultCacheSizeMiB * MEGABYTE );
+        }
+        if ( options.m_MetricsPort )
+        {
+            worker.StartMetricsServer( options.m_MetricsPort );
+        }
         ret = worker.Work();
     }
 
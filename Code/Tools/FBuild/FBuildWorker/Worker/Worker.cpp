@@ -16,6 +16,7 @@
 // FBuild
 #include "Tools/FBuild/FBuildCore/FBuild.h"
 #include "Tools/FBuild/FBuildCore/FBuildVersion.h"
+#include "Tools/FBuild/FBuildCore/Helpers/MetricsServer.h"
 #include "Tools/FBuild/FBuildCore/Protocol/Protocol.h"
 #include "Tools/FBuild/FBuildCore/Protocol/Server.h"
 #include "Tools/FBuild/FBuildCore/WorkerPool/JobQueueRemote.h"
@@ -46,6 +47,7 @@ Worker::Worker( const AString & args, bool consoleMode, bool periodicRestart, bo
     , m_PeriodicRestart( periodicRestart )
     , m_MainWindow( nullptr )
     , m_ConnectionPool( nullptr )
+    , m_MetricsServer( nullptr )
     , m_NetworkStartupHelper( nullptr )
     , m_WorkerBrokerage( preferHostName )
     , m_BaseArgs( args )
@@ -75,6 +77,7 @@ Worker::Worker( const AString & args, bool consoleMode, bool periodicRestart, bo
 //------------------------------------------------------------------------------
 Worker::~Worker()
 {
+    FDELETE m_MetricsServer;
     FDELETE m_NetworkStartupHelper;
     FDELETE m_ConnectionPool;
     FDELETE m_MainWindow;
@@ -230,6 +233,22 @@ uint32_t Worker::WorkThread()
     return 0;
 }
 
+// SetResultCacheSize
+//------------------------------------------------------------------------------
+void Worker::SetResultCacheSize( uint64_t maxSize )
+{
+    JobQueueRemote::Get().SetResultCacheSize( maxSize );
+}
+
+// StartMetricsServer
+//------------------------------------------------------------------------------
+void Worker::StartMetricsServer( uint16_t port )
+{
+    ASSERT( m_MetricsServer == nullptr );
+    m_MetricsServer = FNEW( MetricsServer );
+    m_MetricsServer->Start( port );
+}
+
 // HasEnoughDiskSpace
 //------------------------------------------------------------------------------
 bool Worker::HasEnoughDiskSpace()
@@ -392,6 +411,16 @@ void Worker::UpdateUI()
             status += " (Low Disk Space)";
         }
     #endif
+    const WorkerResultCache & resultCache = JobQueueRemote::Get().GetResultCache();
+    if ( resultCache.IsEnabled() )
+    {
+        uint32_t numHits;
+        uint32_t numMisses;
+        uint64_t size;
+        resultCache.GetStats( numHits, numMisses, size );
+        const uint32_t numRequests = ( numHits + numMisses );
+        status.AppendFormat( " (Result Cache: %u%% hits, %u MiB)", numRequests ? (uint32_t)( (uint64_t)numHits * 100 / numRequests ) : 0, (uint32_t)( size / MEGABYTE ) );
+    }
     if ( InConsoleMode() )
     {
         status += '\n';
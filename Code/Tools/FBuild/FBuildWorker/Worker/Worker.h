@@ -19,6 +19,7 @@
 class Server;
 class WorkerWindow;
 class JobQueueRemote;
+class MetricsServer;
 class NetworkStartupHelper;
 class WorkerSettings;
 
@@ -36,6 +37,8 @@ public:
 
     void SetCoordinatorAddress(const AString & address) { m_WorkerBrokerage.SetCoordinatorAddress(address); }
     void SetBrokeragePath(const AString & path) { m_WorkerBrokerage.SetBrokeragePath(path); }
+    void SetResultCacheSize( uint64_t maxSize );
+    void StartMetricsServer( uint16_t port );
 private:
     static uint32_t WorkThreadWrapper( void * userData );
     uint32_t WorkThread();
@@ -55,6 +58,7 @@ private:
     bool                m_PeriodicRestart;
     WorkerWindow        * m_MainWindow;
     Server              * m_ConnectionPool;
+    MetricsServer       * m_MetricsServer;
     NetworkStartupHelper * m_NetworkStartupHelper;
     WorkerSettings      * m_WorkerSettings;
     IdleDetection       m_IdleDetection;